@@ -0,0 +1,282 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "analysiscache.h"
+#include "movegen.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+const char fileMagic[4] = { 'C', 'A', 'C', 'H' };
+enum {
+    FILE_VERSION = 1,
+    HEADER_SIZE  = 64,
+    BUCKET_SIZE  = 4,  // entries
+    ENTRY_SIZE   = 16  // bytes: the key xor-ed with the data, then the data
+};
+
+//    Packed layout of the data word:
+//      bits  0-15 - move
+//      bits 16-31 - score
+//      bits 32-39 - depth
+//      bits 40-41 - bound
+inline quint64 packData(Move move, int score, int depth, eBound bound)
+{
+    return quint64(move)
+         | quint64(quint16(qint16(score))) << 16
+         | quint64(quint8(depth))          << 32
+         | quint64(bound)                  << 40;
+}
+
+inline Move   dataMove(quint64 data)  { return Move(data & 0xFFFF); }
+inline int    dataScore(quint64 data) { return qint16(quint16(data >> 16)); }
+inline int    dataDepth(quint64 data) { return quint8(data >> 32); }
+inline eBound dataBound(quint64 data) { return eBound((data >> 40) & 3); }
+
+QMutex   cacheMutex; // guards everything below, a probe is rare: once per search
+QFile    cacheFile;
+uchar   *memory = nullptr;
+uchar   *entryBase = nullptr;
+quint64  bucketMask = 0;
+
+inline quint64 loadWord(const uchar *entry, int word)
+{
+    return qFromLittleEndian<quint64>(entry + 8 * word);
+}
+
+inline void storeWord(uchar *entry, int word, quint64 value)
+{
+    qToLittleEndian<quint64>(value, entry + 8 * word);
+}
+
+inline uchar *bucketOf(Key key)
+{
+    return entryBase + (key & bucketMask) * BUCKET_SIZE * ENTRY_SIZE;
+}
+
+// findEntry: the data word of the key, 0 if it isn't in the cache. Called with the mutex held
+quint64 findEntry(Key key)
+{
+    const uchar *bucket = bucketOf(key);
+    for (auto i = 0; i < BUCKET_SIZE; i++) {
+        const uchar *entry = bucket + i * ENTRY_SIZE;
+        const quint64 data = loadWord(entry, 1);
+        if (data != 0 && (loadWord(entry, 0) ^ data) == key)
+            return data;
+    }
+    return 0;
+}
+
+void storeEntry(Key key, Move move, int score, int depth, eBound bound)
+{
+    uchar *bucket = bucketOf(key);
+    uchar *replace = bucket;
+    for (auto i = 0; i < BUCKET_SIZE; i++) {
+        uchar *entry = bucket + i * ENTRY_SIZE;
+        const quint64 data = loadWord(entry, 1);
+        if (data != 0 && (loadWord(entry, 0) ^ data) == key) {
+            // an inexact result doesn't replace the exact one of a deeper search
+            if (depth < dataDepth(data) && !(bound == BOUND_EXACT && dataBound(data) != BOUND_EXACT))
+                return;
+            replace = entry;
+            break;
+        }
+        if (dataDepth(data) < dataDepth(loadWord(replace, 1)) || data == 0)
+            replace = entry;
+        if (data == 0)
+            break;
+    }
+
+    const quint64 data = packData(move, score, qBound(1, depth, 255), bound);
+    storeWord(replace, 1, data);
+    storeWord(replace, 0, key ^ data);
+}
+
+bool isLegal(const Position &pos, Move move)
+{
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    return moves.contains(move);
+}
+
+}
+
+//==============================================================
+//                      AnalysisCache
+//==============================================================
+
+bool AnalysisCache::open(const QString &fileName, int megabytes)
+{
+    close();
+    QMutexLocker locker(&cacheMutex);
+
+    cacheFile.setFileName(fileName);
+    if (!cacheFile.open(QIODevice::ReadWrite))
+        return false;
+
+    // an existing cache is kept when its header matches its size
+    const Key check = Position::startKey(); // a cache of other Zobrist keys is recreated
+    uchar header[HEADER_SIZE];
+    bool isValid = cacheFile.read(reinterpret_cast<char*>(header), HEADER_SIZE) == HEADER_SIZE;
+    quint64 buckets = isValid ? qFromLittleEndian<quint64>(header + 8) : 0;
+    isValid = isValid && std::memcmp(header, fileMagic, sizeof(fileMagic)) == 0 && header[4] == FILE_VERSION
+           && buckets > 0 && (buckets & (buckets - 1)) == 0
+           && cacheFile.size() == qint64(HEADER_SIZE + buckets * BUCKET_SIZE * ENTRY_SIZE)
+           && qFromLittleEndian<quint64>(header + 16) == check;
+
+    if (!isValid) {
+        // the largest power of two buckets which fits, the entries are zeros
+        const quint64 fits = (quint64(qMax(1, megabytes)) << 20) / (BUCKET_SIZE * ENTRY_SIZE);
+        buckets = 1;
+        while (buckets * 2 <= fits)
+            buckets *= 2;
+
+        std::memset(header, 0, sizeof(header));
+        std::memcpy(header, fileMagic, sizeof(fileMagic));
+        header[4] = FILE_VERSION;
+        qToLittleEndian<quint64>(buckets, header + 8);
+        qToLittleEndian<quint64>(check, header + 16);
+        if (!cacheFile.resize(0) || !cacheFile.resize(qint64(HEADER_SIZE + buckets * BUCKET_SIZE * ENTRY_SIZE))
+            || !cacheFile.seek(0) || cacheFile.write(reinterpret_cast<const char*>(header), HEADER_SIZE) != HEADER_SIZE
+            || !cacheFile.flush()) {
+            cacheFile.close();
+            return false;
+        }
+    }
+
+    memory = cacheFile.map(0, cacheFile.size());
+    if (memory == nullptr) {
+        cacheFile.close();
+        return false;
+    }
+    entryBase = memory + HEADER_SIZE;
+    bucketMask = buckets - 1;
+    return true;
+}
+
+void AnalysisCache::close()
+{
+    QMutexLocker locker(&cacheMutex);
+    if (memory)
+        cacheFile.unmap(memory);
+    cacheFile.close();
+    memory = entryBase = nullptr;
+    bucketMask = 0;
+}
+
+bool AnalysisCache::isOpen()
+{
+    QMutexLocker locker(&cacheMutex);
+    return memory != nullptr;
+}
+
+QString AnalysisCache::fileName()
+{
+    QMutexLocker locker(&cacheMutex);
+    return memory ? cacheFile.fileName() : QString();
+}
+
+quint64 AnalysisCache::entries()
+{
+    QMutexLocker locker(&cacheMutex);
+    return memory ? (bucketMask + 1) * BUCKET_SIZE : 0;
+}
+
+quint64 AnalysisCache::used()
+{
+    QMutexLocker locker(&cacheMutex);
+    if (!memory)
+        return 0;
+    quint64 count = 0;
+    for (quint64 i = 0; i < (bucketMask + 1) * BUCKET_SIZE; i++)
+        count += loadWord(entryBase + i * ENTRY_SIZE, 1) != 0 ? 1 : 0;
+    return count;
+}
+
+bool AnalysisCache::probe(Key key, Move *move, int *score, int *depth, eBound *bound)
+{
+    QMutexLocker locker(&cacheMutex);
+    const quint64 data = memory ? findEntry(key) : 0;
+    if (data == 0)
+        return false;
+    *move  = dataMove(data);
+    *score = dataScore(data);
+    *depth = dataDepth(data);
+    *bound = dataBound(data);
+    return true;
+}
+
+void AnalysisCache::store(Key key, Move move, int score, int depth, eBound bound)
+{
+    QMutexLocker locker(&cacheMutex);
+    if (memory)
+        storeEntry(key, move, score, depth, bound);
+}
+
+bool AnalysisCache::probeLine(const Position &pos, CachedLine *line)
+{
+    QMutexLocker locker(&cacheMutex);
+    quint64 data = memory ? findEntry(pos.key()) : 0;
+    if (data == 0 || dataBound(data) != BOUND_EXACT || !isLegal(pos, dataMove(data)))
+        return false;
+
+    line->score = scoreFromTT(dataScore(data), 0);
+    line->depth = dataDepth(data);
+    line->pv.clear();
+
+    // the line ends where the cache has no exact result or the moves repeat a position
+    Position next = pos;
+    QVector<Key> keys;
+    while (data != 0 && dataBound(data) == BOUND_EXACT && line->pv.size() < MAX_PLY
+           && !keys.contains(next.key()) && isLegal(next, dataMove(data))) {
+        keys.append(next.key());
+        line->pv.append(dataMove(data));
+        next.doMove(dataMove(data));
+        data = findEntry(next.key());
+    }
+    return true;
+}
+
+void AnalysisCache::storeLine(const Position &pos, int score, int depth, const QVector<Move> &pv)
+{
+    QMutexLocker locker(&cacheMutex);
+    if (!memory)
+        return;
+
+    // the score alternates its sign along the line, mate scores become relative to each position
+    Position next = pos;
+    for (auto ply = 0; ply < pv.size() && depth - ply > 0; ply++) {
+        const int nodeScore = ply % 2 == 0 ? score : -score;
+        storeEntry(next.key(), pv.at(ply), scoreToTT(nodeScore, ply), depth - ply, BOUND_EXACT);
+        next.doMove(pv.at(ply));
+    }
+}
+
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_ANALYSISCACHE_H
+#define ENGINE_ANALYSISCACHE_H
+
+#include <QString>
+#include <QVector>
+
+#include "position.h"
+#include "transposition.h"
+
+//==============================================================
+//                      Analysis cache
+//==============================================================
+
+//    Results of the searches kept on disk between sessions: the best move,
+//    score, depth and bound of a position by its Zobrist key. The file is
+//    a 64 bytes header and buckets of 4 entries of 16 bytes, each entry the
+//    data word and the key xor-ed with it, little endian, as in the
+//    transposition table. It is mapped read-write, so the pages written go
+//    back to the file without any explicit save, and processes sharing
+//    the file see each other's results; a torn entry is simply a miss.
+//
+//    A search stores its principal variation, every position of it with the
+//    depth left. Before searching, the line of the root is read back: it fills
+//    the transposition table and it is reported at once, so a position studied
+//    before is shown analysed as soon as it's reached again.
+
+namespace engine
+{
+
+//    CachedLine is the best line of a position as found by an earlier search
+struct CachedLine {
+    int           score; // from the side to move point of view
+    int           depth;
+    QVector<Move> pv;
+};
+
+namespace AnalysisCache
+{
+    enum { DEFAULT_SIZE_MB = 64 };
+
+    // open: maps the cache file, it is created with about `megabytes` if it doesn't exist
+    //      or isn't a cache of this engine; an existing cache keeps its size.
+    //      The previous cache is closed even on failure
+    bool    open(const QString &fileName, int megabytes = DEFAULT_SIZE_MB);
+    void    close();
+    bool    isOpen();
+    QString fileName();
+    // entries: the size of the cache and the number of entries used
+    quint64 entries();
+    quint64 used();
+
+    // probe: the entry of the key; the scores are relative to the position
+    //      as in the transposition table, mate scores are in plies from it
+    bool    probe(Key key, Move *move, int *score, int *depth, eBound *bound);
+    // store: an entry of the same position is replaced by a deeper or an exact one,
+    //      otherwise the shallowest entry of the bucket is replaced
+    void    store(Key key, Move move, int score, int depth, eBound bound);
+
+    // probeLine: the exact line of the position following the best moves of the cache
+    bool    probeLine(const Position &pos, CachedLine *line);
+    // storeLine: the result of a search of the position, all the positions of
+    //      the principal variation are stored with the depth left
+    void    storeLine(const Position &pos, int score, int depth, const QVector<Move> &pv);
+}
+
+}
+
+#endif//ENGINE_ANALYSISCACHE_H
@@ -0,0 +1,271 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "annotator.h"
+#include "parallel.h"
+#include "pgn.h"
+#include "movegen.h"
+#include "search.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QtAlgorithms>
+
+#include <cmath>
+#include <deque>
+
+namespace engine
+{
+
+namespace
+{
+
+enum eMark {
+    MARK_NONE,
+    MARK_INACCURACY,
+    MARK_MISTAKE,
+    MARK_BLUNDER,
+    MARK_NB
+};
+
+const int markNags[MARK_NB] = { 0, 6, 2, 4 };
+const char *markNames[MARK_NB] = { "", "Inaccuracy.", "Mistake.", "Blunder." };
+
+// winningChances: -1 to 1, scores beyond 10 pawns and mates are as good as a won game
+double winningChances(int score)
+{
+    const int cp = qBound(-1000, score, 1000);
+    return 2 / (1 + std::exp(-0.00368208 * cp)) - 1;
+}
+
+eMark markOf(int before, int after)
+{
+    const double drop = winningChances(before) - winningChances(after);
+    return drop >= 0.3 ? MARK_BLUNDER : drop >= 0.2 ? MARK_MISTAKE : drop >= 0.1 ? MARK_INACCURACY : MARK_NONE;
+}
+
+// formatEval: from White's point of view, #moves to mate or pawns
+QString formatEval(int score, eColor sideToMove)
+{
+    if (sideToMove == BLACK)
+        score = -score;
+    if (isMateScore(score)) {
+        // plies to mate rounded up to the moves of the mating side
+        const int moves = score > 0 ? (VALUE_MATE - score + 1) / 2 : -((VALUE_MATE + score + 1) / 2);
+        return QString("#%1").arg(moves);
+    }
+    return QString::number(score / 100.0, 'f', 2);
+}
+
+//    JobQueue holds the games of a thread, the owner takes them from the back
+//    and the other threads from the front, so they rarely meet on a game
+struct JobQueue {
+    QMutex          mutex;
+    std::deque<int> games;
+};
+
+struct Statistics {
+    Statistics() : positions(0) { for (auto &count : marks) count = 0; }
+
+    qint64 positions;
+    qint64 marks[MARK_NB];
+};
+
+// analyseGame: searches every position of the game and annotates its moves
+void analyseGame(Search &search, PgnGame &game, const Annotator::Options &options, Statistics &stats)
+{
+    Position pos;
+    if (!pos.setFEN(game.startFEN()))
+        return;
+    search.newGame();
+
+    SearchLimits limits;
+    if (options.nodes > 0)
+        limits.nodes = options.nodes;
+    if (options.depth > 0)
+        limits.depth = qMin(options.depth, MAX_PLY - 1);
+
+    // scores from the side to move of each position, the one after the last move included;
+    // no best move in a checkmate or a stalemate
+    QVector<int> scores;
+    QVector<Move> bestMoves, played;
+    for (auto i = 0; ; i++) {
+        MoveList legal;
+        generateLegalMoves(pos, legal);
+        if (legal.isEmpty()) {
+            scores.append(pos.inCheck() ? matedIn(0) : VALUE_DRAW);
+            bestMoves.append(NO_MOVE);
+        } else {
+            const SearchResult result = search.go(pos, limits);
+            scores.append(result.score);
+            bestMoves.append(result.bestMove);
+            stats.positions++;
+        }
+
+        const Move move = i < game.moves.size() ? moveFromSan(pos, game.moves.at(i)) : NO_MOVE;
+        if (move == NO_MOVE)
+            break;
+        played.append(move);
+        pos.doMove(move);
+    }
+
+    Position replay;
+    replay.setFEN(game.startFEN());
+    game.nags.fill(0, game.moves.size());
+    game.comments = QStringList();
+    for (auto i = 0; i < game.moves.size(); i++)
+        game.comments.append(QString());
+
+    for (auto i = 0; i < played.size(); i++) {
+        const eColor us = replay.sideToMove();
+        // both scores from the point of view of the side which has played the move
+        const eMark mark = played.at(i) == bestMoves.at(i) ? MARK_NONE : markOf(scores.at(i), -scores.at(i + 1));
+        QString comment;
+        if (bestMoves.at(i + 1) != NO_MOVE)
+            comment = QString("[%eval %1]").arg(formatEval(scores.at(i + 1), opposite(us)));
+        if (mark != MARK_NONE) {
+            game.nags[i] = markNags[mark];
+            comment += QString(" %1 %2 was best.").arg(markNames[mark]).arg(moveToSan(replay, bestMoves.at(i)));
+            stats.marks[mark]++;
+        }
+        game.comments[i] = comment.trimmed();
+        replay.doMove(played.at(i));
+    }
+}
+
+}
+
+//==============================================================
+//                          Annotator
+//==============================================================
+
+bool Annotator::annotate(const QStringList &pgnFiles, const QString &outputFile, const Options &options,
+                         QTextStream &out, QString *error)
+{
+    QFile output(outputFile);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        *error = "can't write " + outputFile;
+        return false;
+    }
+    QTextStream annotated(&output);
+
+    const int threads = qMax(1, options.threads);
+    const int batchGames = qMax(1, options.batchGames);
+    QVector<Search*> searches;
+    for (auto i = 0; i < threads; i++) {
+        searches.append(new Search);
+        searches.last()->setHashSize(options.hashMB);
+    }
+    QVector<JobQueue*> queues;
+    for (auto i = 0; i < threads; i++)
+        queues.append(new JobQueue);
+    QVector<Statistics> stats(threads);
+
+    out << "Annotating with " << threads << " threads, "
+        << (options.nodes > 0 ? QString("%1 nodes").arg(options.nodes) : QString())
+        << (options.nodes > 0 && options.depth > 0 ? " and " : "")
+        << (options.depth > 0 ? QString("depth %1").arg(options.depth) : QString())
+        << " per position\n";
+    out << "     games   positions   positions/s  games/s\n";
+    out.flush();
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 games = 0;
+    bool isOk = true;
+    QVector<PgnGame> batch(batchGames);
+    for (const auto &fileName : pgnFiles) {
+        PgnFile file;
+        if (!file.open(fileName)) {
+            *error = "can't open " + fileName;
+            isOk = false;
+            break;
+        }
+
+        int batchSize;
+        do {
+            batchSize = 0;
+            while (batchSize < batchGames && file.readGame(batch[batchSize]))
+                batchSize++;
+
+            // contiguous shares first, the games differ in length so the queues are
+            // evened out by stealing: the games at the front of the longest queues go first
+            const int shareSize = (batchSize + threads - 1) / threads;
+            for (auto share = 0; share < threads; share++)
+                for (auto i = share * shareSize; i < qMin(batchSize, (share + 1) * shareSize); i++)
+                    queues[share]->games.push_back(i);
+
+            runParallel(threads, [&](int share) {
+                for (;;) {
+                    int game = -1;
+                    for (auto k = 0; k < threads && game < 0; k++) {
+                        JobQueue *queue = queues.at((share + k) % threads);
+                        QMutexLocker locker(&queue->mutex);
+                        if (queue->games.empty())
+                            continue;
+                        if (k == 0) {
+                            game = queue->games.back();
+                            queue->games.pop_back();
+                        } else {
+                            game = queue->games.front();
+                            queue->games.pop_front();
+                        }
+                    }
+                    if (game < 0)
+                        return;
+                    analyseGame(*searches.at(share), batch[game], options, stats[share]);
+                }
+            });
+
+            for (auto i = 0; i < batchSize; i++) {
+                batch[i].tags.append(qMakePair(QString("Annotator"), QString("chess-annotate")));
+                writeGame(annotated, batch.at(i));
+            }
+            annotated.flush();
+            games += batchSize;
+
+            qint64 positions = 0;
+            for (const auto &share : stats)
+                positions += share.positions;
+            const qint64 ms = qMax<qint64>(1, timer.elapsed());
+            out << QString("%1 %2 %3 %4\n").arg(games, 10).arg(positions, 11).arg(positions * 1000 / ms, 13)
+                   .arg(games * 1000.0 / ms, 8, 'f', 1);
+            out.flush();
+        } while (batchSize == batchGames);
+    }
+
+    Statistics total;
+    for (const auto &share : stats) {
+        total.positions += share.positions;
+        for (auto mark = 0; mark < MARK_NB; mark++)
+            total.marks[mark] += share.marks[mark];
+    }
+    out << "Games " << games << ", positions " << total.positions << " in " << timer.elapsed() / 1000 << " s: "
+        << total.marks[MARK_INACCURACY] << " inaccuracies, " << total.marks[MARK_MISTAKE] << " mistakes, "
+        << total.marks[MARK_BLUNDER] << " blunders\n";
+
+    qDeleteAll(searches);
+    qDeleteAll(queues);
+    return isOk;
+}
+
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_ANNOTATOR_H
+#define ENGINE_ANNOTATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+//==============================================================
+//                      Game annotator
+//==============================================================
+
+//    Analyses every position of the games of PGN files with a fixed budget
+//    and writes the games back with the evaluation after every move as
+//    a [%eval] comment, White's point of view in pawns or #moves to mate.
+//    A move losing winning chances is marked: 2 / (1 + e^(-0.00368 * cp)) - 1
+//    goes from -1 to 1, a drop of 0.1 is an inaccuracy ($6, ?!), 0.2 a mistake
+//    ($2, ?) and 0.3 a blunder ($4, ??), with the best move named.
+//    Games are read and written in batches, in the order of the files; the games
+//    of a batch are shared between the threads, each with its own queue, and a
+//    thread done with its queue takes the games left at the far end of the others.
+//    Each game is analysed from an empty table, so the output doesn't depend
+//    on the number of threads.
+
+namespace engine
+{
+
+namespace Annotator
+{
+    struct Options {
+        Options() : threads(1), nodes(100000), depth(0), hashMB(16), batchGames(256) {}
+
+        int    threads;
+        qint64 nodes;      // per position, the budget if not 0
+        int    depth;      // per position, the budget if not 0
+        int    hashMB;     // transposition table of each thread
+        int    batchGames; // games held in memory at once
+    };
+
+    // annotate: progress and throughput go to `out`, the annotated games to `outputFile`.
+    //      Games with moves that can't be played are copied without annotations
+    //      past them. False with `error` set on failure
+    bool    annotate(const QStringList &pgnFiles, const QString &outputFile, const Options &options,
+                     QTextStream &out, QString *error);
+}
+
+}
+
+#endif//ENGINE_ANNOTATOR_H
@@ -0,0 +1,984 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "benchmark.h"
+#include "search.h"
+#include "movegen.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "book.h"
+#include "bots.h"
+#include "pgn.h"
+#include "pgnimport.h"
+#include "gamecodec.h"
+#include "gamedb.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+
+namespace engine
+{
+
+QStringList Benchmark::positions()
+{
+    return QStringList()
+        << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+        << "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10"
+        << "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4"
+        << "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+        << "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        << "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 8"
+        << "2r3k1/pp3ppp/2n1b3/3p4/3P4/2N1B3/PP3PPP/2R3K1 w - - 0 20"
+        << "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+        << "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"
+        << "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1";
+}
+
+QStringList Benchmark::benchPositions()
+{
+    return QStringList()
+        << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+        << "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2"
+        << "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3"
+        << "rnbqkb1r/ppp1pppp/5n2/3p4/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 1 3"
+        << "rnbqkb1r/pppp1ppp/5n2/4p3/4P3/2N5/PPPP1PPP/R1BQKBNR w KQkq - 2 3"
+        << "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10"
+        << "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19"
+        << "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14"
+        << "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14"
+        << "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15"
+        << "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13"
+        << "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16"
+        << "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17"
+        << "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11"
+        << "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16"
+        << "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22"
+        << "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18"
+        << "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22"
+        << "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26"
+        << "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+        << "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        << "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 8"
+        << "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16"
+        << "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40"
+        << "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21"
+        << "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1"
+        << "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1"
+        << "2r3k1/pp3ppp/2n1b3/3p4/3P4/2N1B3/PP3PPP/2R3K1 w - - 0 20"
+        << "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90"
+        << "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1"
+        << "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1"
+        << "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1"
+        << "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1"
+        << "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1"
+        << "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1"
+        << "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1"
+        << "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1"
+        << "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1"
+        << "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1"
+        << "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1"
+        << "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1"
+        << "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1"
+        << "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1"
+        << "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+        << "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"
+        << "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1"
+        << "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1"
+        << "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1"
+        << "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124"
+        << "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1";
+}
+
+quint64 Benchmark::bench(QTextStream &out, int depth, int threads, int hashMB)
+{
+    const QStringList fens = benchPositions();
+
+    Search search;
+    search.setHashSize(hashMB);
+    search.setThreads(threads);
+    // the signature must not depend on the tables found on the machine nor on earlier sessions
+    SearchOptions options;
+    options.useTablebases = false;
+    options.useAnalysisCache = false;
+    search.setOptions(options);
+
+    SearchLimits limits;
+    limits.depth = depth;
+
+    quint64 nodes = 0;
+    qint64 time = 0;
+    for (auto i = 0; i < fens.size(); i++) {
+        Position pos;
+        pos.setFEN(fens.at(i));
+        search.newGame();
+        const SearchResult result = search.go(pos, limits);
+        nodes += quint64(result.nodes);
+        time  += result.time;
+        out << QString("position %1/%2 %3 nodes\n").arg(i + 1, 2).arg(fens.size()).arg(result.nodes, 12);
+        out.flush();
+    }
+
+    out << "===========================\n";
+    out << "Total time (ms) : " << time << "\n";
+    out << "Nodes searched  : " << nodes << "\n";
+    out << "Nodes/second    : " << nodes * 1000 / quint64(qMax<qint64>(1, time)) << "\n";
+    out.flush();
+    return nodes;
+}
+
+void Benchmark::smpSpeedup(QTextStream &out, int depth, const QVector<int> &threadCounts, int hashMB)
+{
+    const QStringList fens = positions();
+    qint64 baseTime = 0;
+
+    out << "Lazy SMP time to depth " << depth << ", " << fens.size() << " positions, hash " << hashMB << " MB\n";
+    out << "threads        time ms          nodes        nps   speedup\n";
+    out.flush();
+
+    for (auto threads : threadCounts) {
+        Search search;
+        search.setHashSize(hashMB);
+        search.setThreads(threads);
+
+        SearchLimits limits;
+        limits.depth = depth;
+
+        qint64 time = 0, nodes = 0;
+        for (const auto &fen : fens) {
+            Position pos;
+            pos.setFEN(fen);
+            search.newGame(); // every position starts with an empty table
+            SearchResult result = search.go(pos, limits);
+            time  += result.time;
+            nodes += result.nodes;
+        }
+
+        if (baseTime == 0)
+            baseTime = qMax<qint64>(1, time);
+
+        out << QString("%1 %2 %3 %4 %5\n")
+               .arg(threads, 7)
+               .arg(time, 14)
+               .arg(nodes, 14)
+               .arg(nodes * 1000 / qMax<qint64>(1, time), 10)
+               .arg(double(baseTime) / qMax<qint64>(1, time), 9, 'f', 2);
+        out.flush();
+    }
+}
+
+void Benchmark::moveOrdering(QTextStream &out, int depth, int hashMB)
+{
+    const QStringList fens = positions();
+
+    out << "Move ordering, nodes to depth " << depth << ", hash " << hashMB << " MB\n";
+    out << "position      unordered        ordered   reduction\n";
+    out.flush();
+
+    Search search;
+    search.setHashSize(hashMB);
+
+    SearchLimits limits;
+    limits.depth = depth;
+
+    qint64 totalNodes[2] = { 0, 0 };
+    for (auto i = 0; i < fens.size(); i++) {
+        Position pos;
+        pos.setFEN(fens.at(i));
+
+        qint64 nodes[2];
+        for (auto ordered = 0; ordered < 2; ordered++) {
+            SearchOptions options;
+            options.moveOrdering = ordered != 0;
+            search.setOptions(options);
+            search.newGame();
+            nodes[ordered] = search.go(pos, limits).nodes;
+            totalNodes[ordered] += nodes[ordered];
+        }
+
+        out << QString("%1 %2 %3 %4%\n")
+               .arg(i + 1, 8)
+               .arg(nodes[0], 14)
+               .arg(nodes[1], 14)
+               .arg(100.0 * (nodes[0] - nodes[1]) / qMax<qint64>(1, nodes[0]), 10, 'f', 1);
+        out.flush();
+    }
+
+    out << QString("%1 %2 %3 %4%\n")
+           .arg("total", 8)
+           .arg(totalNodes[0], 14)
+           .arg(totalNodes[1], 14)
+           .arg(100.0 * (totalNodes[0] - totalNodes[1]) / qMax<qint64>(1, totalNodes[0]), 10, 'f', 1);
+}
+
+void Benchmark::selectiveSearch(QTextStream &out, int depth, int hashMB)
+{
+    const QStringList fens = positions();
+
+    struct Setting {
+        const char   *name;
+        SearchOptions options;
+    };
+    QVector<Setting> settings(5);
+    settings[0].name = "all on";
+    settings[1].name = "no null move";
+    settings[1].options.nullMove = false;
+    settings[2].name = "no LMR";
+    settings[2].options.lateMoveReductions = false;
+    settings[3].name = "no futility";
+    settings[3].options.futilityPruning = false;
+    settings[4].name = "all off";
+    settings[4].options.nullMove = settings[4].options.lateMoveReductions = settings[4].options.futilityPruning = false;
+
+    out << "Selective search, nodes and time to depth " << depth << ", " << fens.size()
+        << " positions, hash " << hashMB << " MB\n";
+    out << "setting                nodes        time ms    nodes x    time x   same move\n";
+    out.flush();
+
+    Search search;
+    search.setHashSize(hashMB);
+
+    SearchLimits limits;
+    limits.depth = depth;
+
+    qint64 baseNodes = 0, baseTime = 0;
+    QVector<Move> baseMoves;
+    for (const auto &setting : settings) {
+        search.setOptions(setting.options);
+
+        qint64 nodes = 0, time = 0;
+        int sameMoves = 0;
+        for (auto i = 0; i < fens.size(); i++) {
+            Position pos;
+            pos.setFEN(fens.at(i));
+            search.newGame();
+            const SearchResult result = search.go(pos, limits);
+            nodes += result.nodes;
+            time  += result.time;
+            if (baseMoves.size() < fens.size())
+                baseMoves.append(result.bestMove);
+            else if (baseMoves.at(i) == result.bestMove)
+                sameMoves++;
+        }
+        if (baseNodes == 0) {
+            baseNodes = qMax<qint64>(1, nodes);
+            baseTime = qMax<qint64>(1, time);
+            sameMoves = fens.size();
+        }
+
+        // x: nodes and time against all the techniques on
+        out << QString("%1 %2 %3 %4 %5 %6/%7\n")
+               .arg(setting.name, -14)
+               .arg(nodes, 14)
+               .arg(time, 14)
+               .arg(double(nodes) / baseNodes, 10, 'f', 2)
+               .arg(double(time) / baseTime, 9, 'f', 2)
+               .arg(sameMoves, 9)
+               .arg(fens.size());
+        out.flush();
+    }
+}
+
+void Benchmark::pawnHash(QTextStream &out, int depth, int hashMB)
+{
+    const QStringList fens = positions();
+
+    out << "Pawn hash, classical evaluation, depth " << depth << ", " << fens.size()
+        << " positions, " << int(PawnTable::SIZE) << " entries per thread\n";
+    out << "position          nodes         probes           hits    hit %\n";
+    out.flush();
+
+    Search search;
+    search.setHashSize(hashMB);
+
+    SearchLimits limits;
+    limits.depth = depth;
+
+    // the table doesn't change any score, so both runs must search the same tree
+    qint64 nodes[2] = { 0, 0 }, time[2] = { 0, 0 };
+    quint64 probes = 0, hits = 0;
+    for (auto useTable = 1; useTable >= 0; useTable--) {
+        SearchOptions options;
+        options.useNnue = false;
+        options.pawnHash = useTable != 0;
+        search.setOptions(options);
+
+        for (auto i = 0; i < fens.size(); i++) {
+            Position pos;
+            pos.setFEN(fens.at(i));
+            search.newGame();
+            const SearchResult result = search.go(pos, limits);
+            nodes[useTable] += result.nodes;
+            time[useTable]  += result.time;
+            if (!useTable)
+                continue;
+
+            probes += search.pawnHashProbes();
+            hits   += search.pawnHashHits();
+            out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(i + 1, 8)
+                   .arg(result.nodes, 14)
+                   .arg(search.pawnHashProbes(), 14)
+                   .arg(search.pawnHashHits(), 14)
+                   .arg(100.0 * search.pawnHashHits() / qMax<quint64>(1, search.pawnHashProbes()), 8, 'f', 2);
+            out.flush();
+        }
+    }
+
+    out << QString("total    %1 %2 %3 %4\n")
+           .arg(nodes[1], 14)
+           .arg(probes, 14)
+           .arg(hits, 14)
+           .arg(100.0 * hits / qMax<quint64>(1, probes), 8, 'f', 2);
+    out << "time to depth with the table " << time[1] << " ms, without " << time[0] << " ms"
+        << (nodes[0] == nodes[1] ? "" : ", node counts differ") << "\n";
+}
+
+namespace
+{
+
+//    SearchThread runs a search in the background as the engine thread
+//    does, e.g. a ponder search while the opponent is thinking
+class SearchThread : public QThread {
+public:
+    SearchThread(Search &search, const Position &pos, const SearchLimits &limits)
+        : m_search(search), m_pos(pos), m_limits(limits) {}
+
+    SearchResult result;
+
+protected:
+    void run() { result = m_search.go(m_pos, m_limits); }
+
+private:
+    Search         &m_search;
+    Position        m_pos;
+    SearchLimits    m_limits;
+};
+
+// evalsPerSecond: repeats the batch for about half a second, the batch returns evaluations made
+template <typename Batch>
+qint64 evalsPerSecond(Batch batch, int &checksum)
+{
+    QElapsedTimer timer;
+    timer.start();
+    qint64 evals = 0;
+    while (timer.elapsed() < 500)
+        evals += batch(checksum);
+    return evals * 1000 / qMax<qint64>(1, timer.elapsed());
+}
+
+}
+
+bool Benchmark::nnue(QTextStream &out, const QString &networkFile)
+{
+    if (networkFile.isEmpty()) {
+        Nnue::initRandom(1070372ULL);
+    } else if (!Nnue::load(networkFile)) {
+        out << "Can't load the network " << networkFile << "\n";
+        return false;
+    }
+
+    QVector<Position> positions;
+    for (const auto &fen : Benchmark::positions()) {
+        Position pos;
+        pos.setFEN(fen);
+        positions.append(pos);
+    }
+
+    // the checksum keeps the compiler from dropping the evaluations
+    int checksum = 0;
+
+    const qint64 classical = evalsPerSecond([&positions](int &sum) {
+        for (const auto &pos : positions)
+            sum += evaluate(pos);
+        return positions.size();
+    }, checksum);
+
+    const qint64 full = evalsPerSecond([&positions](int &sum) {
+        for (const auto &pos : positions)
+            sum += Nnue::evaluate(pos);
+        return positions.size();
+    }, checksum);
+
+    const qint64 incremental = evalsPerSecond([&positions](int &sum) {
+        Nnue::Accumulator root, child;
+        int evals = 0;
+        for (const auto &pos : positions) {
+            Nnue::refresh(root, pos);
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            for (const auto &scored : moves) {
+                Nnue::update(child, root, pos, scored.move);
+                sum += Nnue::evaluate(child, opposite(pos.sideToMove()));
+                evals++;
+            }
+        }
+        return evals;
+    }, checksum);
+
+    out << "Network " << (networkFile.isEmpty() ? QString("random") : networkFile)
+        << ", kernels " << Nnue::simdName() << ", single thread\n";
+    out << QString("%1 %2 evals/s\n").arg("classical evaluation", -28).arg(classical, 12);
+    out << QString("%1 %2 evals/s\n").arg("network, from scratch", -28).arg(full, 12);
+    out << QString("%1 %2 evals/s\n").arg("network, update + evaluate", -28).arg(incremental, 12);
+    out << "checksum " << checksum << "\n";
+    return true;
+}
+
+void Benchmark::ponderLatency(QTextStream &out, qint64 opponentMs, qint64 clockMs)
+{
+    out << "Reply latency, clock " << clockMs << " ms, opponent thinks " << opponentMs << " ms\n";
+    out << "position      no ponder ms    ponder hit ms\n";
+    out.flush();
+
+    SearchLimits limits;
+    limits.time[WHITE] = limits.time[BLACK] = clockMs;
+
+    Search search;
+    search.setHashSize(64);
+
+    qint64 totalCold = 0, totalPonder = 0;
+    int count = 0;
+    const QStringList fens = positions();
+    for (auto i = 0; i < fens.size(); i++) {
+        Position pos;
+        pos.setFEN(fens.at(i));
+
+        // both runs start with the same table: the engine's own move has just been searched
+        search.newGame();
+        SearchResult own = search.go(pos, limits);
+        if (own.bestMove == NO_MOVE || own.ponderMove == NO_MOVE)
+            continue;
+        pos.doMove(own.bestMove);
+        Position reply = pos;
+        reply.doMove(own.ponderMove);
+
+        const qint64 cold = search.go(reply, limits).time;
+
+        search.newGame();
+        pos.undoMove(own.bestMove);
+        search.go(pos, limits);
+        pos.doMove(own.bestMove);
+
+        SearchLimits ponderLimits = limits;
+        ponderLimits.ponder = true;
+        SearchThread ponder(search, reply, ponderLimits);
+        ponder.start();
+        QThread::msleep(opponentMs);
+
+        QElapsedTimer latency;
+        latency.start();
+        search.ponderHit();
+        ponder.wait();
+        const qint64 hit = latency.elapsed();
+
+        out << QString("%1 %2 %3\n").arg(i + 1, 8).arg(cold, 16).arg(hit, 16);
+        out.flush();
+        totalCold += cold;
+        totalPonder += hit;
+        count++;
+    }
+
+    out << QString("%1 %2 %3\n").arg("average", 8)
+           .arg(totalCold / qMax(1, count), 16)
+           .arg(totalPonder / qMax(1, count), 16);
+}
+
+void Benchmark::stopLatency(QTextStream &out, int threads, qint64 searchMs)
+{
+    out << "Stop latency, " << threads << " threads, infinite search stopped after " << searchMs << " ms\n";
+    out << "position      nodes      latency us\n";
+    out.flush();
+
+    SearchLimits limits;
+    limits.infinite = true;
+
+    Search search;
+    search.setThreads(threads);
+    search.setHashSize(64);
+
+    qint64 total = 0, worst = 0;
+    const QStringList fens = positions();
+    for (auto i = 0; i < fens.size(); i++) {
+        Position pos;
+        pos.setFEN(fens.at(i));
+
+        search.newGame();
+        SearchThread thread(search, pos, limits);
+        thread.start();
+        QThread::msleep(searchMs);
+
+        // from the request to the moment the result is ready, all helpers joined
+        QElapsedTimer latency;
+        latency.start();
+        search.stop();
+        thread.wait();
+        const qint64 us = latency.nsecsElapsed() / 1000;
+
+        out << QString("%1 %2 %3\n").arg(i + 1, 8).arg(thread.result.nodes, 12).arg(us, 12);
+        out.flush();
+        total += us;
+        worst = qMax(worst, us);
+    }
+
+    out << QString("%1 %2 %3\n").arg("average", 8).arg("", 12).arg(total / qMax(1, fens.size()), 12);
+    out << QString("%1 %2 %3\n").arg("worst", 8).arg("", 12).arg(worst, 12);
+}
+
+void Benchmark::bots(QTextStream &out, int games, int threads, int seconds)
+{
+    //    LevelStats of the moves answered, guarded by the mutex
+    struct LevelStats {
+        LevelStats() : moves(0), nodes(0), totalLatency(0), maxLatency(0) {}
+
+        qint64 moves;
+        qint64 nodes;
+        qint64 totalLatency;
+        qint64 maxLatency;
+    };
+
+    const QStringList fens = benchPositions();
+    QVector<Position> boards(games);
+    QVector<int> plies(games, 0);
+    QVector<LevelStats> levels(Bots::levelCount());
+    QVector<int> gameLevels(games);
+    QMap<int, int> boardOf; // scheduler ids to boards
+    QMutex mutex;
+    QAtomicInt stopping(0);
+
+    // the scheduler is destroyed first, the callback may run until then
+    BotScheduler *scheduler = Q_NULLPTR;
+    BotScheduler::MoveCallback callback = [&](int game, const BotMove &answer) {
+        mutex.lock();
+        const int board = boardOf.value(game);
+        LevelStats &level = levels[gameLevels.at(board) - 1];
+        level.moves++;
+        level.nodes += answer.nodes;
+        level.totalLatency += answer.latency;
+        level.maxLatency = qMax(level.maxLatency, answer.latency);
+        mutex.unlock();
+
+        // a game over starts again from its opening
+        Position &pos = boards[board];
+        pos.doMove(answer.move);
+        MoveList moves;
+        generateLegalMoves(pos, moves);
+        if (moves.isEmpty() || pos.isDraw(0) || ++plies[board] >= 200) {
+            pos.setFEN(fens.at(board % fens.size()));
+            plies[board] = 0;
+        }
+        if (!stopping.load())
+            scheduler->requestMove(game, pos);
+    };
+    scheduler = new BotScheduler(callback, threads);
+
+    out << "Bots, " << games << " games of levels 1 to " << Bots::levelCount() << " on "
+        << scheduler->stats().threads << " threads for " << seconds << " s\n";
+    out << "second    moves/s   nodes/s  utilisation  pending  max wait ms\n";
+    out.flush();
+
+    for (auto i = 0; i < games; i++) {
+        gameLevels[i] = i % Bots::levelCount() + 1;
+        boards[i].setFEN(fens.at(i % fens.size()));
+        mutex.lock();
+        const int id = scheduler->addGame(Bots::level(gameLevels.at(i)), quint64(i + 1));
+        boardOf.insert(id, i);
+        mutex.unlock();
+        scheduler->requestMove(id, boards.at(i));
+    }
+
+    BotStats last = scheduler->stats();
+    for (auto second = 1; second <= seconds; second++) {
+        QThread::sleep(1);
+        const BotStats stats = scheduler->stats();
+        out << QString("%1 %2 %3 %4 %5 %6\n").arg(second, 6).arg(stats.moves - last.moves, 10)
+               .arg(stats.nodes - last.nodes, 9).arg(stats.utilisation, 12, 'f', 2)
+               .arg(stats.pending, 8).arg(stats.maxWait, 12);
+        out.flush();
+        last = stats;
+    }
+
+    stopping.store(1);
+    const BotStats stats = scheduler->stats();
+    delete scheduler;
+
+    out << "level    moves  nodes/move  average ms  max ms\n";
+    for (auto i = 0; i < levels.size(); i++) {
+        const LevelStats &level = levels.at(i);
+        const qint64 moves = qMax(Q_INT64_C(1), level.moves);
+        out << QString("%1 %2 %3 %4 %5\n").arg(i + 1, 5).arg(level.moves, 8).arg(level.nodes / moves, 11)
+               .arg(double(level.totalLatency) / moves, 11, 'f', 1).arg(level.maxLatency, 7);
+    }
+    out << "moves " << stats.moves << ", slices " << stats.slices << ", nodes " << stats.nodes
+        << ", utilisation " << QString::number(stats.utilisation, 'f', 2) << "\n";
+}
+
+bool Benchmark::book(QTextStream &out, const QString &bookFile)
+{
+    Book book;
+    if (!book.open(bookFile)) {
+        out << "Can't open the book " << bookFile << "\n";
+        return false;
+    }
+
+    // suite positions, the start position after two plies and their children:
+    // the opening ones are mostly hits, the rest mostly misses
+    QVector<Position> positions;
+    QVector<Position> roots;
+    Position start;
+    start.setFEN(Position::startFEN());
+    MoveList firstMoves;
+    generateLegalMoves(start, firstMoves);
+    for (const auto &first : firstMoves) {
+        Position pos = start;
+        pos.doMove(first.move);
+        MoveList replies;
+        generateLegalMoves(pos, replies);
+        for (const auto &reply : replies) {
+            Position child = pos;
+            child.doMove(reply.move);
+            roots.append(child);
+        }
+    }
+    for (const auto &fen : Benchmark::positions()) {
+        Position pos;
+        pos.setFEN(fen);
+        roots.append(pos);
+    }
+    for (const auto &root : roots) {
+        positions.append(root);
+        MoveList moves;
+        generateLegalMoves(root, moves);
+        for (const auto &scored : moves) {
+            Position child = root;
+            child.doMove(scored.move);
+            positions.append(child);
+        }
+    }
+
+    // the first pass touches the pages of the mapping, the timed ones find them in memory
+    int hits = 0;
+    for (const auto &pos : positions)
+        hits += book.probe(pos) != NO_MOVE ? 1 : 0;
+
+    const int passes = 5;
+    QElapsedTimer timer;
+    timer.start();
+    int checksum = 0;
+    for (auto pass = 0; pass < passes; pass++)
+        for (const auto &pos : positions)
+            checksum += book.probe(pos);
+    const qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+    const qint64 probes = qint64(passes) * positions.size();
+
+    out << "Book " << bookFile << ", " << book.entries() << " entries ("
+        << book.entries() * 16 / (1024 * 1024) << " MB mapped)\n";
+    out << QString("%1 %2\n").arg("positions", -20).arg(positions.size(), 12);
+    out << QString("%1 %2\n").arg("book hits", -20).arg(hits, 12);
+    out << QString("%1 %2 probes/s\n").arg("probe", -20).arg(probes * 1000000000LL / elapsedNs, 12);
+    out << QString("%1 %2 us\n").arg("time per probe", -20).arg(double(elapsedNs) / probes / 1000.0, 12, 'f', 3);
+    out << "checksum " << checksum << "\n";
+    return true;
+}
+
+bool Benchmark::pgn(QTextStream &out, const QString &pgnFile)
+{
+    PgnFile file;
+    if (!file.open(pgnFile)) {
+        out << "Can't open " << pgnFile << "\n";
+        return false;
+    }
+    const double megabytes = double(file.size()) / (1024 * 1024);
+    out << "PGN " << pgnFile << ", " << QString::number(megabytes, 'f', 1) << " MB mapped\n";
+    out << "                         games      moves       MB/s    games/s\n";
+
+    auto report = [&](const char *name, qint64 games, qint64 moves, qint64 elapsedNs) {
+        elapsedNs = qMax<qint64>(1, elapsedNs);
+        out << QString("%1 %2 %3 %4 %5\n").arg(name, -20).arg(games, 10).arg(moves, 10)
+                   .arg(megabytes * 1e9 / elapsedNs, 10, 'f', 1).arg(games * 1000000000LL / elapsedNs, 10);
+        out.flush();
+    };
+
+    // the first pass reads the file in, the following ones find its pages in memory
+    QVector<PgnToken> tokens;
+    qint64 games = 0, moves = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (file.readTokens(tokens)) {
+        games++;
+        for (const auto &token : tokens)
+            moves += token.type == PgnToken::SAN ? 1 : 0;
+    }
+    report("tokens", games, moves, timer.nsecsElapsed());
+
+    file.seek(0);
+    games = moves = 0;
+    qint64 illegal = 0;
+    timer.start();
+    while (file.readTokens(tokens)) {
+        games++;
+        Position pos;
+        pos.setFEN(Position::startFEN());
+        for (const auto &token : tokens)
+            if (token.type == PgnToken::TAG && token.equals("FEN"))
+                pos.setFEN(QString::fromLatin1(token.value, token.valueSize));
+        int variationDepth = 0;
+        for (const auto &token : tokens) {
+            if (token.type == PgnToken::VARIATION_START) {
+                variationDepth++;
+            } else if (token.type == PgnToken::VARIATION_END) {
+                variationDepth--;
+            } else if (token.type == PgnToken::SAN && variationDepth == 0) {
+                const Move move = moveFromSan(pos, token.text, token.size);
+                if (move == NO_MOVE) {
+                    illegal++;
+                    break;
+                }
+                pos.doMove(move);
+                moves++;
+            }
+        }
+    }
+    report("tokens and moves", games, moves, timer.nsecsElapsed());
+
+    QFile textFile(pgnFile);
+    textFile.open(QIODevice::ReadOnly | QIODevice::Text);
+    QTextStream in(&textFile);
+    PgnReader reader(in);
+    PgnGame game;
+    games = moves = 0;
+    timer.start();
+    while (reader.readGame(game)) {
+        games++;
+        moves += game.moves.size();
+    }
+    report("text stream reader", games, moves, timer.nsecsElapsed());
+
+    out << "games with an illegal or unknown move " << illegal << "\n";
+    return true;
+}
+
+bool Benchmark::pgnImport(QTextStream &out, const QString &pgnFile, int maxThreads)
+{
+    // the checksum of the moves and the offsets in the order of the list
+    auto checksum = [](const GameList &games) {
+        quint64 sum = 0;
+        for (auto game = 0; game < games.size(); game++) {
+            sum = sum * 31 + quint64(games.offset(game));
+            for (auto ply = 0; ply < games.plies(game); ply++)
+                sum = sum * 31 + games.moves(game)[ply];
+        }
+        return sum;
+    };
+
+    out << "PGN import of " << pgnFile << "\n";
+    out << "threads  chunks      games      moves   games/s    moves/s     MB/s  speedup\n";
+    out.flush();
+
+    double baseGamesPerSecond = 0;
+    quint64 baseChecksum = 0;
+    bool isSameOrder = true;
+    for (auto threads = 1; threads <= qMax(1, maxThreads); threads *= 2) {
+        GameList games;
+        PgnImport::Options options;
+        options.threads = threads;
+        PgnImport::Statistics stats;
+        QString error;
+        if (!PgnImport::importFile(pgnFile, games, options, &error, &stats)) {
+            out << error << "\n";
+            return false;
+        }
+
+        const double seconds = qMax<qint64>(1, stats.elapsedMs) / 1000.0;
+        const double gamesPerSecond = stats.games / seconds;
+        if (threads == 1) {
+            baseGamesPerSecond = gamesPerSecond;
+            baseChecksum = checksum(games);
+        } else {
+            isSameOrder = isSameOrder && checksum(games) == baseChecksum;
+        }
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n").arg(threads, 7).arg(stats.chunks, 7)
+                   .arg(stats.games, 10).arg(stats.moves, 10).arg(qint64(gamesPerSecond), 9)
+                   .arg(qint64(stats.moves / seconds), 10).arg(stats.bytes / (1024.0 * 1024.0) / seconds, 8, 'f', 1)
+                   .arg(gamesPerSecond / qMax(1.0, baseGamesPerSecond), 8, 'f', 2);
+        out.flush();
+        if (threads == 1 && stats.incomplete > 0)
+            out << "games with a move which couldn't be played " << stats.incomplete << "\n";
+    }
+    out << (isSameOrder ? "every thread count gave the same games in the same order\n"
+                        : "the games differ between the thread counts\n");
+    return isSameOrder;
+}
+
+bool Benchmark::gameCodec(QTextStream &out, const QString &pgnFile)
+{
+    GameList games;
+    PgnImport::Options options;
+    options.threads = QThread::idealThreadCount();
+    PgnImport::Statistics stats;
+    QString error;
+    if (!PgnImport::importFile(pgnFile, games, options, &error, &stats)) {
+        out << error << "\n";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray encoded = GameCodec::header();
+    int skipped = 0;
+    for (auto game = 0; game < games.size(); game++)
+        skipped += GameCodec::encodeGame(games, game, encoded) ? 0 : 1;
+    const qint64 encodeNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    GameList decoded;
+    timer.start();
+    qint64 pos = GameCodec::HEADER_SIZE;
+    while (pos < encoded.size()) {
+        const qint64 size = GameCodec::decodeGame(encoded.constData() + pos, encoded.size() - pos, pos, decoded);
+        if (size == 0)
+            break;
+        pos += size;
+    }
+    const qint64 decodeNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    bool isSame = decoded.size() == games.size() - skipped && skipped == 0;
+    for (auto game = 0; game < decoded.size() && isSame; game++) {
+        isSame = decoded.plies(game) == games.plies(game) && decoded.result(game) == games.result(game)
+              && decoded.isComplete(game) == games.isComplete(game) && decoded.tagCount(game) == games.tagCount(game)
+              && memcmp(decoded.moves(game), games.moves(game), games.plies(game) * sizeof(Move)) == 0;
+        for (auto idx = 0; idx < games.tagCount(game) && isSame; idx++)
+            isSame = decoded.tagName(game, idx) == games.tagName(game, idx)
+                  && decoded.tagValue(game, idx) == games.tagValue(game, idx);
+    }
+
+    const qint64 games64 = qMax<qint64>(1, games.size());
+    const qint64 moves = qMax<qint64>(1, games.moveCount());
+    out << "Games " << games.size() << ", moves " << games.moveCount() << " of " << pgnFile << "\n";
+    out << QString("%1 %2 bytes\n").arg("PGN", -20).arg(stats.bytes, 12);
+    out << QString("%1 %2 bytes, %3 times smaller\n").arg("binary", -20).arg(encoded.size(), 12)
+               .arg(double(stats.bytes) / qMax(1, encoded.size()), 0, 'f', 1);
+    out << QString("%1 %2\n").arg("bytes per game", -20).arg(double(encoded.size()) / games64, 12, 'f', 1);
+    out << QString("%1 %2\n").arg("bytes per move", -20).arg(double(encoded.size()) / moves, 12, 'f', 2);
+    out << QString("%1 %2 games/s %3 moves/s\n").arg("encode", -20).arg(games64 * 1000000000LL / encodeNs, 12)
+               .arg(moves * 1000000000LL / encodeNs);
+    out << QString("%1 %2 games/s %3 moves/s\n").arg("decode", -20).arg(games64 * 1000000000LL / decodeNs, 12)
+               .arg(moves * 1000000000LL / decodeNs);
+    out << (isSame ? "the decoded games are the imported ones\n" : "the decoded games differ from the imported ones\n");
+    return isSame;
+}
+
+bool Benchmark::gameDatabase(QTextStream &out, const QString &databaseFile, const QString &pgnFile)
+{
+    GameDatabase database;
+    if (!database.open(databaseFile)) {
+        out << "Can't open the database " << databaseFile << "\n";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    QString error;
+    if (!pgnFile.isEmpty()) {
+        GameList games;
+        PgnImport::Options options;
+        options.threads = QThread::idealThreadCount();
+        timer.start();
+        if (!PgnImport::importFile(pgnFile, games, options, &error) || !database.addGames(games, &error)) {
+            out << error << "\n";
+            return false;
+        }
+        out << QString("%1 %2 games in %3 ms\n").arg("added", -20).arg(games.size(), 12).arg(timer.elapsed());
+    }
+
+    timer.start();
+    if (!database.buildIndex(GameDatabase::DEFAULT_BUILD_MB, &error)) {
+        out << error << "\n";
+        return false;
+    }
+    const qint64 buildMs = timer.elapsed();
+    out << QString("%1 %2 games\n").arg("database", -20).arg(database.size(), 12);
+    out << QString("%1 %2 positions in %3 ms, %4 bytes\n").arg("index", -20).arg(database.indexEntries(), 12)
+               .arg(buildMs).arg(QFile(GameDatabase::indexFileName(databaseFile)).size());
+    if (database.size() == 0)
+        return true;
+
+    // positions of games spread over the database, each must find its own game
+    const int searches = 1000;
+    QVector<Key> keys;
+    QVector<GameHit> expected;
+    GameList games;
+    for (auto i = 0; i < searches; i++) {
+        const int game = int((qint64(i) * 7919) % database.size());
+        games.clear();
+        Position pos;
+        if (!database.readGame(game, games) || !pos.setFEN(games.startFEN(0)))
+            continue;
+        const int ply = (i * 31) % (games.plies(0) + 1);
+        for (auto idx = 0; idx < ply; idx++)
+            pos.doMove(games.moves(0)[idx]);
+        keys.append(pos.key());
+        expected.append(GameHit{ game, ply });
+    }
+
+    // the first pass touches the pages of the mapping, the timed one finds them in memory
+    const int maxHits = 1000;
+    QVector<GameHit> hits;
+    qint64 found = 0;
+    for (const auto key : keys) {
+        hits.clear();
+        found += database.find(key, hits, maxHits);
+    }
+
+    bool isFound = true;
+    qint64 maxNs = 0;
+    timer.start();
+    for (auto i = 0; i < keys.size(); i++) {
+        QElapsedTimer searchTimer;
+        searchTimer.start();
+        hits.clear();
+        const int count = database.find(keys.at(i), hits, maxHits);
+        maxNs = qMax(maxNs, searchTimer.nsecsElapsed());
+
+        // the game is among the hits unless there are more than maxHits of them
+        bool hasGame = count > maxHits;
+        for (const auto &hit : hits)
+            hasGame = hasGame || (hit.game == expected.at(i).game && hit.ply <= expected.at(i).ply);
+        isFound = isFound && hasGame;
+    }
+    const qint64 totalNs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    QVector<GameHit> startHits;
+    Position start;
+    start.setFEN(Position::startFEN());
+    timer.start();
+    const int startCount = database.find(start, startHits, maxHits);
+    const qint64 startNs = timer.nsecsElapsed();
+
+    out << QString("%1 %2, %3 games found on average\n").arg("searches", -20).arg(keys.size(), 12)
+               .arg(double(found) / qMax(1, keys.size()), 0, 'f', 1);
+    out << QString("%1 %2 ms average, %3 ms at most\n").arg("search", -20)
+               .arg(double(totalNs) / qMax(1, keys.size()) / 1000000.0, 12, 'f', 3).arg(double(maxNs) / 1000000.0, 0, 'f', 3);
+    out << QString("%1 %2 ms for %3 games\n").arg("start position", -20)
+               .arg(double(startNs) / 1000000.0, 12, 'f', 3).arg(startCount);
+    out << (isFound ? "every game was found at its position\n" : "some games weren't found at their position\n");
+    return isFound;
+}
+
+}
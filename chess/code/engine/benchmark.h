@@ -0,0 +1,133 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_BENCHMARK_H
+#define ENGINE_BENCHMARK_H
+
+#include <QTextStream>
+#include <QStringList>
+#include <QVector>
+
+//==============================================================
+//                      Benchmarks
+//==============================================================
+
+namespace engine
+{
+
+namespace Benchmark
+{
+    // positions: fixed suite of opening, middlegame and endgame positions in FEN
+    QStringList positions();
+
+    // benchPositions: the ~50 positions of the bench signature. Changing them,
+    //      or the default depth, changes the signature of every build
+    QStringList benchPositions();
+
+    // bench:
+    //      Searches every bench position to a fixed depth from an empty table and
+    //      returns the total node count. With one thread it's a signature of the search:
+    //      it changes with functional changes only, never with speed or the machine.
+    //      The time and nodes per second are printed along with it
+    quint64 bench(QTextStream &out, int depth, int threads, int hashMB);
+
+    // smpSpeedup:
+    //      Searches the suite to a fixed depth with every thread count and
+    //      reports time to depth along with the speedup against the first count
+    void smpSpeedup(QTextStream &out, int depth, const QVector<int> &threadCounts, int hashMB);
+
+    // moveOrdering:
+    //      Searches every position of the suite to a fixed depth in a single thread
+    //      without and with the ordering heuristics and compares the node counts
+    void moveOrdering(QTextStream &out, int depth, int hashMB);
+
+    // selectiveSearch:
+    //      Searches the suite to a fixed depth in a single thread with all the
+    //      selective search techniques, then with each of them switched off and
+    //      with none, and compares nodes, time to depth and the best moves found
+    void selectiveSearch(QTextStream &out, int depth, int hashMB);
+
+    // pawnHash:
+    //      Searches the suite to a fixed depth in a single thread with the classical
+    //      evaluation and reports the hit rate of the pawn table in every position,
+    //      then compares the time to depth with and without the table
+    void pawnHash(QTextStream &out, int depth, int hashMB);
+
+    // nnue:
+    //      Single thread evaluations per second of the neural network, both from
+    //      scratch and incrementally after every legal move of the suite positions.
+    //      An untrained random network is used if the file name is empty
+    bool nnue(QTextStream &out, const QString &networkFile);
+
+    // ponderLatency:
+    //      Plays the engine move in every suite position, then answers the expected reply
+    //      once without pondering and once after pondering for `opponentMs`, and compares
+    //      the time from the opponent move to the engine reply. Both sides have `clockMs` left
+    void ponderLatency(QTextStream &out, qint64 opponentMs, qint64 clockMs);
+
+    // stopLatency:
+    //      Runs an infinite search of every suite position for `searchMs` and measures
+    //      the time from Search::stop() to the result, the engine thread of the GUI
+    //      must answer a stop within a millisecond
+    void stopLatency(QTextStream &out, int threads, qint64 searchMs);
+
+    // bots:
+    //      Plays `games` bot games at once on a pool of `threads`, the levels taking turns
+    //      from game to game, for `seconds`. Reports the moves per second, the utilisation
+    //      of the pool and the longest wait every second, then the answer latency and the
+    //      nodes per move of every level: the weak bots must answer at once whatever
+    //      the strong ones are searching
+    void bots(QTextStream &out, int games, int threads, int seconds);
+
+    // book:
+    //      Probes the Polyglot book with the suite positions, the start position
+    //      after every pair of first moves and all their children, and reports
+    //      the time per probe along with the number of book hits
+    bool book(QTextStream &out, const QString &bookFile);
+
+    // pgn:
+    //      Reads the PGN file three times: the tokens of the mapped file only, the
+    //      tokens with every main line move resolved by the move generator, and the
+    //      games read by the text stream reader. Reports MB/s and games/s of each
+    bool pgn(QTextStream &out, const QString &pgnFile);
+
+    // pgnImport:
+    //      Imports the PGN file with 1, 2, 4, ... threads up to maxThreads and reports
+    //      games/s, moves/s and the speedup of each, and whether every thread count
+    //      gave the games in the same order
+    bool pgnImport(QTextStream &out, const QString &pgnFile, int maxThreads);
+
+    // gameCodec:
+    //      Imports the PGN file, encodes its games in the binary game format and decodes
+    //      them back. Reports the size against the PGN text, the bytes per game and per
+    //      move, the encoding and decoding speed, and whether the games came back the same
+    bool gameCodec(QTextStream &out, const QString &pgnFile);
+
+    // gameDatabase:
+    //      Appends the games of the PGN file, if given, to the database, rebuilds its
+    //      position index and searches positions of its games. Reports the time of the
+    //      index build, the search times and whether every game was found
+    bool gameDatabase(QTextStream &out, const QString &databaseFile, const QString &pgnFile);
+}
+
+}
+
+#endif//ENGINE_BENCHMARK_H
@@ -0,0 +1,147 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "bitboard.h"
+
+namespace engine
+{
+
+Bitboard Bitboards::pawnAttacks[2][64];
+Bitboard Bitboards::knightAttacks[64];
+Bitboard Bitboards::kingAttacks[64];
+Bitboard Bitboards::rays[DIRECTION_NB][64];
+Bitboard Bitboards::between[64][64];
+Bitboard Bitboards::line[64][64];
+int      Bitboards::distance[64][64];
+
+namespace
+{
+
+// File and rank steps for every eDirection
+const int directionFile[DIRECTION_NB] = { 0,  1, 1,  1,  0, -1, -1, -1 };
+const int directionRank[DIRECTION_NB] = { 1,  1, 0, -1, -1, -1,  0,  1 };
+
+bool isOnBoard(int file, int rank)
+{
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+// stepAttacks: squares reachable by a single (file, rank) step from each of the given offsets
+Bitboard stepAttacks(int square, const int (*steps)[2], int count)
+{
+    Bitboard attacks = 0;
+    for (auto i = 0; i < count; i++) {
+        int file = fileOf(square) + steps[i][0];
+        int rank = rankOf(square) + steps[i][1];
+        if (isOnBoard(file, rank))
+            attacks |= squareBB(makeSquare(file, rank));
+    }
+    return attacks;
+}
+
+bool initTables()
+{
+    const int knightSteps[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+    const int kingSteps[8][2]   = { {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1} };
+    const int whitePawn[2][2]   = { {-1, 1}, {1, 1} };
+    const int blackPawn[2][2]   = { {-1, -1}, {1, -1} };
+
+    for (auto square = 0; square < 64; square++) {
+        Bitboards::knightAttacks[square]     = stepAttacks(square, knightSteps, 8);
+        Bitboards::kingAttacks[square]       = stepAttacks(square, kingSteps, 8);
+        Bitboards::pawnAttacks[WHITE][square] = stepAttacks(square, whitePawn, 2);
+        Bitboards::pawnAttacks[BLACK][square] = stepAttacks(square, blackPawn, 2);
+
+        for (auto dir = 0; dir < DIRECTION_NB; dir++) {
+            Bitboard ray = 0;
+            int file = fileOf(square) + directionFile[dir];
+            int rank = rankOf(square) + directionRank[dir];
+            while (isOnBoard(file, rank)) {
+                ray |= squareBB(makeSquare(file, rank));
+                file += directionFile[dir];
+                rank += directionRank[dir];
+            }
+            Bitboards::rays[dir][square] = ray;
+        }
+    }
+
+    for (auto a = 0; a < 64; a++) {
+        for (auto b = 0; b < 64; b++) {
+            Bitboards::distance[a][b] = qMax(qAbs(fileOf(a) - fileOf(b)), qAbs(rankOf(a) - rankOf(b)));
+            Bitboards::between[a][b] = 0;
+            Bitboards::line[a][b] = 0;
+            if (a == b) continue;
+
+            for (auto dir = 0; dir < DIRECTION_NB; dir++) {
+                if (Bitboards::rays[dir][a] & squareBB(b)) {
+                    // the ray from b in the same direction is cut off the ray from a
+                    Bitboards::between[a][b] = Bitboards::rays[dir][a] & ~Bitboards::rays[dir][b] & ~squareBB(b);
+                    // opposite direction is dir + 4 modulo 8
+                    Bitboards::line[a][b] = Bitboards::rays[dir][a] |
+                                            Bitboards::rays[(dir + 4) % DIRECTION_NB][a] | squareBB(a);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// slidingAttack: attacks along one ray stopped by the first blocker.
+//      Rays going up the board are scanned from the lowest bit,
+//      rays going down - from the highest one
+inline Bitboard slidingAttack(eDirection dir, int square, Bitboard occupied)
+{
+    Bitboard attacks = Bitboards::rays[dir][square];
+    Bitboard blockers = attacks & occupied;
+    if (blockers) {
+        bool isForward = dir == NORTH || dir == NORTH_EAST || dir == EAST || dir == NORTH_WEST;
+        int blocker = isForward ? lsb(blockers) : msb(blockers);
+        attacks ^= Bitboards::rays[dir][blocker];
+    }
+    return attacks;
+}
+
+}
+
+void Bitboards::init()
+{
+    // C++11 guarantees thread safe initialization of function statics
+    static const bool isInitialized = initTables();
+    Q_UNUSED(isInitialized);
+}
+
+Bitboard bishopAttacks(int square, Bitboard occupied)
+{
+    return slidingAttack(NORTH_EAST, square, occupied) |
+           slidingAttack(SOUTH_EAST, square, occupied) |
+           slidingAttack(SOUTH_WEST, square, occupied) |
+           slidingAttack(NORTH_WEST, square, occupied);
+}
+
+Bitboard rookAttacks(int square, Bitboard occupied)
+{
+    return slidingAttack(NORTH, square, occupied) |
+           slidingAttack(EAST,  square, occupied) |
+           slidingAttack(SOUTH, square, occupied) |
+           slidingAttack(WEST,  square, occupied);
+}
+
+}
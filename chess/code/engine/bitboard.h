@@ -0,0 +1,133 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_BITBOARD_H
+#define ENGINE_BITBOARD_H
+
+#include <QtGlobal>
+
+#include "logic/notation.h"
+
+using namespace notation;
+
+//==============================================================
+//                    Bitboard primitives
+//==============================================================
+
+//    Square numbering follows eSquareNames: A1 = 0, B1 = 1, ..., H8 = 63.
+//    A bitboard holds one bit per square in the same order.
+
+namespace engine
+{
+
+typedef quint64 Bitboard;
+
+enum {
+    NO_SQUARE = 64
+};
+
+enum eDirection {
+    NORTH,
+    NORTH_EAST,
+    EAST,
+    SOUTH_EAST,
+    SOUTH,
+    SOUTH_WEST,
+    WEST,
+    NORTH_WEST,
+    DIRECTION_NB
+};
+
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard RANK_1_BB = 0xFFULL;
+const Bitboard RANK_2_BB = RANK_1_BB << 8;
+const Bitboard RANK_4_BB = RANK_1_BB << 24;
+const Bitboard RANK_5_BB = RANK_1_BB << 32;
+const Bitboard RANK_7_BB = RANK_1_BB << 48;
+const Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+inline int fileOf(int square) { return square & 7; }
+inline int rankOf(int square) { return square >> 3; }
+inline int makeSquare(int file, int rank) { return (rank << 3) | file; }
+// relativeRank: rank of the square as seen from the side of `color`, 0-7
+inline int relativeRank(eColor color, int square) { return color == WHITE ? rankOf(square) : 7 - rankOf(square); }
+inline eColor opposite(eColor color) { return color == WHITE ? BLACK : WHITE; }
+
+inline Bitboard squareBB(int square) { return 1ULL << square; }
+inline Bitboard fileBB(int square) { return FILE_A_BB << fileOf(square); }
+inline Bitboard rankBB(int square) { return RANK_1_BB << (8 * rankOf(square)); }
+
+inline int  popCount(Bitboard b) { return int(qPopulationCount(b)); }
+inline int  lsb(Bitboard b) { Q_ASSERT(b); return int(qCountTrailingZeroBits(b)); }
+inline int  msb(Bitboard b) { Q_ASSERT(b); return 63 - int(qCountLeadingZeroBits(b)); }
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+// popLsb: returns the lowest square of the bitboard and clears it
+inline int popLsb(Bitboard &b)
+{
+    const int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+inline Bitboard shiftNorth(Bitboard b) { return b << 8; }
+inline Bitboard shiftSouth(Bitboard b) { return b >> 8; }
+inline Bitboard shiftEast(Bitboard b)  { return (b & ~FILE_H_BB) << 1; }
+inline Bitboard shiftWest(Bitboard b)  { return (b & ~FILE_A_BB) >> 1; }
+
+//    Precomputed attack tables, filled once on the first use
+//    of the engine (see Bitboards::init)
+namespace Bitboards
+{
+    // init(): fills the tables; safe to call several times
+    void init();
+
+    extern Bitboard pawnAttacks[2][64];
+    extern Bitboard knightAttacks[64];
+    extern Bitboard kingAttacks[64];
+    // rays[direction][square] - squares from `square` to the edge, excluding the square itself
+    extern Bitboard rays[DIRECTION_NB][64];
+    // between[a][b] - squares strictly between a and b if they share a line, 0 otherwise
+    extern Bitboard between[64][64];
+    // line[a][b] - the whole line through a and b including both of them, 0 otherwise
+    extern Bitboard line[64][64];
+    extern int      distance[64][64];
+}
+
+// Sliding attacks for the given occupancy, the blocker square is included
+Bitboard bishopAttacks(int square, Bitboard occupied);
+Bitboard rookAttacks(int square, Bitboard occupied);
+inline Bitboard queenAttacks(int square, Bitboard occupied)
+{
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+// pawnAttacksBB: squares attacked by pawns of `color` standing on `pawns`
+inline Bitboard pawnAttacksBB(eColor color, Bitboard pawns)
+{
+    return color == WHITE ? shiftNorth(shiftEast(pawns) | shiftWest(pawns))
+                          : shiftSouth(shiftEast(pawns) | shiftWest(pawns));
+}
+
+}
+
+#endif//ENGINE_BITBOARD_H
@@ -0,0 +1,93 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_BOOK_H
+#define ENGINE_BOOK_H
+
+#include <QFile>
+#include <QVector>
+
+#include "position.h"
+
+//==============================================================
+//                      Opening book
+//==============================================================
+
+//    Polyglot opening book (.bin): entries of 16 bytes, big endian,
+//    sorted by the key of the position:
+//      quint64  Polyglot key of the position (not the engine Zobrist key)
+//      quint16  move: to file 0-2, to rank 3-5, from file 6-8, from rank 9-11,
+//               promotion 12-14 (1 knight ... 4 queen), castling is king takes own rook
+//      quint16  weight
+//      quint32  learn, not used
+//    The file is mapped read-only instead of being read, so a book of any size
+//    costs address space only and a probe is a binary search over the mapping.
+
+namespace engine
+{
+
+struct BookMove {
+    Move    move;
+    quint16 weight;
+};
+
+class Book {
+public:
+    Book();
+    ~Book();
+
+    // open: maps the book file, the previous book is closed even on failure
+    bool    open(const QString &fileName);
+    void    close();
+    bool    isOpen() const { return m_entries != nullptr; }
+    QString fileName() const { return m_file.fileName(); }
+    qint64  entries() const { return m_count; }
+
+    // moves: legal book moves of the position, the heaviest first
+    QVector<BookMove> moves(const Position &pos) const;
+    // probe: one of the book moves picked in proportion to the weights, NO_MOVE
+    //      out of book. `random` is any 32-bit random value
+    Move    probe(const Position &pos, quint32 random) const;
+    // probe: the same with the own random generator, a Book is used by one thread
+    //      at a time. Threads sharing a book file open it each, the pages are shared
+    Move    probe(const Position &pos);
+
+    // key: Polyglot key of the position
+    static Key key(const Position &pos);
+
+private:
+    Q_DISABLE_COPY(Book)
+
+    // m_lowerBound: index of the first entry with the key not less than the given one
+    qint64  m_lowerBound(Key key) const;
+    Key     m_entryKey(qint64 idx) const;
+    // m_decodeMove: the legal move of the position matching the Polyglot move, NO_MOVE if none
+    Move    m_decodeMove(const Position &pos, quint16 bookMove) const;
+
+    QFile        m_file;
+    const uchar *m_entries;
+    qint64       m_count;
+    quint64      m_random; // xorshift64 state
+};
+
+}
+
+#endif//ENGINE_BOOK_H
@@ -0,0 +1,343 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "bots.h"
+#include "movegen.h"
+
+#include <QtAlgorithms>
+
+namespace engine
+{
+
+namespace
+{
+
+// lines searched by the bots playing with noise
+const int SKILL_LINES = 4;
+// the noise never pushes a move by much more than a pawn
+const int SKILL_PAWN = 100;
+// nodes of a slice, a few milliseconds: the longest a thread is held by one game
+const qint64 SLICE_NODES = 20000;
+
+//    nodes, depth, skill and hash of the levels from the weakest one,
+//    every level spends about three times the nodes of the previous one;
+//    the two strongest evaluate with the network when one is loaded
+struct LevelLimits {
+    qint64 nodes;
+    int    depth;
+    int    skill;
+    int    hashMB;
+    bool   useNnue;
+};
+
+const LevelLimits levels[] = {
+    {     200,  1,  0,  1, false },
+    {    1000,  2,  3,  1, false },
+    {    5000,  4,  6,  1, false },
+    {   20000,  6,  9,  2, false },
+    {   60000,  8, 12,  4, false },
+    {  200000, 10, 15,  8, false },
+    {  600000, 14, 18, 16, true  },
+    { 2000000, 20, 20, 16, true  }
+};
+
+}
+
+//==============================================================
+//                          Bots
+//==============================================================
+
+int Bots::levelCount()
+{
+    return int(sizeof(levels) / sizeof(levels[0]));
+}
+
+BotProfile Bots::level(int level)
+{
+    level = qBound(1, level, levelCount());
+    const LevelLimits &limits = levels[level - 1];
+
+    BotProfile profile;
+    profile.name   = QString("Level %1").arg(level);
+    profile.level  = level;
+    profile.nodes  = limits.nodes;
+    profile.depth  = limits.depth;
+    profile.skill  = limits.skill;
+    profile.hashMB = limits.hashMB;
+    profile.useNnue = limits.useNnue;
+    return profile;
+}
+
+//==============================================================
+//                          BotThread
+//==============================================================
+
+void BotThread::run()
+{
+    m_scheduler->m_work();
+}
+
+//==============================================================
+//                          BotScheduler
+//==============================================================
+
+BotScheduler::BotScheduler(const MoveCallback &callback, int threads) :
+    m_callback(callback), m_nextId(1), m_quit(false), m_served(0),
+    m_busyTime(0), m_moves(0), m_slices(0), m_nodes(0), m_totalLatency(0), m_maxLatency(0), m_maxWait(0)
+{
+    if (threads <= 0)
+        threads = qMax(1, QThread::idealThreadCount() - 1);
+    m_clock.start();
+    for (auto i = 0; i < threads; i++) {
+        m_threads.append(new BotThread(this));
+        m_threads.last()->start(QThread::LowPriority);
+    }
+}
+
+BotScheduler::~BotScheduler()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_queueChanged.wakeAll();
+    m_mutex.unlock();
+
+    for (auto thread : m_threads)
+        thread->wait();
+    qDeleteAll(m_threads);
+    qDeleteAll(m_games);
+}
+
+int BotScheduler::addGame(const BotProfile &profile, quint64 seed)
+{
+    Game *game = new Game;
+    game->profile = profile;
+    game->random  = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    game->pending = game->running = game->removed = false;
+    game->depth   = 0;
+    game->nodes   = 0;
+    game->sliceNodes = SLICE_NODES;
+    game->served  = 0;
+    game->queuedAt = 0;
+    game->search.setThreads(1);
+    game->search.setHashSize(profile.hashMB);
+    SearchOptions options = game->search.options();
+    options.useNnue = profile.useNnue;
+    game->search.setOptions(options);
+    game->search.newGame();
+    // the lines of an iteration come best first once it is complete
+    game->search.setInfoCallback([game](const SearchInfo &info) {
+        if (info.multiPv == 1)
+            game->lines.clear();
+        PvLine line;
+        line.score = info.score;
+        line.pv = info.pv;
+        game->lines.append(line);
+    });
+
+    QMutexLocker locker(&m_mutex);
+    const int id = m_nextId++;
+    m_games.insert(id, game);
+    return id;
+}
+
+void BotScheduler::removeGame(int game)
+{
+    QMutexLocker locker(&m_mutex);
+    Game *removed = m_games.take(game);
+    if (!removed)
+        return;
+    // a thread searching it deletes it once the slice is over
+    if (removed->running)
+        removed->removed = true;
+    else
+        delete removed;
+}
+
+void BotScheduler::requestMove(int game, const Position &pos)
+{
+    QMutexLocker locker(&m_mutex);
+    Game *requested = m_games.value(game);
+    if (!requested)
+        return;
+    Q_ASSERT(!requested->pending);
+
+    requested->pos     = pos;
+    requested->pending = true;
+    requested->depth   = 0;
+    requested->nodes   = 0;
+    requested->sliceNodes = SLICE_NODES;
+    requested->served  = qMax(requested->served, m_served);
+    requested->lines.clear();
+    requested->result  = SearchResult();
+    requested->requested.start();
+    requested->queuedAt = m_clock.elapsed();
+    m_queueChanged.wakeOne();
+}
+
+BotStats BotScheduler::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    BotStats stats;
+    stats.threads = m_threads.size();
+    stats.games   = m_games.size();
+    stats.pending = 0;
+    for (auto game : m_games)
+        stats.pending += game->pending ? 1 : 0;
+    stats.moves  = m_moves;
+    stats.slices = m_slices;
+    stats.nodes  = m_nodes;
+    const qint64 running = m_clock.nsecsElapsed() * m_threads.size();
+    stats.utilisation    = running > 0 ? double(m_busyTime) / running : 0;
+    stats.averageLatency = m_moves > 0 ? double(m_totalLatency) / m_moves : 0;
+    stats.maxLatency     = m_maxLatency;
+    stats.maxWait        = m_maxWait;
+    return stats;
+}
+
+void BotScheduler::m_work()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        Game *game = Q_NULLPTR;
+        while (!m_quit && !(game = m_next()))
+            m_queueChanged.wait(&m_mutex);
+        if (m_quit)
+            return;
+        game->running = true;
+        m_served = qMax(m_served, game->served);
+        m_maxWait = qMax(m_maxWait, m_clock.elapsed() - game->queuedAt);
+        locker.unlock();
+
+        // the game is searched by this thread only, nobody else touches it but the flags
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 nodesBefore = game->nodes;
+        const bool isDone = m_searchSlice(game);
+        BotMove answer;
+        if (isDone) {
+            answer.move    = m_pickMove(game);
+            answer.score   = game->result.score;
+            answer.depth   = game->result.depth;
+            answer.nodes   = game->nodes;
+            answer.latency = game->requested.elapsed();
+        }
+        const qint64 busy = timer.nsecsElapsed();
+
+        locker.relock();
+        m_busyTime += busy;
+        m_slices++;
+        m_nodes += game->nodes - nodesBefore;
+        game->served += game->nodes - nodesBefore;
+        game->running = false;
+        if (game->removed) {
+            delete game;
+            continue;
+        }
+        if (!isDone) {
+            game->queuedAt = m_clock.elapsed();
+            continue;
+        }
+
+        game->pending = false;
+        m_moves++;
+        m_totalLatency += answer.latency;
+        m_maxLatency = qMax(m_maxLatency, answer.latency);
+        const int id = m_games.key(game);
+        locker.unlock();
+        m_callback(id, answer);
+        locker.relock();
+    }
+}
+
+BotScheduler::Game *BotScheduler::m_next()
+{
+    Game *next = Q_NULLPTR;
+    for (auto game : m_games) {
+        if (!game->pending || game->running)
+            continue;
+        if (!next || game->served < next->served || (game->served == next->served && game->queuedAt < next->queuedAt))
+            next = game;
+    }
+    return next;
+}
+
+bool BotScheduler::m_searchSlice(Game *game)
+{
+    const BotProfile &profile = game->profile;
+
+    // the shallower iterations are mostly cut by the transposition table of the previous slices,
+    // an iteration stopped by the slice limit goes on from the entries it has stored
+    SearchLimits limits;
+    limits.depth   = game->depth + 1;
+    limits.multiPv = profile.skill < 20 ? SKILL_LINES : 1;
+    limits.nodes   = game->sliceNodes;
+    if (profile.nodes > 0)
+        limits.nodes = qMin(limits.nodes, profile.nodes - game->nodes);
+
+    const SearchResult result = game->search.go(game->pos, limits);
+    game->nodes += result.nodes;
+    const bool isComplete = result.depth > game->depth;
+    if (isComplete || game->result.bestMove == NO_MOVE) {
+        game->result = result;
+        game->depth  = qMax(game->depth, result.depth);
+    }
+    // an iteration longer than a slice can't go on forever
+    game->sliceNodes = isComplete ? SLICE_NODES : game->sliceNodes * 2;
+
+    MoveList moves;
+    generateLegalMoves(game->pos, moves);
+    return game->depth >= profile.depth
+        || (profile.nodes > 0 && game->nodes >= profile.nodes)
+        || isMateScore(game->result.score)
+        || moves.size() == 1;
+}
+
+Move BotScheduler::m_pickMove(Game *game)
+{
+    const int skill = game->profile.skill;
+    const QVector<PvLine> &lines = game->lines;
+    if (skill >= 20 || lines.size() < 2)
+        return game->result.bestMove;
+
+    // every line gets a random push, larger for a weaker bot and for
+    // lines further behind the best one, the highest pushed score is played
+    const int weakness = 120 - 2 * skill;
+    const int top = lines.first().score;
+    const int delta = qMin(top - lines.last().score, SKILL_PAWN);
+    Move move = game->result.bestMove;
+    int bestScore = -VALUE_INFINITE;
+    for (const PvLine &line : lines) {
+        if (line.pv.isEmpty())
+            continue;
+        game->random ^= game->random >> 12;
+        game->random ^= game->random << 25;
+        game->random ^= game->random >> 27;
+        const quint64 random = game->random * 0x2545F4914F6CDD1DULL;
+        const int push = (weakness * (top - line.score) + delta * int(random % quint64(weakness))) / 128;
+        if (line.score + push > bestScore) {
+            bestScore = line.score + push;
+            move = line.pv.first();
+        }
+    }
+    return move;
+}
+
+}
@@ -0,0 +1,190 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_BOTS_H
+#define ENGINE_BOTS_H
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <functional>
+
+#include "search.h"
+
+//==============================================================
+//                      Bots
+//==============================================================
+
+//    Bots play many games at once on a fixed pool of threads. A profile
+//    caps the nodes and the depth of every move, so the CPU a move takes is
+//    bounded whatever the position. The weaker profiles search several lines
+//    and pick a move with noise, a worse move the further it is behind.
+//
+//    The scheduler searches a move in short slices: each slice goes one
+//    depth deeper from the transposition table of the game, or as far as it
+//    gets within a few thousand nodes, then the thread goes back to the queue and takes the pending move of the game
+//    with the fewest nodes searched so far, so every game gets the same share
+//    of the pool. A game coming back with a new request starts from the nodes
+//    of the games being served: the time it has spent waiting for its opponent
+//    doesn't give it a credit over the others. A deep search of a strong bot is
+//    thus interleaved with the quick moves of the others instead of holding
+//    a thread until it is over. The pool threads run with a low priority and leave a core to the
+//    rest of the program by default, so the network thread isn't starved.
+
+namespace engine
+{
+
+//    BotProfile limits the work of a bot on every move
+struct BotProfile {
+    BotProfile() : level(0), nodes(0), depth(MAX_PLY - 1), skill(20), hashMB(16), useNnue(false) {}
+
+    QString name;
+    int     level;
+    qint64  nodes;  // hard cap on the nodes of a move, 0 for none
+    int     depth;  // deepest iteration
+    int     skill;  // 0 to 20, below 20 the move is picked among the best lines with noise
+    int     hashMB; // transposition table of each game
+    bool    useNnue; // the network evaluation if a network is loaded, the classical one otherwise
+};
+
+namespace Bots
+{
+    int         levelCount();
+    // level: the profile of a level from 1 (a beginner) to levelCount()
+    BotProfile  level(int level);
+}
+
+//    BotMove is the answer to a move request
+struct BotMove {
+    Move   move;
+    int    score;   // of the best line, from the side to move point of view
+    int    depth;
+    qint64 nodes;
+    qint64 latency; // milliseconds from the request to the answer
+};
+
+//    BotStats are counted since the start of the scheduler
+struct BotStats {
+    int    threads;
+    int    games;
+    int    pending;        // moves requested and not answered yet
+    qint64 moves;          // moves answered
+    qint64 slices;
+    qint64 nodes;
+    double utilisation;    // busy time of the threads over their running time, 0 to 1
+    double averageLatency; // milliseconds
+    qint64 maxLatency;
+    qint64 maxWait;        // longest time a pending move has waited for a thread
+};
+
+class BotScheduler;
+
+//    BotThread is a thread of the pool
+class BotThread : public QThread {
+public:
+    explicit BotThread(BotScheduler *scheduler) : m_scheduler(scheduler) {}
+
+protected:
+    void run();
+
+private:
+    BotScheduler *m_scheduler;
+};
+
+//    BotScheduler serves the move requests of all the bot games, all the
+//    methods may be called from any thread
+class BotScheduler {
+public:
+    // MoveCallback: called from a pool thread without any lock held,
+    //      it may request the next move at once
+    typedef std::function<void(int game, const BotMove &move)> MoveCallback;
+
+    // threads: the size of the pool, all the hardware threads but one if 0
+    explicit BotScheduler(const MoveCallback &callback, int threads = 0);
+    ~BotScheduler();
+
+    // addGame: returns the id of the game, the seed makes the noise of weak bots reproducible
+    int     addGame(const BotProfile &profile, quint64 seed = 0);
+    // removeGame: a pending move is dropped without an answer
+    void    removeGame(int game);
+    // requestMove: one move at a time per game, the position must have legal moves
+    void    requestMove(int game, const Position &pos);
+
+    BotStats stats() const;
+
+private:
+    Q_DISABLE_COPY(BotScheduler)
+    friend class BotThread;
+
+    //    Game is a bot playing one game, with its own search and hash table
+    struct Game {
+        BotProfile      profile;
+        Search          search;
+        Position        pos;
+        quint64         random;   // xorshift64* state of the skill noise
+        bool            pending;  // a move has been requested
+        bool            running;  // a slice of it is being searched
+        bool            removed;  // deleted when the running slice is over
+        int             depth;    // completed so far on the requested move
+        qint64          nodes;
+        qint64          sliceNodes; // limit of the next slice, doubled after a slice without a new iteration
+        qint64          served;   // nodes searched in the whole game, its share of the pool
+        QVector<PvLine> lines;    // of the last completed iteration
+        SearchResult    result;
+        QElapsedTimer   requested;
+        qint64          queuedAt; // scheduler time the move has been put back into the queue
+    };
+
+    // m_work: the loop of a pool thread
+    void    m_work();
+    // m_next: the pending move of the game served least, the one waiting longest among equals
+    Game   *m_next();
+    // m_searchSlice: one iteration deeper at most, true if the move is done
+    bool    m_searchSlice(Game *game);
+    // m_pickMove: the best move, or a worse one with the noise of the skill level
+    Move    m_pickMove(Game *game);
+
+    MoveCallback        m_callback;
+    QVector<BotThread*> m_threads;
+    QMap<int, Game*>    m_games;
+    int                 m_nextId;
+    bool                m_quit;
+    qint64              m_served; // of the last game taken from the queue
+
+    mutable QMutex      m_mutex; // guards everything above and the statistics
+    QWaitCondition      m_queueChanged;
+    QElapsedTimer       m_clock;
+    qint64              m_busyTime; // nanoseconds spent searching by all the threads
+    qint64              m_moves;
+    qint64              m_slices;
+    qint64              m_nodes;
+    qint64              m_totalLatency;
+    qint64              m_maxLatency;
+    qint64              m_maxWait;
+};
+
+}
+
+#endif//ENGINE_BOTS_H
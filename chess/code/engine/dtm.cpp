@@ -0,0 +1,844 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "dtm.h"
+#include "parallel.h"
+#include "material.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+//    Generation works backwards from the mates. Plies are resolved level by level:
+//    the positions mated in n plies make their predecessors wins in n + 1,
+//    the positions won in n plies take one refutation off the counter of their
+//    predecessors, and a position whose counter drops to zero is lost in n + 1.
+//    Moves leaving the material set (captures, promotions) are resolved at once
+//    from the smaller tables and delay a result to the level they lead to.
+//    Every level runs on all the threads: each owns a slice of the indices,
+//    predecessors found by the others are handed over to the owner of their slice,
+//    so no table byte is ever written by two threads.
+
+namespace engine
+{
+
+namespace
+{
+
+enum {
+    HEADER_SIZE  = 32,
+    FILE_VERSION = 1,
+
+    // table values: 0 a draw, plies to mate + 1, VALUE_ILLEGAL for the indices of no position
+    VALUE_ILLEGAL = 255,
+    MAX_DTM_PLIES = 253,
+
+    CANNOT_LOSE = 255, // exit loss of a position with a drawing or winning capture or promotion
+    MAX_MOVES   = 128
+};
+
+const char fileMagic[4] = {'D', 'T', 'M', 'T'};
+const char tableSuffix[] = ".dtm";
+const char sideOrder[] = "QRBNP";         // pieces of a side in a table name after its king
+const int  pieceValues[6] = {1, 3, 3, 5, 9, 0};
+
+//    Setup is a position of a table without the engine state: pieces in any order
+struct Setup {
+    int    count;
+    int    piece[Dtm::DTM_PIECES];
+    int    square[Dtm::DTM_PIECES];
+    eColor stm;
+};
+
+//    Table is one material set, registered with both material keys:
+//    the first side of the name (KQv of KQvK) as WHITE and as BLACK
+struct Table {
+    Table() : key(0), key2(0), pieceCount(0), hasPawns(false), size(0), longest(0), values(nullptr) {}
+
+    QString      name;     // KQvK
+    quint32      key;
+    quint32      key2;
+    int          pieceCount;
+    int          pieces[Dtm::DTM_PIECES]; // ePiece by slot: WHITE and BLACK king, WHITE pieces, BLACK pieces
+    bool         hasPawns;
+    quint64      size;
+    int          longest;  // plies of the longest mate
+    QFile        file;
+    QByteArray   memory;   // values of a table generated and not mapped
+    const uchar *values;
+};
+
+QVector<Table*>        tables;
+QHash<quint32, Table*> registry;
+int                    maxPieceCount = 0;
+
+// Encoding tables, see initEncoding()
+int  kingIndex[2][64];  // [hasPawns][square] of the WHITE king, -1 out of the king area
+int  kingSquare[2][32];
+int  symmetry[8][64];   // bit 0 flips the files, bit 1 the ranks, bit 2 the diagonal
+bool isEncodingReady = false;
+
+// initEncoding: the king area is the a1-d1-d4 triangle without pawns, the a-d files with pawns
+void initEncoding()
+{
+    if (isEncodingReady)
+        return;
+    Bitboards::init();
+
+    int count[2] = {0, 0};
+    for (auto square = 0; square < 64; square++) {
+        const int file = fileOf(square), rank = rankOf(square);
+        kingIndex[0][square] = kingIndex[1][square] = -1;
+        if (file <= 3 && rank <= file) {
+            kingSquare[0][count[0]] = square;
+            kingIndex[0][square] = count[0]++;
+        }
+        if (file <= 3) {
+            kingSquare[1][count[1]] = square;
+            kingIndex[1][square] = count[1]++;
+        }
+        for (auto t = 0; t < 8; t++) {
+            int f = t & 1 ? 7 - file : file;
+            int r = t & 2 ? 7 - rank : rank;
+            symmetry[t][square] = t & 4 ? makeSquare(r, f) : makeSquare(f, r);
+        }
+    }
+    isEncodingReady = true;
+}
+
+inline int flipColor(int piece) { return piece < B_PAWN ? piece + B_PAWN : piece - B_PAWN; }
+inline int kingAreaSize(const Table *table) { return table->hasPawns ? 32 : 10; }
+
+//==============================================================
+//                      Material
+//==============================================================
+
+void countPieces(const Setup &setup, int counts[2][6])
+{
+    std::memset(counts, 0, sizeof(int) * 12);
+    for (auto i = 0; i < setup.count; i++)
+        counts[colorOf(setup.piece[i])][typeOf(setup.piece[i])]++;
+}
+
+quint32 materialKey(const Setup &setup)
+{
+    int counts[2][6];
+    countPieces(setup, counts);
+    return Material::key(counts, false);
+}
+
+QString sideName(const int counts[6])
+{
+    QString name("K");
+    for (auto i = 0; sideOrder[i] != '\0'; i++)
+        name += QString(counts[std::strchr(Material::pieceLetters, sideOrder[i]) - Material::pieceLetters], QChar(sideOrder[i]));
+    return name;
+}
+
+// isStronger: the side named first, by material value, then by the number of pieces
+bool isStronger(const int side[6], const int other[6])
+{
+    int value[2] = {0, 0}, pieces[2] = {0, 0};
+    for (auto type = 0; type < 6; type++) {
+        value[0] += side[type] * pieceValues[type];
+        value[1] += other[type] * pieceValues[type];
+        pieces[0] += side[type];
+        pieces[1] += other[type];
+    }
+    if (value[0] != value[1])
+        return value[0] > value[1];
+    if (pieces[0] != pieces[1])
+        return pieces[0] > pieces[1];
+    return sideName(side) > sideName(other);
+}
+
+// normalize: the stronger side as WHITE, the order of the table name
+void normalize(int counts[2][6])
+{
+    if (isStronger(counts[1], counts[0]))
+        for (auto type = 0; type < 6; type++)
+            std::swap(counts[0][type], counts[1][type]);
+}
+
+int pieceCount(const int counts[2][6])
+{
+    int count = 0;
+    for (auto color = 0; color < 2; color++)
+        for (auto type = 0; type < 6; type++)
+            count += counts[color][type];
+    return count;
+}
+
+// setupTable: name, keys and slots of the normalized material
+void setupTable(Table *table, const int counts[2][6])
+{
+    table->name = sideName(counts[0]) + 'v' + sideName(counts[1]);
+    table->key = Material::key(counts, false);
+    table->key2 = Material::key(counts, true);
+    table->pieceCount = pieceCount(counts);
+    table->hasPawns = counts[WHITE][PAWN] + counts[BLACK][PAWN] > 0;
+
+    int slot = 0;
+    table->pieces[slot++] = W_KING;
+    table->pieces[slot++] = B_KING;
+    for (auto color = 0; color < 2; color++)
+        for (auto i = 0; sideOrder[i] != '\0'; i++) {
+            const int type = int(std::strchr(Material::pieceLetters, sideOrder[i]) - Material::pieceLetters);
+            for (auto n = 0; n < counts[color][type]; n++)
+                table->pieces[slot++] = color * 6 + type;
+        }
+
+    table->size = 2 * quint64(kingAreaSize(table));
+    for (auto i = 1; i < table->pieceCount; i++)
+        table->size *= 64;
+}
+
+//==============================================================
+//                      Index
+//==============================================================
+
+// encode: index of the squares by slot, the WHITE king within the king area
+quint64 encode(const Table *table, const int *squares, eColor stm)
+{
+    quint64 idx = quint64(stm) * kingAreaSize(table) + kingIndex[table->hasPawns][squares[0]];
+    for (auto slot = 1; slot < table->pieceCount; slot++)
+        idx = idx * 64 + squares[slot];
+    return idx;
+}
+
+void decode(const Table *table, quint64 idx, int *squares, eColor *stm)
+{
+    for (auto slot = table->pieceCount - 1; slot > 0; slot--) {
+        squares[slot] = int(idx % 64);
+        idx /= 64;
+    }
+    squares[0] = kingSquare[table->hasPawns][idx % kingAreaSize(table)];
+    *stm = eColor(idx / kingAreaSize(table));
+}
+
+// canonicalIndex: the least index of the symmetric positions, equal pieces sorted by square.
+//      Every position of a class of symmetric ones has the same index
+quint64 canonicalIndex(const Table *table, const int *squares, eColor stm)
+{
+    quint64 best = ~quint64(0);
+    const int symmetries = table->hasPawns ? 2 : 8;
+    for (auto t = 0; t < symmetries; t++) {
+        int mapped[Dtm::DTM_PIECES];
+        for (auto slot = 0; slot < table->pieceCount; slot++)
+            mapped[slot] = symmetry[t][squares[slot]];
+        if (kingIndex[table->hasPawns][mapped[0]] < 0)
+            continue;
+        for (auto slot = 2; slot < table->pieceCount; slot++)
+            for (auto k = slot; k > 2 && table->pieces[k - 1] == table->pieces[k] && mapped[k - 1] > mapped[k]; k--)
+                std::swap(mapped[k - 1], mapped[k]);
+        best = qMin(best, encode(table, mapped, stm));
+    }
+    return best;
+}
+
+// indexOf: index of a position of the table's material, either color as the first side
+quint64 indexOf(const Table *table, const Setup &setup)
+{
+    const bool flip = table->key != table->key2 && materialKey(setup) != table->key;
+    int squares[Dtm::DTM_PIECES];
+    bool isUsed[Dtm::DTM_PIECES] = {false, false, false, false};
+    for (auto slot = 0; slot < table->pieceCount; slot++)
+        for (auto i = 0; i < setup.count; i++) {
+            const int piece = flip ? flipColor(setup.piece[i]) : setup.piece[i];
+            if (!isUsed[i] && piece == table->pieces[slot]) {
+                isUsed[i] = true;
+                squares[slot] = flip ? setup.square[i] ^ 56 : setup.square[i];
+                break;
+            }
+        }
+    return canonicalIndex(table, squares, flip ? opposite(setup.stm) : setup.stm);
+}
+
+//==============================================================
+//                      Moves
+//==============================================================
+
+Bitboard attacksFrom(int piece, int square, Bitboard occupied)
+{
+    switch (typeOf(piece)) {
+    case PAWN:   return Bitboards::pawnAttacks[colorOf(piece)][square];
+    case KNIGHT: return Bitboards::knightAttacks[square];
+    case BISHOP: return bishopAttacks(square, occupied);
+    case ROOK:   return rookAttacks(square, occupied);
+    case QUEEN:  return queenAttacks(square, occupied);
+    default:     return Bitboards::kingAttacks[square];
+    }
+}
+
+Bitboard occupancy(const Setup &setup)
+{
+    Bitboard occupied = 0;
+    for (auto i = 0; i < setup.count; i++)
+        occupied |= squareBB(setup.square[i]);
+    return occupied;
+}
+
+int kingOf(const Setup &setup, eColor color)
+{
+    for (auto i = 0; i < setup.count; i++)
+        if (setup.piece[i] == color * 6 + KING)
+            return setup.square[i];
+    return 0;
+}
+
+bool isAttacked(const Setup &setup, int square, eColor byColor)
+{
+    const Bitboard occupied = occupancy(setup);
+    for (auto i = 0; i < setup.count; i++)
+        if (colorOf(setup.piece[i]) == byColor && (attacksFrom(setup.piece[i], setup.square[i], occupied) & squareBB(square)))
+            return true;
+    return false;
+}
+
+bool inCheck(const Setup &setup)
+{
+    return isAttacked(setup, kingOf(setup, setup.stm), opposite(setup.stm));
+}
+
+// forEachMove: calls visit(next, staysInTable) for every legal move,
+//      captures and promotions leave the material set of the table
+template <typename Visitor>
+void forEachMove(const Setup &setup, Visitor visit)
+{
+    const eColor us = setup.stm;
+    const Bitboard occupied = occupancy(setup);
+    Bitboard own = 0;
+    for (auto i = 0; i < setup.count; i++)
+        if (colorOf(setup.piece[i]) == us)
+            own |= squareBB(setup.square[i]);
+
+    for (auto i = 0; i < setup.count; i++) {
+        const int piece = setup.piece[i];
+        if (colorOf(piece) != us)
+            continue;
+        const int from = setup.square[i];
+
+        Bitboard targets;
+        if (typeOf(piece) == PAWN) {
+            const int push = us == WHITE ? 8 : -8;
+            targets = Bitboards::pawnAttacks[us][from] & occupied & ~own;
+            if (!(occupied & squareBB(from + push))) {
+                targets |= squareBB(from + push);
+                if (relativeRank(us, from) == 1 && !(occupied & squareBB(from + 2 * push)))
+                    targets |= squareBB(from + 2 * push);
+            }
+        } else {
+            targets = attacksFrom(piece, from, occupied) & ~own;
+        }
+
+        while (targets) {
+            const int to = popLsb(targets);
+            Setup next = setup;
+            next.stm = opposite(us);
+            int moved = i;
+            bool isCapture = false;
+            for (auto j = 0; j < next.count; j++)
+                if (next.square[j] == to) {
+                    isCapture = true;
+                    next.count--;
+                    next.piece[j] = next.piece[next.count];
+                    next.square[j] = next.square[next.count];
+                    if (moved == next.count)
+                        moved = j;
+                    break;
+                }
+            next.square[moved] = to;
+            if (isAttacked(next, kingOf(next, us), next.stm))
+                continue;
+
+            if (typeOf(piece) == PAWN && relativeRank(us, to) == 7) {
+                for (auto type = int(QUEEN); type >= int(KNIGHT); type--) {
+                    next.piece[moved] = us * 6 + type;
+                    visit(next, false);
+                }
+            } else {
+                visit(next, !isCapture);
+            }
+        }
+    }
+}
+
+// forEachUnmove: calls visit(previous) for every position a move without capture
+//      or promotion leads from to this one. The previous positions may be illegal
+template <typename Visitor>
+void forEachUnmove(const Setup &setup, Visitor visit)
+{
+    const eColor them = opposite(setup.stm); // the side that has just moved
+    const Bitboard occupied = occupancy(setup);
+
+    for (auto i = 0; i < setup.count; i++) {
+        const int piece = setup.piece[i];
+        if (colorOf(piece) != them)
+            continue;
+        const int to = setup.square[i];
+
+        Bitboard origins;
+        if (typeOf(piece) == PAWN) {
+            const int push = them == WHITE ? 8 : -8;
+            origins = 0;
+            if (relativeRank(them, to) >= 2 && !(occupied & squareBB(to - push))) {
+                origins |= squareBB(to - push);
+                if (relativeRank(them, to) == 3 && !(occupied & squareBB(to - 2 * push)))
+                    origins |= squareBB(to - 2 * push);
+            }
+        } else {
+            origins = attacksFrom(piece, to, occupied) & ~occupied;
+        }
+
+        while (origins) {
+            Setup previous = setup;
+            previous.square[i] = popLsb(origins);
+            previous.stm = them;
+            visit(previous);
+        }
+    }
+}
+
+// decodeLegal: the position of the index, false if the index is of no legal position
+bool decodeLegal(const Table *table, quint64 idx, Setup *setup)
+{
+    int squares[Dtm::DTM_PIECES];
+    eColor stm;
+    decode(table, idx, squares, &stm);
+
+    Bitboard occupied = 0;
+    for (auto slot = 0; slot < table->pieceCount; slot++) {
+        const Bitboard b = squareBB(squares[slot]);
+        if (occupied & b)
+            return false;
+        if (typeOf(table->pieces[slot]) == PAWN && (rankOf(squares[slot]) == 0 || rankOf(squares[slot]) == 7))
+            return false;
+        occupied |= b;
+    }
+    if (Bitboards::distance[squares[0]][squares[1]] <= 1 || canonicalIndex(table, squares, stm) != idx)
+        return false;
+
+    setup->count = table->pieceCount;
+    setup->stm = stm;
+    for (auto slot = 0; slot < table->pieceCount; slot++) {
+        setup->piece[slot] = table->pieces[slot];
+        setup->square[slot] = squares[slot];
+    }
+    // the side that has just moved can't be in check
+    return !isAttacked(*setup, kingOf(*setup, opposite(stm)), stm);
+}
+
+//==============================================================
+//                      Files
+//==============================================================
+
+//    Header of a .dtm file, little endian:
+//      char     magic[4]  DTMT
+//      quint8   version, piece count, has pawns, plies of the longest mate
+//      quint8   pieces[4] ePiece by slot
+//      quint32  reserved
+//      quint64  number of values
+//      quint64  reserved
+bool writeTable(const Table *table, const QString &fileName, QString *error)
+{
+    uchar header[HEADER_SIZE];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, fileMagic, sizeof(fileMagic));
+    header[4] = FILE_VERSION;
+    header[5] = uchar(table->pieceCount);
+    header[6] = table->hasPawns ? 1 : 0;
+    header[7] = uchar(table->longest);
+    for (auto slot = 0; slot < table->pieceCount; slot++)
+        header[8 + slot] = uchar(table->pieces[slot]);
+    qToLittleEndian<quint64>(table->size, header + 16);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char*>(header), HEADER_SIZE) != HEADER_SIZE ||
+        file.write(reinterpret_cast<const char*>(table->values), qint64(table->size)) != qint64(table->size)) {
+        *error = QString("can't write %1: %2").arg(fileName).arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+// mapTable: maps the values of the table file, false if it isn't a table of the material
+bool mapTable(Table *table, const QString &fileName)
+{
+    table->file.setFileName(fileName);
+    if (!table->file.open(QIODevice::ReadOnly) || table->file.size() != HEADER_SIZE + qint64(table->size))
+        return false;
+    const uchar *data = table->file.map(0, table->file.size());
+    if (data == nullptr)
+        return false;
+
+    bool isValid = std::memcmp(data, fileMagic, sizeof(fileMagic)) == 0 && data[4] == FILE_VERSION &&
+                   data[5] == table->pieceCount && qFromLittleEndian<quint64>(data + 16) == table->size;
+    for (auto slot = 0; isValid && slot < table->pieceCount; slot++)
+        isValid = data[8 + slot] == table->pieces[slot];
+    if (!isValid) {
+        table->file.unmap(const_cast<uchar*>(data));
+        table->file.close();
+        return false;
+    }
+    table->longest = data[7];
+    table->values = data + HEADER_SIZE;
+    return true;
+}
+
+//==============================================================
+//                      Generation
+//==============================================================
+
+class Generator {
+public:
+    Generator(const QString &directory, int threads, QTextStream &out)
+        : m_directory(directory), m_threads(qMax(1, threads)), m_out(out) {}
+    ~Generator() { qDeleteAll(m_tables); }
+
+    // ensure: the table of the normalized material is read or generated, with its smaller tables
+    bool ensure(const int counts[2][6], QString *error);
+
+private:
+    bool m_generate(Table *table, QString *error);
+    // m_value: table value of a position of a smaller table, kings alone are a draw
+    int  m_value(const Setup &setup) const;
+
+    QDir                   m_directory;
+    int                    m_threads;
+    QTextStream           &m_out;
+    QVector<Table*>        m_tables;
+    QHash<quint32, Table*> m_registry;
+};
+
+bool Generator::ensure(const int counts[2][6], QString *error)
+{
+    if (pieceCount(counts) == 2 || m_registry.contains(Material::key(counts, false)))
+        return true;
+
+    // smaller tables first: one capture, one promotion or a capture by a promotion
+    for (auto color = 0; color < 2; color++) {
+        for (auto captured = int(PAWN); captured <= int(KING); captured++) {
+            if (captured != KING && counts[opposite(eColor(color))][captured] == 0)
+                continue;
+            for (auto promoted = int(PAWN); promoted <= int(QUEEN); promoted++) {
+                if (captured == KING && promoted == PAWN)
+                    continue; // neither a capture nor a promotion
+                if (promoted != PAWN && counts[color][PAWN] == 0)
+                    continue;
+                int next[2][6];
+                std::memcpy(next, counts, sizeof(next));
+                if (captured != KING)
+                    next[opposite(eColor(color))][captured]--;
+                if (promoted != PAWN) {
+                    next[color][PAWN]--;
+                    next[color][promoted]++;
+                }
+                normalize(next);
+                if (!ensure(next, error))
+                    return false;
+            }
+        }
+    }
+
+    Table *table = new Table;
+    setupTable(table, counts);
+    m_tables.append(table);
+    m_registry.insert(table->key, table);
+    m_registry.insert(table->key2, table);
+
+    const QString fileName = m_directory.filePath(table->name + tableSuffix);
+    if (QFile::exists(fileName) && mapTable(table, fileName))
+        return true;
+    return m_generate(table, error) && writeTable(table, fileName, error);
+}
+
+int Generator::m_value(const Setup &setup) const
+{
+    if (setup.count == 2)
+        return 0;
+    const Table *table = m_registry.value(materialKey(setup));
+    Q_ASSERT(table != nullptr);
+    return table->values[indexOf(table, setup)];
+}
+
+bool Generator::m_generate(Table *table, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const quint64 size = table->size;
+    const quint64 shareSize = (size + m_threads - 1) / m_threads;
+    table->memory = QByteArray(int(size), '\0');
+    table->values = reinterpret_cast<const uchar*>(table->memory.constData());
+    uchar *values = reinterpret_cast<uchar*>(table->memory.data());
+    QVector<quint8> counters(int(size), 0); // moves within the table not refuted yet
+    QVector<quint8> exitWin(int(size), 0);  // plies of the fastest win by a capture or promotion
+    QVector<quint8> exitLoss(int(size), 0); // plies of the slowest loss by one, CANNOT_LOSE
+
+    // the positions of the table: mates, stalemates and the moves leaving the table
+    QVector<quint64> legalCounts(m_threads, 0);
+    QVector<int> exitLevels(m_threads, 0);
+    runParallel(m_threads, [&](int share) {
+        const quint64 end = qMin(size, (share + 1) * shareSize);
+        for (auto idx = share * shareSize; idx < end; idx++) {
+            Setup setup;
+            if (!decodeLegal(table, idx, &setup)) {
+                values[idx] = VALUE_ILLEGAL;
+                continue;
+            }
+            legalCounts[share]++;
+
+            quint64 successors[MAX_MOVES];
+            int successorCount = 0, moveCount = 0, win = 0, loss = 0;
+            bool canLose = true;
+            forEachMove(setup, [&](const Setup &next, bool staysInTable) {
+                moveCount++;
+                if (staysInTable) {
+                    successors[successorCount++] = indexOf(table, next);
+                    return;
+                }
+                const int value = m_value(next);
+                if (value == 0) {
+                    canLose = false;
+                } else if ((value - 1) % 2 == 0) { // the opponent is mated
+                    win = win == 0 ? value : qMin(win, value);
+                    canLose = false;
+                } else {
+                    loss = qMax(loss, value);
+                }
+            });
+
+            if (moveCount == 0) {
+                if (inCheck(setup))
+                    values[idx] = 1;
+                else
+                    exitLoss[idx] = CANNOT_LOSE;
+                continue;
+            }
+            // symmetric moves may lead to the same index, it's refuted once
+            std::sort(successors, successors + successorCount);
+            counters[idx] = quint8(std::unique(successors, successors + successorCount) - successors);
+            exitWin[idx] = quint8(win);
+            exitLoss[idx] = canLose ? quint8(loss) : quint8(CANNOT_LOSE);
+            exitLevels[share] = qMax(exitLevels[share], qMax(win, canLose ? loss : 0));
+        }
+    });
+    const int maxExitLevel = *std::max_element(exitLevels.begin(), exitLevels.end());
+
+    QVector<QVector<quint64>> resolved(m_threads);
+    QVector<QVector<QVector<quint64>>> handovers(m_threads, QVector<QVector<quint64>>(m_threads));
+    int level = 0, lastLevel = -1, emptyLevels = 0;
+    for (; level <= MAX_DTM_PLIES; level++) {
+        // the positions of this level, with the exits and the losses put off to it
+        runParallel(m_threads, [&](int share) {
+            QVector<quint64> &found = resolved[share];
+            found.clear();
+            const quint64 end = qMin(size, (share + 1) * shareSize);
+            for (auto idx = share * shareSize; idx < end; idx++) {
+                if (values[idx] == 0) {
+                    if (level % 2 == 1 && exitWin[idx] == level)
+                        values[idx] = uchar(level + 1);
+                    else if (level % 2 == 0 && counters[idx] == 0 && exitLoss[idx] <= level)
+                        values[idx] = uchar(level + 1);
+                }
+                if (values[idx] == level + 1)
+                    found.append(idx);
+            }
+        });
+
+        int found = 0;
+        for (const auto &share : resolved)
+            found += share.size();
+        if (found > 0) {
+            lastLevel = level;
+            emptyLevels = 0;
+        } else if (++emptyLevels >= 2 && level > maxExitLevel) {
+            break;
+        }
+
+        // predecessors, handed over to the owner of their index
+        runParallel(m_threads, [&](int share) {
+            for (auto &handover : handovers[share])
+                handover.clear();
+            for (auto idx : resolved[share]) {
+                Setup setup;
+                int squares[Dtm::DTM_PIECES];
+                eColor stm;
+                decode(table, idx, squares, &stm);
+                setup.count = table->pieceCount;
+                setup.stm = stm;
+                for (auto slot = 0; slot < setup.count; slot++) {
+                    setup.piece[slot] = table->pieces[slot];
+                    setup.square[slot] = squares[slot];
+                }
+
+                quint64 previous[MAX_MOVES];
+                int count = 0;
+                forEachUnmove(setup, [&](const Setup &position) {
+                    if (count < MAX_MOVES)
+                        previous[count++] = indexOf(table, position);
+                });
+                Q_ASSERT(count < MAX_MOVES);
+                std::sort(previous, previous + count);
+                count = int(std::unique(previous, previous + count) - previous);
+                for (auto i = 0; i < count; i++)
+                    handovers[share][int(previous[i] / shareSize)].append(previous[i]);
+            }
+        });
+
+        // a mated position makes a win, a won one takes a move off the counter
+        runParallel(m_threads, [&](int share) {
+            for (auto from = 0; from < m_threads; from++)
+                for (auto idx : handovers[from][share]) {
+                    if (values[idx] != 0)
+                        continue;
+                    if (level % 2 == 0)
+                        values[idx] = uchar(level + 2);
+                    else
+                        counters[idx]--;
+                }
+        });
+    }
+    if (level > MAX_DTM_PLIES) {
+        *error = QString("%1: mates beyond %2 plies").arg(table->name).arg(MAX_DTM_PLIES);
+        return false;
+    }
+    table->longest = qMax(0, lastLevel);
+
+    quint64 legal = 0;
+    for (auto count : legalCounts)
+        legal += count;
+    const qint64 ms = qMax(qint64(1), timer.elapsed());
+    const QString longest = lastLevel < 0 ? QString("no mate") : QString("longest mate %1 plies").arg(lastLevel);
+    m_out << QString("%1 %2 positions, %3 legal, %4, %5 s, %6 positions/s")
+             .arg(table->name, -8).arg(size).arg(legal).arg(longest)
+             .arg(ms / 1000.0, 0, 'f', 2).arg(quint64(size * 1000 / ms)) << "\n";
+    m_out.flush();
+    return true;
+}
+
+}
+
+int Dtm::init(const QString &paths)
+{
+    initEncoding();
+
+    registry.clear();
+    qDeleteAll(tables);
+    tables.clear();
+    maxPieceCount = 0;
+
+    const QStringList directories = paths.split(QDir::listSeparator(), QString::SkipEmptyParts);
+    for (const auto &directory : directories) {
+        const QDir dir(directory);
+        const QStringList fileNames = dir.entryList(QStringList() << QString("*") + tableSuffix, QDir::Files);
+        for (const auto &fileName : fileNames) {
+            int counts[2][6];
+            if (!Material::parseName(QFileInfo(fileName).completeBaseName(), counts) || pieceCount(counts) > DTM_PIECES)
+                continue;
+            if (registry.contains(Material::key(counts, false))) // the same table in another directory
+                continue;
+
+            Table *table = new Table;
+            setupTable(table, counts);
+            if (!mapTable(table, dir.filePath(fileName))) {
+                delete table;
+                continue;
+            }
+            tables.append(table);
+            registry.insert(table->key, table);
+            registry.insert(table->key2, table);
+            maxPieceCount = qMax(maxPieceCount, table->pieceCount);
+        }
+    }
+    return tables.size();
+}
+
+int Dtm::maxPieces()
+{
+    return maxPieceCount;
+}
+
+bool Dtm::canProbe(const Position &pos)
+{
+    return maxPieceCount > 0 && pos.castlingRights() == NO_CASTLING && popCount(pos.pieces()) <= maxPieceCount;
+}
+
+int Dtm::probe(const Position &pos, bool *ok)
+{
+    Setup setup;
+    setup.count = 0;
+    setup.stm = pos.sideToMove();
+    for (Bitboard b = pos.pieces(); b; ) {
+        const int square = popLsb(b);
+        setup.piece[setup.count] = pos.pieceOn(square);
+        setup.square[setup.count++] = square;
+    }
+
+    const Table *table = registry.value(materialKey(setup));
+    *ok = table != nullptr;
+    if (!*ok)
+        return DTM_DRAW;
+
+    const int value = table->values[indexOf(table, setup)];
+    *ok = value != VALUE_ILLEGAL;
+    return value == 0 || value == VALUE_ILLEGAL ? DTM_DRAW : value - 1;
+}
+
+bool Dtm::generate(const QString &material, const QString &directory, int threads,
+                   QTextStream &out, QString *error)
+{
+    initEncoding();
+
+    int counts[2][6];
+    if (!Material::parseName(material, counts)) {
+        *error = QString("%1 isn't a material like KBNvK").arg(material);
+        return false;
+    }
+    if (pieceCount(counts) > DTM_PIECES) {
+        *error = QString("%1: tables have %2 pieces at most").arg(material).arg(int(DTM_PIECES));
+        return false;
+    }
+    if (counts[WHITE][PAWN] > 0 && counts[BLACK][PAWN] > 0) {
+        *error = QString("%1: pawns of both colors aren't supported").arg(material);
+        return false;
+    }
+    normalize(counts);
+
+    if (!QDir().mkpath(directory)) {
+        *error = QString("can't create %1").arg(directory);
+        return false;
+    }
+    Generator generator(directory, threads, out);
+    return generator.ensure(counts, error);
+}
+
+}
@@ -0,0 +1,77 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_DTM_H
+#define ENGINE_DTM_H
+
+#include <QString>
+#include <QTextStream>
+
+#include "position.h"
+
+//==============================================================
+//                  Distance to mate tables
+//==============================================================
+
+//    Tables of the plies to mate of every position of a small material set
+//    (KQvK.dtm, KBNvK.dtm, KPvK.dtm, ...) of up to 4 pieces, kings included,
+//    generated by retrograde analysis with generate(). A file is a 32 bytes header
+//    and one byte per index: 0 for a draw, plies to mate + 1 otherwise.
+//    The index leaves out the symmetries of the board, so KQvK takes 80 KB
+//    and a 4 pieces table with pawns 16 MB. Files are mapped read-only by init()
+//    and shared by all the search threads. Positions with castling rights
+//    and material sets with pawns of both colors (en passant) aren't covered.
+
+namespace engine
+{
+
+namespace Dtm
+{
+    enum {
+        DTM_PIECES = 4,  // pieces of the largest table, kings included
+        DTM_DRAW   = -1  // probe() result of a drawn position
+    };
+
+    // init: forgets the tables found before and maps the tables in the directories
+    //      separated by QDir::listSeparator(), an empty string turns the tables off.
+    //      Returns the number of tables found. Must not be called while a search is running
+    int     init(const QString &paths);
+    // maxPieces: pieces of the largest table found, kings included; 0 without tables
+    int     maxPieces();
+    // canProbe: few enough pieces for the tables found and no castling rights
+    bool    canProbe(const Position &pos);
+
+    // probe: plies to mate with the best play of both sides, odd when the side
+    //      to move mates, even when it is mated (0: it is checkmate), DTM_DRAW.
+    //      `ok` is false if there is no table of the material
+    int     probe(const Position &pos, bool *ok);
+
+    // generate: writes the table of the material (KBNvK, KPvK, ...) into the directory,
+    //      the tables it converts to by a capture or a promotion are read from there
+    //      or generated first. `threads` share the work of each table, a line of
+    //      statistics per generated table goes to `out`. False with `error` set on failure
+    bool    generate(const QString &material, const QString &directory, int threads,
+                     QTextStream &out, QString *error);
+}
+
+}
+
+#endif//ENGINE_DTM_H
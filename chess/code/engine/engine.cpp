@@ -0,0 +1,233 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "engine.h"
+#include "movegen.h"
+
+namespace engine
+{
+
+//==============================================================
+//                      EngineWorker
+//==============================================================
+
+EngineWorker::EngineWorker()
+{
+    m_cancelledId.store(0);
+    m_ponderHitId.store(0);
+}
+
+void EngineWorker::cancel(int id)
+{
+    m_cancelledId.storeRelease(id);
+    m_search.stop();
+}
+
+void EngineWorker::ponderHit(int id)
+{
+    m_ponderHitId.storeRelease(id);
+    m_search.ponderHit();
+}
+
+void EngineWorker::search(int id, const QString &fen, const QStringList &moves, const SearchLimits &limits)
+{
+    Position pos;
+    if (!pos.setFEN(fen)) {
+        emit bestMove(id, SearchResult());
+        return;
+    }
+    for (const QString &text : moves) {
+        const Move move = moveFromString(pos, text);
+        if (move == NO_MOVE)
+            break;
+        pos.doMove(move);
+    }
+
+    MoveList legal;
+    generateLegalMoves(pos, legal);
+    if (legal.isEmpty()) { // mate or stalemate, an infinite search would never end
+        emit bestMove(id, SearchResult());
+        return;
+    }
+
+    // the book answers games at once, analysis and pondering always search
+    if (m_book.isOpen() && !limits.infinite && !limits.ponder && limits.multiPv == 1) {
+        SearchResult result;
+        result.bestMove = m_book.probe(pos);
+        if (result.bestMove != NO_MOVE) {
+            emit searchStarted(id);
+            emit bestMove(id, result);
+            return;
+        }
+    }
+
+    SearchLimits searchLimits = limits;
+    if (id <= m_cancelledId.loadAcquire()) {
+        // stopped before it started: a quick move is still better than none
+        searchLimits = SearchLimits();
+        searchLimits.depth = 1;
+    }
+    if (id <= m_ponderHitId.loadAcquire())
+        searchLimits.ponder = false;
+
+    m_search.setInfoCallback([this, id](const SearchInfo &info) {
+        m_applyRequests(id);
+        emit searchInfo(id, info);
+    });
+
+    emit searchStarted(id);
+    const SearchResult result = m_search.go(pos, searchLimits);
+    m_search.setInfoCallback(nullptr);
+
+    emit bestMove(id, result);
+}
+
+void EngineWorker::setThreads(int count)
+{
+    m_search.setThreads(qMax(1, count));
+}
+
+void EngineWorker::setHashSize(int megabytes)
+{
+    m_search.setHashSize(megabytes);
+}
+
+void EngineWorker::newGame()
+{
+    m_search.newGame();
+}
+
+void EngineWorker::setBookFile(const QString &fileName)
+{
+    if (fileName.isEmpty())
+        m_book.close();
+    else
+        m_book.open(fileName);
+}
+
+void EngineWorker::setAnalysisCache(bool enabled)
+{
+    SearchOptions options = m_search.options();
+    options.useAnalysisCache = enabled;
+    m_search.setOptions(options);
+}
+
+void EngineWorker::m_applyRequests(int id)
+{
+    if (id <= m_cancelledId.loadAcquire())
+        m_search.stop();
+    if (id <= m_ponderHitId.loadAcquire() && m_search.isPondering())
+        m_search.ponderHit();
+}
+
+
+//==============================================================
+//                          Engine
+//==============================================================
+
+Engine::Engine(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<engine::SearchLimits>("engine::SearchLimits");
+    qRegisterMetaType<engine::SearchInfo>("engine::SearchInfo");
+    qRegisterMetaType<engine::SearchResult>("engine::SearchResult");
+
+    m_lastId = 0;
+    m_searching = false;
+
+    // the worker has no parent to be moved, it is deleted by the thread's event loop
+    m_worker = new EngineWorker;
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, SIGNAL(finished()), m_worker, SLOT(deleteLater()));
+
+    // signals cross the threads, the connections are queued
+    connect(m_worker, SIGNAL(searchStarted(int)), this, SIGNAL(searchStarted(int)));
+    connect(m_worker, SIGNAL(searchInfo(int, const engine::SearchInfo &)),
+            this, SIGNAL(searchInfo(int, const engine::SearchInfo &)));
+    connect(m_worker, SIGNAL(bestMove(int, const engine::SearchResult &)),
+            this, SLOT(searchDone(int, const engine::SearchResult &)));
+
+    m_thread.start();
+}
+
+Engine::~Engine()
+{
+    stop();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+int Engine::start(const QString &fen, const QStringList &moves, const SearchLimits &limits)
+{
+    if (m_searching)
+        stop();
+
+    m_lastId++;
+    m_searching = true;
+    QMetaObject::invokeMethod(m_worker, "search", Qt::QueuedConnection,
+                              Q_ARG(int, m_lastId), Q_ARG(QString, fen), Q_ARG(QStringList, moves),
+                              Q_ARG(engine::SearchLimits, limits));
+    return m_lastId;
+}
+
+void Engine::stop()
+{
+    // doesn't wait for the engine thread, the best move comes with bestMove()
+    m_worker->cancel(m_lastId);
+}
+
+void Engine::ponderHit()
+{
+    m_worker->ponderHit(m_lastId);
+}
+
+void Engine::setThreads(int count)
+{
+    QMetaObject::invokeMethod(m_worker, "setThreads", Qt::QueuedConnection, Q_ARG(int, count));
+}
+
+void Engine::setHashSize(int megabytes)
+{
+    QMetaObject::invokeMethod(m_worker, "setHashSize", Qt::QueuedConnection, Q_ARG(int, megabytes));
+}
+
+void Engine::newGame()
+{
+    QMetaObject::invokeMethod(m_worker, "newGame", Qt::QueuedConnection);
+}
+
+void Engine::setBookFile(const QString &fileName)
+{
+    QMetaObject::invokeMethod(m_worker, "setBookFile", Qt::QueuedConnection, Q_ARG(QString, fileName));
+}
+
+void Engine::setAnalysisCache(bool enabled)
+{
+    QMetaObject::invokeMethod(m_worker, "setAnalysisCache", Qt::QueuedConnection, Q_ARG(bool, enabled));
+}
+
+void Engine::searchDone(int id, const SearchResult &result)
+{
+    if (id == m_lastId)
+        m_searching = false;
+    emit bestMove(id, result);
+}
+
+}
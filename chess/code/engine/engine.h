@@ -0,0 +1,132 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_ENGINE_H
+#define ENGINE_ENGINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QStringList>
+#include <QMetaType>
+
+#include "search.h"
+#include "book.h"
+
+//==============================================================
+//                      Engine
+//==============================================================
+
+namespace engine
+{
+
+//    EngineWorker lives in the engine thread, it receives the queued
+//    calls of Engine and runs the blocking Search::go() there
+class EngineWorker : public QObject {
+    Q_OBJECT
+
+public:
+    EngineWorker();
+
+    // cancel, ponderHit:
+    //      Called directly from the GUI thread, they apply to every search
+    //      with id up to the given one even if it hasn't started yet
+    void    cancel(int id);
+    void    ponderHit(int id);
+
+public slots:
+    void    search(int id, const QString &fen, const QStringList &moves, const engine::SearchLimits &limits);
+    void    setThreads(int count);
+    void    setHashSize(int megabytes);
+    void    newGame();
+    // setBookFile: Polyglot book for the moves of the game, an empty name closes the book
+    void    setBookFile(const QString &fileName);
+    // setAnalysisCache: the searches read and write the analysis cache, see SearchOptions
+    void    setAnalysisCache(bool enabled);
+
+signals:
+    void    searchStarted(int id);
+    void    searchInfo(int id, const engine::SearchInfo &info);
+    void    bestMove(int id, const engine::SearchResult &result);
+
+private:
+    // m_applyRequests: a cancel or ponder hit may come between the start of the
+    //      slot and Search::go() resetting its flags, the info callback of the
+    //      first iteration applies it again
+    void    m_applyRequests(int id);
+
+    Search     m_search;
+    Book       m_book;
+    QAtomicInt m_cancelledId;
+    QAtomicInt m_ponderHitId;
+};
+
+//    Engine is the interface of the GUI thread: every call returns at once,
+//    the search runs in the engine thread and reports through queued signals.
+//    Cancellation is cooperative, the search threads poll the stop flag on
+//    each node and the result comes in well within a millisecond after stop()
+class Engine : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Engine(QObject *parent = Q_NULLPTR);
+    ~Engine();
+
+    // start: searches the position reached from the FEN by the moves in coordinate notation,
+    //      a running search is stopped first. Returns the id passed along with the signals,
+    //      signals of the searches started before may still come and should be ignored
+    int     start(const QString &fen, const QStringList &moves, const SearchLimits &limits);
+    // stop: the search reports its best move as soon as possible
+    void    stop();
+    // ponderHit: the ponder search goes on as a normal one, see Search::ponderHit()
+    void    ponderHit();
+
+    // Options are applied in the engine thread after the current search
+    void    setThreads(int count);
+    void    setHashSize(int megabytes);
+    void    newGame();
+    void    setBookFile(const QString &fileName);
+    void    setAnalysisCache(bool enabled);
+
+    bool    isSearching() const { return m_searching; }
+    int     currentId() const { return m_lastId; }
+
+signals:
+    void    searchStarted(int id);
+    void    searchInfo(int id, const engine::SearchInfo &info);
+    void    bestMove(int id, const engine::SearchResult &result);
+
+private slots:
+    void    searchDone(int id, const engine::SearchResult &result);
+
+private:
+    QThread       m_thread;
+    EngineWorker *m_worker;
+    int           m_lastId;
+    bool          m_searching;
+};
+
+}
+
+Q_DECLARE_METATYPE(engine::SearchLimits)
+Q_DECLARE_METATYPE(engine::SearchInfo)
+Q_DECLARE_METATYPE(engine::SearchResult)
+
+#endif//ENGINE_ENGINE_H
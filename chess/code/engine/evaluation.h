@@ -0,0 +1,55 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_EVALUATION_H
+#define ENGINE_EVALUATION_H
+
+#include "position.h"
+#include "pawns.h"
+
+//==============================================================
+//                      Evaluation
+//==============================================================
+
+namespace engine
+{
+
+enum ePieceValue {
+    PAWN_VALUE   = 100,
+    KNIGHT_VALUE = 320,
+    BISHOP_VALUE = 330,
+    ROOK_VALUE   = 500,
+    QUEEN_VALUE  = 900
+};
+
+// pieceValue: material value by ePieceType, the king has no material value
+extern const int pieceValue[6];
+
+// evaluate:
+//      Static evaluation of the position in centipawns
+//      from the side to move point of view. Material and piece-square
+//      scores come from the position, pawn structure from the pawn table
+//      if one is given, tapered by the game phase
+int evaluate(const Position &pos, PawnTable *pawns = nullptr);
+
+}
+
+#endif//ENGINE_EVALUATION_H
@@ -0,0 +1,339 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "gamecodec.h"
+#include "movegen.h"
+
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+const char MAGIC[4] = { 'C', 'G', 'A', 'M' };
+const int  BUFFER_SIZE = 1 << 20;
+const int  COMPLETE_FLAG = 4;
+
+// the common tag names stored as their number, 1 for the first one
+const char *const tagNames[] = {
+    "Event", "Site", "Date", "Round", "White", "Black", "Result", "WhiteElo", "BlackElo",
+    "ECO", "Opening", "Variation", "TimeControl", "Termination", "PlyCount", "EventDate", "FEN", "SetUp"
+};
+const int TAG_NAMES_NB = int(sizeof(tagNames) / sizeof(tagNames[0]));
+const int FEN_TAG = 17;
+
+void appendVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// readVarint: false if the varint runs past the end
+inline bool readVarint(const uchar *&p, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (auto shift = 0; p < end && shift < 64; shift += 7) {
+        const uchar byte = *p++;
+        value |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// readBytes: a varint size and the bytes after it, false if they run past the end
+inline bool readBytes(const uchar *&p, const uchar *end, const char *&bytes, int &size)
+{
+    quint64 value;
+    if (!readVarint(p, end, value) || value > quint64(end - p))
+        return false;
+    bytes = reinterpret_cast<const char*>(p);
+    size = int(value);
+    p += value;
+    return true;
+}
+
+}
+
+QByteArray GameCodec::header()
+{
+    QByteArray data(MAGIC, 4);
+    for (auto i = 0; i < 4; i++)
+        data.append(char((VERSION >> (8 * i)) & 0xFF));
+    return data;
+}
+
+bool GameCodec::isHeader(const char *data, qint64 size)
+{
+    return size >= HEADER_SIZE && memcmp(data, header().constData(), HEADER_SIZE) == 0;
+}
+
+bool GameCodec::encodeGame(const GameList &games, int game, QByteArray &out)
+{
+    QByteArray body;
+    body.append(char(games.result(game) | (games.isComplete(game) ? COMPLETE_FLAG : 0)));
+
+    appendVarint(body, games.tagCount(game));
+    for (auto idx = 0; idx < games.tagCount(game); idx++) {
+        int nameSize, valueSize;
+        const char *name = games.tagNameData(game, idx, &nameSize);
+        const char *value = games.tagValueData(game, idx, &valueSize);
+        int code = 0;
+        for (auto i = 0; i < TAG_NAMES_NB && code == 0; i++)
+            if (int(strlen(tagNames[i])) == nameSize && memcmp(tagNames[i], name, nameSize) == 0)
+                code = i + 1;
+        appendVarint(body, code);
+        if (code == 0) {
+            appendVarint(body, nameSize);
+            body.append(name, nameSize);
+        }
+        appendVarint(body, valueSize);
+        body.append(value, valueSize);
+    }
+
+    // a game from a broken FEN has no moves, it is kept for its tags
+    Position pos;
+    if (!pos.setFEN(games.startFEN(game)) && games.plies(game) > 0)
+        return false;
+    const Move *moves = games.moves(game);
+    appendVarint(body, games.plies(game));
+    for (auto ply = 0; ply < games.plies(game); ply++) {
+        // the index among the legal moves: the legal ones before it in the generator order
+        MoveList pseudoLegal;
+        generateMoves(pos, pseudoLegal);
+        int index = 0;
+        bool isFound = false;
+        for (const auto &scored : pseudoLegal) {
+            if (scored.move == moves[ply]) {
+                isFound = pos.isLegal(scored.move);
+                break;
+            }
+            if (pos.isLegal(scored.move))
+                index++;
+        }
+        if (!isFound)
+            return false;
+        body.append(char(index));
+        pos.doMove(moves[ply]);
+    }
+
+    appendVarint(out, body.size());
+    out.append(body);
+    return true;
+}
+
+qint64 GameCodec::decodeGame(const char *data, qint64 size, qint64 offset, GameList &games)
+{
+    const uchar *p = reinterpret_cast<const uchar*>(data);
+    const uchar *end = p + size;
+
+    quint64 bodySize;
+    if (!readVarint(p, end, bodySize) || bodySize == 0 || bodySize > quint64(end - p))
+        return 0;
+    end = p + bodySize;
+    const qint64 gameSize = end - reinterpret_cast<const uchar*>(data);
+
+    // the frame is checked as a whole before anything is added to the list
+    const uchar flags = *p++;
+    quint64 tagCount, plies;
+    if (!readVarint(p, end, tagCount))
+        return 0;
+    const uchar *tags = p;
+    const char *fen = nullptr;
+    int fenSize = 0;
+    for (quint64 i = 0; i < tagCount; i++) {
+        quint64 code;
+        const char *bytes;
+        int bytesSize;
+        if (!readVarint(p, end, code) || code > quint64(TAG_NAMES_NB))
+            return 0;
+        if (code == 0 && !readBytes(p, end, bytes, bytesSize))
+            return 0;
+        if (!readBytes(p, end, bytes, bytesSize))
+            return 0;
+        if (code == FEN_TAG) {
+            fen = bytes;
+            fenSize = bytesSize;
+        }
+    }
+    if (!readVarint(p, end, plies) || plies != quint64(end - p))
+        return 0;
+    const uchar *moves = p;
+
+    games.beginGame(offset);
+    p = tags;
+    for (quint64 i = 0; i < tagCount; i++) {
+        quint64 code;
+        const char *name = nullptr, *value = nullptr;
+        int nameSize = 0, valueSize = 0;
+        readVarint(p, end, code);
+        if (code == 0) {
+            readBytes(p, end, name, nameSize);
+        } else {
+            name = tagNames[code - 1];
+            nameSize = int(strlen(name));
+        }
+        readBytes(p, end, value, valueSize);
+        games.addTag(name, nameSize, value, valueSize, false);
+    }
+
+    const GameList::eResult result = GameList::eResult(flags & 3);
+    Position pos;
+    if (!pos.setFEN(fen ? QString::fromUtf8(fen, fenSize) : QString(Position::startFEN()))) {
+        games.endGame(result, false);
+        return gameSize;
+    }
+    for (p = moves; p < end; p++) {
+        // the index counts the legal moves only, the generator order is that of generateLegalMoves()
+        MoveList pseudoLegal;
+        generateMoves(pos, pseudoLegal);
+        int index = *p;
+        Move move = NO_MOVE;
+        for (const auto &scored : pseudoLegal) {
+            if (pos.isLegal(scored.move) && index-- == 0) {
+                move = scored.move;
+                break;
+            }
+        }
+        if (move == NO_MOVE) {
+            games.endGame(result, false);
+            return gameSize;
+        }
+        games.addMove(move);
+        pos.doMove(move);
+    }
+    games.endGame(result, (flags & COMPLETE_FLAG) != 0);
+    return gameSize;
+}
+
+qint64 GameCodec::gameSize(const char *data, qint64 size)
+{
+    const uchar *p = reinterpret_cast<const uchar*>(data);
+    const uchar *end = p + size;
+    quint64 bodySize;
+    if (!readVarint(p, end, bodySize) || bodySize == 0 || bodySize > quint64(end - p))
+        return 0;
+    return (p - reinterpret_cast<const uchar*>(data)) + qint64(bodySize);
+}
+
+//==============================================================
+//                         GameWriter
+//==============================================================
+
+bool GameWriter::open(const QString &fileName, bool append)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(append ? QIODevice::OpenMode(QIODevice::ReadWrite) : QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    m_written = m_file.size();
+    if (m_written == 0) {
+        m_buffer = GameCodec::header();
+        return true;
+    }
+
+    const QByteArray header = m_file.read(GameCodec::HEADER_SIZE);
+    if (!GameCodec::isHeader(header.constData(), header.size()) || !m_file.seek(m_written)) {
+        m_file.close();
+        m_written = 0;
+        return false;
+    }
+    return true;
+}
+
+void GameWriter::close()
+{
+    if (!m_file.isOpen())
+        return;
+    m_flush();
+    m_file.close();
+    m_written = 0;
+}
+
+bool GameWriter::writeGame(const GameList &games, int game)
+{
+    if (!m_file.isOpen() || !GameCodec::encodeGame(games, game, m_buffer))
+        return false;
+    return m_buffer.size() < BUFFER_SIZE || m_flush();
+}
+
+bool GameWriter::m_flush()
+{
+    const bool isOk = m_file.write(m_buffer) == m_buffer.size();
+    m_written += m_buffer.size();
+    m_buffer.clear();
+    return isOk;
+}
+
+//==============================================================
+//                         GameReader
+//==============================================================
+
+bool GameReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = m_file.size();
+    const char *data = size >= GameCodec::HEADER_SIZE ? reinterpret_cast<const char*>(m_file.map(0, size)) : nullptr;
+    if (data == nullptr || !GameCodec::isHeader(data, size)) {
+        if (data)
+            m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        m_file.close();
+        return false;
+    }
+    m_data = data;
+    m_size = size;
+    m_pos = GameCodec::HEADER_SIZE;
+    return true;
+}
+
+void GameReader::close()
+{
+    if (m_data)
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_pos = 0;
+}
+
+bool GameReader::readGame(GameList &games)
+{
+    if (m_data == nullptr || m_pos >= m_size)
+        return false;
+    const qint64 gameSize = GameCodec::decodeGame(m_data + m_pos, m_size - m_pos, m_pos, games);
+    if (gameSize == 0)
+        return false;
+    m_pos += gameSize;
+    return true;
+}
+
+}
@@ -0,0 +1,129 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_GAMECODEC_H
+#define ENGINE_GAMECODEC_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "gamelist.h"
+
+//==============================================================
+//                      Binary game format
+//==============================================================
+
+//    Games stored as the index of every move in the list of the legal moves of
+//    its position, in the order of generateLegalMoves(). There are never more
+//    than 218 legal moves, so a move is one byte, and the decoder replays the
+//    game with the same generator. A file is an 8 bytes header, "CGAM" and the
+//    quint32 version 1 little endian, followed by the games one after another:
+//      varint   size of the rest of the game, a reader may skip it
+//      quint8   bits 0-1 the result (GameList::eResult), bit 2 set if the game is complete
+//      varint   number of tags, then each tag:
+//                 varint  name: 1 to 18 one of the common names, 0 the name
+//                         follows as a varint size and UTF-8 bytes
+//                 varint  size of the value, the UTF-8 bytes of the value
+//      varint   number of moves, one byte per move
+//    The varints are 7 bits per byte, low bits first, the high bit set on all
+//    the bytes but the last. A game from a set up position has a FEN tag.
+
+namespace engine
+{
+
+namespace GameCodec
+{
+    enum { HEADER_SIZE = 8, VERSION = 1 };
+
+    // header: the 8 bytes starting a file of games
+    QByteArray header();
+    // isHeader: true if the data start with the header of a file of games
+    bool    isHeader(const char *data, qint64 size);
+
+    // encodeGame: appends the game of the list to `out`, false if a move isn't legal
+    bool    encodeGame(const GameList &games, int game, QByteArray &out);
+    // decodeGame:
+    //      Appends the game starting at data to the list, `offset` is its offset for
+    //      GameList::offset(). Returns the size of the game, 0 if the data are broken
+    qint64  decodeGame(const char *data, qint64 size, qint64 offset, GameList &games);
+    // gameSize: the size of the game starting at data without decoding it, 0 if it runs past the end
+    qint64  gameSize(const char *data, qint64 size);
+}
+
+//    GameWriter writes games to a file of games through a buffer
+class GameWriter {
+public:
+    GameWriter() : m_written(0) {}
+    ~GameWriter() { close(); }
+
+    // open: a new file, an existing one is truncated unless `append` is set;
+    //      then the games go after those of the file, false if it isn't a file of games
+    bool    open(const QString &fileName, bool append = false);
+    void    close();
+    bool    isOpen() const { return m_file.isOpen(); }
+
+    // writeGame: false if the game can't be encoded or written
+    bool    writeGame(const GameList &games, int game);
+    // size: bytes written so far, the header included
+    qint64  size() const { return m_written + m_buffer.size(); }
+
+private:
+    Q_DISABLE_COPY(GameWriter)
+
+    bool    m_flush();
+
+    QFile      m_file;
+    QByteArray m_buffer;
+    qint64     m_written;
+};
+
+//    GameReader reads the games of a file of games mapped into memory one by one
+class GameReader {
+public:
+    GameReader() : m_data(nullptr), m_size(0), m_pos(0) {}
+    ~GameReader() { close(); }
+
+    // open: maps the file, false if it can't be mapped or isn't a file of games
+    bool    open(const QString &fileName);
+    void    close();
+    bool    isOpen() const { return m_data != nullptr; }
+    qint64  size() const { return m_size; }
+
+    // offset: of the next game in the file, seek() returns to a game found before
+    qint64  offset() const { return m_pos; }
+    void    seek(qint64 offset) { m_pos = qBound<qint64>(GameCodec::HEADER_SIZE, offset, m_size); }
+
+    // readGame: appends the next game to the list, false at the end of the file or on broken data
+    bool    readGame(GameList &games);
+
+private:
+    Q_DISABLE_COPY(GameReader)
+
+    QFile       m_file;
+    const char *m_data;
+    qint64      m_size;
+    qint64      m_pos;
+};
+
+}
+
+#endif//ENGINE_GAMECODEC_H
@@ -0,0 +1,475 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "gamedb.h"
+#include "gamecodec.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+const char indexMagic[4] = { 'C', 'I', 'D', 'X' };
+enum {
+    INDEX_VERSION      = 1,
+    INDEX_HEADER_SIZE  = 64,
+    ENTRY_SIZE         = 16,
+    BUCKET_ENTRIES     = 16, // about as many entries per bucket of the directory
+    MAX_DIRECTORY_BITS = 24,
+    MAX_PART_BITS      = 8   // up to 256 parts sorted one by one
+};
+
+struct IndexEntry {
+    Key     key;
+    quint32 game;
+    quint32 ply;
+
+    bool operator<(const IndexEntry &other) const
+    {
+        return key < other.key || (key == other.key && game < other.game);
+    }
+};
+
+// Chunk: entries of a part written to the spill file
+struct Chunk {
+    qint64 offset;
+    int    count;
+};
+
+inline int bucketOf(Key key, int bits)
+{
+    return bits > 0 ? int(key >> (64 - bits)) : 0;
+}
+
+// isRepeated: the position was reached before in the game, `keys` are those of the earlier plies
+bool isRepeated(const Position &pos, const QVector<Key> &keys)
+{
+    const int first = qMax(0, keys.size() - pos.rule50());
+    for (auto i = keys.size() - 2; i >= first; i -= 2)
+        if (keys.at(i) == pos.key())
+            return true;
+    return false;
+}
+
+void setError(QString *error, const QString &text)
+{
+    if (error)
+        *error = text;
+}
+
+}
+
+//==============================================================
+//                        GameDatabase
+//==============================================================
+
+GameDatabase::GameDatabase()
+    : m_data(nullptr), m_fileSize(0), m_size(0),
+      m_index(nullptr), m_indexedGames(0), m_entryCount(0), m_directoryBits(0),
+      m_directory(nullptr), m_entries(nullptr)
+{
+}
+
+bool GameDatabase::open(const QString &fileName)
+{
+    close();
+
+    if (!QFile::exists(fileName)) {
+        GameWriter writer;
+        if (!writer.open(fileName))
+            return false;
+        writer.close();
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_mapGames())
+        return false;
+
+    // the offsets of the indexed games come with the index, the others are read from the file
+    m_size = GameCodec::HEADER_SIZE;
+    if (m_openIndex()) {
+        const uchar *offsets = m_entries + m_entryCount * ENTRY_SIZE;
+        m_offsets.resize(m_indexedGames);
+        for (auto game = 0; game < m_indexedGames; game++)
+            m_offsets[game] = qFromLittleEndian<qint64>(offsets + 8 * game);
+        m_size = qFromLittleEndian<qint64>(m_index + 24);
+    }
+    m_scanGames();
+    return true;
+}
+
+void GameDatabase::close()
+{
+    m_closeIndex();
+    m_unmapGames();
+    m_offsets.clear();
+    m_size = 0;
+}
+
+bool GameDatabase::addGames(const GameList &games, QString *error)
+{
+    if (!isOpen()) {
+        setError(error, "The database isn't open");
+        return false;
+    }
+
+    // the games go after the last complete one, a game torn by a failed write is dropped
+    const QString fileName = m_file.fileName();
+    const int oldSize = size();
+    m_unmapGames();
+    bool isWritten = QFile(fileName).resize(m_size);
+
+    GameWriter writer;
+    isWritten = isWritten && writer.open(fileName, true);
+    for (auto game = 0; game < games.size() && isWritten; game++)
+        isWritten = writer.writeGame(games, game);
+    writer.close();
+
+    if (!m_mapGames()) {
+        setError(error, QString("Can't map %1").arg(fileName));
+        close();
+        return false;
+    }
+    m_scanGames();
+    if (!isWritten || size() != oldSize + games.size()) {
+        setError(error, QString("Can't write the games to %1").arg(fileName));
+        return false;
+    }
+    return true;
+}
+
+bool GameDatabase::readGame(int game, GameList &games) const
+{
+    if (game < 0 || game >= size())
+        return false;
+    const qint64 offset = m_offsets.at(game);
+    return GameCodec::decodeGame(m_data + offset, m_size - offset, offset, games) != 0;
+}
+
+bool GameDatabase::buildIndex(int megabytes, QString *error)
+{
+    // the new index is written aside and replaces the old one once complete
+    const QString newName = indexFileName(m_file.fileName()) + ".new";
+    return writeIndex(newName, megabytes, nullptr, error) && replaceIndex(newName, error);
+}
+
+bool GameDatabase::writeIndex(const QString &fileName, int megabytes, const QAtomicInt *cancel, QString *error) const
+{
+    auto isCancelled = [cancel]() { return cancel && cancel->loadAcquire() != 0; };
+    if (!isOpen()) {
+        setError(error, "The database isn't open");
+        return false;
+    }
+
+    // a game has at most as many moves as bytes, so the entries can't be more than the
+    // size of the games plus a start position each; they are split into parts by the
+    // high bits of the key so that a part fits the memory, the parts are buckets of the directory
+    const qint64 memory = qint64(qMax(1, megabytes)) << 20;
+    const qint64 maxEntries = m_size + size();
+    int partBits = 0;
+    while (partBits < MAX_PART_BITS && (maxEntries * ENTRY_SIZE >> partBits) > memory)
+        partBits++;
+    const int parts = 1 << partBits;
+    const int spillEntries = qMax<qint64>(1024, memory / ENTRY_SIZE / parts / 4);
+
+    QFile spill(fileName + ".spill");
+    if (parts > 1 && !spill.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        setError(error, QString("Can't create %1").arg(spill.fileName()));
+        return false;
+    }
+
+    QVector<QVector<IndexEntry>> partEntries(parts);
+    QVector<QVector<Chunk>> partChunks(parts);
+    qint64 entryCount = 0;
+    bool isOk = true;
+
+    GameList games;
+    QVector<Key> keys;
+    Position pos;
+    for (auto game = 0; game < size() && isOk; game++) {
+        if ((game & 1023) == 0 && isCancelled())
+            break;
+        games.clear();
+        if (!readGame(game, games) || !pos.setFEN(games.startFEN(0)))
+            continue;
+
+        keys.clear();
+        const Move *moves = games.moves(0);
+        for (auto ply = 0; ply <= games.plies(0); ply++) {
+            if (!isRepeated(pos, keys)) {
+                const int partIdx = bucketOf(pos.key(), partBits);
+                QVector<IndexEntry> &part = partEntries[partIdx];
+                part.append(IndexEntry{ pos.key(), quint32(game), quint32(ply) });
+                entryCount++;
+                if (parts > 1 && part.size() >= spillEntries) {
+                    const int bytes = part.size() * int(sizeof(IndexEntry));
+                    partChunks[partIdx].append(Chunk{ spill.pos(), part.size() });
+                    isOk = spill.write(reinterpret_cast<const char*>(part.constData()), bytes) == bytes;
+                    part.clear();
+                }
+            }
+            keys.append(pos.key());
+            if (ply < games.plies(0))
+                pos.doMove(moves[ply]);
+        }
+    }
+    if (!isOk || isCancelled()) {
+        setError(error, isOk ? QString("Cancelled") : QString("Can't write %1").arg(spill.fileName()));
+        spill.remove();
+        return false;
+    }
+
+    int bits = partBits;
+    while (bits < MAX_DIRECTORY_BITS && (qint64(BUCKET_ENTRIES) << (bits + 1)) <= entryCount)
+        bits++;
+    const qint64 buckets = qint64(1) << bits;
+    const qint64 directorySize = (buckets + 1) * 8;
+    const qint64 indexSize = INDEX_HEADER_SIZE + directorySize + entryCount * ENTRY_SIZE + qint64(size()) * 8;
+
+    QFile out(fileName);
+    uchar *map = nullptr;
+    if (out.open(QIODevice::ReadWrite | QIODevice::Truncate) && out.resize(indexSize))
+        map = out.map(0, indexSize);
+    if (map == nullptr) {
+        setError(error, QString("Can't create %1").arg(out.fileName()));
+        out.remove();
+        spill.remove();
+        return false;
+    }
+    uchar *directory = map + INDEX_HEADER_SIZE;
+    uchar *entries = directory + directorySize;
+    std::memset(directory, 0, size_t(directorySize));
+
+    // every part sorted on its own is a run of buckets, the directory counts them first
+    qint64 next = 0;
+    for (auto part = 0; part < parts && isOk && !isCancelled(); part++) {
+        QVector<IndexEntry> sorted;
+        for (const auto &chunk : partChunks.at(part)) {
+            const int bytes = chunk.count * int(sizeof(IndexEntry));
+            sorted.resize(sorted.size() + chunk.count);
+            isOk = isOk && spill.seek(chunk.offset)
+                && spill.read(reinterpret_cast<char*>(sorted.data() + sorted.size() - chunk.count), bytes) == bytes;
+        }
+        sorted += partEntries.at(part);
+        partEntries[part].clear();
+        std::sort(sorted.begin(), sorted.end());
+
+        for (const auto &entry : sorted) {
+            uchar *p = entries + next++ * ENTRY_SIZE;
+            qToLittleEndian<quint64>(entry.key, p);
+            qToLittleEndian<quint32>(entry.game, p + 8);
+            qToLittleEndian<quint32>(entry.ply, p + 12);
+            uchar *count = directory + 8 * (bucketOf(entry.key, bits) + 1);
+            qToLittleEndian<quint64>(qFromLittleEndian<quint64>(count) + 1, count);
+        }
+    }
+    for (qint64 bucket = 1; bucket <= buckets; bucket++) {
+        const quint64 first = qFromLittleEndian<quint64>(directory + 8 * (bucket - 1))
+                            + qFromLittleEndian<quint64>(directory + 8 * bucket);
+        qToLittleEndian<quint64>(first, directory + 8 * bucket);
+    }
+    uchar *offsets = entries + entryCount * ENTRY_SIZE;
+    for (auto game = 0; game < size(); game++)
+        qToLittleEndian<quint64>(quint64(m_offsets.at(game)), offsets + 8 * game);
+
+    // the header goes last, an index left unfinished isn't taken for a valid one
+    std::memcpy(map, indexMagic, sizeof(indexMagic));
+    qToLittleEndian<quint32>(INDEX_VERSION, map + 4);
+    qToLittleEndian<quint64>(Position::startKey(), map + 8);
+    qToLittleEndian<quint64>(quint64(size()), map + 16);
+    qToLittleEndian<quint64>(quint64(m_size), map + 24);
+    qToLittleEndian<quint64>(quint64(entryCount), map + 32);
+    qToLittleEndian<quint32>(quint32(bits), map + 40);
+    out.unmap(map);
+    out.close();
+    spill.remove();
+
+    if (!isOk || isCancelled()) {
+        setError(error, isOk ? QString("Cancelled") : QString("Can't write %1").arg(fileName));
+        out.remove();
+        return false;
+    }
+    return true;
+}
+
+bool GameDatabase::replaceIndex(const QString &fileName, QString *error)
+{
+    const QString indexName = indexFileName(m_file.fileName());
+    m_closeIndex();
+    QFile::remove(indexName);
+    if (!QFile::rename(fileName, indexName)) {
+        setError(error, QString("Can't write %1").arg(indexName));
+        QFile::remove(fileName);
+        return false;
+    }
+    return m_openIndex();
+}
+
+int GameDatabase::find(Key key, QVector<GameHit> &hits, int maxHits) const
+{
+    int count = 0;
+    if (m_index) {
+        // the first entry of the key in its bucket
+        const int bucket = bucketOf(key, m_directoryBits);
+        qint64 low = qFromLittleEndian<qint64>(m_directory + 8 * bucket);
+        qint64 high = qFromLittleEndian<qint64>(m_directory + 8 * (bucket + 1));
+        while (low < high) {
+            const qint64 middle = (low + high) / 2;
+            if (m_entryKey(middle) < key)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        for (auto entry = low; entry < m_entryCount && m_entryKey(entry) == key; entry++, count++) {
+            if (hits.size() < maxHits) {
+                const uchar *p = m_entries + entry * ENTRY_SIZE;
+                hits.append(GameHit{ int(qFromLittleEndian<quint32>(p + 8)), int(qFromLittleEndian<quint32>(p + 12)) });
+            }
+        }
+    }
+
+    // the games added since the index was built
+    GameList games;
+    Position pos;
+    for (auto game = m_indexedGames; game < size(); game++) {
+        games.clear();
+        if (!readGame(game, games) || !pos.setFEN(games.startFEN(0)))
+            continue;
+        const Move *moves = games.moves(0);
+        for (auto ply = 0; ply <= games.plies(0); ply++) {
+            if (pos.key() == key) {
+                if (hits.size() < maxHits)
+                    hits.append(GameHit{ game, ply });
+                count++;
+                break;
+            }
+            if (ply < games.plies(0))
+                pos.doMove(moves[ply]);
+        }
+    }
+    return count;
+}
+
+bool GameDatabase::m_mapGames()
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_fileSize = m_file.size();
+    const char *data = m_fileSize >= GameCodec::HEADER_SIZE
+                     ? reinterpret_cast<const char*>(m_file.map(0, m_fileSize)) : nullptr;
+    if (data == nullptr || !GameCodec::isHeader(data, m_fileSize)) {
+        if (data)
+            m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        m_file.close();
+        m_fileSize = 0;
+        return false;
+    }
+    m_data = data;
+    return true;
+}
+
+void GameDatabase::m_unmapGames()
+{
+    if (m_data)
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    m_file.close();
+    m_data = nullptr;
+    m_fileSize = 0;
+}
+
+void GameDatabase::m_scanGames()
+{
+    // the games are skipped by their sizes, a game running past the end is a torn write
+    while (m_size < m_fileSize) {
+        const qint64 gameSize = GameCodec::gameSize(m_data + m_size, m_fileSize - m_size);
+        if (gameSize == 0)
+            break;
+        m_offsets.append(m_size);
+        m_size += gameSize;
+    }
+}
+
+bool GameDatabase::m_openIndex()
+{
+    m_closeIndex();
+
+    m_indexFile.setFileName(indexFileName(m_file.fileName()));
+    if (!m_indexFile.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 indexSize = m_indexFile.size();
+    const uchar *index = indexSize >= INDEX_HEADER_SIZE ? m_indexFile.map(0, indexSize) : nullptr;
+    if (index == nullptr) {
+        m_indexFile.close();
+        return false;
+    }
+
+    // the index is of these games if it was built for a file of games of this size or smaller
+    const quint64 games = qFromLittleEndian<quint64>(index + 16);
+    const quint64 gamesSize = qFromLittleEndian<quint64>(index + 24);
+    const quint64 entries = qFromLittleEndian<quint64>(index + 32);
+    const quint32 bits = qFromLittleEndian<quint32>(index + 40);
+    bool isValid = std::memcmp(index, indexMagic, sizeof(indexMagic)) == 0
+                && qFromLittleEndian<quint32>(index + 4) == INDEX_VERSION
+                && qFromLittleEndian<quint64>(index + 8) == Position::startKey() // an index of other Zobrist keys is rebuilt
+                && gamesSize >= quint64(GameCodec::HEADER_SIZE) && gamesSize <= quint64(m_fileSize)
+                && games <= gamesSize && entries <= quint64(indexSize) && bits <= MAX_DIRECTORY_BITS
+                && quint64(indexSize) == INDEX_HEADER_SIZE + ((quint64(1) << bits) + 1) * 8 + entries * ENTRY_SIZE + games * 8;
+    const uchar *directory = index + INDEX_HEADER_SIZE;
+    isValid = isValid && qFromLittleEndian<quint64>(directory + 8 * (quint64(1) << bits)) == entries;
+    if (!isValid) {
+        m_indexFile.unmap(const_cast<uchar*>(index));
+        m_indexFile.close();
+        return false;
+    }
+
+    m_index = index;
+    m_indexedGames = int(games);
+    m_entryCount = qint64(entries);
+    m_directoryBits = int(bits);
+    m_directory = directory;
+    m_entries = directory + ((qint64(1) << bits) + 1) * 8;
+    return true;
+}
+
+void GameDatabase::m_closeIndex()
+{
+    if (m_index)
+        m_indexFile.unmap(const_cast<uchar*>(m_index));
+    m_indexFile.close();
+    m_index = m_directory = m_entries = nullptr;
+    m_indexedGames = 0;
+    m_entryCount = 0;
+    m_directoryBits = 0;
+}
+
+Key GameDatabase::m_entryKey(qint64 entry) const
+{
+    return qFromLittleEndian<quint64>(m_entries + entry * ENTRY_SIZE);
+}
+
+}
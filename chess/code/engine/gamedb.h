@@ -0,0 +1,136 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_GAMEDB_H
+#define ENGINE_GAMEDB_H
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "gamelist.h"
+#include "position.h"
+
+//==============================================================
+//                        Game database
+//==============================================================
+
+//    A database is a file of games (see GameCodec) which only grows, and
+//    an index next to it, the file name with ".index", of every position of
+//    every game by its Zobrist key. Both files are mapped, not read. The index,
+//    little endian:
+//      64 bytes header  "CIDX", quint32 version, the key of the start position,
+//                       the games indexed, the size of the file of games they
+//                       take, the number of entries, the bits of the directory
+//      directory        2^bits + 1 quint64, the first entry of every bucket
+//      entries          16 bytes: quint64 key, quint32 game, quint32 ply,
+//                       sorted by key then game, one per game and position
+//      offsets          quint64 offset of every game indexed in the file of games
+//    The bucket of a key is its high bits, Zobrist keys being random the buckets
+//    are even, so a search is a directory read and a binary search of a few
+//    entries. Games added after the index was built are searched by replaying
+//    them until buildIndex() is run again.
+
+namespace engine
+{
+
+//    GameHit is a game reaching the position and the ply it is first reached at
+struct GameHit {
+    int game;
+    int ply;
+};
+
+class GameDatabase {
+public:
+    enum { DEFAULT_BUILD_MB = 256 };
+
+    GameDatabase();
+    ~GameDatabase() { close(); }
+
+    // open: the file of games is created if it doesn't exist, the index is used
+    //      if it was built for the games of this file
+    bool    open(const QString &fileName);
+    void    close();
+    bool    isOpen() const { return m_data != nullptr; }
+    QString fileName() const { return m_file.fileName(); }
+    static QString indexFileName(const QString &fileName) { return fileName + ".index"; }
+
+    // size: the number of games, indexedGames() of them are in the index
+    int     size() const { return m_offsets.size(); }
+    int     indexedGames() const { return m_indexedGames; }
+    qint64  indexEntries() const { return m_entryCount; }
+
+    // addGames: appends the games of the list, false if they can't be written
+    bool    addGames(const GameList &games, QString *error = nullptr);
+    // readGame: appends the game of the database to the list
+    bool    readGame(int game, GameList &games) const;
+
+    // buildIndex:
+    //      Indexes all the games. The entries are sorted in parts of about
+    //      `megabytes` of memory, spilled to temporary files next to the index
+    bool    buildIndex(int megabytes = DEFAULT_BUILD_MB, QString *error = nullptr);
+    // writeIndex:
+    //      The index of all the games written to the file, the database keeps its own:
+    //      find() and readGame() may run on other threads meanwhile. False and no
+    //      file once the cancel flag is raised
+    bool    writeIndex(const QString &fileName, int megabytes = DEFAULT_BUILD_MB,
+                       const QAtomicInt *cancel = nullptr, QString *error = nullptr) const;
+    // replaceIndex: the file written by writeIndex() becomes the index of the database
+    bool    replaceIndex(const QString &fileName, QString *error = nullptr);
+
+    // find:
+    //      The games reaching the position, ordered by game, up to maxHits of them
+    //      are added to `hits`. Returns the number of games reaching the position
+    int     find(Key key, QVector<GameHit> &hits, int maxHits = 1000) const;
+    int     find(const Position &pos, QVector<GameHit> &hits, int maxHits = 1000) const
+    {
+        return find(pos.key(), hits, maxHits);
+    }
+
+private:
+    Q_DISABLE_COPY(GameDatabase)
+
+    bool    m_mapGames();
+    void    m_unmapGames();
+    void    m_scanGames();
+    bool    m_openIndex();
+    void    m_closeIndex();
+    Key     m_entryKey(qint64 entry) const;
+
+    QFile           m_file;
+    const char     *m_data;
+    qint64          m_fileSize;
+    qint64          m_size;      // of the games read, a torn game at the end is left out
+    QVector<qint64> m_offsets;   // of all the games
+
+    QFile           m_indexFile;
+    const uchar    *m_index;
+    int             m_indexedGames;
+    qint64          m_entryCount;
+    int             m_directoryBits;
+    const uchar    *m_directory;
+    const uchar    *m_entries;
+};
+
+}
+
+#endif//ENGINE_GAMEDB_H
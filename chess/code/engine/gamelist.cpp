@@ -0,0 +1,221 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "gamelist.h"
+#include "position.h"
+
+#include <cstring>
+
+namespace engine
+{
+
+qint64 GameList::moveCount() const
+{
+    qint64 count = 0;
+    for (const auto &block : m_blocks)
+        count += block.moves.size();
+    return count;
+}
+
+void GameList::clear()
+{
+    m_games.clear();
+    m_blocks.clear();
+}
+
+QString GameList::tagName(int game, int idx) const
+{
+    int size;
+    const char *data = tagNameData(game, idx, &size);
+    return QString::fromUtf8(data, size);
+}
+
+QString GameList::tagValue(int game, int idx) const
+{
+    int size;
+    const char *data = tagValueData(game, idx, &size);
+    return QString::fromUtf8(data, size);
+}
+
+const char *GameList::tagNameData(int game, int idx, int *size) const
+{
+    const TagRecord &tag = m_tag(game, idx);
+    *size = tag.nameSize;
+    return m_blocks.at(m_games.at(game).block).text.constData() + tag.name;
+}
+
+const char *GameList::tagValueData(int game, int idx, int *size) const
+{
+    const TagRecord &tag = m_tag(game, idx);
+    *size = tag.valueSize;
+    return m_blocks.at(m_games.at(game).block).text.constData() + tag.value;
+}
+
+QString GameList::tag(int game, const QString &name) const
+{
+    const QByteArray utf8 = name.toUtf8();
+    const GameRecord &record = m_games.at(game);
+    const Block &block = m_blocks.at(record.block);
+    for (auto i = record.firstTag; i < record.firstTag + record.tagCount; i++) {
+        const TagRecord &tag = block.tags.at(i);
+        if (tag.nameSize == utf8.size() && memcmp(block.text.constData() + tag.name, utf8.constData(), tag.nameSize) == 0)
+            return QString::fromUtf8(block.text.constData() + tag.value, tag.valueSize);
+    }
+    return QString();
+}
+
+QString GameList::startFEN(int game) const
+{
+    const QString fen = tag(game, "FEN");
+    return fen.isEmpty() ? QString(Position::startFEN()) : fen;
+}
+
+void GameList::beginGame(qint64 offset /*= 0*/)
+{
+    GameRecord record;
+    record.offset = offset;
+    record.block = m_blockForGame();
+    record.firstMove = m_blocks.last().moves.size();
+    record.moveCount = 0;
+    record.firstTag = m_blocks.last().tags.size();
+    record.tagCount = 0;
+    record.result = RESULT_UNKNOWN;
+    record.isComplete = false;
+    m_games.append(record);
+}
+
+void GameList::addTag(const char *name, int nameSize, const char *value, int valueSize, bool isEscaped /*= true*/)
+{
+    Block &block = m_blocks.last();
+    TagRecord tag;
+    tag.name = block.text.size();
+    tag.nameSize = nameSize;
+    block.text.append(name, nameSize);
+
+    tag.value = block.text.size();
+    for (auto i = 0; i < valueSize; i++) {
+        if (isEscaped && value[i] == '\\' && i + 1 < valueSize && (value[i + 1] == '"' || value[i + 1] == '\\'))
+            i++;
+        block.text.append(value[i]);
+    }
+    tag.valueSize = block.text.size() - tag.value;
+
+    block.tags.append(tag);
+    m_games.last().tagCount++;
+}
+
+void GameList::endGame(eResult result, bool isComplete /*= true*/)
+{
+    GameRecord &record = m_games.last();
+    record.moveCount = m_blocks.last().moves.size() - record.firstMove;
+    record.result = quint8(result);
+    record.isComplete = isComplete;
+}
+
+void GameList::append(const GameList &other, int first, int last)
+{
+    // the moves, the tags and their text of the games of a block are contiguous in the
+    // other list, a run of them going to the same block of this one is copied at once
+    // and the offsets into them shifted. The run ends with the block of the other list
+    // or once the block of this one is full
+    for (auto runBegin = first; runBegin < last;) {
+        const GameRecord &firstGame = other.m_games.at(runBegin);
+        const Block &from = other.m_blocks.at(firstGame.block);
+        const int block = m_blockForGame();
+        Block &to = m_blocks[block];
+
+        qint64 bytes = to.bytes();
+        auto runEnd = runBegin;
+        for (; runEnd < last && other.m_games.at(runEnd).block == firstGame.block && bytes < BLOCK_SIZE; runEnd++) {
+            const GameRecord &record = other.m_games.at(runEnd);
+            bytes += record.tagCount * qint64(sizeof(TagRecord)) + record.moveCount * qint64(sizeof(Move));
+            if (record.tagCount > 0) {
+                const TagRecord &lastTag = from.tags.at(record.firstTag + record.tagCount - 1);
+                bytes += lastTag.value + lastTag.valueSize - from.tags.at(record.firstTag).name;
+            }
+        }
+        const GameRecord &lastGame = other.m_games.at(runEnd - 1);
+
+        const int moveShift = to.moves.size() - firstGame.firstMove;
+        const int tagShift = to.tags.size() - firstGame.firstTag;
+        const int movesEnd = lastGame.firstMove + lastGame.moveCount;
+        const int tagsEnd = lastGame.firstTag + lastGame.tagCount;
+        const bool hasTags = tagsEnd > firstGame.firstTag;
+        const int textBegin = hasTags ? from.tags.at(firstGame.firstTag).name : 0;
+        const int textEnd = hasTags ? from.tags.at(tagsEnd - 1).value + from.tags.at(tagsEnd - 1).valueSize : 0;
+        const int textShift = to.text.size() - textBegin;
+
+        to.moves.reserve(to.moves.size() + movesEnd - firstGame.firstMove);
+        for (auto i = firstGame.firstMove; i < movesEnd; i++)
+            to.moves.append(from.moves.at(i));
+        to.text.append(from.text.constData() + textBegin, textEnd - textBegin);
+        for (auto i = firstGame.firstTag; i < tagsEnd; i++) {
+            TagRecord tag = from.tags.at(i);
+            tag.name += textShift;
+            tag.value += textShift;
+            to.tags.append(tag);
+        }
+        for (auto i = runBegin; i < runEnd; i++) {
+            GameRecord record = other.m_games.at(i);
+            record.block = block;
+            record.firstMove += moveShift;
+            record.firstTag += tagShift;
+            m_games.append(record);
+        }
+        runBegin = runEnd;
+    }
+}
+
+GameList::eResult GameList::resultFromString(const char *text, int size)
+{
+    if (size == 3 && text[0] == '1' && text[1] == '-' && text[2] == '0')
+        return WHITE_WINS;
+    if (size == 3 && text[0] == '0' && text[1] == '-' && text[2] == '1')
+        return BLACK_WINS;
+    if (size == 7 && memcmp(text, "1/2-1/2", 7) == 0)
+        return DRAW;
+    return RESULT_UNKNOWN;
+}
+
+const char *GameList::resultToString(eResult result)
+{
+    switch (result) {
+    case WHITE_WINS: return "1-0";
+    case BLACK_WINS: return "0-1";
+    case DRAW:       return "1/2-1/2";
+    default:         return "*";
+    }
+}
+
+const GameList::TagRecord &GameList::m_tag(int game, int idx) const
+{
+    const GameRecord &record = m_games.at(game);
+    return m_blocks.at(record.block).tags.at(record.firstTag + idx);
+}
+
+int GameList::m_blockForGame()
+{
+    if (m_blocks.isEmpty() || m_blocks.last().bytes() >= BLOCK_SIZE)
+        m_blocks.append(Block());
+    return m_blocks.size() - 1;
+}
+
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_GAMELIST_H
+#define ENGINE_GAMELIST_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "types.h"
+
+//==============================================================
+//                         Game list
+//==============================================================
+
+//    GameList holds many replayed games at once: the moves and the tags of all
+//    the games go to a few arrays shared by the list instead of containers of
+//    their own, so adding a game allocates nothing but the growth of the arrays.
+//    The arrays are cut into blocks of about BLOCK_SIZE bytes, a game is never
+//    split between two of them: a list isn't bound by the size of one array and
+//    may hold the games of a database of any size.
+//    A list filled by one thread is its arena, lists are merged by append()
+
+namespace engine
+{
+
+class GameList {
+public:
+    enum eResult {
+        RESULT_UNKNOWN, // * or no result
+        WHITE_WINS,
+        BLACK_WINS,
+        DRAW
+    };
+
+    int     size() const { return m_games.size(); }
+    bool    isEmpty() const { return m_games.isEmpty(); }
+    qint64  moveCount() const;
+    void    clear();
+
+    // plies: number of moves of the game
+    int     plies(int game) const { return m_games.at(game).moveCount; }
+    // moves: of the game from its start position, plies(game) legal moves
+    const Move *moves(int game) const
+    {
+        const GameRecord &record = m_games.at(game);
+        return m_blocks.at(record.block).moves.constData() + record.firstMove;
+    }
+    eResult result(int game) const { return eResult(m_games.at(game).result); }
+    // isComplete: false if the game had a move which couldn't be played, the moves stop before it
+    bool    isComplete(int game) const { return m_games.at(game).isComplete; }
+    // offset: of the game in its source, a file offset for the games of a PGN file
+    qint64  offset(int game) const { return m_games.at(game).offset; }
+
+    int     tagCount(int game) const { return m_games.at(game).tagCount; }
+    QString tagName(int game, int idx) const;
+    QString tagValue(int game, int idx) const;
+    // tagNameData, tagValueData: the UTF-8 bytes of the tag in the list, not copied
+    const char *tagNameData(int game, int idx, int *size) const;
+    const char *tagValueData(int game, int idx, int *size) const;
+    // tag: value of the tag, empty if there is no such tag
+    QString tag(int game, const QString &name) const;
+    // startFEN: the FEN tag of the games starting from a set up position, else the start position
+    QString startFEN(int game) const;
+
+    // beginGame:
+    //      Starts a new game, addTag() and addMove() add to it until endGame()
+    void    beginGame(qint64 offset = 0);
+    // addTag: the value as written in PGN, the escapes \" and \\ are resolved unless isEscaped is false
+    void    addTag(const char *name, int nameSize, const char *value, int valueSize, bool isEscaped = true);
+    void    addMove(Move move) { m_blocks.last().moves.append(move); }
+    void    endGame(eResult result, bool isComplete = true);
+
+    // append: the games first to last - 1 of the other list, added in their order
+    void    append(const GameList &other, int first, int last);
+
+    static eResult resultFromString(const char *text, int size);
+    static const char *resultToString(eResult result);
+
+private:
+    enum { BLOCK_SIZE = 64 << 20 }; // bytes of the moves, the tags and their text
+
+    struct GameRecord {
+        qint64 offset;
+        int    block;
+        int    firstMove; // in the block
+        int    moveCount;
+        int    firstTag;
+        int    tagCount;
+        quint8 result;
+        bool   isComplete;
+    };
+    struct TagRecord {
+        int name;      // offsets into the text of the block
+        int nameSize;
+        int value;
+        int valueSize;
+    };
+    struct Block {
+        QVector<TagRecord> tags;
+        QVector<Move>      moves;
+        QByteArray         text; // the names and values of the tags
+
+        qint64 bytes() const
+        {
+            return qint64(tags.size()) * sizeof(TagRecord) + qint64(moves.size()) * sizeof(Move) + text.size();
+        }
+    };
+
+    const TagRecord &m_tag(int game, int idx) const;
+    // m_blockForGame: the block the next game goes to, a new one once the last is full
+    int     m_blockForGame();
+
+    QVector<GameRecord> m_games;
+    QVector<Block>      m_blocks;
+};
+
+}
+
+#endif//ENGINE_GAMELIST_H
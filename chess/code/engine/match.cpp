@@ -0,0 +1,302 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "match.h"
+#include "parallel.h"
+#include "movegen.h"
+#include "tablebase.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QVector>
+
+#include <cmath>
+
+namespace engine
+{
+
+namespace
+{
+
+enum eGameEnd {
+    END_CHECKMATE,
+    END_STALEMATE,
+    END_TABLEBASE,
+    END_FIFTY_MOVES,
+    END_REPETITION,
+    END_MATERIAL,   // insufficient material to mate
+    END_MAX_PLIES,
+    END_TIME,       // a side has run out of its clock
+    END_NB
+};
+
+const char *endNames[END_NB] = {
+    "checkmate", "stalemate", "tablebase", "fifty moves", "repetition", "material", "max plies", "time"
+};
+
+//    GameResult is from WHITE point of view: 2 a win, 1 a draw, 0 a loss
+struct GameResult {
+    int      result;
+    eGameEnd end;
+};
+
+// playGame: engines by eColor, both searching on the calling thread
+GameResult playGame(Search *engines[2], const QString &fen, const Match::Options &options)
+{
+    Position pos;
+    pos.setFEN(fen);
+    engines[WHITE]->newGame();
+    engines[BLACK]->newGame();
+
+    qint64 clock[2] = { options.timeMs, options.timeMs };
+    for (auto ply = 0; ; ply++) {
+        const eColor us = pos.sideToMove();
+
+        // the rules of the Chessboard first: a mate given by the hundredth halfmove wins
+        MoveList moves;
+        generateLegalMoves(pos, moves);
+        if (moves.isEmpty()) {
+            if (pos.inCheck())
+                return { us == WHITE ? 0 : 2, END_CHECKMATE };
+            return { 1, END_STALEMATE };
+        }
+        if (Tablebases::canProbe(pos)) {
+            bool isFound = false;
+            const eWdl wdl = Tablebases::probeWdl(pos, &isFound);
+            // cursed wins and blessed losses are drawn by the fifty moves rule
+            if (isFound && wdl == WDL_WIN)
+                return { us == WHITE ? 2 : 0, END_TABLEBASE };
+            if (isFound && wdl == WDL_LOSS)
+                return { us == WHITE ? 0 : 2, END_TABLEBASE };
+            if (isFound)
+                return { 1, END_TABLEBASE };
+        }
+        if (pos.isDraw(0)) {
+            if (pos.rule50() >= 100)
+                return { 1, END_FIFTY_MOVES };
+            return { 1, pos.isRepetition(0) ? END_REPETITION : END_MATERIAL };
+        }
+        if (ply >= options.maxPlies)
+            return { 1, END_MAX_PLIES };
+
+        SearchLimits limits;
+        if (options.nodes > 0) {
+            limits.nodes = options.nodes;
+        } else {
+            limits.time[WHITE] = clock[WHITE];
+            limits.time[BLACK] = clock[BLACK];
+            limits.increment[WHITE] = limits.increment[BLACK] = options.incrementMs;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        const Move move = engines[us]->go(pos, limits).bestMove;
+        if (options.nodes == 0) {
+            clock[us] -= timer.elapsed();
+            if (clock[us] < 0)
+                return { us == WHITE ? 0 : 2, END_TIME };
+            clock[us] += options.incrementMs;
+        }
+        pos.doMove(move);
+    }
+}
+
+}
+
+//==============================================================
+//                          Results
+//==============================================================
+
+double Match::Results::llr(double elo0, double elo1) const
+{
+    // generalized SPRT: the games are approximated by a normal distribution
+    // with the mean and variance of the observed scores
+    const int n = games();
+    if (n == 0)
+        return 0;
+    const double score = (wins + 0.5 * draws) / n;
+    const double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score)
+                           + losses * score * score) / n;
+    if (variance <= 0)
+        return 0;
+    const double score0 = 1 / (1 + std::pow(10.0, -elo0 / 400));
+    const double score1 = 1 / (1 + std::pow(10.0, -elo1 / 400));
+    return n * (score1 - score0) * (2 * score - score0 - score1) / (2 * variance);
+}
+
+double Match::Results::elo(double *margin) const
+{
+    const int n = games();
+    auto eloOf = [](double score) {
+        score = qBound(1e-6, score, 1 - 1e-6);
+        return -400 * std::log10(1 / score - 1);
+    };
+    if (n == 0) {
+        *margin = 0;
+        return 0;
+    }
+    const double score = (wins + 0.5 * draws) / n;
+    const double variance = (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score)
+                           + losses * score * score) / n;
+    const double deviation = 1.96 * std::sqrt(variance / n);
+    *margin = (eloOf(score + deviation) - eloOf(score - deviation)) / 2;
+    return eloOf(score);
+}
+
+Match::eDecision Match::sprtDecision(double llr, double alpha, double beta)
+{
+    if (llr >= std::log((1 - beta) / alpha))
+        return ACCEPT_H1;
+    if (llr <= std::log(beta / (1 - alpha)))
+        return ACCEPT_H0;
+    return UNDECIDED;
+}
+
+//==============================================================
+//                          Match
+//==============================================================
+
+bool Match::readOpenings(const QString &fileName, QStringList *fens, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = "can't open " + fileName;
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split(' ', QString::SkipEmptyParts);
+        if (fields.size() < 4)
+            continue;
+        // EPD: four fields and operations, FEN: six fields with the move counters
+        QString fen = fields.mid(0, 4).join(' ');
+        bool isFen = fields.size() >= 6;
+        if (isFen) {
+            bool isNumber;
+            fields.at(4).toInt(&isNumber);
+            isFen = isNumber;
+            fields.at(5).toInt(&isNumber);
+            isFen = isFen && isNumber;
+        }
+        fen += isFen ? " " + fields.at(4) + " " + fields.at(5) : QString(" 0 1");
+        Position pos;
+        if (!pos.setFEN(fen)) {
+            *error = "invalid position " + fen;
+            return false;
+        }
+        fens->append(fen);
+    }
+    if (fens->isEmpty()) {
+        *error = "no positions in " + fileName;
+        return false;
+    }
+    return true;
+}
+
+Match::eDecision Match::run(const Player &first, const Player &second, const Options &options, QTextStream &out)
+{
+    const QStringList openings = options.openings.isEmpty() ? QStringList(Position::startFEN()) : options.openings;
+    const int concurrency = qMax(1, options.concurrency);
+
+    out << first.name << " vs " << second.name << ", " << openings.size() << " openings, "
+        << (options.nodes > 0 ? QString("%1 nodes per move").arg(options.nodes)
+                              : QString("%1+%2 s").arg(options.timeMs / 1000.0).arg(options.incrementMs / 1000.0))
+        << ", " << concurrency << " games at once\n";
+    out << QString("SPRT elo0 %1 elo1 %2 alpha %3 beta %4, bounds [%5, %6]\n")
+           .arg(options.elo0).arg(options.elo1).arg(options.alpha).arg(options.beta)
+           .arg(std::log(options.beta / (1 - options.alpha)), 0, 'f', 2)
+           .arg(std::log((1 - options.beta) / options.alpha), 0, 'f', 2);
+    out.flush();
+
+    QAtomicInt nextGame(0);
+    QAtomicInt stop(0);
+    QMutex mutex; // guards everything below
+    Results results;
+    int ends[END_NB] = {};
+    eDecision decision = UNDECIDED;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto report = [&]() {
+        double margin;
+        const double elo = results.elo(&margin);
+        out << QString("games %1: +%2 -%3 =%4, elo %5 +- %6, LLR %7\n")
+               .arg(results.games(), 6).arg(results.wins).arg(results.losses).arg(results.draws)
+               .arg(elo, 0, 'f', 1).arg(margin, 0, 'f', 1)
+               .arg(results.llr(options.elo0, options.elo1), 0, 'f', 2);
+        out.flush();
+    };
+
+    runParallel(concurrency, [&](int) {
+        Search engines[2];
+        engines[0].setHashSize(first.hashMB);
+        engines[0].setOptions(first.options);
+        engines[1].setHashSize(second.hashMB);
+        engines[1].setOptions(second.options);
+
+        for (;;) {
+            const int game = nextGame.fetchAndAddRelaxed(1);
+            if (game >= options.maxGames || stop.load())
+                break;
+            // every opening twice, the first player is white in the even games
+            const bool firstIsWhite = game % 2 == 0;
+            Search *byColor[2] = { &engines[firstIsWhite ? 0 : 1], &engines[firstIsWhite ? 1 : 0] };
+            const GameResult played = playGame(byColor, openings.at((game / 2) % openings.size()), options);
+            const int firstScore = firstIsWhite ? played.result : 2 - played.result;
+
+            QMutexLocker locker(&mutex);
+            if (decision != UNDECIDED)
+                continue; // games finishing after the decision don't count
+            if (firstScore == 2)      results.wins++;
+            else if (firstScore == 0) results.losses++;
+            else                      results.draws++;
+            ends[played.end]++;
+
+            decision = sprtDecision(results.llr(options.elo0, options.elo1), options.alpha, options.beta);
+            if (decision != UNDECIDED || results.games() % 10 == 0)
+                report();
+            if (decision != UNDECIDED)
+                stop.store(1);
+        }
+    });
+
+    if (results.games() % 10 != 0 && decision == UNDECIDED)
+        report();
+    out << "game ends:";
+    for (auto end = 0; end < END_NB; end++)
+        if (ends[end])
+            out << " " << endNames[end] << " " << ends[end];
+    out << "\n";
+    out << "time " << timer.elapsed() / 1000 << " s, ";
+    if (decision == ACCEPT_H1)
+        out << "H1 accepted: " << first.name << " is stronger\n";
+    else if (decision == ACCEPT_H0)
+        out << "H0 accepted: " << first.name << " isn't stronger by " << options.elo1 << " Elo\n";
+    else
+        out << "no decision after " << results.games() << " games\n";
+    out.flush();
+    return decision;
+}
+
+}
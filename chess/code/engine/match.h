@@ -0,0 +1,107 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_MATCH_H
+#define ENGINE_MATCH_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include "search.h"
+
+//==============================================================
+//                      Engine matches
+//==============================================================
+
+//    Fast games between two configurations of the built-in engine, every opening
+//    of the suite played twice with the colors reversed. Each game runs on a single
+//    thread with its own clocks, so as many games as cores are played at once.
+//    Games end as on the Chessboard: checkmate, stalemate and tablebase results
+//    (if tables are loaded), plus the fifty moves rule, threefold repetition and
+//    insufficient material of the engine. The match stops as soon as the sequential
+//    probability ratio test tells whether the first player is stronger.
+
+namespace engine
+{
+
+namespace Match
+{
+    //    Player is a configuration of the engine
+    struct Player {
+        Player() : name("engine"), hashMB(16) {}
+
+        QString       name;
+        SearchOptions options;
+        int           hashMB;
+    };
+
+    struct Options {
+        Options() : concurrency(1), maxGames(20000), timeMs(10000), incrementMs(100), nodes(0), maxPlies(400),
+                    elo0(0), elo1(5), alpha(0.05), beta(0.05) {}
+
+        int         concurrency;  // games played at once
+        int         maxGames;     // the match stops here if the test hasn't decided before
+        qint64      timeMs;       // clock of each side in milliseconds
+        qint64      incrementMs;  // added to the clock after every move
+        qint64      nodes;        // nodes per move instead of the clocks if not 0
+        int         maxPlies;     // longer games are drawn
+        QStringList openings;     // FENs, the start position if empty
+        double      elo0;         // SPRT hypotheses: the first player is elo0 (H0)
+        double      elo1;         //      or elo1 (H1) stronger than the second one
+        double      alpha;        // probability to accept H1 when H0 is true
+        double      beta;         // probability to accept H0 when H1 is true
+    };
+
+    enum eDecision {
+        UNDECIDED,
+        ACCEPT_H0,
+        ACCEPT_H1
+    };
+
+    //    Results counts the games from the point of view of the first player
+    struct Results {
+        Results() : wins(0), losses(0), draws(0) {}
+
+        int     games() const { return wins + losses + draws; }
+        // llr: log-likelihood ratio of H1 against H0 with the logistic Elo model
+        double  llr(double elo0, double elo1) const;
+        // elo: difference estimated from the score, `margin` gets the 95% confidence half-width
+        double  elo(double *margin) const;
+
+        int     wins;
+        int     losses;
+        int     draws;
+    };
+
+    // sprtDecision: the bounds of the test are ln(beta / (1 - alpha)) and ln((1 - beta) / alpha)
+    eDecision   sprtDecision(double llr, double alpha, double beta);
+
+    // readOpenings: FEN or EPD lines of the file, the opcodes of EPD lines are dropped
+    bool        readOpenings(const QString &fileName, QStringList *fens, QString *error);
+
+    // run: plays the match, progress and the final statistics go to `out`
+    eDecision   run(const Player &first, const Player &second, const Options &options, QTextStream &out);
+}
+
+}
+
+#endif//ENGINE_MATCH_H
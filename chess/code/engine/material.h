@@ -0,0 +1,82 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_MATERIAL_H
+#define ENGINE_MATERIAL_H
+
+#include <QString>
+#include <QStringList>
+
+#include <cstring>
+
+#include "types.h"
+
+//==============================================================
+//                      Table material
+//==============================================================
+
+//    The material of an endgame table as the Syzygy and the DTM tables
+//    name and look it up, internal to tablebase.cpp and dtm.cpp
+
+namespace engine
+{
+
+namespace Material
+{
+
+const char pieceLetters[] = "PNBRQK"; // by ePieceType
+
+// key: pieces but kings counted by color and type, 3 bits each,
+//      `flip` counts BLACK as WHITE and the other way around
+inline quint32 key(const int counts[2][6], bool flip)
+{
+    quint32 key = 0;
+    for (auto color = 0; color < 2; color++)
+        for (auto type = int(PAWN); type < int(KING); type++)
+            key |= quint32(counts[color ^ (flip ? 1 : 0)][type]) << (3 * (5 * color + type));
+    return key;
+}
+
+// parseName: piece counts of a table name like KRPvKR, false if it isn't one
+inline bool parseName(const QString &name, int counts[2][6])
+{
+    std::memset(counts, 0, sizeof(int) * 12);
+    const QStringList sides = name.split('v');
+    if (sides.size() != 2)
+        return false;
+    for (auto side = 0; side < 2; side++) {
+        for (auto i = 0; i < sides.at(side).size(); i++) {
+            const char *letter = std::strchr(pieceLetters, sides.at(side).at(i).toLatin1());
+            if (letter == nullptr || *letter == '\0')
+                return false;
+            counts[side][letter - pieceLetters]++;
+        }
+        if (counts[side][KING] != 1)
+            return false;
+    }
+    return true;
+}
+
+}
+
+}
+
+#endif//ENGINE_MATERIAL_H
@@ -0,0 +1,201 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "movegen.h"
+
+namespace engine
+{
+
+namespace
+{
+
+void addPromotions(MoveList &moves, int from, int to, bool isCapture, eGenType type)
+{
+    // queen promotions and all capture promotions are tactical moves
+    if (type != GEN_QUIETS)
+        moves.add(makePromotion(from, to, QUEEN, isCapture));
+    if (type == GEN_ALL || (type == GEN_CAPTURES) == isCapture) {
+        moves.add(makePromotion(from, to, KNIGHT, isCapture));
+        moves.add(makePromotion(from, to, BISHOP, isCapture));
+        moves.add(makePromotion(from, to, ROOK, isCapture));
+    }
+}
+
+void generatePawnMoves(const Position &pos, MoveList &moves, eGenType type)
+{
+    const eColor us = pos.sideToMove();
+    const eColor them = opposite(us);
+    const int push = us == WHITE ? 8 : -8;
+    const Bitboard rank8 = us == WHITE ? RANK_8_BB : RANK_1_BB;
+    const Bitboard rank3 = us == WHITE ? (RANK_2_BB << 8) : (RANK_7_BB >> 8);
+    const Bitboard empty = ~pos.pieces();
+    const Bitboard enemies = pos.pieces(them);
+    const Bitboard pawns = pos.pieces(us, PAWN);
+
+    Bitboard single = (us == WHITE ? shiftNorth(pawns) : shiftSouth(pawns)) & empty;
+    Bitboard promotions = single & rank8;
+
+    if (type != GEN_CAPTURES) {
+        Bitboard quiet = single & ~rank8;
+        Bitboard doubles = (us == WHITE ? shiftNorth(single & rank3) : shiftSouth(single & rank3)) & empty;
+        while (quiet) {
+            int to = popLsb(quiet);
+            moves.add(makeMove(to - push, to));
+        }
+        while (doubles) {
+            int to = popLsb(doubles);
+            moves.add(makeMove(to - 2 * push, to, DOUBLE_PAWN_PUSH));
+        }
+    }
+
+    while (promotions) {
+        int to = popLsb(promotions);
+        addPromotions(moves, to - push, to, false, type);
+    }
+
+    if (type != GEN_QUIETS) {
+        // west and east captures
+        Bitboard west = (us == WHITE ? shiftNorth(shiftWest(pawns)) : shiftSouth(shiftWest(pawns))) & enemies;
+        Bitboard east = (us == WHITE ? shiftNorth(shiftEast(pawns)) : shiftSouth(shiftEast(pawns))) & enemies;
+        while (west) {
+            int to = popLsb(west);
+            if (squareBB(to) & rank8) addPromotions(moves, to - push + 1, to, true, type);
+            else moves.add(makeMove(to - push + 1, to, CAPTURE));
+        }
+        while (east) {
+            int to = popLsb(east);
+            if (squareBB(to) & rank8) addPromotions(moves, to - push - 1, to, true, type);
+            else moves.add(makeMove(to - push - 1, to, CAPTURE));
+        }
+
+        if (pos.epSquare() != NO_SQUARE) {
+            Bitboard capturers = Bitboards::pawnAttacks[them][pos.epSquare()] & pawns;
+            while (capturers)
+                moves.add(makeMove(popLsb(capturers), pos.epSquare(), EN_PASSANT));
+        }
+    }
+}
+
+void generatePieceMoves(const Position &pos, MoveList &moves, eGenType type)
+{
+    const eColor us = pos.sideToMove();
+    const Bitboard occupied = pos.pieces();
+    Bitboard targets = 0;
+    if (type != GEN_QUIETS)   targets |= pos.pieces(opposite(us));
+    if (type != GEN_CAPTURES) targets |= ~occupied;
+
+    for (auto pieceType = KNIGHT; pieceType <= KING; pieceType = ePieceType(pieceType + 1)) {
+        Bitboard pieces = pos.pieces(us, pieceType);
+        while (pieces) {
+            const int from = popLsb(pieces);
+            Bitboard attacks;
+            switch (pieceType) {
+                case KNIGHT: attacks = Bitboards::knightAttacks[from]; break;
+                case BISHOP: attacks = bishopAttacks(from, occupied);  break;
+                case ROOK:   attacks = rookAttacks(from, occupied);    break;
+                case QUEEN:  attacks = queenAttacks(from, occupied);   break;
+                default:     attacks = Bitboards::kingAttacks[from];   break;
+            }
+            attacks &= targets;
+            while (attacks) {
+                const int to = popLsb(attacks);
+                moves.add(makeMove(from, to, pos.isEmpty(to) ? QUIET_MOVE : CAPTURE));
+            }
+        }
+    }
+}
+
+void generateCastling(const Position &pos, MoveList &moves)
+{
+    // only emptiness is checked here, attacked squares are left to Position::isLegal()
+    const eColor us = pos.sideToMove();
+    const int kingSq = us == WHITE ? E1 : E8;
+    const int rights = pos.castlingRights();
+    const Bitboard occupied = pos.pieces();
+
+    if ((rights & (us == WHITE ? WHITE_OO : BLACK_OO)) && !(Bitboards::between[kingSq][kingSq + 3] & occupied))
+        moves.add(makeMove(kingSq, kingSq + 2, KING_CASTLE));
+    if ((rights & (us == WHITE ? WHITE_OOO : BLACK_OOO)) && !(Bitboards::between[kingSq][kingSq - 4] & occupied))
+        moves.add(makeMove(kingSq, kingSq - 2, QUEEN_CASTLE));
+}
+
+}
+
+void generateMoves(const Position &pos, MoveList &moves, eGenType type /*= GEN_ALL*/)
+{
+    generatePawnMoves(pos, moves, type);
+    generatePieceMoves(pos, moves, type);
+    if (type != GEN_CAPTURES)
+        generateCastling(pos, moves);
+}
+
+void generateLegalMoves(const Position &pos, MoveList &moves)
+{
+    MoveList pseudoLegal;
+    generateMoves(pos, pseudoLegal, GEN_ALL);
+    for (const auto &scored : pseudoLegal)
+        if (pos.isLegal(scored.move))
+            moves.add(scored.move);
+}
+
+QString moveToString(Move move)
+{
+    if (move == NO_MOVE)
+        return QString("0000");
+
+    QString result;
+    result += QChar('a' + fileOf(moveFrom(move)));
+    result += QChar('1' + rankOf(moveFrom(move)));
+    result += QChar('a' + fileOf(moveTo(move)));
+    result += QChar('1' + rankOf(moveTo(move)));
+    if (isPromotionMove(move))
+        result += QChar("nbrq"[promotionType(move) - KNIGHT]);
+    return result;
+}
+
+Move moveFromString(const Position &pos, const QString &text)
+{
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    const QString lower = text.toLower();
+    for (const auto &scored : moves)
+        if (moveToString(scored.move) == lower)
+            return scored.move;
+    return NO_MOVE;
+}
+
+quint64 perft(Position &pos, int depth)
+{
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (depth <= 1)
+        return depth == 1 ? quint64(moves.size()) : 1;
+
+    quint64 nodes = 0;
+    for (const auto &scored : moves) {
+        pos.doMove(scored.move);
+        nodes += perft(pos, depth - 1);
+        pos.undoMove(scored.move);
+    }
+    return nodes;
+}
+
+}
@@ -0,0 +1,63 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_MOVEGEN_H
+#define ENGINE_MOVEGEN_H
+
+#include <QString>
+
+#include "position.h"
+
+//==============================================================
+//                      Move generation
+//==============================================================
+
+namespace engine
+{
+
+enum eGenType {
+    GEN_CAPTURES, // captures, capture promotions and queen promotions
+    GEN_QUIETS,   // the rest: quiet moves, castling and quiet underpromotions
+    GEN_ALL
+};
+
+// generateMoves:
+//      Appends pseudo legal moves of the side to move, the moves may leave
+//      own king in check and have to be checked by Position::isLegal()
+void    generateMoves(const Position &pos, MoveList &moves, eGenType type = GEN_ALL);
+// generateLegalMoves:
+//      Appends legal moves only
+void    generateLegalMoves(const Position &pos, MoveList &moves);
+
+// moveToString:
+//      Move in coordinate notation used by UCI: e2e4, e7e8q, e1g1 for castling
+QString moveToString(Move move);
+// moveFromString:
+//      Searches the legal move given in coordinate notation, NO_MOVE if there is none
+Move    moveFromString(const Position &pos, const QString &text);
+
+// perft:
+//      Counts leaf nodes of the legal move tree, validates the generator
+quint64 perft(Position &pos, int depth);
+
+}
+
+#endif//ENGINE_MOVEGEN_H
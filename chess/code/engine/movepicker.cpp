@@ -0,0 +1,205 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "movepicker.h"
+#include "movegen.h"
+#include "evaluation.h"
+#include "see.h"
+
+#include <cstring>
+
+namespace engine
+{
+
+//==============================================================
+//                      HistoryTable
+//==============================================================
+
+void HistoryTable::clear()
+{
+    std::memset(m_table, 0, sizeof(m_table));
+}
+
+void HistoryTable::update(eColor color, Move move, int bonus)
+{
+    int &entry = m_table[color][move & 0xFFF];
+    bonus = qBound(-int(MAX_HISTORY), bonus, int(MAX_HISTORY));
+    entry += bonus - entry * qAbs(bonus) / MAX_HISTORY;
+}
+
+
+//==============================================================
+//                      MovePicker
+//==============================================================
+
+MovePicker::MovePicker(const Position &pos, Move ttMove, const Move *killers, const HistoryTable *history)
+    : m_pos(pos)
+{
+    m_history = history;
+    m_ordered = history != nullptr;
+    m_ttMove = ttMove != NO_MOVE && pos.isPseudoLegal(ttMove) ? ttMove : NO_MOVE;
+    m_killers[0] = killers ? killers[0] : NO_MOVE;
+    m_killers[1] = killers ? killers[1] : NO_MOVE;
+    m_stage = m_ttMove != NO_MOVE ? STAGE_TT_MOVE : STAGE_INIT_CAPTURES;
+    m_current = 0;
+}
+
+MovePicker::MovePicker(const Position &pos, Move ttMove)
+    : m_pos(pos)
+{
+    m_history = nullptr;
+    m_ordered = true;
+    m_ttMove = ttMove != NO_MOVE && isTacticalMove(ttMove) && pos.isPseudoLegal(ttMove) ? ttMove : NO_MOVE;
+    m_killers[0] = m_killers[1] = NO_MOVE;
+    m_stage = m_ttMove != NO_MOVE ? STAGE_QS_TT_MOVE : STAGE_QS_INIT_CAPTURES;
+    m_current = 0;
+}
+
+Move MovePicker::nextMove()
+{
+    switch (m_stage) {
+    case STAGE_TT_MOVE:
+        m_stage++;
+        return m_ttMove;
+
+    case STAGE_INIT_CAPTURES:
+        m_moves.clear();
+        generateMoves(m_pos, m_moves, GEN_CAPTURES);
+        m_scoreCaptures();
+        m_current = 0;
+        m_stage++;
+        // fall through
+    case STAGE_CAPTURES:
+        while (m_current < m_moves.size()) {
+            Move move = m_pickBest();
+            if (move == m_ttMove)
+                continue;
+            // losing captures are tried after the quiet moves
+            if (m_ordered && !seeGE(m_pos, move)) {
+                m_badCaptures.add(move);
+                continue;
+            }
+            return move;
+        }
+        m_stage++;
+        // fall through
+    case STAGE_KILLER_1:
+    case STAGE_KILLER_2:
+        while (m_stage <= STAGE_KILLER_2) {
+            // a killer comes from a sibling node and may be illegal or a capture here
+            Move killer = m_killers[m_stage - STAGE_KILLER_1];
+            m_stage++;
+            if (killer != NO_MOVE && killer != m_ttMove &&
+                !isTacticalMove(killer) && m_pos.isPseudoLegal(killer))
+                return killer;
+        }
+        // fall through
+    case STAGE_INIT_QUIETS:
+        m_moves.clear();
+        generateMoves(m_pos, m_moves, GEN_QUIETS);
+        m_scoreQuiets();
+        m_current = 0;
+        m_stage++;
+        // fall through
+    case STAGE_QUIETS:
+        while (m_current < m_moves.size()) {
+            Move move = m_pickBest();
+            if (move != m_ttMove && !m_isKiller(move))
+                return move;
+        }
+        m_current = 0;
+        m_stage++;
+        // fall through
+    case STAGE_BAD_CAPTURES:
+        if (m_current < m_badCaptures.size())
+            return m_badCaptures.move(m_current++);
+        m_stage = STAGE_DONE;
+        return NO_MOVE;
+
+    case STAGE_QS_TT_MOVE:
+        m_stage++;
+        return m_ttMove;
+
+    case STAGE_QS_INIT_CAPTURES:
+        m_moves.clear();
+        generateMoves(m_pos, m_moves, GEN_CAPTURES);
+        m_scoreCaptures();
+        m_current = 0;
+        m_stage++;
+        // fall through
+    case STAGE_QS_CAPTURES:
+        while (m_current < m_moves.size()) {
+            Move move = m_pickBest();
+            if (move != m_ttMove)
+                return move;
+        }
+        m_stage = STAGE_DONE;
+        // fall through
+    default:
+        return NO_MOVE;
+    }
+}
+
+void MovePicker::m_scoreCaptures()
+{
+    if (!m_ordered)
+        return;
+
+    // most valuable victim first, the least valuable attacker breaks ties
+    for (auto &scored : m_moves) {
+        const Move move = scored.move;
+        int victim = 0;
+        if (isEnPassantMove(move))
+            victim = PAWN_VALUE;
+        else if (isCaptureMove(move))
+            victim = pieceValue[typeOf(m_pos.pieceOn(moveTo(move)))];
+        if (isPromotionMove(move))
+            victim += pieceValue[promotionType(move)] - PAWN_VALUE;
+        scored.score = victim * 8 - typeOf(m_pos.movedPiece(move));
+    }
+}
+
+void MovePicker::m_scoreQuiets()
+{
+    if (!m_ordered)
+        return;
+
+    const eColor us = m_pos.sideToMove();
+    for (auto &scored : m_moves)
+        scored.score = m_history->get(us, scored.move);
+}
+
+Move MovePicker::m_pickBest()
+{
+    int best = m_current;
+    for (auto i = m_current + 1; i < m_moves.size(); i++)
+        if (m_moves[i].score > m_moves[best].score)
+            best = i;
+    qSwap(m_moves[best], m_moves[m_current]);
+    return m_moves[m_current++].move;
+}
+
+bool MovePicker::m_isKiller(Move move) const
+{
+    return move == m_killers[0] || move == m_killers[1];
+}
+
+}
@@ -0,0 +1,107 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_MOVEPICKER_H
+#define ENGINE_MOVEPICKER_H
+
+#include "position.h"
+
+//==============================================================
+//                      Move ordering
+//==============================================================
+
+namespace engine
+{
+
+//    HistoryTable is the butterfly history: how often a quiet move
+//    caused a cutoff, indexed by side to move and from/to squares only
+class HistoryTable {
+public:
+    enum { MAX_HISTORY = 16384 };
+
+    HistoryTable() { clear(); }
+
+    void    clear();
+    int     get(eColor color, Move move) const { return m_table[color][move & 0xFFF]; }
+    // update: the bonus (negative for a malus) is damped as the score
+    //      approaches MAX_HISTORY so old statistics fade out
+    void    update(eColor color, Move move, int bonus);
+
+private:
+    int     m_table[2][64 * 64];
+};
+
+//    MovePicker hands out pseudo legal moves one by one in stages:
+//      1. hash move
+//      2. captures and queen promotions not losing material (SEE), MVV-LVA order
+//      3. two killer moves of the ply
+//      4. quiet moves in history order
+//      5. losing captures
+//    The quiescence search gets the hash move and all the captures only.
+//    Each stage generates its moves only when it is reached, so a cutoff
+//    by the hash move or a capture saves the generation of quiet moves.
+class MovePicker {
+public:
+    // killers and history may be null, moves are not ordered within a stage then
+    MovePicker(const Position &pos, Move ttMove, const Move *killers, const HistoryTable *history);
+    // quiescence search: captures and queen promotions only
+    MovePicker(const Position &pos, Move ttMove);
+
+    // nextMove: NO_MOVE when all the stages are exhausted
+    Move    nextMove();
+
+private:
+    enum eStage {
+        STAGE_TT_MOVE,
+        STAGE_INIT_CAPTURES,
+        STAGE_CAPTURES,
+        STAGE_KILLER_1,
+        STAGE_KILLER_2,
+        STAGE_INIT_QUIETS,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_QS_TT_MOVE,
+        STAGE_QS_INIT_CAPTURES,
+        STAGE_QS_CAPTURES,
+        STAGE_DONE
+    };
+
+    void    m_scoreCaptures();
+    void    m_scoreQuiets();
+    // m_pickBest: moves the best scored of the remaining moves to the current index
+    Move    m_pickBest();
+    bool    m_isKiller(Move move) const;
+
+    const Position     &m_pos;
+    const HistoryTable *m_history;
+    bool     m_ordered;
+    Move     m_ttMove;
+    Move     m_killers[2];
+    int      m_stage;
+
+    MoveList m_moves;
+    int      m_current;
+    MoveList m_badCaptures;
+};
+
+}
+
+#endif//ENGINE_MOVEPICKER_H
@@ -0,0 +1,321 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "nnue.h"
+
+#include <QFile>
+#include <QByteArray>
+
+#include <cstring>
+
+// Kernels are chosen at compile time: AVX2 builds define __AVX2__,
+// for SSE4.1 gcc/clang define __SSE4_1__ and MSVC builds define NNUE_SSE41
+#if defined(__AVX2__)
+#  define NNUE_USE_AVX2
+#  include <immintrin.h>
+#elif defined(__SSE4_1__) || defined(NNUE_SSE41)
+#  define NNUE_USE_SSE41
+#  include <smmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+//    Network parameters, read only once loaded and shared by all the threads
+struct Network {
+    qint16 featureWeights[Nnue::INPUTS][Nnue::HIDDEN];
+    qint16 featureBiases[Nnue::HIDDEN];
+    qint8  outputWeights[2 * Nnue::HIDDEN];
+    qint32 outputBias;
+};
+
+const char    networkMagic[4] = { 'C', 'N', 'N', 'U' };
+const quint32 networkVersion = 1;
+const int     headerSize = 4 + 2 * sizeof(quint32);
+
+Network *network = nullptr;
+
+Network *allocateNetwork()
+{
+    return static_cast<Network*>(qMallocAligned(sizeof(Network), 64));
+}
+
+void setNetwork(Network *loaded)
+{
+    qFreeAligned(network);
+    network = loaded;
+}
+
+// featureIndex: features are seen from the perspective side, so for BLACK
+//      the board is mirrored vertically and the piece colors are swapped
+inline int featureIndex(eColor perspective, int piece, int square)
+{
+    if (perspective == BLACK) {
+        piece = piece < 6 ? piece + 6 : piece - 6;
+        square ^= 56;
+    }
+    return piece * 64 + square;
+}
+
+// == Kernels ==
+
+// applyDelta: dst = src + sum of added rows - sum of removed rows, dst may be src
+void applyDelta(qint16 *dst, const qint16 *src,
+                const qint16 *const *added, int addedCount,
+                const qint16 *const *removed, int removedCount)
+{
+#if defined(NNUE_USE_AVX2)
+    for (auto i = 0; i < Nnue::HIDDEN; i += 16) {
+        __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        for (auto k = 0; k < addedCount; k++)
+            sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(added[k] + i)));
+        for (auto k = 0; k < removedCount; k++)
+            sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(removed[k] + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), sum);
+    }
+#elif defined(NNUE_USE_SSE41)
+    for (auto i = 0; i < Nnue::HIDDEN; i += 8) {
+        __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        for (auto k = 0; k < addedCount; k++)
+            sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(added[k] + i)));
+        for (auto k = 0; k < removedCount; k++)
+            sum = _mm_sub_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(removed[k] + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), sum);
+    }
+#else
+    for (auto i = 0; i < Nnue::HIDDEN; i++) {
+        int sum = src[i];
+        for (auto k = 0; k < addedCount; k++)
+            sum += added[k][i];
+        for (auto k = 0; k < removedCount; k++)
+            sum -= removed[k][i];
+        dst[i] = qint16(sum);
+    }
+#endif
+}
+
+// dotClipped: sum of clamp(input, 0, ACTIVATION_MAX) * weights over HIDDEN values
+int dotClipped(const qint16 *input, const qint8 *weights)
+{
+#if defined(NNUE_USE_AVX2)
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i maxValue = _mm256_set1_epi8(Nnue::ACTIVATION_MAX);
+    __m256i sum = _mm256_setzero_si256();
+    for (auto i = 0; i < Nnue::HIDDEN; i += 32) {
+        const __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        const __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16));
+        // saturating pack to unsigned bytes clips to [0, 255], ACTIVATION_MAX is taken after it;
+        // the pack works within 128-bit lanes, so the quadwords are put back in order
+        __m256i packed = _mm256_min_epu8(_mm256_packus_epi16(in0, in1), maxValue);
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // u8 x s8 pairs to s16: at most 2 * 127 * 128, no saturation
+        const __m256i products = _mm256_maddubs_epi16(packed, w);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(NNUE_USE_SSE41)
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i maxValue = _mm_set1_epi8(Nnue::ACTIVATION_MAX);
+    __m128i sum = _mm_setzero_si128();
+    for (auto i = 0; i < Nnue::HIDDEN; i += 16) {
+        const __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        const __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+        // saturating pack to unsigned bytes clips to [0, 255], ACTIVATION_MAX is taken after it
+        const __m128i packed = _mm_min_epu8(_mm_packus_epi16(in0, in1), maxValue);
+        const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(packed, w), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (auto i = 0; i < Nnue::HIDDEN; i++)
+        sum += qBound(0, int(input[i]), int(Nnue::ACTIVATION_MAX)) * weights[i];
+    return sum;
+#endif
+}
+
+}
+
+bool Nnue::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray data = file.readAll();
+    if (data.size() < headerSize)
+        return false;
+
+    quint32 version = 0, hidden = 0;
+    std::memcpy(&version, data.constData() + 4, sizeof(quint32));
+    std::memcpy(&hidden, data.constData() + 8, sizeof(quint32));
+    if (std::memcmp(data.constData(), networkMagic, 4) != 0 || version != networkVersion || hidden != HIDDEN)
+        return false;
+
+    const int featureBytes = INPUTS * HIDDEN * sizeof(qint16) + HIDDEN * sizeof(qint16);
+    const int outputBytes = 2 * HIDDEN * sizeof(qint8) + sizeof(qint32);
+    if (data.size() != headerSize + featureBytes + outputBytes)
+        return false;
+
+    Network *loaded = allocateNetwork();
+    if (!loaded)
+        return false;
+
+    const char *src = data.constData() + headerSize;
+    std::memcpy(loaded->featureWeights, src, sizeof(loaded->featureWeights));
+    src += sizeof(loaded->featureWeights);
+    std::memcpy(loaded->featureBiases, src, sizeof(loaded->featureBiases));
+    src += sizeof(loaded->featureBiases);
+    std::memcpy(loaded->outputWeights, src, sizeof(loaded->outputWeights));
+    src += sizeof(loaded->outputWeights);
+    std::memcpy(&loaded->outputBias, src, sizeof(loaded->outputBias));
+
+    setNetwork(loaded);
+    return true;
+}
+
+void Nnue::unload()
+{
+    setNetwork(nullptr);
+}
+
+void Nnue::initRandom(quint64 seed)
+{
+    Network *random = allocateNetwork();
+    if (!random)
+        return;
+
+    // xorshift64, small weights keep the accumulator far from overflow
+    quint64 state = seed ? seed : 1;
+    auto next = [&state](int range) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return int(state % quint64(2 * range + 1)) - range;
+    };
+
+    for (auto feature = 0; feature < INPUTS; feature++)
+        for (auto i = 0; i < HIDDEN; i++)
+            random->featureWeights[feature][i] = qint16(next(16));
+    for (auto i = 0; i < HIDDEN; i++)
+        random->featureBiases[i] = qint16(next(32) + 32);
+    for (auto i = 0; i < 2 * HIDDEN; i++)
+        random->outputWeights[i] = qint8(next(64));
+    random->outputBias = 0;
+
+    setNetwork(random);
+}
+
+bool Nnue::isLoaded()
+{
+    return network != nullptr;
+}
+
+const char *Nnue::simdName()
+{
+#if defined(NNUE_USE_AVX2)
+    return "AVX2";
+#elif defined(NNUE_USE_SSE41)
+    return "SSE4.1";
+#else
+    return "scalar";
+#endif
+}
+
+void Nnue::refresh(Accumulator &acc, const Position &pos)
+{
+    for (auto perspective = WHITE; perspective <= BLACK; perspective = eColor(perspective + 1)) {
+        qint16 *values = acc.values[perspective];
+        std::memcpy(values, network->featureBiases, sizeof(network->featureBiases));
+
+        Bitboard occupied = pos.pieces();
+        while (occupied) {
+            const int square = popLsb(occupied);
+            const qint16 *row = network->featureWeights[featureIndex(perspective, pos.pieceOn(square), square)];
+            applyDelta(values, values, &row, 1, nullptr, 0);
+        }
+    }
+}
+
+void Nnue::update(Accumulator &acc, const Accumulator &parent, const Position &pos, Move move)
+{
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int piece = pos.movedPiece(move);
+    const eColor us = colorOf(piece);
+
+    // a move changes at most two features each way: castling moves the rook too,
+    // a capture removes the captured piece
+    int addedPieces[2], addedSquares[2], removedPieces[2], removedSquares[2];
+    int addedCount = 0, removedCount = 0;
+
+    removedPieces[removedCount] = piece;
+    removedSquares[removedCount++] = from;
+    addedPieces[addedCount] = isPromotionMove(move) ? makePiece(us, promotionType(move)) : piece;
+    addedSquares[addedCount++] = to;
+
+    if (isCastlingMove(move)) {
+        const int rook = makePiece(us, ROOK);
+        removedPieces[removedCount] = rook;
+        removedSquares[removedCount++] = moveFlag(move) == KING_CASTLE ? to + 1 : to - 2;
+        addedPieces[addedCount] = rook;
+        addedSquares[addedCount++] = moveFlag(move) == KING_CASTLE ? to - 1 : to + 1;
+    } else if (isCaptureMove(move)) {
+        const int capturedSquare = isEnPassantMove(move) ? to + (us == WHITE ? -8 : 8) : to;
+        removedPieces[removedCount] = pos.pieceOn(capturedSquare);
+        removedSquares[removedCount++] = capturedSquare;
+    }
+
+    for (auto perspective = WHITE; perspective <= BLACK; perspective = eColor(perspective + 1)) {
+        const qint16 *added[2], *removed[2];
+        for (auto i = 0; i < addedCount; i++)
+            added[i] = network->featureWeights[featureIndex(perspective, addedPieces[i], addedSquares[i])];
+        for (auto i = 0; i < removedCount; i++)
+            removed[i] = network->featureWeights[featureIndex(perspective, removedPieces[i], removedSquares[i])];
+        applyDelta(acc.values[perspective], parent.values[perspective], added, addedCount, removed, removedCount);
+    }
+}
+
+int Nnue::evaluate(const Accumulator &acc, eColor sideToMove)
+{
+    const int output = network->outputBias
+                     + dotClipped(acc.values[sideToMove], network->outputWeights)
+                     + dotClipped(acc.values[opposite(sideToMove)], network->outputWeights + HIDDEN);
+    return int(qint64(output) * OUTPUT_SCALE / (ACTIVATION_MAX * WEIGHT_SCALE));
+}
+
+int Nnue::evaluate(const Position &pos)
+{
+    Accumulator acc;
+    refresh(acc, pos);
+    return evaluate(acc, pos.sideToMove());
+}
+
+}
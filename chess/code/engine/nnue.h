@@ -0,0 +1,90 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_NNUE_H
+#define ENGINE_NNUE_H
+
+#include <QString>
+
+#include "position.h"
+
+//==============================================================
+//                  Neural network evaluation
+//==============================================================
+
+//    Efficiently updatable neural network (768 -> 256) x 2 -> 1.
+//    Inputs are the 12 x 64 piece-square features seen from each side.
+//    The first layer outputs (accumulator) are kept per ply and updated
+//    with the few features a move changes instead of being recomputed.
+//    The accumulator is int16, clipped to [0, 127] and multiplied by int8
+//    output weights, with AVX2 or SSE4.1 kernels when the build allows them.
+//
+//    Network file, little endian:
+//      char[4]  "CNNU"
+//      quint32  version, 1
+//      quint32  hidden layer size, 256
+//      qint16   feature weights [768][256], feature index = piece * 64 + square
+//      qint16   feature biases  [256]
+//      qint8    output weights  [2 * 256], the side to move half first
+//      qint32   output bias
+
+namespace engine
+{
+
+namespace Nnue
+{
+    enum {
+        INPUTS         = PIECE_NB * 64,
+        HIDDEN         = 256,
+        ACTIVATION_MAX = 127, // clipped ReLU output 127 stands for 1.0
+        WEIGHT_SCALE   = 64,  // output weights are quantized by 64
+        OUTPUT_SCALE   = 400  // network output 1.0 is 400 centipawns
+    };
+
+    //    Accumulator holds the first layer outputs of both perspectives
+    struct Accumulator {
+        qint16 values[2][HIDDEN]; // by eColor of the perspective
+    };
+
+    // load: reads the network file, the loaded network is kept on failure.
+    //      Must not be called while a search is running
+    bool    load(const QString &fileName);
+    // unload: back to the classical evaluation, must not be called while a search is running
+    void    unload();
+    // initRandom: untrained network with reproducible weights, for benchmarks only
+    void    initRandom(quint64 seed);
+    bool    isLoaded();
+    // simdName: kernels compiled in, "AVX2", "SSE4.1" or "scalar"
+    const char *simdName();
+
+    // refresh: computes the accumulator of the position from scratch
+    void    refresh(Accumulator &acc, const Position &pos);
+    // update: accumulator after the move from the accumulator before it,
+    //      pos is the position before the move is made
+    void    update(Accumulator &acc, const Accumulator &parent, const Position &pos, Move move);
+    // evaluate: centipawns from the side to move point of view
+    int     evaluate(const Accumulator &acc, eColor sideToMove);
+    int     evaluate(const Position &pos);
+}
+
+}
+
+#endif//ENGINE_NNUE_H
@@ -0,0 +1,69 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_PARALLEL_H
+#define ENGINE_PARALLEL_H
+
+#include <QThread>
+#include <QVector>
+#include <QtAlgorithms>
+
+#include <functional>
+
+//==============================================================
+//                      Parallel jobs
+//==============================================================
+
+namespace engine
+{
+
+//    JobThread runs one share of a job split between the threads
+class JobThread : public QThread {
+public:
+    JobThread(const std::function<void(int)> &job, int share) : m_job(job), m_share(share) {}
+
+protected:
+    void run() { m_job(m_share); }
+
+private:
+    const std::function<void(int)> &m_job;
+    int m_share;
+};
+
+// runParallel:
+//      job(share) for the shares 0 to `threads` - 1, the share 0 on the calling thread.
+//      Returns when all the shares are done
+inline void runParallel(int threads, const std::function<void(int)> &job)
+{
+    QVector<JobThread*> workers;
+    for (auto share = 1; share < threads; share++) {
+        workers.append(new JobThread(job, share));
+        workers.last()->start();
+    }
+    job(0);
+    for (auto worker : workers)
+        worker->wait();
+    qDeleteAll(workers);
+}
+
+}
+
+#endif//ENGINE_PARALLEL_H
@@ -0,0 +1,129 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "pawns.h"
+
+#include <cstring>
+
+#include "bitboard.h"
+
+namespace engine
+{
+
+const Score PawnValues::doubled  = Score(-10, -25);
+const Score PawnValues::isolated = Score(-10, -15);
+const Score PawnValues::backward = Score( -8, -12);
+const Score PawnValues::passed[8] = {
+    Score(0, 0), Score(5, 10), Score(5, 15), Score(10, 25),
+    Score(25, 45), Score(45, 80), Score(70, 120), Score(0, 0)
+};
+
+namespace
+{
+
+inline Bitboard adjacentFiles(int square)
+{
+    return shiftEast(fileBB(square)) | shiftWest(fileBB(square));
+}
+
+// countColor: adds the terms of one color with the given sign
+void countColor(eColor us, Bitboard ourPawns, Bitboard theirPawns, int sign, PawnTerms &terms)
+{
+    const int up = us == WHITE ? NORTH : SOUTH;
+
+    Bitboard pawns = ourPawns;
+    while (pawns) {
+        const int square = popLsb(pawns);
+        const Bitboard front = Bitboards::rays[up][square];
+        const Bitboard neighbours = ourPawns & adjacentFiles(square);
+
+        if (front & ourPawns)
+            terms.doubled += sign;
+
+        if (!neighbours) {
+            terms.isolated += sign;
+        } else {
+            // own pawns on the adjacent files may only advance,
+            // the pawn is backward if all of them are already ahead of it
+            const Bitboard supportSpan = adjacentFiles(square) & ~(shiftEast(front) | shiftWest(front));
+            const int stop = square + (us == WHITE ? 8 : -8);
+            if (!(neighbours & supportSpan) && (Bitboards::pawnAttacks[us][stop] & theirPawns))
+                terms.backward += sign;
+        }
+
+        const Bitboard passedSpan = front | shiftEast(front) | shiftWest(front);
+        if (!(passedSpan & theirPawns) && !(front & ourPawns))
+            terms.passed[relativeRank(us, square)] += sign;
+    }
+}
+
+}
+
+void countPawnTerms(Bitboard whitePawns, Bitboard blackPawns, PawnTerms &terms)
+{
+    std::memset(&terms, 0, sizeof(PawnTerms));
+    countColor(WHITE, whitePawns, blackPawns, 1, terms);
+    countColor(BLACK, blackPawns, whitePawns, -1, terms);
+}
+
+Score evaluatePawns(const Position &pos)
+{
+    PawnTerms terms;
+    countPawnTerms(pos.pieces(WHITE, PAWN), pos.pieces(BLACK, PAWN), terms);
+
+    Score score;
+    score.mg = terms.doubled * PawnValues::doubled.mg + terms.isolated * PawnValues::isolated.mg
+             + terms.backward * PawnValues::backward.mg;
+    score.eg = terms.doubled * PawnValues::doubled.eg + terms.isolated * PawnValues::isolated.eg
+             + terms.backward * PawnValues::backward.eg;
+    for (auto rank = 1; rank < 7; rank++) {
+        score.mg += terms.passed[rank] * PawnValues::passed[rank].mg;
+        score.eg += terms.passed[rank] * PawnValues::passed[rank].eg;
+    }
+    return score;
+}
+
+//==============================================================
+//                      PawnTable
+//==============================================================
+
+void PawnTable::clear()
+{
+    // pawn keys start from Zobrist::noPawns, zero never matches a real key
+    std::memset(m_entries, 0, sizeof(m_entries));
+    resetStats();
+}
+
+Score PawnTable::probe(const Position &pos)
+{
+    const Key key = pos.pawnKey();
+    Entry &entry = m_entries[key & (SIZE - 1)];
+    m_probes++;
+    if (entry.key == key) {
+        m_hits++;
+        return entry.score;
+    }
+    entry.key = key;
+    entry.score = evaluatePawns(pos);
+    return entry.score;
+}
+
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_PAWNS_H
+#define ENGINE_PAWNS_H
+
+#include "position.h"
+
+//==============================================================
+//                  Pawn structure evaluation
+//==============================================================
+
+namespace engine
+{
+
+//    PawnTerms counts how many times every pawn structure term applies,
+//    the ones of WHITE minus the ones of BLACK
+struct PawnTerms {
+    int doubled;    // pawns with an own pawn in front of them
+    int isolated;   // no own pawns on the adjacent files
+    int backward;   // can't be supported and the stop square is controlled by an enemy pawn
+    int passed[8];  // by relative rank, no enemy pawns in front on the same and the adjacent files
+};
+
+// countPawnTerms: the pawn bitboards are enough, the tuner doesn't build positions
+void  countPawnTerms(Bitboard whitePawns, Bitboard blackPawns, PawnTerms &terms);
+
+//    Values of the pawn structure terms, see PawnTerms
+namespace PawnValues
+{
+    extern const Score doubled;
+    extern const Score isolated;
+    extern const Score backward;
+    extern const Score passed[8];
+}
+
+// evaluatePawns:
+//      Passed, isolated, doubled and backward pawns of both colors
+//      from WHITE point of view. Depends on the pawns only, so the score
+//      can be cached by Position::pawnKey
+Score evaluatePawns(const Position &pos);
+
+//    PawnTable caches evaluatePawns by the pawn key. Pawn structures
+//    change much less often than the rest of the position, so most of
+//    the evaluations in the search find their structure here.
+//    Every search thread owns its table, there are no locks.
+class PawnTable {
+public:
+    enum { SIZE = 1 << 14 }; // entries, a power of two
+
+    PawnTable() { clear(); }
+
+    // clear: drops the entries and resets the counters
+    void    clear();
+    // resetStats: counters only, the entries stay
+    void    resetStats() { m_probes = m_hits = 0; }
+    // probe: the entry of the pawn structure is replaced on a miss
+    Score   probe(const Position &pos);
+
+    quint64 probes() const { return m_probes; }
+    quint64 hits() const { return m_hits; }
+
+private:
+    struct Entry {
+        Key   key;
+        Score score;
+    };
+
+    Entry   m_entries[SIZE];
+    quint64 m_probes;
+    quint64 m_hits;
+};
+
+}
+
+#endif//ENGINE_PAWNS_H
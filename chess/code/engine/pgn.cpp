@@ -0,0 +1,685 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "pgn.h"
+#include "movegen.h"
+
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+const char *pieceLetters = "PNBRQK";
+
+// pieceTypeOf: SAN piece letter, -1 if it isn't one
+int pieceTypeOf(char letter)
+{
+    for (auto type = KNIGHT; type <= KING; type = ePieceType(type + 1))
+        if (pieceLetters[type] == letter)
+            return type;
+    return -1;
+}
+
+bool isResult(const QString &token)
+{
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// parseMovetext: splits the movetext into moves and the result
+void parseMovetext(const QString &text, PgnGame &game)
+{
+    QString token;
+    auto flushToken = [&]() {
+        // move numbers may stick to the move: 12.e4, 12...e5
+        int start = 0;
+        while (start < token.size() && token.at(start).isDigit())
+            start++;
+        if (start < token.size() && token.at(start) == '.') {
+            while (start < token.size() && token.at(start) == '.')
+                start++;
+            token = token.mid(start);
+        }
+        if (isResult(token))
+            game.result = token;
+        else if (!token.isEmpty() && !token.at(0).isDigit())
+            game.moves.append(token);
+        token.clear();
+    };
+
+    int variationDepth = 0;
+    for (auto i = 0; i < text.size(); i++) {
+        const QChar c = text.at(i);
+        if (c == '{') {
+            flushToken();
+            while (i < text.size() && text.at(i) != '}')
+                i++;
+        } else if (c == ';') {
+            flushToken();
+            while (i < text.size() && text.at(i) != '\n')
+                i++;
+        } else if (c == '(') {
+            flushToken();
+            variationDepth++;
+        } else if (c == ')') {
+            variationDepth = qMax(0, variationDepth - 1);
+        } else if (variationDepth > 0) {
+            continue;
+        } else if (c == '$') {
+            flushToken();
+            while (i + 1 < text.size() && text.at(i + 1).isDigit())
+                i++;
+        } else if (c.isSpace()) {
+            flushToken();
+        } else {
+            token += c;
+        }
+    }
+    flushToken();
+}
+
+}
+
+Move moveFromSan(const Position &pos, const QString &text)
+{
+    const QByteArray san = text.toLatin1();
+    return moveFromSan(pos, san.constData(), san.size());
+}
+
+Move moveFromSan(const Position &pos, const char *text, int size)
+{
+    while (size > 0 && (text[size - 1] == '+' || text[size - 1] == '#' || text[size - 1] == '!' || text[size - 1] == '?'))
+        size--;
+
+    MoveList moves;
+    generateMoves(pos, moves);
+
+    if ((size == 3 || size == 5) && (text[0] == 'O' || text[0] == '0')) {
+        const char zero = text[0];
+        if (text[1] != '-' || text[2] != zero || (size == 5 && (text[3] != '-' || text[4] != zero)))
+            return NO_MOVE;
+        const int flag = size == 3 ? KING_CASTLE : QUEEN_CASTLE;
+        for (const auto &scored : moves)
+            if (moveFlag(scored.move) == flag && pos.isLegal(scored.move))
+                return scored.move;
+        return NO_MOVE;
+    }
+
+    // promotion: e8=Q or e8Q
+    int promotion = -1;
+    if (size > 2 && pieceTypeOf(text[size - 1]) > PAWN) {
+        promotion = pieceTypeOf(text[size - 1]);
+        size -= text[size - 2] == '=' ? 2 : 1;
+    }
+    if (size < 2)
+        return NO_MOVE;
+
+    const char toFile = text[size - 2], toRank = text[size - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+        return NO_MOVE;
+    const int to = makeSquare(toFile - 'a', toRank - '1');
+
+    int type = PAWN, first = 0;
+    if (pieceTypeOf(text[0]) > PAWN) {
+        type = pieceTypeOf(text[0]);
+        first = 1;
+    }
+    // disambiguation between the piece letter and the target square, the capture mark is skipped
+    int fromFile = -1, fromRank = -1;
+    for (auto i = first; i < size - 2; i++) {
+        const char c = text[i];
+        if (c >= 'a' && c <= 'h')      fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != ':') return NO_MOVE;
+    }
+
+    // the pseudo legal moves are filtered by the notation first, only the few
+    // matching ones are checked for legality
+    Move found = NO_MOVE;
+    for (const auto &scored : moves) {
+        const Move move = scored.move;
+        const int from = moveFrom(move);
+        if (moveTo(move) != to || isCastlingMove(move) || typeOf(pos.pieceOn(from)) != type)
+            continue;
+        if (fromFile != -1 && fileOf(from) != fromFile)
+            continue;
+        if (fromRank != -1 && rankOf(from) != fromRank)
+            continue;
+        if (isPromotionMove(move) ? int(promotionType(move)) != promotion : promotion != -1)
+            continue;
+        if (!pos.isLegal(move))
+            continue;
+        if (found != NO_MOVE)
+            return NO_MOVE; // ambiguous
+        found = move;
+    }
+    return found;
+}
+
+QString moveToSan(const Position &pos, Move move)
+{
+    QString san;
+    const int from = moveFrom(move), to = moveTo(move);
+    const int type = typeOf(pos.pieceOn(from));
+
+    if (isCastlingMove(move)) {
+        san = moveFlag(move) == KING_CASTLE ? "O-O" : "O-O-O";
+    } else {
+        if (type != PAWN) {
+            san += pieceLetters[type];
+            // the origin of the moving piece when others of its kind reach the square too
+            MoveList moves;
+            generateLegalMoves(pos, moves);
+            bool isAmbiguous = false, sameFile = false, sameRank = false;
+            for (const auto &scored : moves) {
+                const int other = moveFrom(scored.move);
+                if (other == from || moveTo(scored.move) != to || typeOf(pos.pieceOn(other)) != type)
+                    continue;
+                isAmbiguous = true;
+                sameFile = sameFile || fileOf(other) == fileOf(from);
+                sameRank = sameRank || rankOf(other) == rankOf(from);
+            }
+            if (isAmbiguous && (!sameFile || sameRank))
+                san += QChar('a' + fileOf(from));
+            if (isAmbiguous && sameFile)
+                san += QChar('1' + rankOf(from));
+        }
+        if (isCaptureMove(move)) {
+            if (type == PAWN)
+                san += QChar('a' + fileOf(from));
+            san += 'x';
+        }
+        san += QChar('a' + fileOf(to));
+        san += QChar('1' + rankOf(to));
+        if (isPromotionMove(move)) {
+            san += '=';
+            san += pieceLetters[promotionType(move)];
+        }
+    }
+
+    Position next = pos;
+    next.doMove(move);
+    if (next.inCheck()) {
+        MoveList replies;
+        generateLegalMoves(next, replies);
+        san += replies.isEmpty() ? '#' : '+';
+    }
+    return san;
+}
+
+void writeGame(QTextStream &out, const PgnGame &game)
+{
+    for (const auto &tag : game.tags) {
+        QString value = tag.second;
+        value.replace("\\", "\\\\").replace("\"", "\\\"");
+        out << "[" << tag.first << " \"" << value << "\"]\n";
+    }
+    out << "\n";
+
+    // the move number of the first move and its side from the FEN
+    const QStringList fields = game.startFEN().split(' ', QString::SkipEmptyParts);
+    bool isWhite = fields.size() < 2 || fields.at(1) != "b";
+    int number = fields.size() >= 6 ? qMax(1, fields.at(5).toInt()) : 1;
+
+    QString line;
+    auto append = [&](const QString &token) {
+        if (!line.isEmpty() && line.size() + 1 + token.size() > 80) {
+            out << line << "\n";
+            line.clear();
+        }
+        if (!line.isEmpty())
+            line += ' ';
+        line += token;
+    };
+
+    bool needNumber = true; // black moves are numbered after a comment and first of all
+    for (auto i = 0; i < game.moves.size(); i++) {
+        if (isWhite)
+            append(QString("%1. %2").arg(number).arg(game.moves.at(i)));
+        else if (needNumber)
+            append(QString("%1... %2").arg(number).arg(game.moves.at(i)));
+        else
+            append(game.moves.at(i));
+        needNumber = false;
+
+        if (i < game.nags.size() && game.nags.at(i) > 0)
+            append(QString("$%1").arg(game.nags.at(i)));
+        if (i < game.comments.size() && !game.comments.at(i).isEmpty()) {
+            // comments are wrapped word by word, the embedded commands like [%eval 0.25] as a whole
+            const QStringList words = QString("{ " + game.comments.at(i) + " }").split(' ', QString::SkipEmptyParts);
+            QString command;
+            for (const auto &word : words) {
+                if (command.isEmpty() && !word.startsWith("[%")) {
+                    append(word);
+                    continue;
+                }
+                command += command.isEmpty() ? word : " " + word;
+                if (word.endsWith(']')) {
+                    append(command);
+                    command.clear();
+                }
+            }
+            if (!command.isEmpty())
+                append(command);
+            needNumber = true;
+        }
+        if (!isWhite)
+            number++;
+        isWhite = !isWhite;
+    }
+    append(game.result.isEmpty() ? QString("*") : game.result);
+    out << line << "\n\n";
+}
+
+//==============================================================
+//                          PgnGame
+//==============================================================
+
+QString PgnGame::tag(const QString &name) const
+{
+    for (const auto &tag : tags)
+        if (tag.first == name)
+            return tag.second;
+    return QString();
+}
+
+QString PgnGame::startFEN() const
+{
+    const QString fen = tag("FEN");
+    return fen.isEmpty() ? QString(Position::startFEN()) : fen;
+}
+
+//==============================================================
+//                         PgnReader
+//==============================================================
+
+bool PgnReader::readGame(PgnGame &game)
+{
+    game = PgnGame();
+    QString movetext;
+    int openComments = 0; // a comment may span empty lines
+    bool inMovetext = false;
+
+    while (!m_pending.isNull() || !m_in.atEnd()) {
+        QString line = m_pending.isNull() ? m_in.readLine() : m_pending;
+        m_pending = QString();
+        line = line.trimmed();
+
+        if (line.startsWith('[') && openComments == 0) {
+            if (inMovetext) {
+                m_pending = line; // the tags of the next game
+                break;
+            }
+            // [Name "Value"]
+            const int space = line.indexOf(' ');
+            const int open = line.indexOf('"');
+            const int close = line.lastIndexOf('"');
+            if (space > 1 && open > space && close > open)
+                game.tags.append(qMakePair(line.mid(1, space - 1), line.mid(open + 1, close - open - 1).replace("\\\"", "\"")));
+        } else if (line.isEmpty()) {
+            if (inMovetext && openComments == 0)
+                break;
+        } else if (!line.startsWith('%')) { // escaped lines are skipped
+            inMovetext = true;
+            movetext += line;
+            movetext += '\n';
+            openComments = qMax(0, openComments + line.count('{') - line.count('}'));
+        }
+    }
+
+    if (game.tags.isEmpty() && movetext.isEmpty())
+        return false;
+
+    parseMovetext(movetext, game);
+    if (game.result.isEmpty())
+        game.result = game.tag("Result").isEmpty() ? QString("*") : game.tag("Result");
+    return true;
+}
+
+//==============================================================
+//                        PgnTokenizer
+//==============================================================
+
+namespace
+{
+
+// character classes of the tokenizer, a table lookup per byte
+enum { CHAR_SPACE = 1, CHAR_DELIMITER = 2 };
+
+struct CharClasses {
+    quint8 flags[256];
+
+    CharClasses()
+    {
+        memset(flags, 0, sizeof(flags));
+        for (auto c : " \n\r\t\f\v")
+            flags[quint8(c)] = CHAR_SPACE | CHAR_DELIMITER;
+        // a move, a number or a result ends at these
+        for (auto c : "{}();$[]")
+            flags[quint8(c)] = CHAR_DELIMITER;
+        flags[0] = 0;
+    }
+};
+
+const CharClasses charClasses;
+
+inline bool isSpace(char c)
+{
+    return charClasses.flags[quint8(c)] & CHAR_SPACE;
+}
+
+inline bool isDelimiter(char c)
+{
+    return charClasses.flags[quint8(c)] & CHAR_DELIMITER;
+}
+
+inline void setToken(PgnToken &token, PgnToken::eType type, const char *text, const char *end)
+{
+    token.type = type;
+    token.text = text;
+    token.size = int(end - text);
+    token.value = nullptr;
+    token.valueSize = 0;
+}
+
+}
+
+bool PgnTokenizer::next(PgnToken &token)
+{
+    const char *p = m_pos;
+    const char *const end = m_end;
+    for (;;) {
+        while (p < end && isSpace(*p))
+            p++;
+        if (p >= end) {
+            m_pos = p;
+            return false;
+        }
+        // the escape mechanism: a line starting with % is skipped
+        if (*p == '%' && (p == m_begin || p[-1] == '\n')) {
+            const char *newline = static_cast<const char*>(memchr(p, '\n', end - p));
+            p = newline ? newline : end;
+            continue;
+        }
+        // a stray closing brace or bracket
+        if (*p == '}' || *p == ']') {
+            p++;
+            continue;
+        }
+        break;
+    }
+
+    const char *start = p;
+    switch (*p) {
+    case '[': {
+        // [Name "Value"], the escapes \" and \\ are kept in the value
+        p++;
+        while (p < end && isSpace(*p))
+            p++;
+        const char *name = p;
+        while (p < end && !isSpace(*p) && *p != '"' && *p != ']')
+            p++;
+        setToken(token, PgnToken::TAG, name, p);
+        while (p < end && *p != '"' && *p != ']' && *p != '\n')
+            p++;
+        if (p < end && *p == '"') {
+            const char *value = ++p;
+            while (p < end && *p != '"' && *p != '\n')
+                p += *p == '\\' && p + 1 < end ? 2 : 1;
+            token.value = value;
+            token.valueSize = int(qMin(p, end) - value);
+        } else {
+            token.value = p;
+        }
+        while (p < end && *p != ']' && *p != '\n')
+            p++;
+        if (p < end && *p == ']')
+            p++;
+        break;
+    }
+    case '{': {
+        const char *close = static_cast<const char*>(memchr(p + 1, '}', end - p - 1));
+        setToken(token, PgnToken::COMMENT, p + 1, close ? close : end);
+        p = close ? close + 1 : end;
+        break;
+    }
+    case ';': {
+        const char *newline = static_cast<const char*>(memchr(p + 1, '\n', end - p - 1));
+        const char *last = newline ? newline : end;
+        p = last;
+        if (last > start + 1 && last[-1] == '\r')
+            last--;
+        setToken(token, PgnToken::COMMENT, start + 1, last);
+        break;
+    }
+    case '(':
+        setToken(token, PgnToken::VARIATION_START, p, p + 1);
+        p++;
+        break;
+    case ')':
+        setToken(token, PgnToken::VARIATION_END, p, p + 1);
+        p++;
+        break;
+    case '$':
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+        setToken(token, PgnToken::NAG, start + 1, p);
+        break;
+    case '*':
+        setToken(token, PgnToken::RESULT, p, p + 1);
+        p++;
+        break;
+    default: {
+        while (p < end && !isDelimiter(*p))
+            p++;
+        setToken(token, PgnToken::SAN, start, p);
+        if (*start < '0' || *start > '9')
+            break;
+        // the results and castling written with zeros aren't numbers
+        if (token.size > 1 && (start[1] == '-' || start[1] == '/')) {
+            if (token.equals("1-0") || token.equals("0-1") || token.equals("1/2-1/2"))
+                token.type = PgnToken::RESULT;
+            break;
+        }
+        // 12. 12... and the numbers sticking to the move: 12.e4
+        const char *number = start;
+        while (number < p && *number >= '0' && *number <= '9')
+            number++;
+        while (number < p && *number == '.')
+            number++;
+        setToken(token, PgnToken::MOVE_NUMBER, start, number);
+        p = number;
+        break;
+    }
+    }
+    m_pos = p;
+    return true;
+}
+
+bool PgnTokenizer::readGame(QVector<PgnToken> &tokens)
+{
+    tokens.resize(0); // keeps the capacity
+    bool inMovetext = false;
+    int variationDepth = 0;
+    PgnToken token;
+    for (;;) {
+        const char *start = m_pos;
+        if (!next(token))
+            break;
+        if (token.type == PgnToken::TAG && inMovetext) {
+            m_pos = start; // the tags of the next game
+            break;
+        }
+        tokens.append(token);
+        if (token.type == PgnToken::VARIATION_START)
+            variationDepth++;
+        else if (token.type == PgnToken::VARIATION_END)
+            variationDepth = qMax(0, variationDepth - 1);
+        else if (token.type == PgnToken::RESULT && variationDepth == 0)
+            break; // the result ends the movetext
+        else if (token.type != PgnToken::TAG && token.type != PgnToken::COMMENT)
+            inMovetext = true;
+    }
+    return !tokens.isEmpty();
+}
+
+//==============================================================
+//                          PgnFile
+//==============================================================
+
+PgnFile::PgnFile()
+{
+    m_data = nullptr;
+    m_size = 0;
+}
+
+PgnFile::~PgnFile()
+{
+    close();
+}
+
+bool PgnFile::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_size = m_file.size();
+    // an empty file can't be mapped, it is a file without games
+    static const char empty = 0;
+    m_data = m_size > 0 ? reinterpret_cast<const char*>(m_file.map(0, m_size)) : &empty;
+    if (m_data == nullptr) {
+        m_file.close();
+        m_size = 0;
+        return false;
+    }
+    m_tokenizer = PgnTokenizer(m_data, m_data + m_size);
+    return true;
+}
+
+void PgnFile::close()
+{
+    if (m_data && m_size > 0)
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_data)));
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_tokenizer = PgnTokenizer();
+}
+
+void PgnFile::seek(qint64 offset)
+{
+    m_tokenizer.setPosition(m_data + qBound<qint64>(0, offset, m_size));
+}
+
+qint64 PgnFile::nextGameOffset(qint64 offset) const
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    if (offset == 0)
+        return 0;
+
+    // a tag line: [ and the tag name, the commands in the comments like [%eval 0.25] aren't tags
+    const char *const end = m_data + m_size;
+    auto isTagLine = [end](const char *line) {
+        return line + 1 < end && line[0] == '[' && ((line[1] >= 'A' && line[1] <= 'Z') || (line[1] >= 'a' && line[1] <= 'z'));
+    };
+
+    // from the line holding the offset, the line before it tells whether a tag line starts a game
+    const char *line = m_data + offset;
+    while (line > m_data && line[-1] != '\n')
+        line--;
+    bool isPreviousTag = false;
+    if (line > m_data) {
+        const char *previous = line - 1;
+        while (previous > m_data && previous[-1] != '\n')
+            previous--;
+        isPreviousTag = isTagLine(previous);
+    }
+
+    while (line < end) {
+        const bool isTag = isTagLine(line);
+        if (isTag && !isPreviousTag && line >= m_data + offset)
+            return line - m_data;
+        isPreviousTag = isTag;
+        const char *newline = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (newline == nullptr)
+            break;
+        line = newline + 1;
+    }
+    return m_size;
+}
+
+bool PgnFile::readTokens(QVector<PgnToken> &tokens)
+{
+    return m_tokenizer.readGame(tokens);
+}
+
+bool PgnFile::readGame(PgnGame &game)
+{
+    if (!readTokens(m_tokens)) {
+        game = PgnGame();
+        return false;
+    }
+    toGame(m_tokens, game);
+    return true;
+}
+
+void PgnFile::toGame(const QVector<PgnToken> &tokens, PgnGame &game)
+{
+    game = PgnGame();
+    int variationDepth = 0;
+    for (const auto &token : tokens) {
+        switch (token.type) {
+        case PgnToken::TAG: {
+            QString value = QString::fromUtf8(token.value, token.valueSize);
+            if (value.contains('\\'))
+                value.replace("\\\"", "\"").replace("\\\\", "\\");
+            game.tags.append(qMakePair(token.toString(), value));
+            break;
+        }
+        case PgnToken::VARIATION_START:
+            variationDepth++;
+            break;
+        case PgnToken::VARIATION_END:
+            variationDepth = qMax(0, variationDepth - 1);
+            break;
+        case PgnToken::SAN:
+            if (variationDepth == 0)
+                game.moves.append(QString::fromLatin1(token.text, token.size));
+            break;
+        case PgnToken::RESULT:
+            if (variationDepth == 0)
+                game.result = token.toString();
+            break;
+        default:
+            break;
+        }
+    }
+    if (game.result.isEmpty())
+        game.result = game.tag("Result").isEmpty() ? QString("*") : game.tag("Result");
+}
+
+}
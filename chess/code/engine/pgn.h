@@ -0,0 +1,181 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_PGN_H
+#define ENGINE_PGN_H
+
+#include <QFile>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include "position.h"
+
+//==============================================================
+//                  Portable Game Notation
+//==============================================================
+
+namespace engine
+{
+
+// moveFromSan:
+//      Searches the legal move given in Standard Algebraic Notation: e4, Nbd7, exd5,
+//      e8=Q, O-O. Check and annotation marks are ignored. NO_MOVE if there is
+//      no such move or the notation is ambiguous
+Move    moveFromSan(const Position &pos, const QString &text);
+// moveFromSan: the same for the notation as it is in the file, no string is made
+Move    moveFromSan(const Position &pos, const char *text, int size);
+// moveToSan:
+//      Standard Algebraic Notation of the legal move with the check or mate mark,
+//      the origin file or rank is given only when another piece may go to the same square
+QString moveToSan(const Position &pos, Move move);
+
+//    PgnGame is a game as written in the file, the moves are not validated
+struct PgnGame {
+    QVector<QPair<QString, QString>> tags; // in the order of the file
+    QStringList moves;  // SAN without move numbers, comments, NAGs and variations
+    QString     result; // 1-0, 0-1, 1/2-1/2 or * for an unfinished or unknown one
+    // annotations written after the moves by writeGame(), by move index; the reader leaves them empty
+    QVector<int> nags;     // numeric annotation glyph, 0 for none
+    QStringList  comments;
+
+    // tag: value of the tag, empty if there is no such tag
+    QString tag(const QString &name) const;
+    // startFEN: the FEN tag of the games starting from a set up position, else the start position
+    QString startFEN() const;
+};
+
+// writeGame:
+//      The tags, then the movetext wrapped at 80 columns with the annotations
+//      of the moves and the result, followed by an empty line
+void    writeGame(QTextStream &out, const PgnGame &game);
+
+//    PgnReader reads the games of a PGN stream one by one,
+//    the whole file is never held in memory
+class PgnReader {
+public:
+    explicit PgnReader(QTextStream &in) : m_in(in) {}
+
+    // readGame: false at the end of the stream
+    bool    readGame(PgnGame &game);
+
+private:
+    QTextStream &m_in;
+    QString      m_pending; // tag line of the next game read after the movetext of the previous one
+};
+
+//    PgnToken is a piece of the file, the text points into the file and isn't copied
+struct PgnToken {
+    enum eType {
+        TAG,             // text: the name, value: the value with the escapes as written
+        MOVE_NUMBER,     // 12. or 12...
+        SAN,             // the move with its check and annotation marks
+        NAG,             // $2, text: the number
+        COMMENT,         // {...} or ;... without the braces or the semicolon
+        VARIATION_START,
+        VARIATION_END,
+        RESULT           // 1-0, 0-1, 1/2-1/2 or *
+    };
+
+    eType       type;
+    const char *text;
+    int         size;
+    const char *value;
+    int         valueSize;
+
+    QString     toString() const { return QString::fromUtf8(text, size); }
+    bool        equals(const char *string) const { return qstrncmp(text, string, size) == 0 && string[size] == 0; }
+};
+
+//    PgnTokenizer splits the text between two pointers into tokens,
+//    one pass over the bytes without any allocation
+class PgnTokenizer {
+public:
+    PgnTokenizer(const char *begin = nullptr, const char *end = nullptr)
+        : m_begin(begin), m_pos(begin), m_end(end) {}
+
+    // next: false at the end of the text
+    bool        next(PgnToken &token);
+    // readGame:
+    //      The tokens of the next game, the variations included, into the vector
+    //      keeping its capacity. False at the end of the text
+    bool        readGame(QVector<PgnToken> &tokens);
+
+    const char *position() const { return m_pos; }
+    void        setPosition(const char *pos) { m_pos = pos; }
+
+private:
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+};
+
+//    PgnFile reads the games of a file mapped into memory instead of reading it:
+//    a database of any size costs address space only, the pages are read in
+//    by the system as the tokenizer walks over them and may be dropped again
+class PgnFile {
+public:
+    PgnFile();
+    ~PgnFile();
+
+    // open: maps the file, the previous one is closed even on failure
+    bool    open(const QString &fileName);
+    void    close();
+    bool    isOpen() const { return m_file.isOpen(); }
+    QString fileName() const { return m_file.fileName(); }
+    qint64  size() const { return m_size; }
+    // data: the mapped file, size() bytes
+    const char *data() const { return m_data; }
+
+    // nextGameOffset:
+    //      Offset of the first game starting at or after the offset, size() if there is
+    //      none. A game starts with a tag line following the movetext of the previous one
+    qint64  nextGameOffset(qint64 offset) const;
+
+    // offset: of the next game in the file, seek() returns to a game found before
+    qint64  offset() const { return m_tokenizer.position() - m_data; }
+    void    seek(qint64 offset);
+
+    // readTokens:
+    //      The tokens of the next game, the variations included. They point into
+    //      the mapping and are valid while the file is open. False at the end of the file
+    bool    readTokens(QVector<PgnToken> &tokens);
+    // readGame: the next game the way PgnReader reads it, false at the end of the file
+    bool    readGame(PgnGame &game);
+
+    // toGame: the tags, the main line and the result of the tokens of a game
+    static void toGame(const QVector<PgnToken> &tokens, PgnGame &game);
+
+private:
+    Q_DISABLE_COPY(PgnFile)
+
+    QFile         m_file;
+    const char   *m_data;
+    qint64        m_size;
+    PgnTokenizer  m_tokenizer;
+    QVector<PgnToken> m_tokens; // reused by readGame()
+};
+
+}
+
+#endif//ENGINE_PGN_H
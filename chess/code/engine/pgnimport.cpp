@@ -0,0 +1,172 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "pgnimport.h"
+#include "parallel.h"
+#include "pgn.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+namespace engine
+{
+
+namespace
+{
+
+struct ChunkRange {
+    int chunk;
+    int firstGame; // in the arena of the thread
+    int lastGame;
+};
+
+//    Arena is what one thread imports: the games of its chunks one after another
+struct Arena {
+    GameList            games;
+    QVector<ChunkRange> ranges;
+};
+
+// replayGame: the tags, the result and the playable part of the main line
+void replayGame(const QVector<PgnToken> &tokens, qint64 offset, const QString &startFEN, Position &pos, GameList &games)
+{
+    games.beginGame(offset);
+
+    // a game from a broken FEN keeps its tags and result without any moves
+    bool hasFEN = false, isComplete = true;
+    GameList::eResult result = GameList::RESULT_UNKNOWN;
+    for (const auto &token : tokens) {
+        if (token.type != PgnToken::TAG)
+            continue;
+        games.addTag(token.text, token.size, token.value, token.valueSize);
+        if (token.equals("FEN")) {
+            hasFEN = true;
+            isComplete = pos.setFEN(QString::fromLatin1(token.value, token.valueSize));
+        } else if (token.equals("Result")) {
+            result = GameList::resultFromString(token.value, token.valueSize);
+        }
+    }
+    if (!hasFEN)
+        pos.setFEN(startFEN);
+
+    int variationDepth = 0;
+    for (const auto &token : tokens) {
+        if (token.type == PgnToken::VARIATION_START) {
+            variationDepth++;
+        } else if (token.type == PgnToken::VARIATION_END) {
+            variationDepth = qMax(0, variationDepth - 1);
+        } else if (variationDepth > 0) {
+            continue;
+        } else if (token.type == PgnToken::RESULT) {
+            result = GameList::resultFromString(token.text, token.size);
+        } else if (token.type == PgnToken::SAN && isComplete) {
+            const Move move = moveFromSan(pos, token.text, token.size);
+            if (move == NO_MOVE) {
+                isComplete = false;
+                continue;
+            }
+            games.addMove(move);
+            pos.doMove(move);
+        }
+    }
+    games.endGame(result, isComplete);
+}
+
+}
+
+bool PgnImport::importFile(const QString &pgnFile, GameList &games, const Options &options,
+                           QString *error, Statistics *stats /*= nullptr*/)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PgnFile file;
+    if (!file.open(pgnFile)) {
+        *error = "can't open " + pgnFile;
+        return false;
+    }
+
+    // chunk boundaries are found by a short scan from every chunkBytes
+    QVector<qint64> bounds;
+    bounds.append(0);
+    while (bounds.last() < file.size())
+        bounds.append(file.nextGameOffset(bounds.last() + qMax<qint64>(1, options.chunkBytes)));
+    const int chunks = bounds.size() - 1;
+    const int threads = qBound(1, options.threads, qMax(1, chunks));
+
+    QVector<Arena> arenas(threads);
+    QAtomicInt nextChunk(0);
+    runParallel(threads, [&](int share) {
+        Arena &arena = arenas[share];
+        QVector<PgnToken> tokens;
+        Position pos;
+        const QString startFEN = Position::startFEN();
+        for (;;) {
+            const int chunk = nextChunk.fetchAndAddRelaxed(1);
+            if (chunk >= chunks)
+                return;
+            ChunkRange range;
+            range.chunk = chunk;
+            range.firstGame = arena.games.size();
+
+            PgnTokenizer tokenizer(file.data() + bounds.at(chunk), file.data() + bounds.at(chunk + 1));
+            for (;;) {
+                const qint64 offset = tokenizer.position() - file.data();
+                if (!tokenizer.readGame(tokens))
+                    break;
+                replayGame(tokens, offset, startFEN, pos, arena.games);
+            }
+            range.lastGame = arena.games.size();
+            arena.ranges.append(range);
+        }
+    });
+
+    // the ordered merge: the chunks one by one from the arenas holding them
+    QVector<QPair<int, int>> owners(chunks); // the arena and the index of the range of every chunk
+    for (auto share = 0; share < threads; share++)
+        for (auto i = 0; i < arenas.at(share).ranges.size(); i++)
+            owners[arenas.at(share).ranges.at(i).chunk] = qMakePair(share, i);
+    const int firstGame = games.size();
+    if (threads == 1 && games.isEmpty()) {
+        games = arenas.at(0).games; // a single arena is in order already
+    } else {
+        for (const auto &owner : owners) {
+            const Arena &arena = arenas.at(owner.first);
+            const ChunkRange &range = arena.ranges.at(owner.second);
+            games.append(arena.games, range.firstGame, range.lastGame);
+        }
+    }
+
+    if (stats) {
+        stats->bytes = file.size();
+        stats->chunks = chunks;
+        stats->games = games.size() - firstGame;
+        stats->moves = 0;
+        stats->incomplete = 0;
+        for (auto i = firstGame; i < games.size(); i++) {
+            stats->moves += games.plies(i);
+            stats->incomplete += games.isComplete(i) ? 0 : 1;
+        }
+        stats->elapsedMs = timer.elapsed();
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,73 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_PGNIMPORT_H
+#define ENGINE_PGNIMPORT_H
+
+#include <QString>
+
+#include "gamelist.h"
+
+//==============================================================
+//                        PGN import
+//==============================================================
+
+//    Imports the games of a PGN file on many threads. The mapped file is split
+//    at game boundaries into chunks of about a megabyte, the threads take the
+//    chunks in turn, tokenize them and replay the main lines with the move
+//    generator into a game list of their own, an arena used by that thread only.
+//    The arenas are merged in the order of the chunks at the end, so the games
+//    come in the order of the file whatever the number of threads.
+
+namespace engine
+{
+
+namespace PgnImport
+{
+    struct Options {
+        Options() : threads(1), chunkBytes(1 << 20) {}
+
+        int    threads;
+        qint64 chunkBytes; // the file is split into chunks of at least this size
+    };
+
+    struct Statistics {
+        Statistics() : bytes(0), chunks(0), games(0), moves(0), incomplete(0), elapsedMs(0) {}
+
+        qint64 bytes;
+        int    chunks;
+        qint64 games;
+        qint64 moves;
+        qint64 incomplete; // games with a move which couldn't be played
+        qint64 elapsedMs;
+    };
+
+    // importFile:
+    //      Appends the games of the PGN file to `games`, each with its tags, result and
+    //      main line up to the first move which can't be played. The offsets of the games
+    //      are the file offsets for PgnFile::seek(). False with `error` set on failure
+    bool    importFile(const QString &pgnFile, GameList &games, const Options &options,
+                       QString *error, Statistics *stats = nullptr);
+}
+
+}
+
+#endif//ENGINE_PGNIMPORT_H
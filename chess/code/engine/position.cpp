@@ -0,0 +1,709 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "position.h"
+#include "movegen.h"
+
+#include <QStringList>
+#include <cstring>
+
+namespace engine
+{
+
+//==============================================================
+//                      Zobrist keys
+//==============================================================
+
+Key Zobrist::psq[PIECE_NB][64];
+Key Zobrist::enPassant[8];
+Key Zobrist::castling[16];
+Key Zobrist::side;
+Key Zobrist::noPawns;
+
+namespace
+{
+
+// xorshift64* generator with a fixed seed: keys are the same on every run
+// so hash dependent results (bench signatures, cached analysis) are reproducible
+class KeyGenerator {
+public:
+    explicit KeyGenerator(quint64 seed) : m_state(seed) {}
+    Key next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 2685821657736338717ULL;
+    }
+private:
+    quint64 m_state;
+};
+
+bool initZobrist()
+{
+    KeyGenerator generator(1070372ULL);
+    for (auto piece = 0; piece < PIECE_NB; piece++)
+        for (auto square = 0; square < 64; square++)
+            Zobrist::psq[piece][square] = generator.next();
+    for (auto file = 0; file < 8; file++)
+        Zobrist::enPassant[file] = generator.next();
+    // castling keys are combined from the keys of single rights,
+    // so the key can be updated with one xor for any change of rights
+    Key single[4];
+    for (auto i = 0; i < 4; i++)
+        single[i] = generator.next();
+    for (auto rights = 0; rights < 16; rights++) {
+        Zobrist::castling[rights] = 0;
+        for (auto i = 0; i < 4; i++)
+            if (rights & (1 << i)) Zobrist::castling[rights] ^= single[i];
+    }
+    Zobrist::side = generator.next();
+    Zobrist::noPawns = generator.next();
+    return true;
+}
+
+// castlingMask: rights which are kept after any piece leaves or enters the square
+int castlingMask(int square)
+{
+    switch (square) {
+        case A1: return ALL_CASTLING & ~WHITE_OOO;
+        case E1: return ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+        case H1: return ALL_CASTLING & ~WHITE_OO;
+        case A8: return ALL_CASTLING & ~BLACK_OOO;
+        case E8: return ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+        case H8: return ALL_CASTLING & ~BLACK_OO;
+        default: return ALL_CASTLING;
+    }
+}
+
+const char *pieceChars = "PNBRQKpnbrqk";
+
+}
+
+
+//==============================================================
+//                      Position
+//==============================================================
+
+Position::Position()
+{
+    // C++11 guarantees thread safe initialization of function statics
+    static const bool isZobristInitialized = initZobrist();
+    Q_UNUSED(isZobristInitialized);
+    Bitboards::init();
+    PSQT::init();
+
+    m_clear();
+    setFEN(startFEN());
+}
+
+const char *Position::startFEN()
+{
+    return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+}
+
+Key Position::startKey()
+{
+    Position pos;
+    pos.setFEN(startFEN());
+    return pos.key();
+}
+
+bool Position::setFEN(const QString &fen)
+{
+    QStringList fields = fen.split(' ', QString::SkipEmptyParts);
+    if (fields.size() < 4)
+        return false;
+
+    Position parsed(*this);
+    parsed.m_clear();
+    StateInfo &st = parsed.m_state();
+
+    // 1. Piece placement, from the 8th rank down to the 1st one
+    int file = 0, rank = 7;
+    for (auto i = 0; i < fields[0].size(); i++) {
+        char c = fields[0].at(i).toLatin1();
+        if (c == '/') {
+            if (file != 8 || rank == 0) return false;
+            file = 0;
+            rank--;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) return false;
+        } else {
+            const char *found = strchr(pieceChars, c);
+            if (found == nullptr || c == 0 || file > 7) return false;
+            parsed.m_putPiece(int(found - pieceChars), makeSquare(file, rank));
+            file++;
+        }
+    }
+    if (rank != 0 || file != 8) return false;
+    if (popCount(parsed.pieces(WHITE, KING)) != 1 || popCount(parsed.pieces(BLACK, KING)) != 1)
+        return false;
+
+    // 2. Active color
+    if (fields[1] == "w")      parsed.m_sideToMove = WHITE;
+    else if (fields[1] == "b") parsed.m_sideToMove = BLACK;
+    else return false;
+
+    // 3. Castling availability, rights without king and rook on their squares are dropped
+    if (fields[2] != "-") {
+        for (auto i = 0; i < fields[2].size(); i++) {
+            switch (fields[2].at(i).toLatin1()) {
+                case 'K': st.castling |= WHITE_OO;  break;
+                case 'Q': st.castling |= WHITE_OOO; break;
+                case 'k': st.castling |= BLACK_OO;  break;
+                case 'q': st.castling |= BLACK_OOO; break;
+                default: return false;
+            }
+        }
+    }
+    if (parsed.m_board[E1] != W_KING) st.castling &= ~(WHITE_OO | WHITE_OOO);
+    if (parsed.m_board[H1] != W_ROOK) st.castling &= ~WHITE_OO;
+    if (parsed.m_board[A1] != W_ROOK) st.castling &= ~WHITE_OOO;
+    if (parsed.m_board[E8] != B_KING) st.castling &= ~(BLACK_OO | BLACK_OOO);
+    if (parsed.m_board[H8] != B_ROOK) st.castling &= ~BLACK_OO;
+    if (parsed.m_board[A8] != B_ROOK) st.castling &= ~BLACK_OOO;
+
+    // 4. En passant square, kept only if a pawn may actually capture there
+    if (fields[3] != "-") {
+        if (fields[3].size() != 2) return false;
+        int epFile = fields[3].at(0).toLatin1() - 'a';
+        int epRank = fields[3].at(1).toLatin1() - '1';
+        if (epFile < 0 || epFile > 7 || (epRank != 2 && epRank != 5)) return false;
+        int square = makeSquare(epFile, epRank);
+        eColor us = parsed.m_sideToMove;
+        if (Bitboards::pawnAttacks[opposite(us)][square] & parsed.pieces(us, PAWN))
+            st.epSquare = square;
+    }
+
+    // 5-6. Halfmove clock and fullmove number are optional
+    st.rule50 = fields.size() > 4 ? qMax(0, fields[4].toInt()) : 0;
+    int fullMove = fields.size() > 5 ? qMax(1, fields[5].toInt()) : 1;
+    parsed.m_gamePly = 2 * (fullMove - 1) + (parsed.m_sideToMove == BLACK ? 1 : 0);
+
+    // side not to move must not be in check
+    eColor them = opposite(parsed.m_sideToMove);
+    if (parsed.isAttacked(parsed.kingSquare(them), parsed.m_sideToMove))
+        return false;
+
+    st.key = parsed.m_computeKey();
+    st.pawnKey = parsed.m_computePawnKey();
+    parsed.m_updateCheckInfo();
+
+    *this = parsed;
+    return true;
+}
+
+QString Position::fen() const
+{
+    QString result;
+
+    for (auto rank = 7; rank >= 0; rank--) {
+        int emptySquares = 0;
+        for (auto file = 0; file < 8; file++) {
+            int piece = m_board[makeSquare(file, rank)];
+            if (piece == NO_PIECE) {
+                emptySquares++;
+                continue;
+            }
+            if (emptySquares) {
+                result += QString::number(emptySquares);
+                emptySquares = 0;
+            }
+            result += QChar(pieceChars[piece]);
+        }
+        if (emptySquares)
+            result += QString::number(emptySquares);
+        if (rank > 0)
+            result += '/';
+    }
+
+    result += m_sideToMove == WHITE ? " w " : " b ";
+
+    const StateInfo &st = m_state();
+    if (st.castling == NO_CASTLING) result += '-';
+    if (st.castling & WHITE_OO)  result += 'K';
+    if (st.castling & WHITE_OOO) result += 'Q';
+    if (st.castling & BLACK_OO)  result += 'k';
+    if (st.castling & BLACK_OOO) result += 'q';
+
+    result += ' ';
+    if (st.epSquare == NO_SQUARE) {
+        result += '-';
+    } else {
+        result += QChar('a' + fileOf(st.epSquare));
+        result += QChar('1' + rankOf(st.epSquare));
+    }
+
+    result += QString(" %1 %2").arg(st.rule50).arg(m_gamePly / 2 + 1);
+    return result;
+}
+
+Bitboard Position::attackersTo(int square, Bitboard occupied) const
+{
+    return (Bitboards::pawnAttacks[BLACK][square] & pieces(WHITE, PAWN))
+         | (Bitboards::pawnAttacks[WHITE][square] & pieces(BLACK, PAWN))
+         | (Bitboards::knightAttacks[square] & pieces(KNIGHT))
+         | (bishopAttacks(square, occupied) & pieces(BISHOP, QUEEN))
+         | (rookAttacks(square, occupied) & pieces(ROOK, QUEEN))
+         | (Bitboards::kingAttacks[square] & pieces(KING));
+}
+
+bool Position::isAttacked(int square, eColor byColor) const
+{
+    return (attackersTo(square) & pieces(byColor)) != 0;
+}
+
+bool Position::isPseudoLegal(Move move) const
+{
+    if (move == NO_MOVE) return false;
+
+    const eColor us = m_sideToMove;
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int flag = moveFlag(move);
+    const int piece = m_board[from];
+
+    if (piece == NO_PIECE || colorOf(piece) != us) return false;
+    if (m_board[to] != NO_PIECE && colorOf(m_board[to]) == us) return false;
+
+    const ePieceType type = typeOf(piece);
+    const Bitboard occupied = pieces();
+
+    if (isCastlingMove(move)) {
+        if (type != KING || from != (us == WHITE ? E1 : E8)) return false;
+        if (flag == KING_CASTLE)
+            return to == from + 2 &&
+                   (castlingRights() & (us == WHITE ? WHITE_OO : BLACK_OO)) &&
+                   !(Bitboards::between[from][from + 3] & occupied);
+        return to == from - 2 &&
+               (castlingRights() & (us == WHITE ? WHITE_OOO : BLACK_OOO)) &&
+               !(Bitboards::between[from][from - 4] & occupied);
+    }
+
+    if (flag == EN_PASSANT)
+        return type == PAWN && to == epSquare() &&
+               (Bitboards::pawnAttacks[us][from] & squareBB(to));
+
+    // captures must take an enemy piece and quiet moves must go to an empty square
+    if (isCaptureMove(move) != (m_board[to] != NO_PIECE)) return false;
+    if (isCaptureMove(move) && typeOf(m_board[to]) == KING) return false;
+
+    if (type == PAWN) {
+        const int push = us == WHITE ? 8 : -8;
+        if (isPromotionMove(move) != (relativeRank(us, to) == 7)) return false;
+        if (!isPromotionMove(move) && flag != QUIET_MOVE && flag != CAPTURE && flag != DOUBLE_PAWN_PUSH)
+            return false;
+        if (isCaptureMove(move))
+            return (Bitboards::pawnAttacks[us][from] & squareBB(to)) != 0;
+        if (flag == DOUBLE_PAWN_PUSH)
+            return relativeRank(us, from) == 1 && to == from + 2 * push && isEmpty(from + push);
+        return to == from + push;
+    }
+
+    if (isPromotionMove(move) || (flag != QUIET_MOVE && flag != CAPTURE)) return false;
+
+    Bitboard attacks;
+    switch (type) {
+        case KNIGHT: attacks = Bitboards::knightAttacks[from];    break;
+        case BISHOP: attacks = bishopAttacks(from, occupied);     break;
+        case ROOK:   attacks = rookAttacks(from, occupied);       break;
+        case QUEEN:  attacks = queenAttacks(from, occupied);      break;
+        case KING:   attacks = Bitboards::kingAttacks[from];      break;
+        default:     attacks = 0;
+    }
+    return (attacks & squareBB(to)) != 0;
+}
+
+bool Position::isLegal(Move move) const
+{
+    const eColor us = m_sideToMove;
+    const eColor them = opposite(us);
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int kingSq = kingSquare(us);
+
+    if (isEnPassantMove(move)) {
+        // the captured pawn and the moving one both leave the rank, check it as a whole
+        const int capturedSq = to + (us == WHITE ? -8 : 8);
+        const Bitboard occupied = (pieces() ^ squareBB(from) ^ squareBB(capturedSq)) | squareBB(to);
+        return !(attackersTo(kingSq, occupied) & pieces(them) & ~squareBB(capturedSq));
+    }
+
+    if (isCastlingMove(move)) {
+        if (inCheck()) return false;
+        const int step = to > from ? 1 : -1;
+        for (auto square = from + step; square != to + step; square += step)
+            if (isAttacked(square, them)) return false;
+        return true;
+    }
+
+    if (from == kingSq)
+        return !(attackersTo(to, pieces() ^ squareBB(from)) & pieces(them));
+
+    // a single checker must be captured or blocked, a double check allows king moves only
+    const Bitboard checkersBB = checkers();
+    if (checkersBB) {
+        if (moreThanOne(checkersBB)) return false;
+        const int checkerSq = lsb(checkersBB);
+        if (to != checkerSq && !(Bitboards::between[kingSq][checkerSq] & squareBB(to)))
+            return false;
+    }
+
+    // pinned pieces may move along the pin line only
+    return !(pinned() & squareBB(from)) || (Bitboards::line[from][kingSq] & squareBB(to));
+}
+
+bool Position::givesCheck(Move move) const
+{
+    const eColor us = m_sideToMove;
+    const eColor them = opposite(us);
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int kingSq = kingSquare(them);
+    const ePieceType type = isPromotionMove(move) ? promotionType(move) : typeOf(m_board[from]);
+
+    // board as it is after the move, own pieces only
+    Bitboard occupied = (pieces() ^ squareBB(from)) | squareBB(to);
+    Bitboard diagonal = pieces(us, BISHOP, QUEEN) & ~squareBB(from);
+    Bitboard straight = pieces(us, ROOK, QUEEN) & ~squareBB(from);
+    Bitboard knights  = pieces(us, KNIGHT) & ~squareBB(from);
+    Bitboard pawns    = pieces(us, PAWN) & ~squareBB(from);
+
+    if (isEnPassantMove(move))
+        occupied ^= squareBB(to + (us == WHITE ? -8 : 8));
+    if (isCastlingMove(move)) {
+        const int rookFrom = moveFlag(move) == KING_CASTLE ? to + 1 : to - 2;
+        const int rookTo   = moveFlag(move) == KING_CASTLE ? to - 1 : to + 1;
+        occupied = (occupied ^ squareBB(rookFrom)) | squareBB(rookTo);
+        straight = (straight & ~squareBB(rookFrom)) | squareBB(rookTo);
+    }
+
+    switch (type) {
+        case PAWN:   pawns    |= squareBB(to); break;
+        case KNIGHT: knights  |= squareBB(to); break;
+        case BISHOP: diagonal |= squareBB(to); break;
+        case ROOK:   straight |= squareBB(to); break;
+        case QUEEN:  diagonal |= squareBB(to); straight |= squareBB(to); break;
+        default: break;
+    }
+
+    return (bishopAttacks(kingSq, occupied) & diagonal) ||
+           (rookAttacks(kingSq, occupied) & straight) ||
+           (Bitboards::knightAttacks[kingSq] & knights) ||
+           (Bitboards::pawnAttacks[them][kingSq] & pawns);
+}
+
+void Position::doMove(Move move)
+{
+    m_pushState();
+    StateInfo &st = m_state();
+
+    const eColor us = m_sideToMove;
+    const eColor them = opposite(us);
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int piece = m_board[from];
+
+    st.key ^= Zobrist::side;
+    st.rule50++;
+    st.pliesFromNull++;
+    st.captured = NO_PIECE;
+
+    if (st.epSquare != NO_SQUARE) {
+        st.key ^= Zobrist::enPassant[fileOf(st.epSquare)];
+        st.epSquare = NO_SQUARE;
+    }
+
+    if (isCastlingMove(move)) {
+        const int rookFrom = moveFlag(move) == KING_CASTLE ? to + 1 : to - 2;
+        const int rookTo   = moveFlag(move) == KING_CASTLE ? to - 1 : to + 1;
+        const int rook = makePiece(us, ROOK);
+        m_movePiece(from, to);
+        m_movePiece(rookFrom, rookTo);
+        st.key ^= Zobrist::psq[piece][from] ^ Zobrist::psq[piece][to]
+                ^ Zobrist::psq[rook][rookFrom] ^ Zobrist::psq[rook][rookTo];
+    } else {
+        if (isCaptureMove(move)) {
+            const int capturedSq = isEnPassantMove(move) ? to + (us == WHITE ? -8 : 8) : to;
+            st.captured = m_board[capturedSq];
+            st.key ^= Zobrist::psq[st.captured][capturedSq];
+            if (typeOf(st.captured) == PAWN)
+                st.pawnKey ^= Zobrist::psq[st.captured][capturedSq];
+            m_removePiece(capturedSq);
+            st.rule50 = 0;
+        }
+
+        m_movePiece(from, to);
+        st.key ^= Zobrist::psq[piece][from] ^ Zobrist::psq[piece][to];
+
+        if (typeOf(piece) == PAWN) {
+            st.rule50 = 0;
+            st.pawnKey ^= Zobrist::psq[piece][from] ^ Zobrist::psq[piece][to];
+            if (moveFlag(move) == DOUBLE_PAWN_PUSH) {
+                const int epSq = (from + to) / 2;
+                if (Bitboards::pawnAttacks[us][epSq] & pieces(them, PAWN)) {
+                    st.epSquare = epSq;
+                    st.key ^= Zobrist::enPassant[fileOf(epSq)];
+                }
+            } else if (isPromotionMove(move)) {
+                const int promoted = makePiece(us, promotionType(move));
+                m_removePiece(to);
+                m_putPiece(promoted, to);
+                st.key ^= Zobrist::psq[piece][to] ^ Zobrist::psq[promoted][to];
+                st.pawnKey ^= Zobrist::psq[piece][to];
+            }
+        }
+    }
+
+    const int rightsLeft = castlingMask(from) & castlingMask(to);
+    if (st.castling & ~rightsLeft) {
+        st.key ^= Zobrist::castling[st.castling];
+        st.castling &= rightsLeft;
+        st.key ^= Zobrist::castling[st.castling];
+    }
+
+    m_sideToMove = them;
+    m_gamePly++;
+    m_updateCheckInfo();
+
+    Q_ASSERT(m_psq == m_computePsq());
+    Q_ASSERT(st.pawnKey == m_computePawnKey());
+}
+
+void Position::undoMove(Move move)
+{
+    const StateInfo &st = m_state();
+    const eColor us = opposite(m_sideToMove); // side which has made the move
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+
+    if (isCastlingMove(move)) {
+        const int rookFrom = moveFlag(move) == KING_CASTLE ? to + 1 : to - 2;
+        const int rookTo   = moveFlag(move) == KING_CASTLE ? to - 1 : to + 1;
+        m_movePiece(to, from);
+        m_movePiece(rookTo, rookFrom);
+    } else {
+        if (isPromotionMove(move)) {
+            m_removePiece(to);
+            m_putPiece(makePiece(us, PAWN), to);
+        }
+        m_movePiece(to, from);
+        if (st.captured != NO_PIECE) {
+            const int capturedSq = isEnPassantMove(move) ? to + (us == WHITE ? -8 : 8) : to;
+            m_putPiece(st.captured, capturedSq);
+        }
+    }
+
+    m_sideToMove = us;
+    m_gamePly--;
+    m_stateIdx--;
+}
+
+void Position::doNullMove()
+{
+    Q_ASSERT(!inCheck());
+    m_pushState();
+    StateInfo &st = m_state();
+
+    st.key ^= Zobrist::side;
+    st.rule50++;
+    st.pliesFromNull = 0;
+    st.captured = NO_PIECE;
+    if (st.epSquare != NO_SQUARE) {
+        st.key ^= Zobrist::enPassant[fileOf(st.epSquare)];
+        st.epSquare = NO_SQUARE;
+    }
+
+    m_sideToMove = opposite(m_sideToMove);
+    m_gamePly++;
+    m_updateCheckInfo();
+}
+
+void Position::undoNullMove()
+{
+    m_sideToMove = opposite(m_sideToMove);
+    m_gamePly--;
+    m_stateIdx--;
+}
+
+bool Position::isDraw(int ply) const
+{
+    if (m_state().rule50 >= 100) {
+        // checkmate given by the hundredth halfmove still wins
+        if (!inCheck()) return true;
+        MoveList moves;
+        generateLegalMoves(*this, moves);
+        return !moves.isEmpty();
+    }
+
+    // bare kings or a single minor piece can't mate
+    if (!pieces(PAWN) && !pieces(ROOK, QUEEN) && !moreThanOne(pieces(KNIGHT, BISHOP)))
+        return true;
+
+    return isRepetition(ply);
+}
+
+bool Position::isRepetition(int ply) const
+{
+    const StateInfo &st = m_state();
+    const int end = qMin(qMin(st.rule50, st.pliesFromNull), m_stateIdx);
+    int count = 0;
+
+    for (auto i = 4; i <= end; i += 2) {
+        if (m_states[m_stateIdx - i].key == st.key) {
+            // a repetition inside the search tree is enough,
+            // the game history needs the third occurrence
+            if (i <= ply || ++count == 2)
+                return true;
+        }
+    }
+    return false;
+}
+
+void Position::m_clear()
+{
+    for (auto square = 0; square < 64; square++)
+        m_board[square] = NO_PIECE;
+    memset(m_byType, 0, sizeof(m_byType));
+    memset(m_byColor, 0, sizeof(m_byColor));
+    m_sideToMove = WHITE;
+    m_gamePly = 0;
+    m_stateIdx = 0;
+    m_psq = Score();
+    m_phase = 0;
+    m_nonPawnMaterial[WHITE] = m_nonPawnMaterial[BLACK] = 0;
+
+    StateInfo &st = m_state();
+    memset(&st, 0, sizeof(StateInfo));
+    st.epSquare = NO_SQUARE;
+    st.captured = NO_PIECE;
+}
+
+void Position::m_putPiece(int piece, int square)
+{
+    m_board[square] = piece;
+    m_byType[typeOf(piece)] |= squareBB(square);
+    m_byColor[colorOf(piece)] |= squareBB(square);
+
+    m_psq += PSQT::psq[piece][square];
+    m_phase += PSQT::phaseWeight[typeOf(piece)];
+    if (typeOf(piece) != PAWN && typeOf(piece) != KING)
+        m_nonPawnMaterial[colorOf(piece)] += PSQT::material[typeOf(piece)].mg;
+}
+
+void Position::m_removePiece(int square)
+{
+    const int piece = m_board[square];
+    m_byType[typeOf(piece)] ^= squareBB(square);
+    m_byColor[colorOf(piece)] ^= squareBB(square);
+    m_board[square] = NO_PIECE;
+
+    m_psq -= PSQT::psq[piece][square];
+    m_phase -= PSQT::phaseWeight[typeOf(piece)];
+    if (typeOf(piece) != PAWN && typeOf(piece) != KING)
+        m_nonPawnMaterial[colorOf(piece)] -= PSQT::material[typeOf(piece)].mg;
+}
+
+void Position::m_movePiece(int from, int to)
+{
+    const int piece = m_board[from];
+    const Bitboard fromTo = squareBB(from) | squareBB(to);
+    m_byType[typeOf(piece)] ^= fromTo;
+    m_byColor[colorOf(piece)] ^= fromTo;
+    m_board[from] = NO_PIECE;
+    m_board[to] = piece;
+
+    m_psq += PSQT::psq[piece][to] - PSQT::psq[piece][from];
+}
+
+void Position::m_pushState()
+{
+    if (m_stateIdx + 1 == MAX_STATES) {
+        // Very long game: drop the oldest states. What is kept covers
+        // the fifty moves window and the deepest search line
+        const int kept = 100 + 2 * MAX_PLY;
+        memmove(m_states, m_states + (m_stateIdx + 1 - kept), kept * sizeof(StateInfo));
+        m_stateIdx = kept - 1;
+    }
+    m_states[m_stateIdx + 1] = m_states[m_stateIdx];
+    m_stateIdx++;
+}
+
+void Position::m_updateCheckInfo()
+{
+    StateInfo &st = m_state();
+    const eColor us = m_sideToMove;
+    const eColor them = opposite(us);
+    const int kingSq = kingSquare(us);
+    const Bitboard occupied = pieces();
+
+    st.checkers = attackersTo(kingSq) & pieces(them);
+
+    // a piece is pinned if it is the only one between the king and an enemy slider
+    st.pinned = 0;
+    Bitboard snipers = (rookAttacks(kingSq, 0) & pieces(them, ROOK, QUEEN))
+                     | (bishopAttacks(kingSq, 0) & pieces(them, BISHOP, QUEEN));
+    while (snipers) {
+        const Bitboard blockers = Bitboards::between[kingSq][popLsb(snipers)] & occupied;
+        if (blockers && !moreThanOne(blockers))
+            st.pinned |= blockers & pieces(us);
+    }
+}
+
+Key Position::m_computeKey() const
+{
+    const StateInfo &st = m_state();
+    Key key = Zobrist::castling[st.castling];
+
+    for (auto square = 0; square < 64; square++)
+        if (m_board[square] != NO_PIECE)
+            key ^= Zobrist::psq[m_board[square]][square];
+    if (st.epSquare != NO_SQUARE)
+        key ^= Zobrist::enPassant[fileOf(st.epSquare)];
+    if (m_sideToMove == BLACK)
+        key ^= Zobrist::side;
+
+    return key;
+}
+
+Key Position::m_computePawnKey() const
+{
+    Key key = Zobrist::noPawns;
+    Bitboard pawns = pieces(PAWN);
+    while (pawns) {
+        const int square = popLsb(pawns);
+        key ^= Zobrist::psq[m_board[square]][square];
+    }
+    return key;
+}
+
+Score Position::m_computePsq() const
+{
+    Score score;
+    for (auto square = 0; square < 64; square++)
+        if (m_board[square] != NO_PIECE)
+            score += PSQT::psq[m_board[square]][square];
+    return score;
+}
+
+}
@@ -0,0 +1,171 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_POSITION_H
+#define ENGINE_POSITION_H
+
+#include <QString>
+
+#include "types.h"
+#include "psqt.h"
+
+//==============================================================
+//                      Zobrist keys
+//==============================================================
+
+namespace engine
+{
+
+namespace Zobrist
+{
+    extern Key psq[PIECE_NB][64];
+    extern Key enPassant[8];   // by file of the en passant square
+    extern Key castling[16];   // by eCastlingRights combination
+    extern Key side;           // xor-ed in when BLACK is to move
+    extern Key noPawns;        // pawn key of the position without pawns
+}
+
+//==============================================================
+//                      Position
+//==============================================================
+
+//    StateInfo holds everything that can't be restored from the move itself
+//    when the move is taken back
+struct StateInfo {
+    Key      key;
+    Key      pawnKey;       // pawns of both colors only, see PawnTable
+    int      castling;      // eCastlingRights
+    int      epSquare;      // en passant target square or NO_SQUARE
+    int      rule50;        // halfmoves since the last capture or pawn move
+    int      pliesFromNull; // halfmoves since the last null move, bounds repetition search
+    int      captured;      // ePiece captured by the move leading here
+    Bitboard checkers;      // enemy pieces giving check to the side to move
+    Bitboard pinned;        // pieces of the side to move pinned to their king
+};
+
+//    Position is the board representation used by the engine:
+//    bitboards along with a square-centric board, incremental Zobrist key
+//    and a history of states for taking moves back and repetition detection.
+//    Unlike Chessboard it is a plain value type without any signals,
+//    so every search thread works on its own copy.
+class Position {
+public:
+    Position();
+
+    static const char *startFEN();
+    // startKey: Zobrist key of startFEN(), the files of keys store it to tell keys of another build
+    static Key         startKey();
+
+    // setFEN: returns false if the string isn't a valid FEN, position is left unchanged then
+    bool     setFEN(const QString &fen);
+    QString  fen() const;
+
+    eColor   sideToMove() const { return m_sideToMove; }
+    int      pieceOn(int square) const { return m_board[square]; }
+    bool     isEmpty(int square) const { return m_board[square] == NO_PIECE; }
+
+    Bitboard pieces() const { return m_byColor[WHITE] | m_byColor[BLACK]; }
+    Bitboard pieces(eColor color) const { return m_byColor[color]; }
+    Bitboard pieces(ePieceType type) const { return m_byType[type]; }
+    Bitboard pieces(ePieceType type1, ePieceType type2) const { return m_byType[type1] | m_byType[type2]; }
+    Bitboard pieces(eColor color, ePieceType type) const { return m_byColor[color] & m_byType[type]; }
+    Bitboard pieces(eColor color, ePieceType type1, ePieceType type2) const { return m_byColor[color] & (m_byType[type1] | m_byType[type2]); }
+    int      kingSquare(eColor color) const { return lsb(pieces(color, KING)); }
+
+    Key      key() const { return m_state().key; }
+    Key      pawnKey() const { return m_state().pawnKey; }
+    int      castlingRights() const { return m_state().castling; }
+    int      epSquare() const { return m_state().epSquare; }
+    int      rule50() const { return m_state().rule50; }
+    int      pliesFromNull() const { return m_state().pliesFromNull; }
+    int      gamePly() const { return m_gamePly; }
+    int      capturedPiece() const { return m_state().captured; }
+    Bitboard checkers() const { return m_state().checkers; }
+    Bitboard pinned() const { return m_state().pinned; }
+    bool     inCheck() const { return m_state().checkers != 0; }
+
+    // psqScore: material and piece-square values of all the pieces from WHITE
+    //      point of view, kept up to date by doMove/undoMove
+    Score    psqScore() const { return m_psq; }
+    // phase: PHASE_MIDGAME with all the pieces on the board down to 0 with pawns and kings only
+    int      phase() const { return qMin(m_phase, int(PHASE_MIDGAME)); }
+    int      nonPawnMaterial(eColor color) const { return m_nonPawnMaterial[color]; }
+
+    // attackersTo: pieces of both colors attacking the square with the given occupancy
+    Bitboard attackersTo(int square, Bitboard occupied) const;
+    Bitboard attackersTo(int square) const { return attackersTo(square, pieces()); }
+    bool     isAttacked(int square, eColor byColor) const;
+
+    int      movedPiece(Move move) const { return m_board[moveFrom(move)]; }
+    // isPseudoLegal: validates moves which didn't come from the generator (hash table, killers)
+    bool     isPseudoLegal(Move move) const;
+    // isLegal: checks that a pseudo legal move doesn't leave own king in check
+    bool     isLegal(Move move) const;
+    bool     givesCheck(Move move) const;
+
+    void     doMove(Move move);
+    void     undoMove(Move move);
+    // doNullMove: passes the move to the opponent, the side to move must not be in check
+    void     doNullMove();
+    void     undoNullMove();
+
+    // isDraw: fifty moves rule and repetitions. In the search a single repetition
+    //      since the root (`ply` halfmoves ago) is already scored as a draw
+    bool     isDraw(int ply) const;
+    bool     isRepetition(int ply) const;
+
+private:
+    enum {
+        // states kept for taking back moves and repetition detection,
+        // older states of very long games are dropped (see m_pushState)
+        MAX_STATES = 1024
+    };
+
+    const StateInfo &m_state() const { return m_states[m_stateIdx]; }
+    StateInfo       &m_state()       { return m_states[m_stateIdx]; }
+
+    void     m_clear();
+    void     m_putPiece(int piece, int square);
+    void     m_removePiece(int square);
+    void     m_movePiece(int from, int to);
+    void     m_pushState();
+    void     m_updateCheckInfo();
+    Key      m_computeKey() const;
+    Key      m_computePawnKey() const;
+    Score    m_computePsq() const;
+
+    int       m_board[64];
+    Bitboard  m_byType[6];
+    Bitboard  m_byColor[2];
+    eColor    m_sideToMove;
+    int       m_gamePly;
+
+    Score     m_psq;
+    int       m_phase;
+    int       m_nonPawnMaterial[2]; // midgame material of knights, bishops, rooks and queens
+
+    StateInfo m_states[MAX_STATES];
+    int       m_stateIdx; // index of the current state, states are kept by index so copies stay valid
+};
+
+}
+
+#endif//ENGINE_POSITION_H
@@ -0,0 +1,59 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_PSQT_H
+#define ENGINE_PSQT_H
+
+#include "types.h"
+
+//==============================================================
+//                  Material and piece-square tables
+//==============================================================
+
+namespace engine
+{
+
+enum eGamePhase {
+    // phase weights of the pieces: knight and bishop 1, rook 2, queen 4
+    PHASE_MIDGAME = 24 // all the pieces are on the board
+};
+
+namespace PSQT
+{
+    // psq: material plus piece-square bonus of a piece on a square,
+    //      from WHITE point of view: black pieces have negated values
+    extern Score psq[PIECE_NB][64];
+    // material: value of a piece type
+    extern const Score material[6];
+    // phaseWeight: contribution of a piece type to the game phase
+    extern const int phaseWeight[6];
+    // midgameTable / endgameTable: piece-square bonuses by ePieceType from WHITE point of view,
+    //      written as seen on the board: the first row is the 8th rank
+    extern const int midgameTable[6][64];
+    extern const int endgameTable[6][64];
+
+    // init(): fills the tables; safe to call several times
+    void init();
+}
+
+}
+
+#endif//ENGINE_PSQT_H
@@ -0,0 +1,893 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "search.h"
+#include "movegen.h"
+#include "evaluation.h"
+#include "see.h"
+#include "tablebase.h"
+#include "dtm.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+// Helper threads skip depths following these tables, indexed by (helper id - 1) % 20:
+// a depth is skipped if ((depth + phase) / size) is odd, so half of the helpers
+// search one depth ahead of the others
+const int skipSize[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+const int skipPhase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+const int ASPIRATION_WINDOW = 25;
+
+// margins of the selective search in centipawns per ply of remaining depth
+const int RAZOR_MARGIN    = 300;
+const int FUTILITY_MARGIN = 100;
+
+//    ReductionTable: plies a late quiet move is reduced by, growing with
+//    both the remaining depth and the number of moves tried before it
+struct ReductionTable {
+    ReductionTable()
+    {
+        for (auto depth = 0; depth < 64; depth++)
+            for (auto moveNumber = 0; moveNumber < 64; moveNumber++)
+                reductions[depth][moveNumber] = depth == 0 || moveNumber == 0 ? 0 :
+                    int(0.75 + std::log(double(depth)) * std::log(double(moveNumber)) / 2.25);
+    }
+
+    int reductions[64][64];
+};
+
+int lmrReduction(int depth, int moveNumber)
+{
+    static const ReductionTable table;
+    return table.reductions[qMin(depth, 63)][qMin(moveNumber, 63)];
+}
+
+}
+
+
+//==============================================================
+//                      SearchWorker
+//==============================================================
+
+SearchWorker::SearchWorker(Search *owner, int id)
+{
+    m_owner = owner;
+    m_id = id;
+    m_nodes.store(0);
+    m_tbHits.store(0);
+    m_selDepth = 0;
+    m_rootBestMoveNodes = 0;
+    m_completedDepth = 0;
+    m_bestScore = VALUE_NONE;
+    m_multiPv = 1;
+    m_pvIndex = 0;
+    m_useNnue = false;
+    m_usePawnHash = false;
+}
+
+void SearchWorker::prepare(const Position &root)
+{
+    m_pos = root;
+    m_nodes.store(0);
+    m_tbHits.store(0);
+    m_selDepth = 0;
+    m_rootBestMoveNodes = 0;
+    m_completedDepth = 0;
+    m_bestScore = VALUE_NONE;
+    m_bestPv.clear();
+    m_lines.clear();
+    m_pvIndex = 0;
+    std::memset(m_killers, 0, sizeof(m_killers));
+    m_pawnTable.resetStats();
+
+    MoveList rootMoves;
+    generateLegalMoves(m_pos, rootMoves);
+    const int searchedMoves = m_owner->m_tbRootMoves.isEmpty() ? rootMoves.size() : m_owner->m_tbRootMoves.size();
+    m_multiPv = qBound(1, m_owner->m_limits.multiPv, qMax(1, searchedMoves));
+
+    m_useNnue = m_owner->m_options.useNnue && Nnue::isLoaded();
+    if (m_useNnue)
+        Nnue::refresh(m_accumulators[0], m_pos);
+    m_usePawnHash = m_owner->m_options.pawnHash;
+}
+
+void SearchWorker::clearHistory()
+{
+    m_history.clear();
+    m_pawnTable.clear();
+}
+
+void SearchWorker::iterativeDeepening()
+{
+    for (auto depth = 1; depth <= m_owner->m_limits.depth && depth < MAX_PLY; depth++) {
+        if (m_skipDepth(depth))
+            continue;
+
+        m_selDepth = 0;
+
+        QVector<PvLine> lines;
+        quint64 iterationNodes = 0;
+        for (m_pvIndex = 0; m_pvIndex < m_multiPv; m_pvIndex++) {
+            const int previousScore = m_pvIndex < m_lines.size() ? m_lines.at(m_pvIndex).score : VALUE_NONE;
+            quint64 lineNodes = 0;
+
+            PvLine line;
+            line.score = m_searchLine(depth, previousScore, lineNodes);
+            if (m_owner->isStopped())
+                break;
+
+            for (auto i = 0; i < m_pvLength[0]; i++)
+                line.pv.append(m_pv[0][i]);
+            if (!line.pv.isEmpty())
+                m_excludedRootMoves[m_pvIndex] = line.pv.first();
+            if (m_pvIndex == 0)
+                iterationNodes = lineNodes;
+            lines.append(line);
+        }
+
+        // results of an interrupted iteration are not trusted
+        if (m_owner->isStopped())
+            break;
+
+        // a line found later may still beat an earlier one when the score of
+        // the earlier one has dropped in this iteration
+        std::stable_sort(lines.begin(), lines.end(), [](const PvLine &a, const PvLine &b) {
+            return a.score > b.score;
+        });
+
+        m_lines = lines;
+        m_completedDepth = depth;
+        m_bestScore = m_lines.first().score;
+        m_bestPv = m_lines.first().pv;
+
+        if (isMain()) {
+            m_owner->m_reportIteration(*this);
+
+            const double effort = double(m_rootBestMoveNodes) / qMax<quint64>(1, iterationNodes);
+            if (m_owner->m_iterationDone(depth, m_bestPv.isEmpty() ? NO_MOVE : m_bestPv.first(), m_bestScore, effort))
+                break;
+        }
+    }
+}
+
+int SearchWorker::m_searchLine(int depth, int previousScore, quint64 &lineNodes)
+{
+    // aspiration window around the previous score, widened on failure
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -VALUE_INFINITE, beta = VALUE_INFINITE;
+    if (depth >= 5 && previousScore != VALUE_NONE && !isMateScore(previousScore)) {
+        alpha = qMax(previousScore - delta, int(-VALUE_INFINITE));
+        beta  = qMin(previousScore + delta, int(VALUE_INFINITE));
+    }
+
+    int score;
+    while (true) {
+        const quint64 nodesBefore = m_nodes.load();
+        score = m_search(alpha, beta, depth, 0);
+        lineNodes = m_nodes.load() - nodesBefore;
+        if (m_owner->isStopped())
+            break;
+
+        if (score <= alpha) {
+            beta = (alpha + beta) / 2;
+            alpha = qMax(score - delta, int(-VALUE_INFINITE));
+        } else if (score >= beta) {
+            beta = qMin(score + delta, int(VALUE_INFINITE));
+        } else {
+            break;
+        }
+        delta += delta / 2;
+    }
+    return score;
+}
+
+int SearchWorker::m_search(int alpha, int beta, int depth, int ply)
+{
+    const bool isPvNode = beta - alpha > 1;
+    const bool isRoot = ply == 0;
+
+    if (depth <= 0)
+        return m_qsearch(alpha, beta, ply);
+
+    m_pvLength[ply] = 0;
+
+    m_countNode();
+    if (m_owner->isStopped())
+        return 0;
+
+    m_selDepth = qMax(m_selDepth, ply + 1);
+
+    if (!isRoot) {
+        if (m_pos.isDraw(ply))
+            return VALUE_DRAW;
+        if (ply >= MAX_PLY - 1)
+            return m_evaluate(ply);
+
+        // mate distance pruning: a shorter mate has already been found
+        alpha = qMax(matedIn(ply), alpha);
+        beta = qMin(mateIn(ply + 1), beta);
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    const Key key = m_pos.key();
+    TTData ttData;
+    Move ttMove = NO_MOVE;
+    const bool ttHit = m_owner->m_tt.probe(key, ttData);
+    if (ttHit) {
+        ttMove = ttData.move;
+        const int ttScore = scoreFromTT(ttData.score, ply);
+        if (!isPvNode && ttData.depth >= depth &&
+            (ttData.bound == BOUND_EXACT ||
+             (ttData.bound == BOUND_LOWER && ttScore >= beta) ||
+             (ttData.bound == BOUND_UPPER && ttScore <= alpha)))
+            return ttScore;
+    }
+
+    int bestScore = -VALUE_INFINITE;
+    int maxScore = VALUE_INFINITE; // tablebase upper bound of a PV node
+
+    // DTM tables: exact mate distances, as long as the mate comes before the fifty moves rule
+    if (!isRoot && m_owner->m_options.useTablebases && Dtm::canProbe(m_pos)) {
+        bool isFound = false;
+        const int plies = Dtm::probe(m_pos, &isFound);
+        if (isFound && (plies == Dtm::DTM_DRAW || (m_pos.rule50() + plies <= 100 && ply + plies < MAX_PLY))) {
+            m_tbHits.store(m_tbHits.load() + 1);
+
+            const int dtmScore = plies == Dtm::DTM_DRAW ? VALUE_DRAW :
+                                 plies % 2 == 1 ? mateIn(ply + plies) : matedIn(ply + plies);
+            m_owner->m_tt.store(key, NO_MOVE, scoreToTT(dtmScore, ply), VALUE_NONE, MAX_PLY - 1, BOUND_EXACT);
+            return dtmScore;
+        }
+    }
+
+    // Tablebases: exact results right after a capture or a pawn move, the tables
+    // know nothing about the fifty moves counter of the other positions
+    if (!isRoot && m_owner->m_options.useTablebases && m_pos.rule50() == 0 && Tablebases::canProbe(m_pos)) {
+        bool isFound = false;
+        const eWdl wdl = Tablebases::probeWdl(m_pos, &isFound);
+        if (isFound) {
+            m_tbHits.store(m_tbHits.load() + 1);
+
+            const int tbScore = wdl < WDL_BLESSED_LOSS ? -VALUE_TB_WIN + ply :
+                                wdl > WDL_CURSED_WIN   ?  VALUE_TB_WIN - ply : VALUE_DRAW + wdl;
+            const eBound tbBound = wdl < WDL_BLESSED_LOSS ? BOUND_UPPER :
+                                   wdl > WDL_CURSED_WIN   ? BOUND_LOWER : BOUND_EXACT;
+
+            if (tbBound == BOUND_EXACT ||
+                (tbBound == BOUND_LOWER ? tbScore >= beta : tbScore <= alpha)) {
+                m_owner->m_tt.store(key, NO_MOVE, scoreToTT(tbScore, ply), VALUE_NONE, qMin(depth + 6, MAX_PLY - 1), tbBound);
+                return tbScore;
+            }
+
+            // a PV node still needs its line, the score stays within the bound
+            if (isPvNode) {
+                if (tbBound == BOUND_LOWER) {
+                    bestScore = tbScore;
+                    alpha = qMax(alpha, tbScore);
+                } else {
+                    maxScore = tbScore;
+                }
+            }
+        }
+    }
+
+    const SearchOptions &options = m_owner->m_options;
+    const bool inCheck = m_pos.inCheck();
+    int staticEval = VALUE_NONE;
+    if (!inCheck)
+        staticEval = ttHit && ttData.eval != VALUE_NONE ? ttData.eval : m_evaluate(ply);
+
+    // selective search at non-PV nodes, the score of a PV node stays exact
+    if (!isPvNode && !inCheck) {
+        // razoring: far below alpha near the horizon, only a capture may save the node
+        if (options.futilityPruning && depth <= 2 && staticEval + RAZOR_MARGIN * depth <= alpha) {
+            const int score = m_qsearch(alpha, alpha + 1, ply);
+            if (m_owner->isStopped())
+                return 0;
+            if (score <= alpha)
+                return score;
+        }
+
+        // reverse futility: so far above beta that a quiet opponent move won't catch up
+        if (options.futilityPruning && depth <= 6 && staticEval - FUTILITY_MARGIN * depth >= beta &&
+            staticEval < VALUE_TB_WIN_IN_MAX_PLY)
+            return staticEval;
+
+        // null move: the position stays above beta even if the opponent moves twice.
+        // With pawns alone passing may be the only good move (zugzwang), so never then,
+        // and never twice in a row
+        if (options.nullMove && depth >= 3 && staticEval >= beta && m_pos.pliesFromNull() > 0 &&
+            m_pos.nonPawnMaterial(m_pos.sideToMove()) > 0) {
+            const int reduction = 3 + depth / 6;
+            m_doNullMove(ply);
+            const int score = -m_search(-beta, -beta + 1, depth - 1 - reduction, ply + 1);
+            m_pos.undoNullMove();
+
+            if (m_owner->isStopped())
+                return 0;
+            // a mate found after passing isn't proven
+            if (score >= beta)
+                return score >= VALUE_TB_WIN_IN_MAX_PLY ? beta : score;
+        }
+    }
+
+    const bool ordered = options.moveOrdering;
+    MovePicker picker(m_pos, ttMove, ordered ? m_killers[ply] : nullptr, ordered ? &m_history : nullptr);
+
+    const eColor us = m_pos.sideToMove();
+    const int oldAlpha = alpha;
+    Move bestMove = NO_MOVE;
+    int legalMoves = 0;
+    Move quietsTried[64];
+    int quietCount = 0;
+
+    Move move;
+    while ((move = picker.nextMove()) != NO_MOVE) {
+        if (!m_pos.isLegal(move))
+            continue;
+        if (isRoot && !m_isRootMove(move))
+            continue;
+
+        legalMoves++;
+        const bool isQuiet = !isTacticalMove(move);
+
+        // futility: a quiet move can't lift a hopeless static score above alpha near the horizon
+        if (options.futilityPruning && !isPvNode && !inCheck && isQuiet && depth <= 3 &&
+            bestScore > VALUE_MATED_IN_MAX_PLY && !m_pos.givesCheck(move)) {
+            const int futilityScore = staticEval + FUTILITY_MARGIN * (depth + 1);
+            if (futilityScore <= alpha) {
+                bestScore = qMax(bestScore, futilityScore);
+                continue;
+            }
+        }
+
+        const quint64 nodesBefore = m_nodes.load();
+        m_doMove(move, ply);
+        m_owner->m_tt.prefetch(m_pos.key());
+
+        // check extension
+        const bool givesCheck = m_pos.inCheck();
+        const int newDepth = depth - 1 + (givesCheck ? 1 : 0);
+
+        int score;
+        if (legalMoves == 1) {
+            score = -m_search(-beta, -alpha, newDepth, ply + 1);
+        } else {
+            // late move reductions: the later a quiet move comes in the ordering, the less
+            // likely it is best. Killers and moves with a good history are reduced less
+            int reduction = 0;
+            if (options.lateMoveReductions && depth >= 3 && isQuiet && !inCheck && !givesCheck &&
+                legalMoves > (isPvNode ? 4 : 2)) {
+                reduction = lmrReduction(depth, legalMoves) - (isPvNode ? 1 : 0);
+                if (move == m_killers[ply][0] || move == m_killers[ply][1])
+                    reduction--;
+                reduction -= m_history.get(us, move) / (HistoryTable::MAX_HISTORY / 2);
+                reduction = qBound(0, reduction, newDepth - 1);
+            }
+
+            // principal variation search: prove the move is worse with a null window first
+            score = -m_search(-alpha - 1, -alpha, newDepth - reduction, ply + 1);
+            if (reduction > 0 && score > alpha)
+                score = -m_search(-alpha - 1, -alpha, newDepth, ply + 1);
+            if (score > alpha && score < beta)
+                score = -m_search(-beta, -alpha, newDepth, ply + 1);
+        }
+
+        m_pos.undoMove(move);
+
+        if (m_owner->isStopped())
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                bestMove = move;
+                alpha = score;
+                m_updatePv(ply, move);
+                if (isRoot && m_pvIndex == 0)
+                    m_rootBestMoveNodes = m_nodes.load() - nodesBefore;
+                if (score >= beta) {
+                    if (ordered && !isTacticalMove(move))
+                        m_updateQuietStats(ply, depth, move, quietsTried, quietCount);
+                    break;
+                }
+            }
+        }
+
+        if (isQuiet && quietCount < 64)
+            quietsTried[quietCount++] = move;
+    }
+
+    if (legalMoves == 0)
+        return inCheck ? matedIn(ply) : VALUE_DRAW;
+
+    if (isPvNode)
+        bestScore = qMin(bestScore, maxScore);
+
+    // the root result of a later line is not the result of the position
+    if (isRoot && m_pvIndex > 0)
+        return bestScore;
+
+    const eBound bound = bestScore >= beta ? BOUND_LOWER :
+                         bestScore > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
+    m_owner->m_tt.store(key, bestMove, scoreToTT(bestScore, ply), staticEval, depth, bound);
+
+    return bestScore;
+}
+
+int SearchWorker::m_qsearch(int alpha, int beta, int ply)
+{
+    const bool isPvNode = beta - alpha > 1;
+
+    m_pvLength[ply] = 0;
+
+    m_countNode();
+    if (m_owner->isStopped())
+        return 0;
+
+    m_selDepth = qMax(m_selDepth, ply + 1);
+
+    if (m_pos.isDraw(ply))
+        return VALUE_DRAW;
+
+    const bool inCheck = m_pos.inCheck();
+    if (ply >= MAX_PLY - 1)
+        return inCheck ? VALUE_DRAW : m_evaluate(ply);
+
+    const Key key = m_pos.key();
+    TTData ttData;
+    Move ttMove = NO_MOVE;
+    if (m_owner->m_tt.probe(key, ttData)) {
+        ttMove = ttData.move;
+        const int ttScore = scoreFromTT(ttData.score, ply);
+        if (!isPvNode &&
+            (ttData.bound == BOUND_EXACT ||
+             (ttData.bound == BOUND_LOWER && ttScore >= beta) ||
+             (ttData.bound == BOUND_UPPER && ttScore <= alpha)))
+            return ttScore;
+    }
+
+    // stand pat: the side to move isn't forced to capture unless it is in check
+    int bestScore = -VALUE_INFINITE;
+    if (!inCheck) {
+        bestScore = m_evaluate(ply);
+        if (bestScore >= beta)
+            return bestScore;
+        alpha = qMax(alpha, bestScore);
+    }
+
+    // all the evasions when in check, otherwise captures only
+    MovePicker picker = inCheck ? MovePicker(m_pos, ttMove, nullptr, &m_history) : MovePicker(m_pos, ttMove);
+
+    const int oldAlpha = alpha;
+    Move bestMove = NO_MOVE;
+    int legalMoves = 0;
+
+    Move move;
+    while ((move = picker.nextMove()) != NO_MOVE) {
+        if (!m_pos.isLegal(move))
+            continue;
+
+        legalMoves++;
+
+        // a capture losing material can't do better than standing pat
+        if (!inCheck && !seeGE(m_pos, move))
+            continue;
+
+        m_doMove(move, ply);
+        m_owner->m_tt.prefetch(m_pos.key());
+        const int score = -m_qsearch(-beta, -alpha, ply + 1);
+        m_pos.undoMove(move);
+
+        if (m_owner->isStopped())
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                bestMove = move;
+                alpha = score;
+                m_updatePv(ply, move);
+                if (score >= beta)
+                    break;
+            }
+        }
+    }
+
+    if (inCheck && legalMoves == 0)
+        return matedIn(ply);
+
+    const eBound bound = bestScore >= beta ? BOUND_LOWER :
+                         bestScore > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
+    m_owner->m_tt.store(key, bestMove, scoreToTT(bestScore, ply), VALUE_NONE, 0, bound);
+
+    return bestScore;
+}
+
+bool SearchWorker::m_isRootMove(Move move) const
+{
+    // the root moves of the better lines of a multi-PV search
+    if (std::find(m_excludedRootMoves, m_excludedRootMoves + m_pvIndex, move) != m_excludedRootMoves + m_pvIndex)
+        return false;
+    const MoveList &tbRootMoves = m_owner->m_tbRootMoves;
+    return tbRootMoves.isEmpty() || tbRootMoves.contains(move);
+}
+
+bool SearchWorker::m_skipDepth(int depth) const
+{
+    if (isMain())
+        return false;
+    const int idx = (m_id - 1) % 20;
+    return ((depth + m_pos.gamePly() + skipPhase[idx]) / skipSize[idx]) % 2 != 0;
+}
+
+void SearchWorker::m_updateQuietStats(int ply, int depth, Move move, const Move *quietsTried, int quietCount)
+{
+    if (m_killers[ply][0] != move) {
+        m_killers[ply][1] = m_killers[ply][0];
+        m_killers[ply][0] = move;
+    }
+
+    const eColor us = m_pos.sideToMove();
+    const int bonus = qMin(depth * depth, 400);
+    m_history.update(us, move, bonus * 32);
+    for (auto i = 0; i < quietCount; i++)
+        m_history.update(us, quietsTried[i], -bonus * 32);
+}
+
+void SearchWorker::m_doMove(Move move, int ply)
+{
+    if (m_useNnue)
+        Nnue::update(m_accumulators[ply + 1], m_accumulators[ply], m_pos, move);
+    m_pos.doMove(move);
+}
+
+void SearchWorker::m_doNullMove(int ply)
+{
+    if (m_useNnue)
+        m_accumulators[ply + 1] = m_accumulators[ply];
+    m_pos.doNullMove();
+}
+
+int SearchWorker::m_evaluate(int ply)
+{
+    if (m_useNnue)
+        return Nnue::evaluate(m_accumulators[ply], m_pos.sideToMove());
+    return evaluate(m_pos, m_usePawnHash ? &m_pawnTable : nullptr);
+}
+
+void SearchWorker::m_countNode()
+{
+    const quint64 nodes = m_nodes.load() + 1;
+    m_nodes.store(nodes);
+    if (isMain() && (nodes & 1023) == 0)
+        m_owner->m_checkLimits();
+}
+
+void SearchWorker::m_updatePv(int ply, Move move)
+{
+    m_pv[ply][0] = move;
+    for (auto i = 0; i < m_pvLength[ply + 1]; i++)
+        m_pv[ply][i + 1] = m_pv[ply + 1][i];
+    m_pvLength[ply] = m_pvLength[ply + 1] + 1;
+}
+
+
+//==============================================================
+//                          Search
+//==============================================================
+
+Search::Search()
+{
+    m_stop.store(0);
+    m_pondering.store(0);
+    m_stopOnPonderHit.store(0);
+    m_ponderHitTime = 0;
+    m_cachedDepth = 0;
+    setThreads(1);
+}
+
+Search::~Search()
+{
+    setThreads(0);
+}
+
+void Search::setThreads(int count)
+{
+    qDeleteAll(m_helpers);
+    m_helpers.clear();
+    qDeleteAll(m_workers);
+    m_workers.clear();
+
+    for (auto i = 0; i < count; i++) {
+        m_workers.append(new SearchWorker(this, i));
+        if (i > 0)
+            m_helpers.append(new HelperThread(m_workers.last()));
+    }
+}
+
+void Search::setHashSize(int megabytes)
+{
+    m_tt.resize(megabytes);
+}
+
+void Search::newGame()
+{
+    m_tt.clear();
+    for (auto worker : m_workers)
+        worker->clearHistory();
+}
+
+void Search::setInfoCallback(const std::function<void(const SearchInfo&)> &callback)
+{
+    m_infoCallback = callback;
+}
+
+SearchResult Search::go(const Position &root, const SearchLimits &limits)
+{
+    SearchResult result;
+    if (m_workers.isEmpty())
+        return result;
+
+    MoveList rootMoves;
+    generateLegalMoves(root, rootMoves);
+
+    // with the root in the tablebases only the moves keeping its result are searched
+    m_tbRootMoves.clear();
+    if (m_options.useTablebases && Tablebases::canProbe(root)) {
+        Position pos = root;
+        if (Tablebases::rootMoves(pos, m_tbRootMoves))
+            rootMoves = m_tbRootMoves;
+    }
+
+    // a result of an earlier session deep enough answers a depth limited search at once,
+    // otherwise its line is shown first and the search finds it in the transposition table
+    CachedLine cached;
+    const bool isCached = m_options.useAnalysisCache && m_tbRootMoves.isEmpty() && AnalysisCache::isOpen()
+                       && AnalysisCache::probeLine(root, &cached);
+    m_cachedDepth = isCached ? cached.depth : 0;
+    if (isCached && cached.depth >= limits.depth && !limits.infinite && !limits.ponder && limits.multiPv == 1) {
+        m_reportCachedLine(cached);
+        result.bestMove   = cached.pv.at(0);
+        result.ponderMove = cached.pv.size() > 1 ? cached.pv.at(1) : NO_MOVE;
+        result.score      = cached.score;
+        result.depth      = cached.depth;
+        return result;
+    }
+
+    m_limits = limits;
+    m_stop.store(0);
+    m_pondering.store(limits.ponder ? 1 : 0);
+    m_stopOnPonderHit.store(0);
+    m_ponderHitTime = limits.ponder ? -1 : 0;
+    m_tt.newSearch();
+    m_timer.start();
+    m_timeManager.init(limits, root.sideToMove(), rootMoves.size());
+
+    if (isCached) {
+        Position pos = root;
+        for (auto ply = 0; ply < cached.pv.size() && cached.depth - ply > 0; ply++) {
+            const int score = ply % 2 == 0 ? cached.score : -cached.score;
+            m_tt.store(pos.key(), cached.pv.at(ply), scoreToTT(score, ply), VALUE_NONE, cached.depth - ply, BOUND_EXACT);
+            pos.doMove(cached.pv.at(ply));
+        }
+        m_reportCachedLine(cached);
+    }
+
+    for (auto worker : m_workers)
+        worker->prepare(root);
+    for (auto helper : m_helpers)
+        helper->start();
+
+    m_workers.first()->iterativeDeepening();
+
+    // an infinite or ponder search keeps the result until it is stopped explicitly
+    m_waitMutex.lock();
+    while ((m_limits.infinite || isPondering()) && !isStopped())
+        m_waitCondition.wait(&m_waitMutex);
+    m_waitMutex.unlock();
+
+    m_stop.storeRelease(1);
+    for (auto helper : m_helpers)
+        helper->wait();
+
+    SearchWorker *best = m_bestWorker();
+    result.depth = best->completedDepth();
+    result.score = best->bestScore();
+    result.nodes = qint64(nodesSearched());
+    result.time  = m_timer.elapsed();
+    if (best->bestPv().size() > 0) result.bestMove   = best->bestPv().at(0);
+    if (best->bestPv().size() > 1) result.ponderMove = best->bestPv().at(1);
+
+    if (m_options.useAnalysisCache && result.depth > 0 && !best->bestPv().isEmpty())
+        AnalysisCache::storeLine(root, result.score, result.depth, best->bestPv());
+    // stopped before the depth of the cache: the cached line is the better answer
+    if (isCached && cached.depth > result.depth) {
+        result.bestMove   = cached.pv.at(0);
+        result.ponderMove = cached.pv.size() > 1 ? cached.pv.at(1) : NO_MOVE;
+        result.score      = cached.score;
+        result.depth      = cached.depth;
+    }
+
+    // not even the first iteration is complete: any legal move is better than none
+    if (result.bestMove == NO_MOVE && !rootMoves.isEmpty())
+        result.bestMove = rootMoves.move(0);
+
+    return result;
+}
+
+void Search::stop()
+{
+    m_stop.storeRelease(1);
+    m_wakeUp();
+}
+
+void Search::ponderHit()
+{
+    // the time of the hit is taken by the searching thread in m_checkLimits(), the timer is its own
+    // paired with m_iterationDone(): either this call sees the request to stop
+    // or the main worker sees that pondering is over and stops by itself
+    m_pondering.fetchAndStoreOrdered(0);
+    if (m_stopOnPonderHit.loadAcquire())
+        stop();
+    else
+        m_wakeUp(); // a depth limited search may be waiting for the end of pondering
+}
+
+quint64 Search::nodesSearched() const
+{
+    quint64 nodes = 0;
+    for (auto worker : m_workers)
+        nodes += worker->nodes();
+    return nodes;
+}
+
+quint64 Search::tbHits() const
+{
+    quint64 hits = 0;
+    for (auto worker : m_workers)
+        hits += worker->tbHits();
+    return hits;
+}
+
+quint64 Search::pawnHashProbes() const
+{
+    quint64 probes = 0;
+    for (auto worker : m_workers)
+        probes += worker->pawnTable().probes();
+    return probes;
+}
+
+quint64 Search::pawnHashHits() const
+{
+    quint64 hits = 0;
+    for (auto worker : m_workers)
+        hits += worker->pawnTable().hits();
+    return hits;
+}
+
+void Search::m_checkLimits()
+{
+    if (m_limits.infinite || isPondering())
+        return;
+
+    if (m_ponderHitTime < 0)
+        m_ponderHitTime = m_timer.elapsed();
+    const qint64 elapsed = m_timer.elapsed() - m_ponderHitTime;
+    if (m_limits.moveTime && elapsed >= m_limits.moveTime)
+        stop();
+    if (m_limits.nodes && nodesSearched() >= quint64(m_limits.nodes))
+        stop();
+    if (m_timeManager.isEnabled() && elapsed >= m_timeManager.hardLimit())
+        stop();
+}
+
+bool Search::m_iterationDone(int depth, Move bestMove, int score, double bestMoveEffort)
+{
+    // the time spent pondering counts for the soft limit: the longer the
+    // search has been running the sooner the move is played after a ponder hit
+    if (!m_timeManager.iterationDone(m_timer.elapsed(), depth, bestMove, score, bestMoveEffort))
+        return false;
+
+    if (isPondering()) {
+        m_stopOnPonderHit.fetchAndStoreOrdered(1);
+        if (isPondering())
+            return false; // keep searching deeper until the opponent moves
+    }
+    stop();
+    return true;
+}
+
+void Search::m_reportIteration(const SearchWorker &worker)
+{
+    if (!m_infoCallback)
+        return;
+
+    SearchInfo info;
+    info.depth    = worker.completedDepth();
+    info.selDepth = worker.selDepth();
+    info.nodes    = qint64(nodesSearched());
+    info.tbHits   = qint64(tbHits());
+    info.time     = m_timer.elapsed();
+    info.hashfull = m_tt.hashfull();
+    for (auto i = 0; i < worker.lines().size(); i++) {
+        // the cached line stays the first one until the search goes deeper
+        if (i == 0 && info.depth <= m_cachedDepth)
+            continue;
+        info.multiPv = i + 1;
+        info.score   = worker.lines().at(i).score;
+        info.pv      = worker.lines().at(i).pv;
+        m_infoCallback(info);
+    }
+}
+
+void Search::m_reportCachedLine(const CachedLine &line)
+{
+    if (!m_infoCallback)
+        return;
+
+    SearchInfo info;
+    info.multiPv  = 1;
+    info.depth    = line.depth;
+    info.selDepth = line.pv.size();
+    info.score    = line.score;
+    info.nodes    = 0;
+    info.tbHits   = 0;
+    info.time     = 0;
+    info.hashfull = m_tt.hashfull();
+    info.pv       = line.pv;
+    m_infoCallback(info);
+}
+
+SearchWorker *Search::m_bestWorker() const
+{
+    // the deepest completed iteration wins, a higher score breaks ties
+    SearchWorker *best = m_workers.first();
+    for (auto worker : m_workers) {
+        if (worker->bestPv().isEmpty())
+            continue;
+        if (worker->completedDepth() > best->completedDepth() ||
+            (worker->completedDepth() == best->completedDepth() && worker->bestScore() > best->bestScore()))
+            best = worker;
+    }
+    return best;
+}
+
+
+void Search::m_wakeUp()
+{
+    // locking makes sure go() is either waiting or hasn't checked the flags yet
+    QMutexLocker locker(&m_waitMutex);
+    m_waitCondition.wakeAll();
+}
+
+}
@@ -0,0 +1,295 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_SEARCH_H
+#define ENGINE_SEARCH_H
+
+#include <QThread>
+#include <QVector>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+
+#include <functional>
+
+#include "position.h"
+#include "transposition.h"
+#include "movepicker.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "analysiscache.h"
+#include "timemanager.h"
+
+//==============================================================
+//                      Search
+//==============================================================
+
+namespace engine
+{
+
+//    SearchLimits tells when the search has to stop,
+//    zero values mean there is no such limit
+struct SearchLimits {
+    SearchLimits() : depth(MAX_PLY - 1), nodes(0), moveTime(0), movesToGo(0), multiPv(1), infinite(false), ponder(false)
+    {
+        time[WHITE] = time[BLACK] = 0;
+        increment[WHITE] = increment[BLACK] = 0;
+    }
+
+    int    depth;
+    qint64 nodes;
+    qint64 moveTime;     // milliseconds
+    // clock of a timed game in milliseconds by eColor, see GameConfig::timeLeft and increment
+    qint64 time[2];
+    qint64 increment[2];
+    int    movesToGo;    // moves until the next time control, 0 for the whole game
+    // multiPv: number of the best root moves searched with exact scores, each of them
+    //      is reported as a separate line. Analysis only, play uses a single line
+    int    multiPv;
+    bool   infinite;     // search until Search::stop() even if the depth has been reached
+    // ponder: searching the expected opponent move on the opponent's time, the time limits
+    //      apply from Search::ponderHit() and the search goes on until then like an infinite one
+    bool   ponder;
+};
+
+//    SearchOptions switch search features on and off at runtime,
+//    benchmarks compare the node counts with and without a feature
+struct SearchOptions {
+    SearchOptions() : moveOrdering(true), useNnue(true), useTablebases(true),
+                      nullMove(true), lateMoveReductions(true), futilityPruning(true), pawnHash(true),
+                      useAnalysisCache(false) {}
+
+    bool moveOrdering;  // MVV-LVA for captures, killers and history for quiet moves
+    bool useNnue;       // neural network evaluation, if a network is loaded
+    bool useTablebases; // Syzygy at the root, Syzygy and DTM tables in the tree, if tables are found
+    bool nullMove;      // null move pruning, not with pawns alone (zugzwang)
+    bool lateMoveReductions; // quiet moves late in the ordering are searched shallower first
+    bool futilityPruning;    // razoring, reverse futility and futility pruning near the horizon
+    bool pawnHash;      // pawn structure of the classical evaluation is cached by the pawn key
+    // useAnalysisCache: results of earlier sessions are read and written, if a cache is open.
+    //      Analysis only, a line taken from the cache is reported without nodes or time
+    bool useAnalysisCache;
+};
+
+//    SearchInfo is reported after every completed iteration,
+//    once for every line of a multi-PV search, the best line first
+struct SearchInfo {
+    int           multiPv; // line number starting from 1
+    int           depth;
+    int           selDepth;
+    int           score;
+    qint64        nodes;
+    qint64        tbHits;
+    qint64        time; // milliseconds
+    int           hashfull;
+    QVector<Move> pv;
+};
+
+struct SearchResult {
+    SearchResult() : bestMove(NO_MOVE), ponderMove(NO_MOVE), score(VALUE_NONE), depth(0), nodes(0), time(0) {}
+
+    Move   bestMove;
+    Move   ponderMove; // expected reply, the second move of the principal variation
+    int    score;
+    int    depth;
+    qint64 nodes;
+    qint64 time;
+};
+
+//    PvLine is one of the best root moves with its principal variation
+struct PvLine {
+    int           score;
+    QVector<Move> pv;
+};
+
+class Search;
+
+//    SearchWorker owns everything a single search thread needs:
+//    a copy of the root position, node counter and principal variation.
+//    Workers share the transposition table only (Lazy SMP).
+class SearchWorker {
+public:
+    SearchWorker(Search *owner, int id);
+
+    // prepare: copies the root position before the search starts
+    void    prepare(const Position &root);
+    // iterativeDeepening: searches with increasing depth until the limits are reached
+    void    iterativeDeepening();
+    // clearHistory: forgets move ordering statistics and pawn structures of the previous games
+    void    clearHistory();
+
+    int     id() const { return m_id; }
+    bool    isMain() const { return m_id == 0; }
+    quint64 nodes() const { return m_nodes.load(); }
+    quint64 tbHits() const { return m_tbHits.load(); }
+    // pawnTable: probes and hits of the last search, read them when it's over
+    const PawnTable &pawnTable() const { return m_pawnTable; }
+    int     selDepth() const { return m_selDepth; }
+    int     completedDepth() const { return m_completedDepth; }
+    int     bestScore() const { return m_bestScore; }
+    const QVector<Move> &bestPv() const { return m_bestPv; }
+    // lines: the lines of the last completed iteration sorted by score
+    const QVector<PvLine> &lines() const { return m_lines; }
+
+private:
+    // m_searchLine: searches the root with an aspiration window around the score
+    //      of the previous iteration skipping the root moves of the better lines
+    int     m_searchLine(int depth, int previousScore, quint64 &lineNodes);
+    int     m_search(int alpha, int beta, int depth, int ply);
+    // m_qsearch: resolves captures at the leaves so the static evaluation
+    //      is never taken in the middle of an exchange
+    int     m_qsearch(int alpha, int beta, int ply);
+    // m_isRootMove: legal root moves are searched but the ones of the better
+    //      multi-PV lines and the ones losing the tablebase result
+    bool    m_isRootMove(Move move) const;
+    // m_skipDepth: helper threads skip some iterations so the threads
+    //      don't all search the same depth at the same time
+    bool    m_skipDepth(int depth) const;
+    // m_doMove: makes the move and updates the network accumulator of the next ply
+    void    m_doMove(Move move, int ply);
+    void    m_doNullMove(int ply);
+    int     m_evaluate(int ply);
+    void    m_countNode();
+    void    m_updatePv(int ply, Move move);
+    // m_updateQuietStats: a quiet move caused a cutoff, it becomes a killer and
+    //      gets a history bonus while the quiet moves tried before get a malus
+    void    m_updateQuietStats(int ply, int depth, Move move, const Move *quietsTried, int quietCount);
+
+    Search  *m_owner;
+    int      m_id;
+    Position m_pos;
+
+    QAtomicInteger<quint64> m_nodes; // written by the own thread only
+    QAtomicInteger<quint64> m_tbHits;
+    int            m_selDepth;
+    quint64        m_rootBestMoveNodes; // nodes spent on the best root move in the last iteration
+    int            m_completedDepth;
+    int            m_bestScore;
+    QVector<Move>  m_bestPv;
+    QVector<PvLine> m_lines;
+    int            m_multiPv;       // lines to search, no more than the legal root moves
+    int            m_pvIndex;       // line being searched
+    Move           m_excludedRootMoves[MAX_MOVES]; // first moves of the lines found in this iteration
+
+    bool           m_useNnue;
+    Nnue::Accumulator m_accumulators[MAX_PLY + 1];
+    bool           m_usePawnHash;
+    PawnTable      m_pawnTable;
+
+    HistoryTable   m_history;
+    Move           m_killers[MAX_PLY + 1][2];
+
+    // triangular principal variation table
+    Move     m_pv[MAX_PLY + 1][MAX_PLY + 1];
+    int      m_pvLength[MAX_PLY + 1];
+};
+
+//    HelperThread runs a helper SearchWorker, the main worker
+//    runs in the thread which has called Search::go()
+class HelperThread : public QThread {
+public:
+    explicit HelperThread(SearchWorker *worker) : m_worker(worker) {}
+
+protected:
+    void run() { m_worker->iterativeDeepening(); }
+
+private:
+    SearchWorker *m_worker;
+};
+
+//    Search runs the main worker along with N - 1 helpers over
+//    the shared lock-free transposition table
+class Search {
+public:
+    Search();
+    ~Search();
+
+    // setThreads: number of threads including the calling one
+    void    setThreads(int count);
+    int     threads() const { return m_workers.size(); }
+    void    setHashSize(int megabytes);
+    void    setOptions(const SearchOptions &options) { m_options = options; }
+    const SearchOptions &options() const { return m_options; }
+    // newGame: forgets everything learnt in previous searches
+    void    newGame();
+
+    // setInfoCallback: the callback is called from the searching thread
+    void    setInfoCallback(const std::function<void(const SearchInfo&)> &callback);
+
+    // go: blocks until the search is done
+    SearchResult go(const Position &root, const SearchLimits &limits);
+    // stop: may be called from any thread, every worker polls the flag on each node
+    //      so the search is over well within a millisecond
+    void    stop();
+    bool    isStopped() const { return m_stop.load() != 0; }
+    // ponderHit: the opponent has played the expected move, the ponder search
+    //      becomes the normal one and keeps everything it has found so far.
+    //      On a miss the ponder search is simply stopped. May be called from any thread
+    void    ponderHit();
+    bool    isPondering() const { return m_pondering.load() != 0; }
+
+    quint64 nodesSearched() const;
+    quint64 tbHits() const;
+    // pawnHashProbes / pawnHashHits: pawn tables of all the workers after the last search
+    quint64 pawnHashProbes() const;
+    quint64 pawnHashHits() const;
+    TranspositionTable &transpositionTable() { return m_tt; }
+
+private:
+    Q_DISABLE_COPY(Search)
+    friend class SearchWorker;
+
+    // m_checkLimits: polled by the main worker, raises the stop flag on time or nodes limit
+    void    m_checkLimits();
+    // m_iterationDone: the main worker asks the time manager whether to go on
+    bool    m_iterationDone(int depth, Move bestMove, int score, double bestMoveEffort);
+    void    m_reportIteration(const SearchWorker &worker);
+    // m_reportCachedLine: the line of the analysis cache before the search starts
+    void    m_reportCachedLine(const CachedLine &line);
+    SearchWorker *m_bestWorker() const;
+    // m_wakeUp: an infinite or ponder search waits in go() for stop() or ponderHit()
+    void    m_wakeUp();
+
+    QVector<SearchWorker*>  m_workers;
+    QVector<HelperThread*>  m_helpers;
+
+    TranspositionTable m_tt;
+    SearchOptions      m_options;
+    SearchLimits       m_limits;
+    MoveList           m_tbRootMoves; // root moves keeping the tablebase result, empty if not probed
+    int                m_cachedDepth; // of the root line found in the analysis cache, 0 if none
+    TimeManager        m_timeManager;
+    QElapsedTimer      m_timer;
+    QAtomicInt         m_stop;
+    QAtomicInt         m_pondering;
+    QAtomicInt         m_stopOnPonderHit; // the time is over, the search stops as soon as pondering ends
+    qint64             m_ponderHitTime; // milliseconds since the start, hard time limits count from it,
+                                        // -1 until the searching thread sees the end of pondering
+    QMutex             m_waitMutex;
+    QWaitCondition     m_waitCondition;
+
+    std::function<void(const SearchInfo&)> m_infoCallback;
+};
+
+}
+
+#endif//ENGINE_SEARCH_H
@@ -0,0 +1,104 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "see.h"
+#include "evaluation.h"
+
+namespace engine
+{
+
+int see(const Position &pos, Move move)
+{
+    if (isCastlingMove(move))
+        return 0;
+
+    const int from = moveFrom(move);
+    const int to = moveTo(move);
+    const int promotionBonus = QUEEN_VALUE - PAWN_VALUE;
+
+    // gain[d] is the balance for the side making the capture d if the exchange stops after it
+    int gain[32];
+    int d = 0;
+
+    Bitboard occupied = pos.pieces() ^ squareBB(from);
+    if (isEnPassantMove(move)) {
+        occupied ^= squareBB(makeSquare(fileOf(to), rankOf(from)));
+        gain[0] = PAWN_VALUE;
+    } else {
+        gain[0] = pos.isEmpty(to) ? 0 : pieceValue[typeOf(pos.pieceOn(to))];
+    }
+
+    // value of the piece standing on the target square, to be captured next
+    int onSquare = pieceValue[typeOf(pos.movedPiece(move))];
+    if (isPromotionMove(move)) {
+        gain[0] += pieceValue[promotionType(move)] - PAWN_VALUE;
+        onSquare = pieceValue[promotionType(move)];
+    }
+
+    const Bitboard bishops = pos.pieces(BISHOP, QUEEN);
+    const Bitboard rooks = pos.pieces(ROOK, QUEEN);
+    const bool isPromotionRank = (squareBB(to) & (RANK_1_BB | RANK_8_BB)) != 0;
+
+    Bitboard attackers = pos.attackersTo(to, occupied) & occupied;
+    eColor side = opposite(colorOf(pos.movedPiece(move)));
+
+    while (d < 31) {
+        const Bitboard ourAttackers = attackers & pos.pieces(side);
+        if (!ourAttackers)
+            break;
+
+        int type = PAWN;
+        while (!(ourAttackers & pos.pieces(ePieceType(type))))
+            type++;
+
+        // the king may only capture the last defender
+        if (type == KING && (attackers & pos.pieces(opposite(side))))
+            break;
+
+        d++;
+        gain[d] = onSquare - gain[d - 1];
+        onSquare = pieceValue[type];
+        if (type == PAWN && isPromotionRank) {
+            gain[d] += promotionBonus;
+            onSquare = QUEEN_VALUE;
+        }
+
+        occupied ^= squareBB(lsb(ourAttackers & pos.pieces(ePieceType(type))));
+
+        // sliders behind the capturing piece join the exchange
+        if (type == PAWN || type == BISHOP || type == QUEEN)
+            attackers |= bishopAttacks(to, occupied) & bishops;
+        if (type == ROOK || type == QUEEN)
+            attackers |= rookAttacks(to, occupied) & rooks;
+        attackers &= occupied;
+
+        side = opposite(side);
+    }
+
+    // each side chooses between stopping and continuing the exchange
+    while (d > 0) {
+        gain[d - 1] = -qMax(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+}
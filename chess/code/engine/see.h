@@ -0,0 +1,50 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_SEE_H
+#define ENGINE_SEE_H
+
+#include "position.h"
+
+//==============================================================
+//                  Static exchange evaluation
+//==============================================================
+
+namespace engine
+{
+
+// see:
+//      Material balance in centipawns after the whole exchange on the target
+//      square of the move, both sides recapturing with the least valuable
+//      piece first and free to stop when it doesn't pay off.
+//      Quiet moves are scored as well: a negative value means the moved piece hangs.
+//      Pins are not taken into account.
+int     see(const Position &pos, Move move);
+
+// seeGE: true if the exchange wins at least `threshold` centipawns
+inline bool seeGE(const Position &pos, Move move, int threshold = 0)
+{
+    return see(pos, move) >= threshold;
+}
+
+}
+
+#endif//ENGINE_SEE_H
@@ -0,0 +1,1019 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "tablebase.h"
+#include "movegen.h"
+#include "material.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+#include <QtEndian>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cstring>
+
+//    The table format and its decoding follow the original Syzygy prober
+//    by Ronald de Man: positions are mapped to an index with the symmetries
+//    of the board removed, values are compressed by recursive pairing and
+//    canonical Huffman codes in blocks with a sparse index over them.
+
+namespace engine
+{
+
+namespace
+{
+
+enum {
+    TB_PIECES = 7,
+    MAX_DTZ   = 1 << 18 // root rank of a win converted before the fifty moves rule
+};
+
+enum eTableType { WDL_TABLE, DTZ_TABLE };
+
+//    eProbeState tells how the value of a probe has been found
+enum eProbeState {
+    PROBE_FAIL         =  0, // the table is missing or broken
+    PROBE_OK           =  1,
+    PROBE_CHANGE_STM   = -1, // DTZ table of the other side to move
+    PROBE_ZEROING_MOVE =  2  // the best move is a capture or a pawn move
+};
+
+// flags of PairsData
+enum {
+    FLAG_STM          = 1,   // DTZ: side to move the table is for
+    FLAG_MAPPED       = 2,   // DTZ: values go through the value map
+    FLAG_WIN_PLIES    = 4,   // DTZ: wins are in plies, not in moves
+    FLAG_LOSS_PLIES   = 8,   // DTZ: losses are in plies, not in moves
+    FLAG_WIDE         = 16,  // DTZ: 16-bit value map
+    FLAG_SINGLE_VALUE = 128  // every position has the same value
+};
+
+const uchar tableMagic[2][4] = {
+    { 0x71, 0xE8, 0x23, 0x5D }, // WDL_TABLE
+    { 0xD7, 0x66, 0x0C, 0xA5 }  // DTZ_TABLE
+};
+const char *const tableSuffix[2] = { ".rtbw", ".rtbz" };
+
+// tbPiece: piece code of the tables, ePieceType + 1 with bit 3 set for BLACK
+inline int tbPiece(int piece) { return typeOf(piece) + 1 + (colorOf(piece) == BLACK ? 8 : 0); }
+
+inline int offA1H8(int square) { return rankOf(square) - fileOf(square); }
+inline int flipFile(int square) { return square ^ 7; }
+inline int flipRank(int square) { return square ^ 56; }
+
+// SparseEntry: block holding every `span`-th value and the value offset in it, little endian
+struct SparseEntry {
+    uchar block[4];
+    uchar offset[2];
+};
+
+// LR: the two 12-bit symbols a symbol of the recursive pairing stands for,
+//      a leaf keeps its value in left() and 0xFFF in right()
+struct LR {
+    uchar lr[3];
+
+    int left()  const { return ((lr[1] & 0xF) << 8) | lr[0]; }
+    int right() const { return (lr[2] << 4) | (lr[1] >> 4); }
+};
+
+//    PairsData holds the compressed values for one side to move
+//    and one file of the leading pawn
+struct PairsData {
+    PairsData() : flags(0), sizeofBlock(0), span(0), blocksNum(0), maxSymLen(0), minSymLen(0),
+                  lowestSym(nullptr), btree(nullptr), blockLength(nullptr), blockLengthSize(0),
+                  sparseIndex(nullptr), sparseIndexSize(0), data(nullptr)
+    {
+        std::memset(pieces, 0, sizeof(pieces));
+        std::memset(groupIdx, 0, sizeof(groupIdx));
+        std::memset(groupLen, 0, sizeof(groupLen));
+        std::memset(mapIdx, 0, sizeof(mapIdx));
+    }
+
+    int                flags;
+    quint64            sizeofBlock;     // bytes in a block
+    quint64            span;            // values between two entries of the sparse index
+    quint64            blocksNum;
+    int                maxSymLen;
+    int                minSymLen;       // the value itself with FLAG_SINGLE_VALUE
+    const uchar       *lowestSym;       // quint16 little endian by symbol length
+    const LR          *btree;
+    const uchar       *blockLength;     // quint16 little endian, values in the block - 1
+    quint64            blockLengthSize;
+    const SparseEntry *sparseIndex;
+    quint64            sparseIndexSize;
+    const uchar       *data;            // blocks of the Huffman codes
+    QVector<quint64>   base64;          // lowest code of every length, left aligned to 64 bits
+    QVector<quint8>    symlen;          // values a symbol stands for - 1
+    int                pieces[TB_PIECES];       // table piece codes in the encoding order
+    quint64            groupIdx[TB_PIECES + 1]; // index multiplier of every group
+    int                groupLen[TB_PIECES + 1]; // pieces in every group, zero terminated
+    quint16            mapIdx[4];       // DTZ value map offsets by WDL
+};
+
+//    Table is one tablebase file, registered with both material keys:
+//    the stronger side of the name (KRv of KRvK) as WHITE and as BLACK
+struct Table {
+    Table() : type(WDL_TABLE), key(0), key2(0), pieceCount(0), hasPawns(false), hasUniquePieces(false),
+              isReady(0), map(nullptr)
+    {
+        pawnCount[0] = pawnCount[1] = 0;
+    }
+
+    // get: values of the side to move, DTZ tables hold one side only
+    PairsData *get(int stm, int file) { return &items[type == WDL_TABLE ? stm % 2 : 0][hasPawns ? file : 0]; }
+
+    eTableType   type;
+    QString      name;       // KRvK
+    QString      filePath;
+    quint32      key;
+    quint32      key2;
+    int          pieceCount;
+    bool         hasPawns;
+    bool         hasUniquePieces; // a piece other than the king is alone of its kind
+    int          pawnCount[2];    // pawns of the leading color first
+    QAtomicInt   isReady;         // mapped or failed to map, set once
+    QFile        file;
+    const uchar *map;             // DTZ value map
+    PairsData    items[2][4];     // by side to move and by file of the leading pawn
+};
+
+QVector<Table*>         tables;
+QHash<quint32, Table*>  wdlTables;
+QHash<quint32, Table*>  dtzTables;
+int                     maxPieceCount = 0;
+QMutex                  mappingMutex;
+
+// Encoding tables, see initEncoding()
+int     mapA1D1D4[64];
+int     mapB1H1H7[64];
+int     mapKK[10][64];
+int     mapPawns[64];
+quint64 binomial[6][64];
+quint64 leadPawnIdx[6][64];
+quint64 leadPawnsSize[6][4];
+bool    isEncodingReady = false;
+
+quint32 materialKey(const Position &pos)
+{
+    int counts[2][6];
+    for (auto color = 0; color < 2; color++)
+        for (auto type = 0; type < 6; type++)
+            counts[color][type] = popCount(pos.pieces(eColor(color), ePieceType(type)));
+    return Material::key(counts, false);
+}
+
+// initEncoding: tables mapping the squares of the pieces to the table index
+void initEncoding()
+{
+    if (isEncodingReady)
+        return;
+    Bitboards::init();
+
+    std::memset(mapA1D1D4, 0, sizeof(mapA1D1D4));
+    std::memset(mapB1H1H7, 0, sizeof(mapB1H1H7));
+    std::memset(mapKK, 0, sizeof(mapKK));
+    std::memset(mapPawns, 0, sizeof(mapPawns));
+    std::memset(binomial, 0, sizeof(binomial));
+    std::memset(leadPawnIdx, 0, sizeof(leadPawnIdx));
+    std::memset(leadPawnsSize, 0, sizeof(leadPawnsSize));
+
+    // squares below the a1-h8 diagonal to 0..27
+    int code = 0;
+    for (auto square = 0; square < 64; square++)
+        if (offA1H8(square) < 0)
+            mapB1H1H7[square] = code++;
+
+    // squares of the a1-d1-d4 triangle to 0..9, the diagonal ones last
+    QVector<int> diagonal;
+    code = 0;
+    for (auto square = int(A1); square <= int(D4); square++) {
+        if (offA1H8(square) < 0 && fileOf(square) <= 3)
+            mapA1D1D4[square] = code++;
+        else if (offA1H8(square) == 0 && fileOf(square) <= 3)
+            diagonal.append(square);
+    }
+    for (auto square : diagonal)
+        mapA1D1D4[square] = code++;
+
+    // the 462 legal placements of two kings with the first one in the a1-d1-d4
+    // triangle; with the first king on the diagonal the second one isn't above it
+    QVector<QPair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (auto idx = 0; idx < 10; idx++) {
+        for (auto s1 = int(A1); s1 <= int(D4); s1++) {
+            if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != B1)) // b1 is mapped to 0
+                continue;
+            for (auto s2 = 0; s2 < 64; s2++) {
+                if ((Bitboards::kingAttacks[s1] | squareBB(s1)) & squareBB(s2))
+                    continue; // kings next to each other
+                else if (offA1H8(s1) == 0 && offA1H8(s2) > 0)
+                    continue; // the first king on the diagonal, the second one above
+                else if (offA1H8(s1) == 0 && offA1H8(s2) == 0)
+                    bothOnDiagonal.append(qMakePair(idx, s2));
+                else
+                    mapKK[idx][s2] = code++;
+            }
+        }
+    }
+    for (const auto &kings : bothOnDiagonal)
+        mapKK[kings.first][kings.second] = code++;
+
+    // binomial[k][n]: ways to choose k squares out of n
+    binomial[0][0] = 1;
+    for (auto n = 1; n < 64; n++)
+        for (auto k = 0; k < 6 && k <= n; k++)
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+
+    // mapPawns: squares a2-h7 to 0..47, the pawn with the highest value is the leading
+    // one, the nearest to the edge and of those the one with the lowest rank.
+    // leadPawnIdx and leadPawnsSize: indices of the leading pawns group, restarted
+    // at every file as the tables are split by the file of the leading pawn
+    int availableSquares = 47;
+    for (auto leadPawnsCount = 1; leadPawnsCount <= 5; leadPawnsCount++) {
+        for (auto file = 0; file < 4; file++) {
+            quint64 idx = 0;
+            for (auto rank = 1; rank <= 6; rank++) {
+                const int square = makeSquare(file, rank);
+                if (leadPawnsCount == 1) {
+                    mapPawns[square] = availableSquares--;
+                    mapPawns[flipFile(square)] = availableSquares--;
+                }
+                leadPawnIdx[leadPawnsCount][square] = idx;
+                idx += binomial[leadPawnsCount - 1][mapPawns[square]];
+            }
+            leadPawnsSize[leadPawnsCount][file] = idx;
+        }
+    }
+
+    isEncodingReady = true;
+}
+
+//==============================================================
+//                      Table layout
+//==============================================================
+
+// setSymlen: values the symbol stands for - 1, computed from the pairs it expands to
+int setSymlen(PairsData *d, int sym, QVector<bool> &visited)
+{
+    visited[sym] = true; // the pairing tree has no cycles
+    const int right = d->btree[sym].right();
+    if (right == 0xFFF)
+        return 0;
+    const int left = d->btree[sym].left();
+    if (!visited[left])
+        d->symlen[left] = quint8(setSymlen(d, left, visited));
+    if (!visited[right])
+        d->symlen[right] = quint8(setSymlen(d, right, visited));
+    return d->symlen[left] + d->symlen[right] + 1;
+}
+
+// setSizes: reads the header of the compressed values, returns the data after it
+const uchar *setSizes(PairsData *d, const uchar *data)
+{
+    d->flags = *data++;
+    if (d->flags & FLAG_SINGLE_VALUE) {
+        d->blocksNum = d->blockLengthSize = 0;
+        d->span = d->sparseIndexSize = 0;
+        d->minSymLen = *data++; // the single value
+        return data;
+    }
+
+    // the last group index is the number of positions in the table
+    const int groups = int(std::find(d->groupLen, d->groupLen + TB_PIECES, 0) - d->groupLen);
+    const quint64 tbSize = d->groupIdx[groups];
+
+    d->sizeofBlock = 1ULL << *data++;
+    d->span = 1ULL << *data++;
+    d->sparseIndexSize = (tbSize + d->span - 1) / d->span;
+    const int padding = *data++;
+    d->blocksNum = qFromLittleEndian<quint32>(data);
+    data += sizeof(quint32);
+    // padded so the sparse index never points beyond the block lengths
+    d->blockLengthSize = d->blocksNum + padding;
+    d->maxSymLen = *data++;
+    d->minSymLen = *data++;
+    d->lowestSym = data;
+    d->base64.fill(0, d->maxSymLen - d->minSymLen + 1);
+
+    // Canonical Huffman codes: longer codes have lower values, base64[i] is the
+    // lowest code of length minSymLen + i left aligned to 64 bits, so a code
+    // of that length c64 is base64[i - 1] > c64 >= base64[i]
+    for (auto i = d->base64.size() - 2; i >= 0; i--) {
+        d->base64[i] = (d->base64[i + 1] + qFromLittleEndian<quint16>(d->lowestSym + 2 * i)
+                                         - qFromLittleEndian<quint16>(d->lowestSym + 2 * (i + 1))) / 2;
+    }
+    for (auto i = 0; i < d->base64.size(); i++)
+        d->base64[i] <<= 64 - i - d->minSymLen;
+
+    data += d->base64.size() * sizeof(quint16);
+    d->symlen.fill(0, qFromLittleEndian<quint16>(data));
+    data += sizeof(quint16);
+    d->btree = reinterpret_cast<const LR*>(data);
+
+    // recursive pairing replaces the most frequent pair of adjacent symbols
+    // with a new symbol again and again, symlen is the length of the expansion
+    QVector<bool> visited(d->symlen.size(), false);
+    for (auto sym = 0; sym < d->symlen.size(); sym++)
+        if (!visited[sym])
+            d->symlen[sym] = quint8(setSymlen(d, sym, visited));
+
+    return data + d->symlen.size() * sizeof(LR) + (d->symlen.size() & 1);
+}
+
+// setDtzMap: value maps of the DTZ table, 8 or 16 bits per value
+const uchar *setDtzMap(Table *table, const uchar *data, int maxFile)
+{
+    table->map = data;
+    for (auto file = 0; file <= maxFile; file++) {
+        PairsData *d = table->get(0, file);
+        if (!(d->flags & FLAG_MAPPED))
+            continue;
+        if (d->flags & FLAG_WIDE) {
+            data += quintptr(data) & 1; // word alignment, the maps may be mixed
+            for (auto i = 0; i < 4; i++) {
+                d->mapIdx[i] = quint16((data - table->map) / 2 + 1);
+                data += 2 * qFromLittleEndian<quint16>(data) + 2;
+            }
+        } else {
+            for (auto i = 0; i < 4; i++) {
+                d->mapIdx[i] = quint16(data - table->map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + (quintptr(data) & 1);
+}
+
+// setGroups: groups of the pieces encoded together and their index multipliers
+void setGroups(Table *table, PairsData *d, const int order[2], int file)
+{
+    // KRvKN is (3, 1): three unique pieces are encoded together, otherwise the kings
+    int n = 0;
+    int firstLen = table->hasPawns ? 0 : table->hasUniquePieces ? 3 : 2;
+    d->groupLen[n] = 1;
+    for (auto i = 1; i < table->pieceCount; i++) {
+        if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1])
+            d->groupLen[n]++;
+        else
+            d->groupLen[++n] = 1;
+    }
+    d->groupLen[++n] = 0;
+
+    // The position index is g1 * N(g2) * N(g3) + g2 * N(g3) + g3 where N(g) is
+    // the number of placements of the group, the order of the groups is stored
+    // in the table: the leading group at order[0], the other pawns at order[1]
+    const bool pp = table->hasPawns && table->pawnCount[1]; // pawns of both colors
+    int next = pp ? 2 : 1;
+    int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+    quint64 idx = 1;
+
+    for (auto k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if (k == order[0]) {
+            d->groupIdx[0] = idx;
+            idx *= table->hasPawns ? leadPawnsSize[d->groupLen[0]][file] :
+                   table->hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d->groupIdx[1] = idx;
+            idx *= binomial[d->groupLen[1]][48 - d->groupLen[0]];
+        } else {
+            d->groupIdx[next] = idx;
+            idx *= binomial[d->groupLen[next]][freeSquares];
+            freeSquares -= d->groupLen[next++];
+        }
+    }
+    d->groupIdx[n] = idx;
+}
+
+// setup: reads the layout of the mapped table, `data` follows the magic
+void setup(Table *table, const uchar *data)
+{
+    data++; // flags: split sides and pawns, known from the name
+
+    const int sides = table->type == WDL_TABLE && table->key != table->key2 ? 2 : 1;
+    const int maxFile = table->hasPawns ? 3 : 0;
+    const bool pp = table->hasPawns && table->pawnCount[1];
+
+    for (auto file = 0; file <= maxFile; file++) {
+        for (auto i = 0; i < sides; i++)
+            *table->get(i, file) = PairsData();
+
+        const int order[2][2] = {
+            { *data & 0xF, pp ? *(data + 1) & 0xF : 0xF },
+            { *data >> 4,  pp ? *(data + 1) >> 4  : 0xF }
+        };
+        data += 1 + (pp ? 1 : 0);
+
+        for (auto k = 0; k < table->pieceCount; k++, data++)
+            for (auto i = 0; i < sides; i++)
+                table->get(i, file)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+
+        for (auto i = 0; i < sides; i++)
+            setGroups(table, table->get(i, file), order[i], file);
+    }
+
+    data += quintptr(data) & 1; // word alignment
+
+    for (auto file = 0; file <= maxFile; file++)
+        for (auto i = 0; i < sides; i++)
+            data = setSizes(table->get(i, file), data);
+
+    if (table->type == DTZ_TABLE)
+        data = setDtzMap(table, data, maxFile);
+
+    for (auto file = 0; file <= maxFile; file++) {
+        for (auto i = 0; i < sides; i++) {
+            PairsData *d = table->get(i, file);
+            d->sparseIndex = reinterpret_cast<const SparseEntry*>(data);
+            data += d->sparseIndexSize * sizeof(SparseEntry);
+        }
+    }
+    for (auto file = 0; file <= maxFile; file++) {
+        for (auto i = 0; i < sides; i++) {
+            PairsData *d = table->get(i, file);
+            d->blockLength = data;
+            data += d->blockLengthSize * sizeof(quint16);
+        }
+    }
+    for (auto file = 0; file <= maxFile; file++) {
+        for (auto i = 0; i < sides; i++) {
+            data = reinterpret_cast<const uchar*>((quintptr(data) + 0x3F) & ~quintptr(0x3F)); // 64-byte alignment
+            PairsData *d = table->get(i, file);
+            d->data = data;
+            data += d->blocksNum * d->sizeofBlock;
+        }
+    }
+}
+
+// mapTable: maps the file on the first probe of the table, false if it can't be used
+bool mapTable(Table *table)
+{
+    // acquire: the layout written by the thread which has mapped the table is visible
+    if (table->isReady.loadAcquire())
+        return table->file.isOpen();
+
+    QMutexLocker locker(&mappingMutex);
+    if (!table->isReady.load()) {
+        table->file.setFileName(table->filePath);
+        const uchar *data = nullptr;
+        // every table is 16 bytes longer than a multiple of 64
+        if (table->file.open(QIODevice::ReadOnly) && table->file.size() % 64 == 16)
+            data = table->file.map(0, table->file.size());
+        if (data != nullptr && std::memcmp(data, tableMagic[table->type], 4) == 0) {
+            setup(table, data + 4);
+        } else {
+            if (data != nullptr)
+                table->file.unmap(const_cast<uchar*>(data));
+            table->file.close();
+        }
+        table->isReady.storeRelease(1);
+    }
+    return table->file.isOpen();
+}
+
+//==============================================================
+//                      Decoding
+//==============================================================
+
+// decompressPairs: the value with the index `idx` of the compressed values
+int decompressPairs(const PairsData *d, quint64 idx)
+{
+    if (d->flags & FLAG_SINGLE_VALUE)
+        return d->minSymLen;
+
+    // Block n holds blockLength[n] + 1 values. The sparse index entry k points to
+    // the value k * span + span / 2 with its block and its offset in the block,
+    // the block of `idx` is found walking the block lengths from there
+    const quint32 k = quint32(idx / d->span);
+    quint32 block = qFromLittleEndian<quint32>(d->sparseIndex[k].block);
+    int offset = qFromLittleEndian<quint16>(d->sparseIndex[k].offset);
+    offset += int(idx % d->span) - int(d->span / 2);
+
+    while (offset < 0)
+        offset += qFromLittleEndian<quint16>(d->blockLength + 2 * --block) + 1;
+    while (offset > qFromLittleEndian<quint16>(d->blockLength + 2 * block))
+        offset -= qFromLittleEndian<quint16>(d->blockLength + 2 * block++) + 1;
+
+    // the block is a sequence of canonical Huffman codes, read 64 bits at a time
+    const uchar *ptr = d->data + quint64(block) * d->sizeofBlock;
+    quint64 buf64 = qFromBigEndian<quint64>(ptr);
+    ptr += sizeof(quint64);
+    int buf64Size = 64;
+    int sym;
+
+    while (true) {
+        // the length of the code at the top of the buffer, minus minSymLen
+        int len = 0;
+        while (buf64 < d->base64[len])
+            len++;
+        // codes of the same length are consecutive integers
+        sym = int((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+        sym += qFromLittleEndian<quint16>(d->lowestSym + 2 * len);
+
+        if (offset < d->symlen[sym] + 1)
+            break;
+        offset -= d->symlen[sym] + 1;
+
+        len += d->minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= quint64(qFromBigEndian<quint32>(ptr)) << (64 - buf64Size);
+            ptr += sizeof(quint32);
+        }
+    }
+
+    // the symbol stands for symlen[sym] + 1 values, walk down the pairs to the value
+    while (d->symlen[sym]) {
+        const int left = d->btree[sym].left();
+        if (offset < d->symlen[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d->symlen[left] + 1;
+            sym = d->btree[sym].right();
+        }
+    }
+    return d->btree[sym].left();
+}
+
+// mapScore: the table value as eWdl or as DTZ in plies
+int mapScore(Table *table, int file, int value, eWdl wdl)
+{
+    if (table->type == WDL_TABLE)
+        return value - 2;
+
+    static const int wdlMap[] = { 1, 3, 0, 2, 0 }; // value map of the WDL
+    const PairsData *d = table->get(0, file);
+    if (d->flags & FLAG_MAPPED) {
+        const int idx = d->mapIdx[wdlMap[wdl + 2]] + value;
+        value = d->flags & FLAG_WIDE ? qFromLittleEndian<quint16>(table->map + 2 * idx) : table->map[idx];
+    }
+
+    // DTZ is stored in moves where it can't make a difference, the result is in plies
+    if ((wdl == WDL_WIN  && !(d->flags & FLAG_WIN_PLIES)) ||
+        (wdl == WDL_LOSS && !(d->flags & FLAG_LOSS_PLIES)) ||
+        wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS)
+        value *= 2;
+
+    return value + 1;
+}
+
+// probeTable: the value of the position in the mapped table
+int probeTable(const Position &pos, Table *table, eWdl wdl, eProbeState *result)
+{
+    int squares[TB_PIECES];
+    int pieces[TB_PIECES];
+    int size = 0;
+    int leadPawnsCount = 0;
+    Bitboard leadPawns = 0;
+    int tbFile = 0;
+
+    // Tables are for WHITE as the stronger side and a table of equal sides holds
+    // WHITE to move only, otherwise the colors are swapped and the board is flipped
+    const bool symmetricBlackToMove = table->key == table->key2 && pos.sideToMove() == BLACK;
+    const bool blackStronger = materialKey(pos) != table->key;
+    const bool flip = symmetricBlackToMove || blackStronger;
+    const int flipColor   = flip ? 8 : 0;
+    const int flipSquares = flip ? 56 : 0;
+    const int stm = (flip ? 1 : 0) ^ int(pos.sideToMove());
+
+    // With pawns the tables are split by the file of the leading pawn, the one
+    // with the highest mapPawns: the nearest to the edge and the lowest rank
+    if (table->hasPawns) {
+        const int pawn = table->get(0, 0)->pieces[0] ^ flipColor;
+        Bitboard b = leadPawns = pos.pieces(pawn & 8 ? BLACK : WHITE, PAWN);
+        do
+            squares[size++] = popLsb(b) ^ flipSquares;
+        while (b);
+        leadPawnsCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount,
+                                                [](int a, int b) { return mapPawns[a] < mapPawns[b]; }));
+        tbFile = qMin(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    // a DTZ table holds one side to move only
+    if (table->type == DTZ_TABLE) {
+        const int flags = table->get(stm, tbFile)->flags;
+        if ((flags & FLAG_STM) != stm && !(table->key == table->key2 && !table->hasPawns)) {
+            *result = PROBE_CHANGE_STM;
+            return 0;
+        }
+    }
+
+    Bitboard b = pos.pieces() ^ leadPawns;
+    do {
+        const int square = popLsb(b);
+        squares[size] = square ^ flipSquares;
+        pieces[size++] = tbPiece(pos.pieceOn(square)) ^ flipColor;
+    } while (b);
+
+    PairsData *d = table->get(stm, tbFile);
+
+    // the pieces in the order of the table
+    for (auto i = leadPawnsCount; i < size - 1; i++) {
+        for (auto j = i + 1; j < size; j++) {
+            if (d->pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // the leading piece to the a-d files
+    if (fileOf(squares[0]) > 3)
+        for (auto i = 0; i < size; i++)
+            squares[i] = flipFile(squares[i]);
+
+    quint64 idx;
+    if (table->hasPawns) {
+        idx = leadPawnIdx[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount,
+                         [](int a, int b) { return mapPawns[a] < mapPawns[b]; });
+        for (auto i = 1; i < leadPawnsCount; i++)
+            idx += binomial[i][mapPawns[squares[i]]];
+    } else {
+        // without pawns the leading piece goes to the ranks 1-4 as well
+        if (rankOf(squares[0]) > 3)
+            for (auto i = 0; i < size; i++)
+                squares[i] = flipRank(squares[i]);
+
+        // and the first piece of the leading group off the a1-h8 diagonal below it
+        for (auto i = 0; i < d->groupLen[0]; i++) {
+            if (!offA1H8(squares[i]))
+                continue;
+            if (offA1H8(squares[i]) > 0)
+                for (auto j = i; j < size; j++)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+
+        if (table->hasUniquePieces) {
+            // three unique pieces (kings included) are encoded together, every
+            // next one skipping the squares taken by the ones before it
+            const int adjust1 = squares[1] > squares[0] ? 1 : 0;
+            const int adjust2 = (squares[2] > squares[0] ? 1 : 0) + (squares[2] > squares[1] ? 1 : 0);
+
+            if (offA1H8(squares[0]))
+                idx = (quint64(mapA1D1D4[squares[0]]) * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (offA1H8(squares[1]))
+                idx = (6 * 63 + quint64(rankOf(squares[0])) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (offA1H8(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62
+                    + quint64(rankOf(squares[0])) * 7 * 28
+                    + (rankOf(squares[1]) - adjust1) * 28
+                    + mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+                    + quint64(rankOf(squares[0])) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6
+                    + (rankOf(squares[2]) - adjust2);
+        } else {
+            idx = mapKK[mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // the other groups in ascending order of squares, skipping the squares
+    // taken by the groups before them
+    idx *= d->groupIdx[0];
+    int *groupSq = squares + d->groupLen[0];
+    bool remainingPawns = table->hasPawns && table->pawnCount[1];
+    int next = 0;
+    while (d->groupLen[++next]) {
+        std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+        quint64 n = 0;
+        for (auto i = 0; i < d->groupLen[next]; i++) {
+            const int square = groupSq[i];
+            const int adjust = int(std::count_if(squares, groupSq, [square](int s) { return square > s; }));
+            n += binomial[i + 1][square - adjust - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    return mapScore(table, tbFile, decompressPairs(d, idx), wdl);
+}
+
+int probeTable(const Position &pos, eTableType type, eProbeState *result, eWdl wdl = WDL_DRAW)
+{
+    if (popCount(pos.pieces()) == 2) // KvK
+        return 0;
+
+    Table *table = (type == WDL_TABLE ? wdlTables : dtzTables).value(materialKey(pos), nullptr);
+    if (table == nullptr || !mapTable(table)) {
+        *result = PROBE_FAIL;
+        return 0;
+    }
+    return probeTable(pos, table, wdl, result);
+}
+
+//==============================================================
+//                      Probing
+//==============================================================
+
+inline bool isZeroingMove(const Position &pos, Move move)
+{
+    return isCaptureMove(move) || typeOf(pos.movedPiece(move)) == PAWN;
+}
+
+// dtzBeforeZeroing: DTZ of the position where the best move is a zeroing one
+int dtzBeforeZeroing(eWdl wdl)
+{
+    return wdl == WDL_WIN          ?  1   :
+           wdl == WDL_CURSED_WIN   ?  101 :
+           wdl == WDL_BLESSED_LOSS ? -101 :
+           wdl == WDL_LOSS         ? -1   : 0;
+}
+
+inline int signOf(int value) { return (value > 0) - (value < 0); }
+
+// searchWdl: the tables hold no positions with en passant captures and may hold
+//      anything where a capture (or a pawn move with `checkZeroingMoves`) wins,
+//      so those moves are searched first and the table is probed for the rest
+eWdl searchWdl(Position &pos, eProbeState *result, bool checkZeroingMoves)
+{
+    eWdl bestWdl = WDL_LOSS;
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    int movesCount = 0;
+
+    for (const auto &scored : moves) {
+        const Move move = scored.move;
+        if (!isCaptureMove(move) && (!checkZeroingMoves || typeOf(pos.movedPiece(move)) != PAWN))
+            continue;
+
+        movesCount++;
+        pos.doMove(move);
+        const eWdl wdl = eWdl(-searchWdl(pos, result, false));
+        pos.undoMove(move);
+
+        if (*result == PROBE_FAIL)
+            return WDL_DRAW;
+
+        if (wdl > bestWdl) {
+            bestWdl = wdl;
+            if (wdl >= WDL_WIN) {
+                *result = PROBE_ZEROING_MOVE; // winning zeroing move
+                return wdl;
+            }
+        }
+    }
+
+    // with all the moves searched the table isn't needed, it may be wrong
+    // for positions with an en passant capture or with captures only
+    const bool noMoreMoves = movesCount > 0 && movesCount == moves.size();
+    eWdl wdl;
+    if (noMoreMoves) {
+        wdl = bestWdl;
+    } else {
+        wdl = eWdl(probeTable(pos, WDL_TABLE, result));
+        if (*result == PROBE_FAIL)
+            return WDL_DRAW;
+    }
+
+    // DTZ holds a "don't care" value when the best move is a zeroing one
+    if (bestWdl >= wdl) {
+        *result = bestWdl > WDL_DRAW || noMoreMoves ? PROBE_ZEROING_MOVE : PROBE_OK;
+        return bestWdl;
+    }
+    *result = PROBE_OK;
+    return wdl;
+}
+
+int probeDtz(Position &pos, eProbeState *result)
+{
+    *result = PROBE_OK;
+    const eWdl wdl = searchWdl(pos, result, true);
+
+    if (*result == PROBE_FAIL || wdl == WDL_DRAW) // draws aren't in DTZ tables
+        return 0;
+
+    // the table holds a "don't care" value, or a wrong one for a losing en passant
+    if (*result == PROBE_ZEROING_MOVE)
+        return dtzBeforeZeroing(wdl);
+
+    int dtz = probeTable(pos, DTZ_TABLE, result, wdl);
+    if (*result == PROBE_FAIL)
+        return 0;
+    if (*result != PROBE_CHANGE_STM)
+        return (dtz + (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN ? 100 : 0)) * signOf(wdl);
+
+    // the table is for the other side to move: the best DTZ of a 1-ply search
+    int minDtz = 0xFFFF;
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    for (const auto &scored : moves) {
+        const Move move = scored.move;
+        const bool zeroing = isZeroingMove(pos, move);
+        pos.doMove(move);
+
+        // after a zeroing move the DTZ is the one before it, the sign comes from the position after it
+        dtz = zeroing ? -dtzBeforeZeroing(searchWdl(pos, result, false)) : -probeDtz(pos, result);
+
+        // a mating move has DTZ 1
+        if (dtz == 1 && pos.inCheck()) {
+            MoveList replies;
+            generateLegalMoves(pos, replies);
+            if (replies.isEmpty())
+                minDtz = 1;
+        }
+
+        if (!zeroing)
+            dtz += signOf(dtz);
+
+        // skip the draws, a winning side picks a winning move only
+        if (dtz < minDtz && signOf(dtz) == signOf(wdl))
+            minDtz = dtz;
+
+        pos.undoMove(move);
+        if (*result == PROBE_FAIL)
+            return 0;
+    }
+
+    // no legal moves: mated
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+}
+
+
+//==============================================================
+//                      Tablebases
+//==============================================================
+
+int Tablebases::init(const QString &paths)
+{
+    initEncoding();
+
+    wdlTables.clear();
+    dtzTables.clear();
+    qDeleteAll(tables);
+    tables.clear();
+    maxPieceCount = 0;
+
+    const QStringList directories = paths.split(QDir::listSeparator(), QString::SkipEmptyParts);
+    int wdlCount = 0;
+    for (const auto &directory : directories) {
+        const QDir dir(directory);
+        const QStringList fileNames = dir.entryList(QStringList() << "*.rtbw" << "*.rtbz", QDir::Files);
+        for (const auto &fileName : fileNames) {
+            const QString name = QFileInfo(fileName).completeBaseName();
+            const eTableType type = fileName.endsWith(tableSuffix[WDL_TABLE]) ? WDL_TABLE : DTZ_TABLE;
+
+            int counts[2][6];
+            if (!Material::parseName(name, counts))
+                continue;
+            int pieceCount = 0;
+            for (auto side = 0; side < 2; side++)
+                for (auto piece = 0; piece < 6; piece++)
+                    pieceCount += counts[side][piece];
+            if (pieceCount > TB_PIECES)
+                continue;
+
+            QHash<quint32, Table*> &registry = type == WDL_TABLE ? wdlTables : dtzTables;
+            const quint32 key = Material::key(counts, false);
+            if (registry.contains(key)) // the same table in another directory
+                continue;
+
+            Table *table = new Table;
+            table->type = type;
+            table->name = name;
+            table->filePath = dir.filePath(fileName);
+            table->key = key;
+            table->key2 = Material::key(counts, true);
+            table->pieceCount = pieceCount;
+            table->hasPawns = counts[0][PAWN] + counts[1][PAWN] > 0;
+            for (auto side = 0; side < 2; side++)
+                for (auto piece = int(PAWN); piece < int(KING); piece++)
+                    if (counts[side][piece] == 1)
+                        table->hasUniquePieces = true;
+
+            // both sides with pawns: the side with fewer pawns leads, it compresses better
+            const bool isWhiteLeading = counts[1][PAWN] == 0 ||
+                                        (counts[0][PAWN] && counts[1][PAWN] >= counts[0][PAWN]);
+            table->pawnCount[0] = counts[isWhiteLeading ? 0 : 1][PAWN];
+            table->pawnCount[1] = counts[isWhiteLeading ? 1 : 0][PAWN];
+
+            tables.append(table);
+            registry.insert(table->key, table);
+            registry.insert(table->key2, table);
+
+            if (type == WDL_TABLE) {
+                wdlCount++;
+                maxPieceCount = qMax(maxPieceCount, pieceCount);
+            }
+        }
+    }
+    return wdlCount;
+}
+
+int Tablebases::maxPieces()
+{
+    return maxPieceCount;
+}
+
+bool Tablebases::canProbe(const Position &pos)
+{
+    return maxPieceCount > 0 && pos.castlingRights() == NO_CASTLING && popCount(pos.pieces()) <= maxPieceCount;
+}
+
+eWdl Tablebases::probeWdl(Position &pos, bool *ok)
+{
+    eProbeState result = PROBE_OK;
+    const eWdl wdl = searchWdl(pos, &result, false);
+    *ok = result != PROBE_FAIL;
+    return wdl;
+}
+
+int Tablebases::probeDtz(Position &pos, bool *ok)
+{
+    eProbeState result = PROBE_OK;
+    const int dtz = engine::probeDtz(pos, &result);
+    *ok = result != PROBE_FAIL;
+    return dtz;
+}
+
+bool Tablebases::rootMoves(Position &pos, MoveList &moves)
+{
+    if (!canProbe(pos))
+        return false;
+
+    MoveList legalMoves;
+    generateLegalMoves(pos, legalMoves);
+    if (legalMoves.isEmpty())
+        return false;
+
+    // A certain win is a win converted before the fifty moves rule, all of them
+    // rank the same and the search picks the fastest. A win the fifty moves
+    // rule may spoil ranks by its DTZ: the nearer the zeroing move the better.
+    // Losses rank the same way the other way around
+    const int rule50 = pos.rule50();
+    int bestRank = -MAX_DTZ - 1;
+    int ranks[MAX_MOVES];
+    for (auto i = 0; i < legalMoves.size(); i++) {
+        const Move move = legalMoves.move(i);
+        eProbeState result = PROBE_OK;
+        pos.doMove(move);
+
+        int dtz;
+        if (pos.rule50() == 0) {
+            // after a zeroing move DTZ is one of -101, -1, 0, 1, 101
+            dtz = dtzBeforeZeroing(eWdl(-searchWdl(pos, &result, false)));
+        } else if (pos.isDraw(1)) {
+            dtz = 0;
+        } else {
+            dtz = -engine::probeDtz(pos, &result);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+
+        // a mating move has DTZ 1
+        if (dtz == 2 && pos.inCheck()) {
+            MoveList replies;
+            generateLegalMoves(pos, replies);
+            if (replies.isEmpty())
+                dtz = 1;
+        }
+
+        pos.undoMove(move);
+        if (result == PROBE_FAIL)
+            return false;
+
+        ranks[i] = dtz > 0 ? (dtz + rule50 <= 99 ? MAX_DTZ : MAX_DTZ - (dtz + rule50)) :
+                   dtz < 0 ? (-dtz * 2 + rule50 < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + rule50)) :
+                   0;
+        bestRank = qMax(bestRank, ranks[i]);
+    }
+
+    moves.clear();
+    for (auto i = 0; i < legalMoves.size(); i++)
+        if (ranks[i] == bestRank)
+            moves.add(legalMoves.move(i));
+    return true;
+}
+
+}
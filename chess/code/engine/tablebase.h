@@ -0,0 +1,81 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_TABLEBASE_H
+#define ENGINE_TABLEBASE_H
+
+#include <QString>
+
+#include "position.h"
+
+//==============================================================
+//                  Syzygy endgame tablebases
+//==============================================================
+
+//    Probing of the Syzygy tables (KRvK.rtbw, KRvK.rtbz, ...) of up to 7 pieces.
+//    WDL tables hold win/draw/loss of every position with the side to move,
+//    DTZ tables hold the distance to the next capture or pawn move (zeroing move)
+//    of the winning side, so a won position is converted within the fifty moves rule.
+//    Tables are found by name in the given directories on init() and mapped
+//    read-only on their first probe, the mapped pages are shared by all the
+//    search threads and all the engines of the process.
+//    None of the tables knows about castling: positions with castling rights
+//    are never probed.
+
+namespace engine
+{
+
+//    Result of a WDL probe from the side to move point of view,
+//    cursed wins and blessed losses are drawn by the fifty moves rule
+enum eWdl {
+    WDL_LOSS         = -2,
+    WDL_BLESSED_LOSS = -1,
+    WDL_DRAW         =  0,
+    WDL_CURSED_WIN   =  1,
+    WDL_WIN          =  2
+};
+
+namespace Tablebases
+{
+    // init: forgets the tables found before and looks for the tables in the directories
+    //      separated by QDir::listSeparator(), an empty string turns the tablebases off.
+    //      Returns the number of WDL tables found. Must not be called while a search is running
+    int     init(const QString &paths);
+    // maxPieces: pieces of the largest WDL table found, kings included; 0 without tables
+    int     maxPieces();
+    // canProbe: few enough pieces for the tables found and no castling rights
+    bool    canProbe(const Position &pos);
+
+    // probeWdl: win/draw/loss of the position, `ok` is false if the table is missing
+    //      or broken. The position is given back as it was, moves are made to resolve captures
+    eWdl    probeWdl(Position &pos, bool *ok);
+    // probeDtz: plies to the zeroing move of the won (positive) or lost (negative)
+    //      position, 0 for a draw. Values beyond 100 are cursed wins and blessed losses
+    int     probeDtz(Position &pos, bool *ok);
+    // rootMoves: the legal moves of the root keeping its tablebase result,
+    //      the ones converting before the fifty moves rule draws the game first.
+    //      False if the root can't be probed, `moves` is left untouched then
+    bool    rootMoves(Position &pos, MoveList &moves);
+}
+
+}
+
+#endif//ENGINE_TABLEBASE_H
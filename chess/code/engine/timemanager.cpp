@@ -0,0 +1,92 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "timemanager.h"
+#include "search.h"
+
+namespace engine
+{
+
+TimeManager::TimeManager()
+{
+    m_enabled = false;
+    m_singleReply = false;
+    m_softLimit = m_hardLimit = 0;
+    m_lastBestMove = NO_MOVE;
+    m_lastScore = VALUE_NONE;
+    m_bestMoveChanges = 0;
+}
+
+void TimeManager::init(const SearchLimits &limits, eColor us, int legalMoves)
+{
+    m_enabled = limits.time[us] > 0 && !limits.infinite;
+    m_singleReply = legalMoves == 1;
+    m_lastBestMove = NO_MOVE;
+    m_lastScore = VALUE_NONE;
+    m_bestMoveChanges = 0;
+    if (!m_enabled)
+        return;
+
+    const qint64 increment = limits.increment[us];
+    const int movesToGo = limits.movesToGo > 0 ? qMin(limits.movesToGo, int(MOVES_HORIZON)) : MOVES_HORIZON;
+    const qint64 available = qMax<qint64>(1, limits.time[us] - MOVE_OVERHEAD);
+
+    // an even share of the clock plus most of the increment; the hard limit
+    // allows three times as much but never more than a fifth of the clock
+    m_hardLimit = qMax<qint64>(1, qMin(available / 5, (available / movesToGo + increment) * 3));
+    m_softLimit = qMin(available / movesToGo + increment * 3 / 4, m_hardLimit);
+    if (limits.movesToGo == 1)
+        m_softLimit = m_hardLimit = qMax<qint64>(1, available * 4 / 5);
+}
+
+bool TimeManager::iterationDone(qint64 elapsed, int depth, Move bestMove, int score, double bestMoveEffort)
+{
+    if (!m_enabled)
+        return false;
+
+    // a forced move is played as soon as there is a move to play
+    if (m_singleReply)
+        return true;
+
+    m_bestMoveChanges /= 2;
+    if (m_lastBestMove != NO_MOVE && bestMove != m_lastBestMove)
+        m_bestMoveChanges += 1;
+
+    // unstable best move: up to 2.5 times the budget
+    double scale = 1.0 + qMin(m_bestMoveChanges, 1.5);
+
+    // the score drops: the position is getting worse, look for the way out
+    if (m_lastScore != VALUE_NONE && !isMateScore(score) && score < m_lastScore - 30)
+        scale *= 1.3;
+
+    // one move takes nearly all the effort: the other moves are refuted quickly
+    if (depth >= 8 && bestMoveEffort > 0.9 && m_bestMoveChanges < 0.25)
+        scale *= 0.5;
+
+    m_lastBestMove = bestMove;
+    m_lastScore = score;
+
+    // the next iteration takes about twice as long as all the previous ones,
+    // don't start it unless it has a chance to complete within the budget
+    return elapsed >= qMin(qint64(m_softLimit * scale), m_hardLimit) / 2;
+}
+
+}
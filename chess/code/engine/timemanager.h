@@ -0,0 +1,75 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_TIMEMANAGER_H
+#define ENGINE_TIMEMANAGER_H
+
+#include "types.h"
+
+//==============================================================
+//                      Time management
+//==============================================================
+
+namespace engine
+{
+
+struct SearchLimits;
+
+//    TimeManager splits the clock of the side to move into two budgets:
+//      soft - a new iteration isn't started after it. It is scaled after
+//             every iteration: stretched while the best move keeps changing
+//             or the score drops, shrunk when one move takes nearly all the
+//             effort or there is a single legal move
+//      hard - the search is stopped in the middle of an iteration
+class TimeManager {
+public:
+    TimeManager();
+
+    // init: the manager stays disabled unless the limits carry a clock of the side to move
+    void    init(const SearchLimits &limits, eColor us, int legalMoves);
+    bool    isEnabled() const { return m_enabled; }
+    qint64  softLimit() const { return m_softLimit; }
+    qint64  hardLimit() const { return m_hardLimit; }
+
+    // iterationDone: called by the main thread after each iteration,
+    //      bestMoveEffort is the share of the iteration nodes spent on the best move.
+    //      Returns true if the next iteration isn't worth starting
+    bool    iterationDone(qint64 elapsed, int depth, Move bestMove, int score, double bestMoveEffort);
+
+private:
+    enum {
+        MOVE_OVERHEAD  = 30, // milliseconds lost on every move by the GUI and network
+        MOVES_HORIZON  = 40  // moves the remaining time is split into without movestogo
+    };
+
+    bool    m_enabled;
+    bool    m_singleReply;
+    qint64  m_softLimit;
+    qint64  m_hardLimit;
+
+    Move    m_lastBestMove;
+    int     m_lastScore;
+    double  m_bestMoveChanges; // decays by half every iteration
+};
+
+}
+
+#endif//ENGINE_TIMEMANAGER_H
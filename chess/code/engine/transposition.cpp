@@ -0,0 +1,200 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "transposition.h"
+
+#include <new>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+namespace engine
+{
+
+namespace
+{
+
+//    Packed layout of the data word:
+//      bits  0-15 - move
+//      bits 16-31 - score
+//      bits 32-47 - static evaluation
+//      bits 48-55 - depth
+//      bits 56-57 - bound
+//      bits 58-63 - generation
+inline quint64 packData(Move move, int score, int eval, int depth, eBound bound, quint8 generation)
+{
+    return quint64(move)
+         | quint64(quint16(qint16(score))) << 16
+         | quint64(quint16(qint16(eval)))  << 32
+         | quint64(quint8(depth))          << 48
+         | quint64(bound)                  << 56
+         | quint64(generation & 0x3F)      << 58;
+}
+
+inline Move   dataMove(quint64 data)       { return Move(data & 0xFFFF); }
+inline int    dataScore(quint64 data)      { return qint16(quint16(data >> 16)); }
+inline int    dataEval(quint64 data)       { return qint16(quint16(data >> 32)); }
+inline int    dataDepth(quint64 data)      { return quint8(data >> 48); }
+inline eBound dataBound(quint64 data)      { return eBound((data >> 56) & 3); }
+inline quint8 dataGeneration(quint64 data) { return quint8(data >> 58); }
+
+// age: how many searches ago the entry has been written, generation wraps at 64
+inline int age(quint64 data, quint8 generation)
+{
+    return (generation - dataGeneration(data)) & 0x3F;
+}
+
+}
+
+TranspositionTable::TranspositionTable()
+{
+    m_table = nullptr;
+    m_clusterMask = 0;
+    m_megabytes = 0;
+    m_generation = 0;
+    resize(16);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    qFreeAligned(m_table);
+}
+
+void TranspositionTable::resize(int megabytes)
+{
+    megabytes = qMax(1, megabytes);
+
+    // the largest power of two clusters which fits
+    quint64 clusters = (quint64(megabytes) << 20) / sizeof(Cluster);
+    quint64 count = 1;
+    while (count * 2 <= clusters)
+        count *= 2;
+
+    qFreeAligned(m_table);
+    m_table = static_cast<Cluster*>(qMallocAligned(count * sizeof(Cluster), 64));
+    if (m_table == nullptr)
+        throw std::bad_alloc();
+    for (quint64 i = 0; i < count; i++)
+        new (&m_table[i]) Cluster();
+
+    m_clusterMask = count - 1;
+    m_megabytes = megabytes;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (quint64 i = 0; i <= m_clusterMask; i++) {
+        for (auto j = 0; j < CLUSTER_SIZE; j++) {
+            m_table[i].entries[j].data.store(0);
+            m_table[i].entries[j].keyXorData.store(0);
+        }
+    }
+    m_generation = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    m_generation = (m_generation + 1) & 0x3F;
+}
+
+bool TranspositionTable::probe(Key key, TTData &data) const
+{
+    const Cluster *cluster = m_cluster(key);
+
+    for (auto i = 0; i < CLUSTER_SIZE; i++) {
+        const quint64 word = cluster->entries[i].data.load();
+        const quint64 check = cluster->entries[i].keyXorData.load();
+        if ((check ^ word) != key || word == 0)
+            continue;
+
+        data.move  = dataMove(word);
+        data.score = dataScore(word);
+        data.eval  = dataEval(word);
+        data.depth = dataDepth(word);
+        data.bound = dataBound(word);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(Key key, Move move, int score, int eval, int depth, eBound bound)
+{
+    Cluster *cluster = m_cluster(key);
+    Entry *replace = &cluster->entries[0];
+    int replaceWorth = 1 << 30;
+
+    for (auto i = 0; i < CLUSTER_SIZE; i++) {
+        Entry *entry = &cluster->entries[i];
+        const quint64 word = entry->data.load();
+        const quint64 check = entry->keyXorData.load();
+
+        if (word == 0 || (check ^ word) == key) {
+            // the same position: keep the old move if the new search hasn't found any,
+            // don't let a shallow non exact result overwrite a deep one of this search
+            if (word != 0) {
+                if (move == NO_MOVE)
+                    move = dataMove(word);
+                if (bound != BOUND_EXACT && depth + 4 < dataDepth(word) && age(word, m_generation) == 0)
+                    return;
+            }
+            replace = entry;
+            break;
+        }
+
+        // otherwise replace the shallowest and the oldest entry
+        const int worth = dataDepth(word) - 8 * age(word, m_generation);
+        if (worth < replaceWorth) {
+            replaceWorth = worth;
+            replace = entry;
+        }
+    }
+
+    const quint64 word = packData(move, score, eval, qBound(0, depth, 255), bound, m_generation);
+    replace->data.store(word);
+    replace->keyXorData.store(key ^ word);
+}
+
+void TranspositionTable::prefetch(Key key) const
+{
+#if defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<const char*>(m_cluster(key)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(m_cluster(key));
+#endif
+}
+
+int TranspositionTable::hashfull() const
+{
+    const quint64 sampled = qMin<quint64>(1000, m_clusterMask + 1);
+    int used = 0;
+    for (quint64 i = 0; i < sampled; i++) {
+        for (auto j = 0; j < CLUSTER_SIZE; j++) {
+            const quint64 word = m_table[i].entries[j].data.load();
+            if (word != 0 && age(word, m_generation) == 0)
+                used++;
+        }
+    }
+    return int(used * 1000 / (sampled * CLUSTER_SIZE));
+}
+
+}
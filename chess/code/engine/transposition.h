@@ -0,0 +1,112 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_TRANSPOSITION_H
+#define ENGINE_TRANSPOSITION_H
+
+#include <QAtomicInteger>
+
+#include "types.h"
+
+//==============================================================
+//                   Transposition table
+//==============================================================
+
+namespace engine
+{
+
+enum eBound {
+    BOUND_NONE,
+    BOUND_UPPER, // fail low, the score is at most the stored one
+    BOUND_LOWER, // fail high, the score is at least the stored one
+    BOUND_EXACT
+};
+
+//    TTData is an unpacked copy of a table entry
+struct TTData {
+    Move   move;
+    int    score;
+    int    eval;
+    int    depth;
+    eBound bound;
+};
+
+//    TranspositionTable is shared by all search threads without any locks.
+//    Every entry is two 64-bit words: the packed data and the key xor-ed with it.
+//    A torn write made by two threads at once leaves words which don't xor
+//    back to the key, so the entry is simply seen as a miss.
+class TranspositionTable {
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+
+    // resize: allocates about `megabytes` of memory, the table is cleared
+    void resize(int megabytes);
+    void clear();
+    // newSearch: ages the entries of the previous searches so they are replaced first
+    void newSearch();
+
+    bool probe(Key key, TTData &data) const;
+    void store(Key key, Move move, int score, int eval, int depth, eBound bound);
+    // prefetch: hints the CPU to load the cluster of the key
+    void prefetch(Key key) const;
+
+    // hashfull: permille of entries used by the current search, sampled
+    int  hashfull() const;
+    int  sizeMB() const { return m_megabytes; }
+
+private:
+    Q_DISABLE_COPY(TranspositionTable)
+
+    struct Entry {
+        QAtomicInteger<quint64> keyXorData;
+        QAtomicInteger<quint64> data;
+    };
+
+    enum { CLUSTER_SIZE = 4 };
+    // cluster fills a 64 bytes cache line
+    struct Cluster {
+        Entry entries[CLUSTER_SIZE];
+    };
+
+    Cluster *m_cluster(Key key) const { return m_table + (key & m_clusterMask); }
+
+    Cluster *m_table;
+    quint64  m_clusterMask; // number of clusters is a power of two
+    int      m_megabytes;
+    quint8   m_generation;  // 6 bits, increased by every search
+};
+
+// scoreToTT / scoreFromTT:
+//      Mate and tablebase scores are stored relative to the node and not to the root,
+//      so they stay valid when the position is reached at another ply
+inline int scoreToTT(int score, int ply)
+{
+    return score >= VALUE_TB_WIN_IN_MAX_PLY ? score + ply : score <= -VALUE_TB_WIN_IN_MAX_PLY ? score - ply : score;
+}
+inline int scoreFromTT(int score, int ply)
+{
+    return score >= VALUE_TB_WIN_IN_MAX_PLY ? score - ply : score <= -VALUE_TB_WIN_IN_MAX_PLY ? score + ply : score;
+}
+
+}
+
+#endif//ENGINE_TRANSPOSITION_H
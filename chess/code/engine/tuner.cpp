@@ -0,0 +1,482 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "tuner.h"
+#include "parallel.h"
+#include "pgn.h"
+#include "pawns.h"
+#include "movegen.h"
+#include "see.h"
+#include "bitboard.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace engine
+{
+
+namespace
+{
+
+enum {
+    // parameters, each of them has a midgame and an endgame value
+    PARAM_MATERIAL = 0,                      // by ePieceType, pawn to queen
+    PARAM_PSQ      = PARAM_MATERIAL + 5,     // [ePieceType][index of PSQT::midgameTable]
+    PARAM_DOUBLED  = PARAM_PSQ + 6 * 64,
+    PARAM_ISOLATED,
+    PARAM_BACKWARD,
+    PARAM_PASSED,                            // by relative rank
+    PARAM_NB       = PARAM_PASSED + 8,
+
+    // games are read by the calling thread and replayed by all the threads in batches
+    BATCH_GAMES    = 4096,
+    // the most terms a position can have: material and square of every piece plus pawn terms
+    MAX_TERMS      = 2 * 32 + 3 + 8
+};
+
+//    PackedPosition keeps only what the evaluation needs: 32 bytes per position,
+//    the pieces in the order of the occupied squares from a1, two per byte
+struct PackedPosition {
+    quint64 occupied;
+    quint8  pieces[16];
+    quint8  result; // from WHITE point of view: 2 a win, 1 a draw, 0 a loss
+};
+
+//    Terms are the parameters a position depends on with their counts,
+//    WHITE ones counting positive and BLACK ones negative
+struct Terms {
+    int    phase;
+    int    size;
+    int    params[MAX_TERMS];
+    int    counts[MAX_TERMS];
+
+    void   add(int param, int count)
+    {
+        params[size] = param;
+        counts[size] = count;
+        size++;
+    }
+};
+
+void termsOf(const PackedPosition &packed, Terms &terms)
+{
+    terms.phase = 0;
+    terms.size = 0;
+
+    Bitboard pawns[2] = { 0, 0 };
+    Bitboard occupied = packed.occupied;
+    for (auto i = 0; occupied; i++) {
+        const int square = popLsb(occupied);
+        const int piece = (packed.pieces[i / 2] >> (4 * (i % 2))) & 0xF;
+        const eColor color = colorOf(piece);
+        const ePieceType type = typeOf(piece);
+        const int sign = color == WHITE ? 1 : -1;
+
+        // the tables are written as seen on the board, WHITE squares are mirrored
+        const int index = color == WHITE ? square ^ 56 : square;
+        if (type != KING)
+            terms.add(PARAM_MATERIAL + type, sign);
+        terms.add(PARAM_PSQ + type * 64 + index, sign);
+        terms.phase += PSQT::phaseWeight[type];
+        if (type == PAWN)
+            pawns[color] |= squareBB(square);
+    }
+    terms.phase = qMin(terms.phase, int(PHASE_MIDGAME));
+
+    PawnTerms pawnTerms;
+    countPawnTerms(pawns[WHITE], pawns[BLACK], pawnTerms);
+    if (pawnTerms.doubled)  terms.add(PARAM_DOUBLED, pawnTerms.doubled);
+    if (pawnTerms.isolated) terms.add(PARAM_ISOLATED, pawnTerms.isolated);
+    if (pawnTerms.backward) terms.add(PARAM_BACKWARD, pawnTerms.backward);
+    for (auto rank = 1; rank < 7; rank++)
+        if (pawnTerms.passed[rank])
+            terms.add(PARAM_PASSED + rank, pawnTerms.passed[rank]);
+}
+
+// evaluationOf: tapered evaluation from WHITE point of view with the values
+//      `mg` and `eg`, the same as evaluate() gives without rounding
+double evaluationOf(const Terms &terms, const double *mg, const double *eg)
+{
+    double midgame = 0, endgame = 0;
+    for (auto i = 0; i < terms.size; i++) {
+        midgame += terms.counts[i] * mg[terms.params[i]];
+        endgame += terms.counts[i] * eg[terms.params[i]];
+    }
+    return (midgame * terms.phase + endgame * (PHASE_MIDGAME - terms.phase)) / PHASE_MIDGAME;
+}
+
+inline double sigmoid(double k, double evaluation)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -k * evaluation / 400.0));
+}
+
+// isQuiet: the static evaluation is meaningful only without a check
+//      or a capture or promotion which wins something at once
+bool isQuiet(const Position &pos, Move lastMove)
+{
+    if (pos.inCheck() || isTacticalMove(lastMove))
+        return false;
+    MoveList moves;
+    generateMoves(pos, moves, GEN_CAPTURES);
+    for (const auto &scored : moves)
+        if (pos.isLegal(scored.move) && (isPromotionMove(scored.move) || see(pos, scored.move) > 0))
+            return false;
+    return true;
+}
+
+PackedPosition pack(const Position &pos, int result)
+{
+    PackedPosition packed;
+    std::memset(&packed, 0, sizeof(packed));
+    packed.occupied = pos.pieces();
+    packed.result = quint8(result);
+
+    Bitboard occupied = packed.occupied;
+    for (auto i = 0; occupied; i++)
+        packed.pieces[i / 2] |= quint8(pos.pieceOn(popLsb(occupied)) << (4 * (i % 2)));
+    return packed;
+}
+
+// extractGame: quiet positions of the game after the opening plies
+void extractGame(const PgnGame &game, int skipPlies, QVector<PackedPosition> &positions)
+{
+    int result;
+    if (game.result == "1-0")          result = 2;
+    else if (game.result == "1/2-1/2") result = 1;
+    else if (game.result == "0-1")     result = 0;
+    else return;
+
+    Position pos;
+    if (!pos.setFEN(game.startFEN()))
+        return;
+    for (auto ply = 0; ply < game.moves.size(); ply++) {
+        const Move move = moveFromSan(pos, game.moves.at(ply));
+        if (move == NO_MOVE)
+            return; // the rest of a broken game can't be replayed
+        pos.doMove(move);
+        if (ply + 1 >= skipPlies && isQuiet(pos, move))
+            positions.append(pack(pos, result));
+    }
+}
+
+//    TexelTuner holds the positions in one compact array and the values being fitted
+class TexelTuner {
+public:
+    TexelTuner(const Tuner::Options &options, QTextStream &out);
+
+    bool    extract(const QStringList &pgnFiles, QString *error);
+    void    run();
+    bool    write(const QString &outputFile, QString *error) const;
+
+private:
+    // m_pass: mean squared error of the predictions with the values `mg` and `eg`,
+    //      the gradient of the error is left in m_gradients[0] if `gradient` is set
+    double  m_pass(double k, const double *mg, const double *eg, bool gradient);
+    // m_fitK: K giving the least error with the values of the engine
+    double  m_fitK();
+
+    const Tuner::Options &m_options;
+    QTextStream   &m_out;
+    int            m_threads;
+
+    QVector<PackedPosition> m_positions;
+    double         m_mg[PARAM_NB];
+    double         m_eg[PARAM_NB];
+    double         m_k;
+    double         m_startError;
+    double         m_error;
+    QVector<QVector<double>> m_gradients; // by thread, the midgame values first
+};
+
+TexelTuner::TexelTuner(const Tuner::Options &options, QTextStream &out)
+    : m_options(options), m_out(out), m_threads(qMax(1, options.threads)), m_k(1.0), m_startError(0), m_error(0)
+{
+    PSQT::init();
+    for (auto type = PAWN; type <= QUEEN; type = ePieceType(type + 1)) {
+        m_mg[PARAM_MATERIAL + type] = PSQT::material[type].mg;
+        m_eg[PARAM_MATERIAL + type] = PSQT::material[type].eg;
+    }
+    for (auto type = PAWN; type <= KING; type = ePieceType(type + 1)) {
+        for (auto index = 0; index < 64; index++) {
+            m_mg[PARAM_PSQ + type * 64 + index] = PSQT::midgameTable[type][index];
+            m_eg[PARAM_PSQ + type * 64 + index] = PSQT::endgameTable[type][index];
+        }
+    }
+    m_mg[PARAM_DOUBLED]  = PawnValues::doubled.mg;
+    m_eg[PARAM_DOUBLED]  = PawnValues::doubled.eg;
+    m_mg[PARAM_ISOLATED] = PawnValues::isolated.mg;
+    m_eg[PARAM_ISOLATED] = PawnValues::isolated.eg;
+    m_mg[PARAM_BACKWARD] = PawnValues::backward.mg;
+    m_eg[PARAM_BACKWARD] = PawnValues::backward.eg;
+    for (auto rank = 0; rank < 8; rank++) {
+        m_mg[PARAM_PASSED + rank] = PawnValues::passed[rank].mg;
+        m_eg[PARAM_PASSED + rank] = PawnValues::passed[rank].eg;
+    }
+
+    m_gradients.resize(m_threads);
+    for (auto &gradient : m_gradients)
+        gradient.resize(2 * PARAM_NB);
+}
+
+bool TexelTuner::extract(const QStringList &pgnFiles, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+    qint64 games = 0;
+    const qint64 maxPositions = m_options.maxPositions > 0 ? m_options.maxPositions : Q_INT64_C(0x7FFFFFFFFFFFFFFF);
+
+    QVector<QVector<PackedPosition>> found(m_threads);
+    for (const auto &fileName : pgnFiles) {
+        PgnFile file;
+        if (!file.open(fileName)) {
+            *error = "can't open " + fileName;
+            return false;
+        }
+
+        QVector<PgnGame> batch(BATCH_GAMES);
+        int batchSize;
+        do {
+            batchSize = 0;
+            while (batchSize < BATCH_GAMES && file.readGame(batch[batchSize]))
+                batchSize++;
+            games += batchSize;
+
+            // every thread replays a contiguous share of the batch, so the positions
+            // keep the order of the file whatever the number of threads
+            const int shareSize = (batchSize + m_threads - 1) / m_threads;
+            runParallel(m_threads, [&](int share) {
+                found[share].clear();
+                const int end = qMin(batchSize, (share + 1) * shareSize);
+                for (auto i = share * shareSize; i < end; i++)
+                    extractGame(batch.at(i), m_options.skipPlies, found[share]);
+            });
+            for (const auto &positions : found)
+                m_positions += positions;
+        } while (batchSize == BATCH_GAMES && m_positions.size() < maxPositions);
+
+        if (m_positions.size() >= maxPositions)
+            break;
+    }
+    if (m_positions.size() > maxPositions)
+        m_positions.resize(int(maxPositions));
+    m_positions.squeeze();
+
+    const qint64 ms = qMax<qint64>(1, timer.elapsed());
+    m_out << "Games " << games << ", quiet positions " << m_positions.size() << " ("
+          << m_positions.size() * qint64(sizeof(PackedPosition)) / (1024 * 1024) << " MB) in " << ms << " ms, "
+          << games * 1000 / ms << " games/s, " << m_positions.size() * 1000 / ms << " positions/s\n";
+    m_out.flush();
+
+    if (m_positions.isEmpty()) {
+        *error = "no quiet positions with a game result";
+        return false;
+    }
+    return true;
+}
+
+double TexelTuner::m_pass(double k, const double *mg, const double *eg, bool gradient)
+{
+    const int size = m_positions.size();
+    const int shareSize = (size + m_threads - 1) / m_threads;
+    QVector<double> errors(m_threads);
+
+    runParallel(m_threads, [&](int share) {
+        double *sums = m_gradients[share].data();
+        if (gradient)
+            std::fill(sums, sums + 2 * PARAM_NB, 0.0);
+
+        Terms terms;
+        double error = 0;
+        const int end = qMin(size, (share + 1) * shareSize);
+        for (auto i = share * shareSize; i < end; i++) {
+            termsOf(m_positions.at(i), terms);
+            const double prediction = sigmoid(k, evaluationOf(terms, mg, eg));
+            const double delta = m_positions.at(i).result / 2.0 - prediction;
+            error += delta * delta;
+            if (!gradient)
+                continue;
+
+            // derivative of delta^2 by the evaluation, the constant factor
+            // 2 * K * ln(10) / 400 is left to the learning rate
+            const double slope = -delta * prediction * (1.0 - prediction);
+            const double mgWeight = slope * terms.phase / PHASE_MIDGAME;
+            const double egWeight = slope * (PHASE_MIDGAME - terms.phase) / PHASE_MIDGAME;
+            for (auto t = 0; t < terms.size; t++) {
+                sums[terms.params[t]]            += terms.counts[t] * mgWeight;
+                sums[PARAM_NB + terms.params[t]] += terms.counts[t] * egWeight;
+            }
+        }
+        errors[share] = error;
+    });
+
+    double error = 0;
+    for (auto share = 0; share < m_threads; share++) {
+        error += errors.at(share);
+        if (gradient && share > 0)
+            for (auto i = 0; i < 2 * PARAM_NB; i++)
+                m_gradients[0][i] += m_gradients[share][i];
+    }
+    return error / size;
+}
+
+double TexelTuner::m_fitK()
+{
+    // the error is unimodal in K: golden section search
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.1, high = 4.0;
+    double k1 = high - ratio * (high - low), k2 = low + ratio * (high - low);
+    double e1 = m_pass(k1, m_mg, m_eg, false), e2 = m_pass(k2, m_mg, m_eg, false);
+    while (high - low > 0.001) {
+        if (e1 < e2) {
+            high = k2;
+            k2 = k1;
+            e2 = e1;
+            k1 = high - ratio * (high - low);
+            e1 = m_pass(k1, m_mg, m_eg, false);
+        } else {
+            low = k1;
+            k1 = k2;
+            e1 = e2;
+            k2 = low + ratio * (high - low);
+            e2 = m_pass(k2, m_mg, m_eg, false);
+        }
+    }
+    return (low + high) / 2;
+}
+
+void TexelTuner::run()
+{
+    m_k = m_fitK();
+    m_startError = m_error = m_pass(m_k, m_mg, m_eg, false);
+    m_out << "K " << QString::number(m_k, 'f', 3) << ", error " << QString::number(m_error, 'f', 6)
+          << ", threads " << m_threads << "\n";
+    m_out << "iteration         error       time ms    positions/s\n";
+    m_out.flush();
+
+    // Adam: every value moves by about the learning rate per iteration
+    // whatever the scale of its gradient, rare terms are tuned as fast as material
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    QVector<double> moment(2 * PARAM_NB), velocity(2 * PARAM_NB);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (auto iteration = 1; iteration <= m_options.iterations; iteration++) {
+        m_error = m_pass(m_k, m_mg, m_eg, true);
+
+        const double *gradient = m_gradients[0].constData();
+        const double correction1 = 1.0 - std::pow(beta1, iteration);
+        const double correction2 = 1.0 - std::pow(beta2, iteration);
+        for (auto i = 0; i < 2 * PARAM_NB; i++) {
+            moment[i]   = beta1 * moment[i] + (1 - beta1) * gradient[i];
+            velocity[i] = beta2 * velocity[i] + (1 - beta2) * gradient[i] * gradient[i];
+            const double step = m_options.learningRate * (moment[i] / correction1)
+                              / (std::sqrt(velocity[i] / correction2) + epsilon);
+            if (i < PARAM_NB) m_mg[i] -= step;
+            else              m_eg[i - PARAM_NB] -= step;
+        }
+
+        if (iteration % 10 == 0 || iteration == m_options.iterations) {
+            const qint64 ms = qMax<qint64>(1, timer.elapsed());
+            m_out << QString("%1 %2 %3 %4\n")
+                     .arg(iteration, 9)
+                     .arg(m_error, 13, 'f', 6)
+                     .arg(ms, 13)
+                     .arg(qint64(iteration) * m_positions.size() * 1000 / ms, 14);
+            m_out.flush();
+        }
+    }
+    m_error = m_pass(m_k, m_mg, m_eg, false);
+}
+
+bool TexelTuner::write(const QString &outputFile, QString *error) const
+{
+    QFile file(outputFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        *error = "can't write " + outputFile;
+        return false;
+    }
+    QTextStream out(&file);
+    auto value = [](double v) { return qRound(v); };
+    auto score = [&](int param) {
+        return QString("Score(%1, %2)").arg(value(m_mg[param])).arg(value(m_eg[param]));
+    };
+
+    out << "// chess-tune: " << m_positions.size() << " positions, K " << QString::number(m_k, 'f', 3)
+        << ", error " << QString::number(m_startError, 'f', 6) << " -> " << QString::number(m_error, 'f', 6) << "\n\n";
+
+    out << "// psqt.cpp\n";
+    out << "const Score PSQT::material[6] = {\n    ";
+    for (auto type = PAWN; type <= QUEEN; type = ePieceType(type + 1))
+        out << score(PARAM_MATERIAL + type) << ", ";
+    out << "Score(0, 0)\n};\n\n";
+
+    const char *typeNames[6] = { "PAWN", "KNIGHT", "BISHOP", "ROOK", "QUEEN", "KING" };
+    for (auto table = 0; table < 2; table++) {
+        const double *values = table == 0 ? m_mg : m_eg;
+        out << "const int PSQT::" << (table == 0 ? "midgameTable" : "endgameTable") << "[6][64] = {\n";
+        for (auto type = PAWN; type <= KING; type = ePieceType(type + 1)) {
+            out << "    { // " << typeNames[type] << "\n";
+            for (auto row = 0; row < 8; row++) {
+                out << "       ";
+                for (auto file = 0; file < 8; file++) {
+                    out << QString("%1").arg(value(values[PARAM_PSQ + type * 64 + row * 8 + file]), 4)
+                        << (row == 7 && file == 7 ? "" : ",");
+                }
+                out << "\n";
+            }
+            out << (type == KING ? "    }\n" : "    },\n");
+        }
+        out << "};\n\n";
+    }
+
+    out << "// pawns.cpp\n";
+    out << "const Score PawnValues::doubled  = " << score(PARAM_DOUBLED) << ";\n";
+    out << "const Score PawnValues::isolated = " << score(PARAM_ISOLATED) << ";\n";
+    out << "const Score PawnValues::backward = " << score(PARAM_BACKWARD) << ";\n";
+    out << "const Score PawnValues::passed[8] = {\n    Score(0, 0)";
+    for (auto rank = 1; rank < 7; rank++)
+        out << ", " << score(PARAM_PASSED + rank);
+    out << ", Score(0, 0)\n};\n";
+    return true;
+}
+
+}
+
+//==============================================================
+//                          Tuner
+//==============================================================
+
+bool Tuner::tune(const QStringList &pgnFiles, const QString &outputFile, const Options &options,
+                 QTextStream &out, QString *error)
+{
+    TexelTuner tuner(options, out);
+    if (!tuner.extract(pgnFiles, error))
+        return false;
+    tuner.run();
+    return tuner.write(outputFile, error);
+}
+
+}
@@ -0,0 +1,65 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_TUNER_H
+#define ENGINE_TUNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+//==============================================================
+//                  Evaluation tuner
+//==============================================================
+
+//    Texel's tuning method for the classical evaluation: quiet positions of
+//    a PGN corpus are labelled with the results of their games, and the
+//    material, piece-square and pawn structure values are fitted so that
+//    1 / (1 + 10^(-K * eval / 400)) predicts the results with the least
+//    mean squared error. K is fitted to the values of the engine first.
+//    The evaluation is linear in its values, so the gradient is exact and
+//    each iteration is a single pass over the positions, split between the threads.
+
+namespace engine
+{
+
+namespace Tuner
+{
+    struct Options {
+        Options() : threads(1), iterations(1000), skipPlies(16), maxPositions(0), learningRate(1.0) {}
+
+        int    threads;
+        int    iterations;
+        int    skipPlies;     // opening plies of every game, they mostly come from books
+        qint64 maxPositions;  // 0 to take the quiet positions of all the games
+        double learningRate;  // largest change of a value per iteration in centipawns
+    };
+
+    // tune: extracts the positions of the games and fits the values, progress and
+    //      throughput go to `out`. The tuned values are written to `outputFile`
+    //      as the definitions of PSQT and PawnValues. False with `error` set on failure
+    bool    tune(const QStringList &pgnFiles, const QString &outputFile, const Options &options,
+                 QTextStream &out, QString *error);
+}
+
+}
+
+#endif//ENGINE_TUNER_H
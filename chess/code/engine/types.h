@@ -0,0 +1,188 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_TYPES_H
+#define ENGINE_TYPES_H
+
+#include <QtGlobal>
+
+#include "bitboard.h"
+
+//==============================================================
+//                    Engine data types
+//==============================================================
+
+namespace engine
+{
+
+typedef quint64 Key;
+
+enum {
+    MAX_PLY   = 128, // deepest ply the search may reach
+    MAX_MOVES = 256  // upper bound of moves in a legal chess position
+};
+
+// == Pieces ==
+
+//    Piece on a square: color * 6 + ePieceType, NO_PIECE for an empty square
+enum ePiece {
+    W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+    B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+    NO_PIECE,
+    PIECE_NB = 12
+};
+
+inline int        makePiece(eColor color, ePieceType type) { return color * 6 + type; }
+inline ePieceType typeOf(int piece)  { return ePieceType(piece < 6 ? piece : piece - 6); }
+inline eColor     colorOf(int piece) { return piece < 6 ? WHITE : BLACK; }
+
+// == Castling ==
+
+enum eCastlingRights {
+    NO_CASTLING     = 0,
+    WHITE_OO        = 1,
+    WHITE_OOO       = 2,
+    BLACK_OO        = 4,
+    BLACK_OOO       = 8,
+    ALL_CASTLING    = 15
+};
+
+// == Moves ==
+
+//    Move is packed into 16 bits:
+//      bits  0-5  - square from
+//      bits  6-11 - square to
+//      bits 12-15 - eMoveFlag
+//    Castling is encoded as the king move (e1g1, e1c1, ...)
+typedef quint16 Move;
+
+enum eMoveFlag {
+    QUIET_MOVE         = 0,
+    DOUBLE_PAWN_PUSH   = 1,
+    KING_CASTLE        = 2,
+    QUEEN_CASTLE       = 3,
+    CAPTURE            = 4,
+    EN_PASSANT         = 5,
+    // promotion flags: PROMOTION | (promoted type - KNIGHT), CAPTURE bit may be set as well
+    PROMOTION          = 8
+};
+
+const Move NO_MOVE = 0; // a1a1 is never a valid move
+
+inline Move makeMove(int from, int to, int flag = QUIET_MOVE)
+{
+    return Move(from | (to << 6) | (flag << 12));
+}
+inline Move makePromotion(int from, int to, ePieceType promoted, bool isCapture)
+{
+    return makeMove(from, to, PROMOTION | (isCapture ? CAPTURE : 0) | (promoted - KNIGHT));
+}
+
+inline int  moveFrom(Move move) { return move & 0x3F; }
+inline int  moveTo(Move move)   { return (move >> 6) & 0x3F; }
+inline int  moveFlag(Move move) { return move >> 12; }
+inline bool isCaptureMove(Move move)   { return (moveFlag(move) & CAPTURE) != 0; }
+inline bool isPromotionMove(Move move) { return (moveFlag(move) & PROMOTION) != 0; }
+inline bool isCastlingMove(Move move)  { return moveFlag(move) == KING_CASTLE || moveFlag(move) == QUEEN_CASTLE; }
+inline bool isEnPassantMove(Move move) { return moveFlag(move) == EN_PASSANT; }
+inline ePieceType promotionType(Move move) { return ePieceType(KNIGHT + (moveFlag(move) & 3)); }
+// isTacticalMove: captures and promotions, moves that change the material balance
+inline bool isTacticalMove(Move move)  { return (moveFlag(move) & (CAPTURE | PROMOTION)) != 0; }
+
+//    ScoredMove keeps an ordering score along with the move
+struct ScoredMove {
+    Move move;
+    int  score;
+};
+
+//    MoveList is a fixed size move container living on the stack,
+//    generation must not allocate in the search
+class MoveList {
+public:
+    MoveList() : m_size(0) {}
+
+    void add(Move move) { m_moves[m_size].move = move; m_moves[m_size].score = 0; m_size++; }
+    void clear() { m_size = 0; }
+    int  size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    bool contains(Move move) const
+    {
+        for (auto i = 0; i < m_size; i++)
+            if (m_moves[i].move == move) return true;
+        return false;
+    }
+
+    Move        move(int i) const { return m_moves[i].move; }
+    ScoredMove &operator[](int i) { return m_moves[i]; }
+    const ScoredMove &operator[](int i) const { return m_moves[i]; }
+
+    ScoredMove *begin() { return m_moves; }
+    ScoredMove *end()   { return m_moves + m_size; }
+    const ScoredMove *begin() const { return m_moves; }
+    const ScoredMove *end()   const { return m_moves + m_size; }
+
+private:
+    ScoredMove m_moves[MAX_MOVES];
+    int        m_size;
+};
+
+// == Scores ==
+
+//    Scores are in centipawns from the side to move point of view
+enum eValue {
+    VALUE_ZERO      = 0,
+    VALUE_DRAW      = 0,
+    VALUE_MATE      = 32000,
+    VALUE_INFINITE  = 32001,
+    VALUE_NONE      = 32002,
+
+    VALUE_MATE_IN_MAX_PLY  =  VALUE_MATE - MAX_PLY,
+    VALUE_MATED_IN_MAX_PLY = -VALUE_MATE + MAX_PLY,
+    // tablebase wins are below the mate scores and shorter by the plies to them
+    VALUE_TB_WIN            = VALUE_MATE_IN_MAX_PLY - 1,
+    VALUE_TB_WIN_IN_MAX_PLY = VALUE_TB_WIN - MAX_PLY
+};
+
+//    Score keeps the midgame and endgame values of an evaluation term,
+//    the evaluation interpolates between them by the game phase
+struct Score {
+    Score() : mg(0), eg(0) {}
+    Score(int mgValue, int egValue) : mg(mgValue), eg(egValue) {}
+
+    Score &operator+=(const Score &other) { mg += other.mg; eg += other.eg; return *this; }
+    Score &operator-=(const Score &other) { mg -= other.mg; eg -= other.eg; return *this; }
+    Score operator+(const Score &other) const { return Score(mg + other.mg, eg + other.eg); }
+    Score operator-(const Score &other) const { return Score(mg - other.mg, eg - other.eg); }
+    Score operator-() const { return Score(-mg, -eg); }
+    bool  operator==(const Score &other) const { return mg == other.mg && eg == other.eg; }
+
+    int mg;
+    int eg;
+};
+
+inline int mateIn(int ply)  { return VALUE_MATE - ply; }
+inline int matedIn(int ply) { return -VALUE_MATE + ply; }
+inline bool isMateScore(int score) { return qAbs(score) >= VALUE_MATE_IN_MAX_PLY && qAbs(score) <= VALUE_MATE; }
+inline bool isTbScore(int score) { return qAbs(score) >= VALUE_TB_WIN_IN_MAX_PLY && qAbs(score) < VALUE_MATE_IN_MAX_PLY; }
+
+}
+
+#endif//ENGINE_TYPES_H
@@ -0,0 +1,308 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "uci.h"
+#include "movegen.h"
+#include "tablebase.h"
+#include "dtm.h"
+#include "analysiscache.h"
+#include "nnue.h"
+#include "benchmark.h"
+
+namespace engine
+{
+
+namespace
+{
+
+// scoreToUci: centipawns or moves to mate as UCI expects them
+QString scoreToUci(int score)
+{
+    if (isMateScore(score)) {
+        int moves = score > 0 ? (VALUE_MATE - score + 1) / 2 : -(VALUE_MATE + score) / 2;
+        return QString("mate %1").arg(moves);
+    }
+    return QString("cp %1").arg(score);
+}
+
+// valueAfter: integer following the token or the default value
+qint64 valueAfter(const QStringList &tokens, const QString &name, qint64 defaultValue)
+{
+    int idx = tokens.indexOf(name);
+    if (idx == -1 || idx + 1 >= tokens.size())
+        return defaultValue;
+    bool ok = false;
+    qint64 value = tokens.at(idx + 1).toLongLong(&ok);
+    return ok ? value : defaultValue;
+}
+
+}
+
+//==============================================================
+//                      UciSearchThread
+//==============================================================
+
+void UciSearchThread::run()
+{
+    m_uci->m_searchDone(m_uci->m_search.go(m_uci->m_searchPosition, m_uci->m_limits));
+}
+
+
+//==============================================================
+//                          Uci
+//==============================================================
+
+Uci::Uci(QTextStream &in, QTextStream &out) : m_in(in), m_out(out), m_multiPv(1), m_ownBook(false), m_thread(this)
+{
+    m_search.setHashSize(DEFAULT_HASH_MB);
+    m_search.setInfoCallback([this](const SearchInfo &info) { m_info(info); });
+}
+
+Uci::~Uci()
+{
+    m_stopSearch();
+}
+
+void Uci::loop()
+{
+    while (!m_in.atEnd()) {
+        const QString line = m_in.readLine();
+        if (line.isNull() || !execute(line))
+            break;
+    }
+    m_stopSearch();
+}
+
+bool Uci::execute(const QString &line)
+{
+    const QStringList tokens = line.split(' ', QString::SkipEmptyParts);
+    if (tokens.isEmpty())
+        return true;
+
+    const QString &command = tokens.first();
+
+    if (command == "uci")             m_uci();
+    else if (command == "isready")    m_send("readyok");
+    else if (command == "setoption")  m_setOption(tokens);
+    else if (command == "position")   m_setPosition(tokens);
+    else if (command == "go")         m_go(tokens);
+    else if (command == "stop")       m_stopSearch();
+    else if (command == "ponderhit")  m_search.ponderHit();
+    else if (command == "ucinewgame") {
+        m_stopSearch();
+        m_search.newGame();
+    }
+    else if (command == "bench")      m_bench(tokens);
+    else if (command == "quit")       return false;
+    else m_send("info string unknown command " + command);
+
+    return true;
+}
+
+void Uci::m_uci()
+{
+    m_send("id name chess");
+    m_send("id author Comrade Andrew A.");
+    m_send(QString("option name Threads type spin default 1 min 1 max %1").arg(int(MAX_THREADS)));
+    m_send(QString("option name Hash type spin default %1 min 1 max %2").arg(int(DEFAULT_HASH_MB)).arg(int(MAX_HASH_MB)));
+    m_send("option name Ponder type check default false");
+    m_send(QString("option name MultiPV type spin default 1 min 1 max %1").arg(int(MAX_MOVES)));
+    m_send("option name OwnBook type check default false");
+    m_send("option name BookFile type string default <empty>");
+    m_send("option name SyzygyPath type string default <empty>");
+    m_send("option name DtmPath type string default <empty>");
+    m_send("option name AnalysisCache type string default <empty>");
+    m_send("option name EvalFile type string default <empty>");
+    m_send("uciok");
+}
+
+void Uci::m_setOption(const QStringList &tokens)
+{
+    // setoption name <id> [value <x>], the name may consist of several words
+    int nameIdx  = tokens.indexOf("name");
+    int valueIdx = tokens.indexOf("value");
+    if (nameIdx == -1)
+        return;
+    const QString name  = tokens.mid(nameIdx + 1, valueIdx == -1 ? -1 : valueIdx - nameIdx - 1).join(' ');
+    const QString value = valueIdx == -1 ? QString() : tokens.mid(valueIdx + 1).join(' ');
+
+    m_stopSearch(); // threads and table aren't resized under a running search
+
+    if (name.compare("Threads", Qt::CaseInsensitive) == 0)
+        m_search.setThreads(qBound(1, value.toInt(), int(MAX_THREADS)));
+    else if (name.compare("Hash", Qt::CaseInsensitive) == 0)
+        m_search.setHashSize(qBound(1, value.toInt(), int(MAX_HASH_MB)));
+    else if (name.compare("Ponder", Qt::CaseInsensitive) == 0)
+        ; // nothing to set up: the GUI decides when to send `go ponder`
+    else if (name.compare("MultiPV", Qt::CaseInsensitive) == 0)
+        m_multiPv = qBound(1, value.toInt(), int(MAX_MOVES));
+    else if (name.compare("OwnBook", Qt::CaseInsensitive) == 0)
+        m_ownBook = value.compare("true", Qt::CaseInsensitive) == 0;
+    else if (name.compare("BookFile", Qt::CaseInsensitive) == 0) {
+        if (value.isEmpty() || value == "<empty>")
+            m_book.close();
+        else if (!m_book.open(value))
+            m_send("info string cannot open book " + value);
+    }
+    else if (name.compare("SyzygyPath", Qt::CaseInsensitive) == 0) {
+        const int found = Tablebases::init(value == "<empty>" ? QString() : value);
+        m_send(QString("info string found %1 tablebases up to %2 pieces").arg(found).arg(Tablebases::maxPieces()));
+    }
+    else if (name.compare("DtmPath", Qt::CaseInsensitive) == 0) {
+        const int found = Dtm::init(value == "<empty>" ? QString() : value);
+        m_send(QString("info string found %1 distance to mate tables up to %2 pieces").arg(found).arg(Dtm::maxPieces()));
+    }
+    else if (name.compare("AnalysisCache", Qt::CaseInsensitive) == 0) {
+        if (value.isEmpty() || value == "<empty>")
+            AnalysisCache::close();
+        else if (AnalysisCache::open(value))
+            m_send(QString("info string analysis cache of %1 entries, %2 used").arg(AnalysisCache::entries()).arg(AnalysisCache::used()));
+        else
+            m_send("info string cannot open analysis cache " + value);
+
+        // the searches use the cache only if it has been asked for
+        SearchOptions options = m_search.options();
+        options.useAnalysisCache = AnalysisCache::isOpen();
+        m_search.setOptions(options);
+    }
+    else if (name.compare("EvalFile", Qt::CaseInsensitive) == 0) {
+        if (value.isEmpty() || value == "<empty>")
+            Nnue::unload();
+        else if (Nnue::load(value))
+            m_send(QString("info string neural network %1 loaded, %2 kernels").arg(value).arg(Nnue::simdName()));
+        else
+            m_send("info string cannot load neural network " + value);
+    }
+    else
+        m_send("info string unknown option " + name);
+}
+
+void Uci::m_setPosition(const QStringList &tokens)
+{
+    m_stopSearch();
+
+    int movesIdx = tokens.indexOf("moves");
+    if (tokens.size() > 1 && tokens.at(1) == "startpos") {
+        m_position.setFEN(Position::startFEN());
+    } else if (tokens.size() > 2 && tokens.at(1) == "fen") {
+        const QString fen = tokens.mid(2, movesIdx == -1 ? -1 : movesIdx - 2).join(' ');
+        if (!m_position.setFEN(fen)) {
+            m_send("info string invalid fen " + fen);
+            return;
+        }
+    } else {
+        return;
+    }
+
+    if (movesIdx == -1)
+        return;
+    for (auto i = movesIdx + 1; i < tokens.size(); i++) {
+        const Move move = moveFromString(m_position, tokens.at(i));
+        if (move == NO_MOVE) {
+            m_send("info string illegal move " + tokens.at(i));
+            return;
+        }
+        m_position.doMove(move);
+    }
+}
+
+void Uci::m_go(const QStringList &tokens)
+{
+    m_stopSearch();
+
+    SearchLimits limits;
+    limits.depth           = int(qBound(qint64(1), valueAfter(tokens, "depth", MAX_PLY - 1), qint64(MAX_PLY - 1)));
+    limits.nodes           = valueAfter(tokens, "nodes", 0);
+    limits.moveTime        = valueAfter(tokens, "movetime", 0);
+    limits.time[WHITE]     = valueAfter(tokens, "wtime", 0);
+    limits.time[BLACK]     = valueAfter(tokens, "btime", 0);
+    limits.increment[WHITE] = valueAfter(tokens, "winc", 0);
+    limits.increment[BLACK] = valueAfter(tokens, "binc", 0);
+    limits.movesToGo       = int(valueAfter(tokens, "movestogo", 0));
+    limits.infinite        = tokens.contains("infinite");
+    limits.ponder          = tokens.contains("ponder");
+    limits.multiPv         = m_multiPv;
+
+    // the book answers games at once, analysis and pondering always search
+    if (m_ownBook && !limits.infinite && !limits.ponder && limits.multiPv == 1) {
+        const Move bookMove = m_book.probe(m_position);
+        if (bookMove != NO_MOVE) {
+            m_send("bestmove " + moveToString(bookMove));
+            return;
+        }
+    }
+
+    m_limits = limits;
+    m_searchPosition = m_position;
+    m_thread.start();
+}
+
+void Uci::m_bench(const QStringList &tokens)
+{
+    m_stopSearch();
+
+    // positional arguments as in `bench 13 4 256`
+    bool ok = false;
+    const int depth   = tokens.size() > 1 ? tokens.at(1).toInt(&ok) : 0;
+    const int threads = tokens.size() > 2 ? tokens.at(2).toInt() : 0;
+    const int hashMB  = tokens.size() > 3 ? tokens.at(3).toInt() : 0;
+
+    QMutexLocker locker(&m_outMutex);
+    Benchmark::bench(m_out, ok ? qBound(1, depth, MAX_PLY - 1) : int(BENCH_DEPTH),
+                     threads > 0 ? qMin(threads, int(MAX_THREADS)) : 1,
+                     hashMB > 0 ? qMin(hashMB, int(MAX_HASH_MB)) : int(DEFAULT_HASH_MB));
+}
+
+void Uci::m_stopSearch()
+{
+    if (!m_thread.isRunning())
+        return;
+    m_search.stop();
+    m_thread.wait();
+}
+
+void Uci::m_searchDone(const SearchResult &result)
+{
+    QString line = "bestmove " + moveToString(result.bestMove);
+    if (result.ponderMove != NO_MOVE)
+        line += " ponder " + moveToString(result.ponderMove);
+    m_send(line);
+}
+
+void Uci::m_info(const SearchInfo &info)
+{
+    QString line = QString("info depth %1 seldepth %2 multipv %3 score %4 nodes %5 nps %6 hashfull %7 tbhits %8 time %9 pv")
+                   .arg(info.depth).arg(info.selDepth).arg(info.multiPv).arg(scoreToUci(info.score))
+                   .arg(info.nodes).arg(info.nodes * 1000 / qMax(qint64(1), info.time))
+                   .arg(info.hashfull).arg(info.tbHits).arg(info.time);
+    for (auto move : info.pv)
+        line += " " + moveToString(move);
+    m_send(line);
+}
+
+void Uci::m_send(const QString &line)
+{
+    QMutexLocker locker(&m_outMutex);
+    m_out << line << "\n";
+    m_out.flush();
+}
+
+}
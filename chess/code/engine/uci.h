@@ -0,0 +1,111 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ENGINE_UCI_H
+#define ENGINE_UCI_H
+
+#include <QTextStream>
+#include <QStringList>
+#include <QMutex>
+#include <QThread>
+
+#include "search.h"
+#include "book.h"
+
+//==============================================================
+//                      UCI protocol
+//==============================================================
+
+namespace engine
+{
+
+class Uci;
+
+//    UciSearchThread runs Search::go() while the protocol loop keeps
+//    reading commands, so `stop` and `ponderhit` are handled at once
+class UciSearchThread : public QThread {
+public:
+    explicit UciSearchThread(Uci *uci) : m_uci(uci) {}
+
+protected:
+    void run();
+
+private:
+    Uci *m_uci;
+};
+
+//    Uci speaks the Universal Chess Interface over text streams:
+//      uci, isready, ucinewgame, setoption name Threads|Hash|Ponder|MultiPV|OwnBook|BookFile|SyzygyPath|DtmPath value X,
+//      position startpos|fen <fen> [moves <move> ...],
+//      go [depth N] [nodes N] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms]
+//         [movestogo N] [infinite] [ponder],
+//      stop, ponderhit, quit,
+//      bench [depth] [threads] [hash MB] - node count signature of the search, see Benchmark::bench
+class Uci {
+public:
+    Uci(QTextStream &in, QTextStream &out);
+    ~Uci();
+
+    // loop: reads commands until `quit` or the end of the input
+    void    loop();
+    // execute: handles a single command line, returns false on `quit`
+    bool    execute(const QString &line);
+
+private:
+    friend class UciSearchThread;
+
+    enum {
+        DEFAULT_HASH_MB = 16,
+        MAX_HASH_MB     = 4096,
+        MAX_THREADS     = 512,
+        BENCH_DEPTH     = 11
+    };
+
+    void    m_uci();
+    void    m_setOption(const QStringList &tokens);
+    void    m_setPosition(const QStringList &tokens);
+    void    m_go(const QStringList &tokens);
+    void    m_bench(const QStringList &tokens);
+    // m_stopSearch: stops the running search and waits for its bestmove
+    void    m_stopSearch();
+    // m_searchDone: called from the search thread when Search::go() returns
+    void    m_searchDone(const SearchResult &result);
+    void    m_info(const SearchInfo &info);
+    // m_send: writes a line, the search thread and the protocol loop share the output
+    void    m_send(const QString &line);
+
+    QTextStream    &m_in;
+    QTextStream    &m_out;
+    QMutex          m_outMutex;
+
+    Search          m_search;
+    Position        m_position;
+    Position        m_searchPosition; // copy of the root while the search thread uses it
+    SearchLimits    m_limits;
+    int             m_multiPv;
+    Book            m_book;
+    bool            m_ownBook; // play the book moves instead of searching
+    UciSearchThread m_thread;
+};
+
+}
+
+#endif//ENGINE_UCI_H
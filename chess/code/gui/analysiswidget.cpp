@@ -0,0 +1,217 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "analysiswidget.h"
+#include "engine/movegen.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QThread>
+#include <QEvent>
+
+//==============================================================
+//                      AnalysisWidget
+//==============================================================
+
+AnalysisWidget::AnalysisWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    m_searchId = 0;
+    m_hasPosition = false;
+    m_isWhiteToMove = true;
+    m_isDirty = false;
+
+    // leave a core to the GUI and the network
+    m_engine.setThreads(qMax(1, QThread::idealThreadCount() - 1));
+    m_engine.setHashSize(64);
+    // positions studied in the earlier sessions are shown at once
+    m_engine.setAnalysisCache(true);
+    connect(&m_engine, SIGNAL(searchInfo(int, const engine::SearchInfo&)),
+            this, SLOT(searchInfo(int, const engine::SearchInfo&)));
+
+    m_enableBox = new QCheckBox(tr("Analysis"), this);
+    m_linesBox = new QSpinBox(this);
+    m_linesBox->setRange(1, maxLines());
+    m_linesBox->setValue(3);
+    m_linesBox->setSuffix(tr(" lines"));
+
+    // score, depth and the line itself
+    m_linesTable = new QTableWidget(0, 3, this);
+    m_linesTable->horizontalHeader()->hide();
+    m_linesTable->verticalHeader()->hide();
+    m_linesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    m_linesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    m_linesTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    m_linesTable->setSelectionMode(QAbstractItemView::NoSelection);
+    m_linesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_linesTable->setEnabled(false);
+
+    auto header = new QHBoxLayout;
+    header->addWidget(m_enableBox);
+    header->addStretch();
+    header->addWidget(m_linesBox);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(header);
+    layout->addWidget(m_linesTable);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(1000 / refreshRate());
+    connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshLines()));
+
+    connect(m_enableBox, SIGNAL(toggled(bool)), this, SLOT(setAnalysisEnabled(bool)));
+    connect(m_linesBox, SIGNAL(valueChanged(int)), this, SLOT(setLinesCount(int)));
+}
+
+AnalysisWidget::~AnalysisWidget()
+{
+    m_engine.stop();
+}
+
+void AnalysisWidget::setPosition(const QString &fen, const QStringList &moves)
+{
+    m_fen = fen;
+    m_moves = moves;
+    m_hasPosition = true;
+
+    // side to move of the FEN, changed by every move after it
+    m_isWhiteToMove = (fen.section(' ', 1, 1) != "b") == (moves.size() % 2 == 0);
+
+    m_restart();
+}
+
+void AnalysisWidget::clearPosition()
+{
+    m_hasPosition = false;
+    m_restart();
+}
+
+void AnalysisWidget::setAnalysisEnabled(bool isEnabled)
+{
+    if (m_enableBox->isChecked() != isEnabled)
+        m_enableBox->setChecked(isEnabled); // comes back through toggled()
+    else
+        m_restart();
+}
+
+void AnalysisWidget::setLinesCount(int count)
+{
+    if (m_linesBox->value() != count)
+        m_linesBox->setValue(count); // comes back through valueChanged()
+    else
+        m_restart();
+}
+
+void AnalysisWidget::searchInfo(int id, const engine::SearchInfo &info)
+{
+    // reports of a cancelled search may still be in the queue
+    if (id != m_searchId || info.multiPv < 1 || info.multiPv > maxLines())
+        return;
+
+    if (m_lines.size() < info.multiPv)
+        m_lines.resize(info.multiPv);
+    m_lines[info.multiPv - 1] = info;
+    m_isDirty = true;
+}
+
+void AnalysisWidget::refreshLines()
+{
+    if (!m_isDirty)
+        return;
+    m_isDirty = false;
+
+    m_linesTable->setRowCount(m_lines.size());
+    for (auto row = 0; row < m_lines.size(); row++) {
+        const engine::SearchInfo &info = m_lines.at(row);
+
+        QStringList line;
+        for (auto move : info.pv)
+            line.append(engine::moveToString(move));
+
+        const QString cells[3] = {
+            info.pv.isEmpty() ? QString() : m_formatScore(info.score),
+            info.pv.isEmpty() ? QString() : QString::number(info.depth),
+            line.join(' ')
+        };
+        for (auto col = 0; col < 3; col++) {
+            auto item = m_linesTable->item(row, col);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                m_linesTable->setItem(row, col, item);
+            }
+            item->setText(cells[col]);
+        }
+    }
+}
+
+void AnalysisWidget::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
+    {
+        m_enableBox->setText(tr("Analysis"));
+        m_linesBox->setSuffix(tr(" lines"));
+    }
+
+    QWidget::changeEvent(event);
+}
+
+void AnalysisWidget::m_restart()
+{
+    // the lines of the previous position are gone at once, not on the next redraw
+    m_lines.clear();
+    m_isDirty = true;
+    refreshLines();
+
+    const bool isAnalysing = m_enableBox->isChecked() && m_hasPosition;
+    m_linesTable->setEnabled(isAnalysing);
+    if (!isAnalysing) {
+        m_refreshTimer->stop();
+        m_engine.stop();
+        m_searchId = 0;
+        return;
+    }
+
+    engine::SearchLimits limits;
+    limits.infinite = true;
+    limits.multiPv = m_linesBox->value();
+    // stops the running search, its reports are told apart by the id
+    m_searchId = m_engine.start(m_fen, m_moves, limits);
+    if (!m_refreshTimer->isActive())
+        m_refreshTimer->start();
+}
+
+QString AnalysisWidget::m_formatScore(int score) const
+{
+    // the engine scores are from the side to move
+    if (!m_isWhiteToMove)
+        score = -score;
+
+    if (engine::isMateScore(score)) {
+        int movesToMate = score > 0 ? (engine::VALUE_MATE - score + 1) / 2 : -(engine::VALUE_MATE + score) / 2;
+        return QString("#%1").arg(movesToMate);
+    }
+    // a won tablebase position has no number of moves to mate, for White as the other scores
+    if (engine::isTbScore(score))
+        return score > 0 ? tr("TB win") : tr("TB loss");
+    return QString("%1%2").arg(score > 0 ? "+" : "").arg(score / 100.0, 0, 'f', 2);
+}
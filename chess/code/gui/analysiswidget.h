@@ -0,0 +1,92 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef ANALYSIS_WIDGET_H
+#define ANALYSIS_WIDGET_H
+
+#include <QWidget>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVector>
+
+#include "engine/engine.h"
+
+//==============================================================
+//                      AnalysisWidget
+//==============================================================
+
+//    AnalysisWidget keeps the engine searching the position shown on the board
+//    and lists the best lines. The engine reports every iteration of every line,
+//    the table is redrawn at a fixed refresh rate with the latest of them
+class AnalysisWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit AnalysisWidget(QWidget *parent = Q_NULLPTR);
+    ~AnalysisWidget();
+
+    // Redraws of the lines per second
+    static inline int refreshRate() { return 20; }
+    static inline int maxLines() { return 5; }
+
+public slots:
+    // setPosition:
+    //      Cancels the analysis of the previous position and starts the new one at once,
+    //      the lines of the previous position are cleared on the spot
+    void setPosition(const QString &fen, const QStringList &moves);
+    // clearPosition: stops the analysis until the next position is set
+    void clearPosition();
+    void setAnalysisEnabled(bool isEnabled = true);
+    void setLinesCount(int count);
+
+private slots:
+    void searchInfo(int id, const engine::SearchInfo &info);
+    void refreshLines(); // Slot for the refresh timer
+
+protected:
+    void changeEvent(QEvent *);
+
+private:
+    // m_restart: stops the running search and starts the one of the current position
+    void    m_restart();
+    // m_formatScore: score from white's point of view, in pawns or moves to mate
+    QString m_formatScore(int score) const;
+
+    engine::Engine  m_engine;
+    int             m_searchId;
+
+    QCheckBox      *m_enableBox;
+    QSpinBox       *m_linesBox;
+    QTableWidget   *m_linesTable;
+    QTimer         *m_refreshTimer;
+
+    QString         m_fen;
+    QStringList     m_moves;
+    bool            m_hasPosition;
+    bool            m_isWhiteToMove;
+
+    QVector<engine::SearchInfo> m_lines; // the latest info of each line
+    bool            m_isDirty;           // lines have changed since the last redraw
+};
+
+#endif//ANALYSIS_WIDGET_H
@@ -38,6 +38,7 @@ BoardInterface::BoardInterface(QWidget * parent) : QWidget(parent) {
 
     auto selectionModel = ui.tableMovesPGN->selectionModel();
     connect(selectionModel, SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(moveSelected()));
+    connect(ui.gameExplorer, SIGNAL(gameChosen(const QStringList &, int)), this, SIGNAL(gameChosen(const QStringList &, int)));
 }
 
 BoardInterface::~BoardInterface() {
@@ -85,6 +86,20 @@ void BoardInterface::selectLastMove()
     ui.tableMovesPGN->setCurrentCell((movesCount - 1) / 2, (movesCount - 1) % 2);
 }
 
+void BoardInterface::analysePosition(const QString &fen, const QStringList &moves)
+{
+    ui.analysisPanel->setPosition(fen, moves);
+    ui.openingExplorer->setPosition(fen, moves);
+    ui.gameExplorer->setPosition(fen, moves);
+}
+
+void BoardInterface::stopAnalysis()
+{
+    ui.analysisPanel->clearPosition();
+    ui.openingExplorer->clearPosition();
+    ui.gameExplorer->clearPosition();
+}
+
 void BoardInterface::on_proposeTakeback_clicked() {
     emit proposeTakeback_clicked();
 }
@@ -39,6 +39,9 @@ public:
 public slots:
     void moveSelected(); // Slot for table selection model
     void selectLastMove(); // Slot for UI board to reset selection
+    // analysePosition: restarts the analysis panel, the book moves and the games on the position shown by the board
+    void analysePosition(const QString &fen, const QStringList &moves);
+    void stopAnalysis();
 
 private slots:
     void on_proposeTakeback_clicked();
@@ -50,6 +53,7 @@ signals:
     void offerDraw_clicked();
     void resign_clicked();
     void moveSelected(int index);
+    void gameChosen(const QStringList &coordinateMoves, int ply); // a game of the game database to open
 
 private:
 	Ui::BoardInterface ui;
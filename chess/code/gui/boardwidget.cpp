@@ -21,6 +21,7 @@
 *******************************************************************************/
 #include "boardwidget.h"
 #include "utilities/chessutilities.h"
+#include "engine/position.h"
 
 #include <QPainter>
 
@@ -515,7 +516,7 @@ BoardWidget::BoardWidget(QWidget* parent)
     m_awatingWidget->setGeometry(17 + 128, 32 + 128, 256, 256);
 
     m_boardInterface = new BoardInterface(this);
-    m_boardInterface->setGeometry(545, 112, m_boardInterface->width(), m_boardInterface->height());
+    m_boardInterface->setGeometry(545, 29, m_boardInterface->width(), m_boardInterface->height());
     
     m_boardWrapper = new QWidget(this);
     m_boardWrapper->setGeometry(17, 32, 512, 512 + 20); // Shift and size of board + menu height
@@ -576,6 +577,7 @@ BoardWidget::BoardWidget(QWidget* parent)
 
     // Connect widgets
     connect(m_boardInterface, SIGNAL(moveSelected(int)), this, SLOT(scrollMoves(int)));
+    connect(m_boardInterface, SIGNAL(gameChosen(const QStringList &, int)), this, SIGNAL(gameChosen(const QStringList &, int)));
 
     // Set theme to default
     setCurrentTheme(&m_defaultTheme);
@@ -597,6 +599,7 @@ void BoardWidget::setBoard(Chessboard *board)
         resetBoardPieces();
         // clear the last move
         setLastMove(QPair<Square, Square>(Square(Position(0, 0)), Square(Position(0, 0))));
+        m_boardInterface->stopAnalysis();
         return;
     } 
     // m_board is valid
@@ -606,7 +609,9 @@ void BoardWidget::setBoard(Chessboard *board)
     setupBoardPieces();
     updateView(); 
     connect(m_board, SIGNAL(moveStateScrolled()), this, SLOT(updateView()));
+    connect(m_board, SIGNAL(moveStateScrolled()), this, SLOT(analyseCurrentPosition()));
     connect(m_board, SIGNAL(moveDone(const QString&)), this, SLOT(moveDone(const QString&)));
+    analyseCurrentPosition();
 }
 
 Chessboard *BoardWidget::getBoard()
@@ -808,6 +813,20 @@ void BoardWidget::scrollMoves(int index)
     }
 }
 
+void BoardWidget::analyseCurrentPosition()
+{
+    if (m_board) {
+        // the board always starts from the initial position
+        m_boardInterface->analysePosition(engine::Position::startFEN(),
+                                          m_board->getMovesInCoordinates(m_board->getCurrentMoveIndex()));
+    }
+}
+
+void BoardWidget::stopAnalysis()
+{
+    m_boardInterface->stopAnalysis();
+}
+
 void BoardWidget::moveDone(const QString& moveInPGN)
 {
     int teamCol, moveRow;
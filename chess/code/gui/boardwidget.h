@@ -231,11 +231,17 @@ public slots:
     void setBoardRotation(eColor);
 
     void scrollMoves(int index);
+    void analyseCurrentPosition(); // Slot for Chessboard to restart the analysis on scroll
+    void stopAnalysis(); // the game is over, scrolling back restarts the analysis
 
     void moveDone(const QString&);
     void enableWaiting(const QString&);
     void disableWaiting();
 
+signals:
+    // gameChosen: a game of the game database to open on the board at the ply
+    void gameChosen(const QStringList &coordinateMoves, int ply);
+
 private:
     void m_updateMoveTiles(); // updates geometry of MoveTilesWrappers
     void m_updatePieceWrappers(); // updates geometry of PieceWrappers
@@ -74,7 +74,7 @@ void CreateDialog::slidersMoved()
         config.timeControl = GameConfig::UNLIMITED;
     else if (ui.timeControlBox->currentIndex() == 1) // Real time
         config.timeControl = GameConfig::TIMER;
-    config.timeLeft = minutes;
+    config.timeLeft = minutes * 60; // GameConfig keeps seconds
     config.increment = seconds;
 }
 
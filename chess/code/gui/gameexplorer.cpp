@@ -0,0 +1,233 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "gameexplorer.h"
+#include "engine/movegen.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QEvent>
+
+//==============================================================
+//                      GameExplorer
+//==============================================================
+
+GameExplorer::GameExplorer(QWidget *parent)
+    : QWidget(parent)
+{
+    m_hasPosition = false;
+    m_hitCount = 0;
+    m_indexThread = nullptr;
+
+    m_openButton = new QPushButton(this);
+    m_databaseLabel = new QLabel(this);
+
+    // players, result and the move the position is reached at
+    m_gamesTable = new QTableWidget(0, 3, this);
+    m_gamesTable->horizontalHeader()->hide();
+    m_gamesTable->verticalHeader()->hide();
+    m_gamesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_gamesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    m_gamesTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+    m_gamesTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_gamesTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_gamesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    auto header = new QHBoxLayout;
+    header->addWidget(m_databaseLabel);
+    header->addStretch();
+    header->addWidget(m_openButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(header);
+    layout->addWidget(m_gamesTable);
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(REFRESH_DELAY);
+
+    m_retranslate();
+
+    connect(m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshGames()));
+    connect(m_openButton, SIGNAL(clicked()), this, SLOT(chooseDatabase()));
+    // queued: opening the game replaces the position and so the rows of the table
+    connect(m_gamesTable, SIGNAL(cellDoubleClicked(int, int)), this, SLOT(openGame(int)), Qt::QueuedConnection);
+}
+
+GameExplorer::~GameExplorer()
+{
+    m_stopIndexing();
+}
+
+void GameExplorer::setPosition(const QString &fen, const QStringList &moves)
+{
+    m_hasPosition = m_position.setFEN(fen);
+    for (auto i = 0; m_hasPosition && i < moves.size(); i++) {
+        engine::Move move = engine::moveFromString(m_position, moves.at(i));
+        if (move == engine::NO_MOVE)
+            m_hasPosition = false;
+        else
+            m_position.doMove(move);
+    }
+    m_refreshTimer->start(); // restarts the delay
+}
+
+void GameExplorer::clearPosition()
+{
+    m_hasPosition = false;
+    m_refreshTimer->start();
+}
+
+bool GameExplorer::openDatabase(const QString &fileName)
+{
+    m_stopIndexing();
+
+    bool isOpen = false;
+    if (fileName.isEmpty())
+        m_database.close();
+    else
+        isOpen = m_database.open(fileName);
+
+    if (isOpen && m_database.indexedGames() < m_database.size()) {
+        m_indexThread = new IndexThread(m_database, engine::GameDatabase::indexFileName(fileName) + ".new");
+        connect(m_indexThread, SIGNAL(finished()), this, SLOT(indexBuilt()));
+        m_indexThread->start(QThread::LowPriority);
+    }
+
+    m_refreshTimer->stop();
+    refreshGames();
+    return isOpen;
+}
+
+void GameExplorer::chooseDatabase()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open game database"), QString(),
+                                                    tr("Game database (*.cgd);;All files (*)"));
+    if (!fileName.isEmpty())
+        openDatabase(fileName);
+}
+
+void GameExplorer::openGame(int row)
+{
+    if (row < 0 || row >= m_hits.size())
+        return;
+
+    // the board plays from the initial position only
+    engine::GameList games;
+    const engine::GameHit hit = m_hits.at(row);
+    if (!m_database.readGame(hit.game, games) || games.startFEN(0) != engine::Position::startFEN())
+        return;
+
+    QStringList moves;
+    for (auto ply = 0; ply < games.plies(0); ply++)
+        moves.append(engine::moveToString(games.moves(0)[ply]));
+    emit gameChosen(moves, hit.ply);
+}
+
+void GameExplorer::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
+        m_retranslate();
+
+    QWidget::changeEvent(event);
+}
+
+void GameExplorer::refreshGames()
+{
+    m_hits.clear();
+    m_hitCount = 0;
+    if (m_hasPosition && m_database.isOpen())
+        m_hitCount = m_database.find(m_position, m_hits, MAX_LISTED_GAMES);
+
+    // the tags come from the games themselves, only the listed ones are read
+    engine::GameList games;
+    for (auto i = 0; i < m_hits.size();) {
+        if (m_database.readGame(m_hits.at(i).game, games))
+            i++;
+        else
+            m_hits.remove(i);
+    }
+
+    m_gamesTable->setRowCount(games.size());
+    for (auto row = 0; row < games.size(); row++) {
+        const QString cells[3] = {
+            QString("%1 - %2").arg(games.tag(row, "White"), games.tag(row, "Black")),
+            engine::GameList::resultToString(games.result(row)),
+            QString::number(m_hits.at(row).ply / 2 + 1)
+        };
+        for (auto col = 0; col < 3; col++) {
+            auto item = m_gamesTable->item(row, col);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                m_gamesTable->setItem(row, col, item);
+            }
+            item->setText(cells[col]);
+        }
+    }
+    m_retranslate();
+}
+
+void GameExplorer::indexBuilt()
+{
+    // the signal of a thread stopped by m_stopIndexing() may come after it
+    if (m_indexThread == nullptr || !m_indexThread->isFinished())
+        return;
+
+    // the games not in the index are still found if it failed
+    m_indexThread->wait();
+    if (m_indexThread->isOk())
+        m_database.replaceIndex(m_indexThread->fileName());
+    delete m_indexThread;
+    m_indexThread = nullptr;
+
+    m_refreshTimer->stop();
+    refreshGames();
+}
+
+void GameExplorer::m_stopIndexing()
+{
+    if (m_indexThread == nullptr)
+        return;
+
+    m_indexThread->cancel();
+    m_indexThread->wait();
+    delete m_indexThread;
+    m_indexThread = nullptr;
+}
+
+void GameExplorer::m_retranslate()
+{
+    m_openButton->setText(tr("Open database..."));
+    QString name = QFileInfo(m_database.fileName()).fileName();
+    if (m_indexThread)
+        name = tr("%1 (indexing)").arg(name);
+
+    if (!m_database.isOpen())
+        m_databaseLabel->setText(tr("No database"));
+    else if (!m_hasPosition)
+        m_databaseLabel->setText(name);
+    else
+        m_databaseLabel->setText(tr("%1: %2 games").arg(name).arg(m_hitCount));
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef GAME_EXPLORER_H
+#define GAME_EXPLORER_H
+
+#include <QWidget>
+#include <QPushButton>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QThread>
+
+#include "engine/gamedb.h"
+
+//==============================================================
+//                      GameExplorer
+//==============================================================
+
+//    IndexThread writes the index of a database beside the one it has,
+//    the database keeps being searched on the GUI thread meanwhile
+class IndexThread : public QThread {
+public:
+    IndexThread(const engine::GameDatabase &database, const QString &fileName)
+        : m_database(database), m_fileName(fileName), m_isOk(false) { m_cancel.store(0); }
+
+    const QString &fileName() const { return m_fileName; }
+    // isOk: the index is complete, valid once the thread is finished
+    bool    isOk() const { return m_isOk; }
+    void    cancel() { m_cancel.storeRelease(1); }
+
+protected:
+    void run() { m_isOk = m_database.writeIndex(m_fileName, engine::GameDatabase::DEFAULT_BUILD_MB, &m_cancel); }
+
+private:
+    const engine::GameDatabase &m_database;
+    const QString               m_fileName;
+    bool                        m_isOk;
+    QAtomicInt                  m_cancel;
+};
+
+//    GameExplorer lists the games of a game database reaching the position
+//    shown on the board, found by the position index of the database.
+//    The list follows the board REFRESH_DELAY after the last change of the
+//    position, scrolling through a game doesn't search every position of it.
+//    A double click on a game opens it on the board at that position
+class GameExplorer : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit GameExplorer(QWidget *parent = Q_NULLPTR);
+    ~GameExplorer();
+
+public slots:
+    void setPosition(const QString &fen, const QStringList &moves);
+    void clearPosition();
+    // openDatabase:
+    //      An empty name closes the database. If the games aren't all in the index
+    //      it is built on its own thread and replaces the old one when done, the
+    //      games out of the index are replayed by the search until then
+    bool openDatabase(const QString &fileName);
+
+signals:
+    // gameChosen: the moves of the game in coordinate notation and the ply of the position
+    void gameChosen(const QStringList &coordinateMoves, int ply);
+
+private slots:
+    void chooseDatabase(); // Slot for the open button
+    void openGame(int row); // Slot for a double click on a game
+    void refreshGames();
+    void indexBuilt();
+
+protected:
+    void changeEvent(QEvent *);
+
+private:
+    enum {
+        MAX_LISTED_GAMES = 200,
+        REFRESH_DELAY    = 150  // milliseconds
+    };
+
+    void m_retranslate();
+    // m_stopIndexing: cancels the index being built, the database may be closed then
+    void m_stopIndexing();
+
+    engine::GameDatabase     m_database;
+    engine::Position         m_position;
+    bool                     m_hasPosition;
+    QVector<engine::GameHit> m_hits;
+    int                      m_hitCount;
+
+    QPushButton        *m_openButton;
+    QLabel             *m_databaseLabel;
+    QTableWidget       *m_gamesTable;
+    QTimer             *m_refreshTimer;
+    IndexThread        *m_indexThread; // nullptr if the index isn't being built
+};
+
+#endif//GAME_EXPLORER_H
@@ -0,0 +1,149 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include "openingexplorer.h"
+#include "engine/movegen.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QEvent>
+
+//==============================================================
+//                      OpeningExplorer
+//==============================================================
+
+OpeningExplorer::OpeningExplorer(QWidget *parent)
+    : QWidget(parent)
+{
+    m_hasPosition = false;
+
+    m_openButton = new QPushButton(this);
+    m_bookLabel = new QLabel(this);
+
+    // move and its share of the weight
+    m_movesTable = new QTableWidget(0, 2, this);
+    m_movesTable->horizontalHeader()->hide();
+    m_movesTable->verticalHeader()->hide();
+    m_movesTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_movesTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    m_movesTable->setSelectionMode(QAbstractItemView::NoSelection);
+    m_movesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    auto header = new QHBoxLayout;
+    header->addWidget(m_bookLabel);
+    header->addStretch();
+    header->addWidget(m_openButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(header);
+    layout->addWidget(m_movesTable);
+
+    m_retranslate();
+
+    connect(m_openButton, SIGNAL(clicked()), this, SLOT(chooseBook()));
+}
+
+void OpeningExplorer::setPosition(const QString &fen, const QStringList &moves)
+{
+    m_hasPosition = m_position.setFEN(fen);
+    for (auto i = 0; m_hasPosition && i < moves.size(); i++) {
+        engine::Move move = engine::moveFromString(m_position, moves.at(i));
+        if (move == engine::NO_MOVE)
+            m_hasPosition = false;
+        else
+            m_position.doMove(move);
+    }
+    m_refreshMoves();
+}
+
+void OpeningExplorer::clearPosition()
+{
+    m_hasPosition = false;
+    m_refreshMoves();
+}
+
+bool OpeningExplorer::openBook(const QString &fileName)
+{
+    bool isOpen = false;
+    if (fileName.isEmpty())
+        m_book.close();
+    else
+        isOpen = m_book.open(fileName);
+
+    m_retranslate();
+    m_refreshMoves();
+    return isOpen;
+}
+
+void OpeningExplorer::chooseBook()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open book"), QString(),
+                                                    tr("Polyglot book (*.bin)"));
+    if (!fileName.isEmpty())
+        openBook(fileName);
+}
+
+void OpeningExplorer::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
+        m_retranslate();
+
+    QWidget::changeEvent(event);
+}
+
+void OpeningExplorer::m_refreshMoves()
+{
+    QVector<engine::BookMove> moves;
+    if (m_hasPosition && m_book.isOpen())
+        moves = m_book.moves(m_position);
+
+    int totalWeight = 0;
+    for (const auto &bookMove : moves)
+        totalWeight += bookMove.weight;
+
+    m_movesTable->setRowCount(moves.size());
+    for (auto row = 0; row < moves.size(); row++) {
+        const engine::BookMove &bookMove = moves.at(row);
+        const QString cells[2] = {
+            engine::moveToString(bookMove.move),
+            totalWeight > 0 ? QString("%1%").arg(100.0 * bookMove.weight / totalWeight, 0, 'f', 1)
+                            : QString()
+        };
+        for (auto col = 0; col < 2; col++) {
+            auto item = m_movesTable->item(row, col);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                m_movesTable->setItem(row, col, item);
+            }
+            item->setText(cells[col]);
+        }
+    }
+}
+
+void OpeningExplorer::m_retranslate()
+{
+    m_openButton->setText(tr("Open book..."));
+    m_bookLabel->setText(m_book.isOpen() ? QFileInfo(m_book.fileName()).fileName() : tr("No book"));
+}
@@ -0,0 +1,70 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#ifndef OPENING_EXPLORER_H
+#define OPENING_EXPLORER_H
+
+#include <QWidget>
+#include <QPushButton>
+#include <QLabel>
+#include <QTableWidget>
+
+#include "engine/book.h"
+
+//==============================================================
+//                      OpeningExplorer
+//==============================================================
+
+//    OpeningExplorer lists the book moves of the position shown on the board
+//    with their share of the total weight. The book file is mapped, not read,
+//    so following the game costs a binary search per position
+class OpeningExplorer : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit OpeningExplorer(QWidget *parent = Q_NULLPTR);
+
+public slots:
+    void setPosition(const QString &fen, const QStringList &moves);
+    void clearPosition();
+    // openBook: an empty name closes the book
+    bool openBook(const QString &fileName);
+
+private slots:
+    void chooseBook(); // Slot for the open button
+
+protected:
+    void changeEvent(QEvent *);
+
+private:
+    void m_refreshMoves();
+    void m_retranslate();
+
+    engine::Book        m_book;
+    engine::Position    m_position;
+    bool                m_hasPosition;
+
+    QPushButton        *m_openButton;
+    QLabel             *m_bookLabel;
+    QTableWidget       *m_movesTable;
+};
+
+#endif//OPENING_EXPLORER_H
@@ -20,6 +20,8 @@
 * SOFTWARE.
 *******************************************************************************/
 #include "chessboard.h"
+#include "engine/movegen.h"
+#include "engine/tablebase.h"
 #include <QtAlgorithms>
 #include <QDebug>
 
@@ -321,6 +323,10 @@ Chessboard::Chessboard(GameConfig _config)
 
     m_nMovesWithoutCapture = 0;
     m_moveStackIterator    = -1;
+    m_isTablebaseResultDeclared = false;
+    m_promotionType = QUEEN;
+    m_isReplaying = false;
+    m_lastMovesKey = -1;
     m_teamToMove           = WHITE;
 
     // Initializing the last board data
@@ -383,44 +389,16 @@ bool Chessboard::isStalemate()
 
 eCheckMateSate Chessboard::isKingCheckmated(eColor kingColor) const
 {
-    auto piecesData = m_lastPiecesData;
-    
-    // If result is in NOCHECK state, then the king is safe
-    if (m_isKingUnderCheck(kingColor, piecesData) == false) return NOCHECK;
-
-    auto getPieceDataAt = [&](Square square) {
-        return m_getPieceDataIdx(piecesData, square);
-    };
-
-    // Here result is CHECK, we should look if king side pieces have any move to protect the king
-    bool isThereUncheckMove = false;
-    for (auto i = 0; i < piecesData.size(); i++) {
-        if (piecesData[i].color == kingColor && piecesData[i].isTaken == false)
-        {   // Looking for moves of king mates and king itself
-            // getting moves without check for CHECKMATE otherwise it would loop 
-            auto moves = getPossibleMoves(piecesData[i], false);
-            for each (auto move in moves)
-            {
-                // Make a move
-                if (move.idxPieceToCapture != -1) {
-                    piecesData[move.idxPieceToCapture].isTaken = true;
-                }
-                piecesData[i].moveToSquare(move.square);
-
-                // check if the king is NOT more under CHECK
-                if (m_isKingUnderCheck(kingColor, piecesData) == false) {
-                    isThereUncheckMove = true;
-                    break; // breaks `for` and doesn't reset data
-                }
-                piecesData = m_lastPiecesData; // reset data after every move has been checked
-            }
-            piecesData = m_lastPiecesData; // reset data after every piece has been checked
-        }
-        if (isThereUncheckMove) break; // move has been found
-    }
-
-    if (isThereUncheckMove) return CHECK_STATE;
-    else return CHECKMATE_STATE; // if there is no such a move king is CHECKMATED
+    engine::Position pos;
+    if (!pos.setFEN(m_getPositionInFEN(m_lastPiecesData, kingColor)) || !pos.inCheck())
+        return NOCHECK;
+
+    // the king is under CHECK, any legal move of the king side protects it
+    engine::MoveList moves;
+    engine::generateLegalMoves(pos, moves);
+    if (moves.isEmpty())
+        return CHECKMATE_STATE;
+    return CHECK_STATE;
 }
 
 QVector<Move> Chessboard::getPossibleMoves(const PieceData &piece, bool checkmateValidation) const
@@ -467,7 +445,8 @@ void Chessboard::scrollToMove(int index)
     else
         m_teamToMove = WHITE;
 
-    emit moveStateScrolled();
+    if (!m_isReplaying)
+        emit moveStateScrolled();
 }
 
 int Chessboard::getCurrentMoveIndex() const
@@ -535,6 +514,63 @@ QVector<PieceData> Chessboard::getBoardStateAfter(int moveIndex)
     return piecesData;
 }
 
+QStringList Chessboard::getMovesInCoordinates(int moveIndex) const
+{
+    QStringList moves;
+    for (auto i = 0; i < m_moveStack.size() && i <= moveIndex; i++)
+        moves.append(m_getMoveInCoordinates(m_moveStack[i]));
+    return moves;
+}
+
+int Chessboard::playMoves(const QStringList &coordinateMoves)
+{
+    auto toSquare = [](const QString &text) {
+        return Square(Position(text.at(0).toUpper().toLatin1(), text.at(1).digitValue()));
+    };
+
+    const QString promotionLetters("qrbn");
+    const ePieceType promotions[] = { QUEEN, ROOK, BISHOP, KNIGHT };
+
+    // the view is updated and the position analysed once, after the last move
+    m_isReplaying = true;
+    int played = 0;
+    for (const auto &text : coordinateMoves) {
+        const int promotionIdx = text.size() > 4 ? promotionLetters.indexOf(text.at(4)) : 0;
+        if (text.size() < 4 || promotionIdx == -1)
+            break;
+        if (m_moveStackIterator != (m_moveStack.size() - 1)) // moves are made in the last position only
+            break;
+
+        const Square from = toSquare(text);
+        const Square to = toSquare(text.mid(2));
+        Piece *piece = from.isValid() && to.isValid() ? getPieceAt(from, m_teamToMove) : nullptr;
+        const int pieceIdx = m_findPieceDataIndex(piece, m_lastPiecesData);
+        if (pieceIdx == -1)
+            break;
+
+        int moveIdx = -1;
+        const QVector<Move> moves = m_getPossibleMoves(m_lastPiecesData, pieceIdx);
+        for (auto i = 0; i < moves.size() && moveIdx == -1; i++)
+            if (moves[i].square == to)
+                moveIdx = i;
+        if (moveIdx == -1)
+            break;
+
+        // the pawn is promoted to the piece of the move, the UI piece follows it through Piece::promoteTo()
+        m_promotionType = promotions[promotionIdx];
+        uiPieceMoved(piece, moves[moveIdx]);
+        m_promotionType = QUEEN;
+        played++;
+    }
+    m_isReplaying = false;
+
+    if (played > 0) {
+        emit moveStateScrolled();
+        m_declareResult(isKingCheckmated(m_teamToMove));
+    }
+    return played;
+}
+
 QPair<Square, Square> Chessboard::getLastMove() const
 {
     if (m_moveStackIterator == -1) { // if there is no moves yet
@@ -552,7 +588,11 @@ QPair<Square, Square> Chessboard::getLastMove() const
 
 QString Chessboard::m_getLastPositionInFEN() const
 {
-    const QVector<PieceData> &pieceData = m_lastPiecesData;
+    return m_getPositionInFEN(m_lastPiecesData, m_teamToMove);
+}
+
+QString Chessboard::m_getPositionInFEN(const QVector<PieceData> &pieceData, eColor teamToMove) const
+{
     QString positionInFEN;
     QChar type;
     int emptySquareSequence = 0;
@@ -567,7 +607,7 @@ QString Chessboard::m_getLastPositionInFEN() const
         for (auto file = 'A'; file <= 'H'; file++) {
             auto pieceIdx = m_getPieceDataIdx(pieceData, Square(Position(file, rank)) );
             
-            if (pieceIdx != -1) // Empty square
+            if (pieceIdx == -1) // Empty square
             { 
                 emptySquareSequence++;
             }
@@ -606,6 +646,8 @@ QString Chessboard::m_getLastPositionInFEN() const
                     type = type.toUpper();
                 else // BLACK
                     type = type.toLower();
+
+                positionInFEN += type;
             }
         }
 
@@ -613,21 +655,17 @@ QString Chessboard::m_getLastPositionInFEN() const
             positionInFEN += QString::number(emptySquareSequence);
             emptySquareSequence = 0;
         }
-        positionInFEN += "/";
+        if (rank > 1)
+            positionInFEN += "/";
     }
     positionInFEN += " ";
 
-    // NOTE: The rest of notation does use data of the last move
-    // It is important to know, that this part won't work right
-    // for arbitrary pieceData.
-    // So it generates notation along with m_lastPiecesData only
-    // To make it arbitrary we should: 
-    //   either return only position
-    //   or provide information about enPassant piece,
-    //     team to move and number of moves
+    // NOTE: En passant and the move counters come from the last move.
+    // For arbitrary pieceData the en passant square is given only if
+    // enPassantablePiece stands there and may be taken by teamToMove
 
     // 2. Active color
-    if (m_teamToMove == WHITE)
+    if (teamToMove == WHITE)
         positionInFEN += "w";
     else // Black
         positionInFEN += "b";
@@ -708,10 +746,15 @@ QString Chessboard::m_getLastPositionInFEN() const
     positionInFEN += " ";
 
     // 4. En passant target square in algebraic notation
-    if (enPassantablePiece != nullptr)
+    auto enPassantIdx = -1;
+    if (enPassantablePiece != nullptr && enPassantablePiece->color != teamToMove)
+        enPassantIdx = m_getPieceDataIdx(pieceData, enPassantablePiece->square, enPassantablePiece->color);
+    if (enPassantIdx != -1 && pieceData[enPassantIdx].type == PAWN)
     {
+        // the square passed over by the pawn, not the pawn square itself
         auto notationPos = enPassantablePiece->square.position;
-        positionInFEN += QChar(notationPos.file).toLower() + QString::number(notationPos.rank);
+        auto targetRank  = enPassantablePiece->color == WHITE ? notationPos.rank - 1 : notationPos.rank + 1;
+        positionInFEN += QChar(notationPos.file).toLower() + QString::number(targetRank);
     }
     else
     {
@@ -727,7 +770,6 @@ QString Chessboard::m_getLastPositionInFEN() const
 
     // 6. The number of the full move. It starts at 1, and is incremented after Black's move.
     positionInFEN += QString::number((m_moveStack.size() - 1) / 2 + 1); // Integer devision by 2
-    positionInFEN += " ";
 
     return positionInFEN;
 }
@@ -735,270 +777,67 @@ QString Chessboard::m_getLastPositionInFEN() const
 QVector<Move> Chessboard::m_getPossibleMoves(const QVector<PieceData> &piecesData, int pieceIndex, bool checkmateValidation /*= true*/) const
 {
     QVector<Move> moves;
-    Square pieceSquare, moveSquare;
-    int pieceDataIdx = -1;
+    const PieceData &piece = piecesData[pieceIndex];
 
-    PieceData piece(piecesData[pieceIndex]);
-    
     if (piece.isTaken) { // There is no moves for taken piece
-        return QVector<Move>(0);
+        return moves;
     }
 
-    auto getPieceDataIdx = [&](Square square) {
-        return m_getPieceDataIdx(piecesData, square);
-    };
-
-    switch (piece.type)
-    {
-        case PAWN:
-        {
-            pieceSquare = piece.square;
-            auto add_move = [&]() {
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx != -1 && piecesData[pieceDataIdx].color != piece.color)
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-            };
-
-            auto moveForward = [&]() {
-                if (piece.color == WHITE) pieceSquare = pieceSquare.moveUp();
-                if (piece.color == BLACK) pieceSquare = pieceSquare.moveDown();
-            };
-
-            moveForward();
-            // it should be impossible for pawn to got invalid forward move o_O
-            if (pieceSquare.isValid() == false) break;
-
-            // pawn can make a forward move
-            if (getPieceDataIdx(pieceSquare) == -1)
-                moves.push_back(Move(pieceSquare, -1));
-
-            if ((moveSquare = pieceSquare.moveLeft()).isValid())  add_move();
-            if ((moveSquare = pieceSquare.moveRight()).isValid()) add_move();
-
-            // check for two-square advance move
-            if (getPieceDataIdx(pieceSquare) == -1 &&
-                (piece.color == WHITE && piece.square.position.rank == 2 ||
-                 piece.color == BLACK && piece.square.position.rank == 7))
-            {
-                moveForward();
-                // pawn can make a forward move
-                if (getPieceDataIdx(pieceSquare) == -1)
-                    moves.push_back(Move(pieceSquare, -1, true));
-            }
-            // check for En Passant move
-            if (enPassantablePiece) {
-                // if current piece and enPassantablePiece is on the same horizontal position
-                if (enPassantablePiece->square.position.rank == piece.square.position.rank) {
-                    // NOTE: pieceSquare already moved forward from piece->square
-                    // if enPassantablePiece either from the left or from the right
-                    if (piece.square.moveLeft() == enPassantablePiece->square)
-                        moves.push_back(Move(pieceSquare.moveLeft(), piecesData.indexOf(*enPassantablePiece)));
-                    if (piece.square.moveRight() == enPassantablePiece->square)
-                        moves.push_back(Move(pieceSquare.moveRight(), piecesData.indexOf(*enPassantablePiece)));
-
-                }
-            }
-
-            break;
-        }
-        case KNIGHT:
-        {
-            pieceSquare = piece.square;
-            auto add_move = [&]() {
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx == -1 || piece.isOpposite(piecesData[pieceDataIdx]))
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-            };
-
-            if ((moveSquare = pieceSquare.moveLeft(2).moveUp()).isValid())    add_move();
-            if ((moveSquare = pieceSquare.moveLeft(2).moveDown()).isValid())  add_move();
-            if ((moveSquare = pieceSquare.moveRight(2).moveUp()).isValid())   add_move();
-            if ((moveSquare = pieceSquare.moveRight(2).moveDown()).isValid()) add_move();
-            if ((moveSquare = pieceSquare.moveUp(2).moveLeft()).isValid())    add_move();
-            if ((moveSquare = pieceSquare.moveUp(2).moveRight()).isValid())   add_move();
-            if ((moveSquare = pieceSquare.moveDown(2).moveLeft()).isValid())  add_move();
-            if ((moveSquare = pieceSquare.moveDown(2).moveRight()).isValid()) add_move();
-
-            break;
-        }
-        case BISHOP:
-        {
-            pieceSquare = piece.square;
-            bool isLast;
-            auto add_move = [&]() {
-                isLast = false;
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx == -1 || (isLast = piece.isOpposite(piecesData[pieceDataIdx]))) {
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-                    return (isLast == false); // if (isLast == false) add_move returns true to continue
-                } else return false; // in move square isn't opposite piece
-            };
-
-            moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeftUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRightUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRightDown()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeftDown()).isValid() && add_move());
-
-            break;
-        }
-        case ROOK:
-        {
-            pieceSquare = piece.square;
-            bool isLast;
-            auto add_move = [&]() {
-                isLast = false;
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx == -1 || (isLast = piece.isOpposite(piecesData[pieceDataIdx]))) {
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-                    return (isLast == false); // if (isLast == false) add_move returns true to continue
-                } else return false; // in move square isn't opposite piece
-            };
-
-            moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeft()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRight()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveDown()).isValid() && add_move());
-
-            break;
-        }
-        case QUEEN:
-        {
-            pieceSquare = piece.square;
-            bool isLast;
-            auto add_move = [&]() {
-                isLast = false;
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx == -1 || (isLast = piece.isOpposite(piecesData[pieceDataIdx]))) {
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-                    return (isLast == false); // if (isLast == false) add_move returns true to continue
-                } else return false; // in move square isn't opposite piece
-            };
-
-            moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeft()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeftUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRightUp()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRight()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveRightDown()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveDown()).isValid() && add_move()); moveSquare = pieceSquare;
-            while ((moveSquare = moveSquare.moveLeftDown()).isValid() && add_move());
-
-            break;
-        }
-        case KING:
-        {
-            pieceSquare = piece.square;
-            auto add_move = [&]() {
-                pieceDataIdx = getPieceDataIdx(moveSquare);
-                if (pieceDataIdx == -1 || piece.isOpposite(piecesData[pieceDataIdx]))
-                    moves.push_back(Move(moveSquare, pieceDataIdx));
-            };
-
-            if ((moveSquare = pieceSquare.moveLeft()).isValid())      add_move();
-            if ((moveSquare = pieceSquare.moveLeftUp()).isValid())    add_move();
-            if ((moveSquare = pieceSquare.moveUp()).isValid())        add_move();
-            if ((moveSquare = pieceSquare.moveRightUp()).isValid())   add_move();
-            if ((moveSquare = pieceSquare.moveRight()).isValid())     add_move();
-            if ((moveSquare = pieceSquare.moveRightDown()).isValid()) add_move();
-            if ((moveSquare = pieceSquare.moveDown()).isValid())      add_move();
-            if ((moveSquare = pieceSquare.moveLeftDown()).isValid())  add_move();
-
-            // Check for possible castling move
-            if (piece.numberOfMoves == 0) {
-                int    rookIdx = -1;
-                eColor oppositeColor;
-                bool   isCastlable, isUnderAttack;
-                Square rookSquare, kingSquare = Square(piece.square);
-                rookSquare = kingSquare; // rook square moves towards its end position
-                moveSquare = kingSquare; // move square is at the end position of the king
-
-                // checks squares from rook to king and adds move of castling if it is possible
-                auto add_castling = [&](ePieceType side) {
-                    rookIdx = getPieceDataIdx(rookSquare);
-                    if (rookIdx != -1) { // if there is rook 
-                        if (piecesData[rookIdx].numberOfMoves != 0) return; // rook hasn't been moved
-
-                        isCastlable = true;
-                        isUnderAttack = false;
-                        // isValid() - check for unsought consequences
-                        while (rookSquare != kingSquare && rookSquare.isValid())
-                        {
-                            isUnderAttack = m_isSquareUnderAttack(rookSquare, oppositeColor, piecesData);
-                            pieceDataIdx = getPieceDataIdx(rookSquare);
-                            // isCastlable if rookSquare isn't under attack and all the way to king is only
-                            // either rook itself or an empty square
-                            isCastlable = !((isUnderAttack) || (pieceDataIdx != -1 && rookIdx != pieceDataIdx));
-                            if (isCastlable == false) break;
-                            // move rookSquare either by queen-side or king-side
-                            if (side == QUEEN)
-                                rookSquare = rookSquare.moveRight();
-                            else if (side == KING)
-                                rookSquare = rookSquare.moveLeft();
-                            else {
-                                isCastlable = false;
-                                break;
-                            }
-                        }
-                        if (rookSquare.isValid() == false) return; // rookSquare should always be valid
-                        if (isCastlable == true &&
-                            m_isKingUnderCheck(piece.color, piecesData) == false)
-                        {
-                            moves.push_back(Move(moveSquare, -1, false, true));
-                        }
-                    }
-                };
-
-                if (piece.color == WHITE) oppositeColor = BLACK;
-                if (piece.color == BLACK) oppositeColor = WHITE;
-
-                rookSquare.position.file = 'A'; // Queen side castling
-                moveSquare.position.file = 'C';
-                add_castling(QUEEN);
-
-                rookSquare.position.file = 'H'; // King side castling
-                moveSquare.position.file = 'G';
-                add_castling(KING);
-            }
-
-            break;
-        }
-        default: break;
+    // Moves come from the engine generator, so the board, the search
+    // and chess-uci follow exactly the same rules
+    engine::MoveList uncached;
+    const engine::MoveList *generated = &uncached;
+    if (&piecesData == &m_lastPiecesData)
+        generated = &m_getLastPositionMoves(piece.color, checkmateValidation);
+    else
+        m_generateMoves(piecesData, piece.color, checkmateValidation, uncached);
+
+    const int from = piece.square.toName();
+    for (const auto &scored : *generated) {
+        const engine::Move move = scored.move;
+        if (engine::moveFrom(move) != from)
+            continue;
+        // promotion piece is chosen by Piece::promoteTo(), one move per square is enough
+        if (engine::isPromotionMove(move) && engine::promotionType(move) != QUEEN)
+            continue;
+
+        Square moveSquare((eSquareNames)engine::moveTo(move));
+        int    captureIdx = -1;
+        if (engine::isEnPassantMove(move)) // the pawn to capture is behind the move square
+            captureIdx = m_getPieceDataIdx(piecesData, piece.color == WHITE ? moveSquare.moveDown() : moveSquare.moveUp());
+        else if (engine::isCaptureMove(move))
+            captureIdx = m_getPieceDataIdx(piecesData, moveSquare);
+
+        moves.push_back(Move(moveSquare, captureIdx,
+                             engine::moveFlag(move) == engine::DOUBLE_PAWN_PUSH,
+                             engine::isCastlingMove(move)));
     }
 
-    // Validate moves with respect to CHECK state
-    if (checkmateValidation) {
-        auto testMoveData = piecesData;
-
-        eCheckMateSate checkmate_state = isKingCheckmated(piece.color);
-        if (checkmate_state == CHECKMATE_STATE) return QVector<Move>(0);
-
-        QVector<Move> validMoves;
-        PieceData*    pieceToCheck = nullptr;
-
-        for each (auto& move in moves)
-        {
-            pieceToCheck = &testMoveData[m_getPieceDataIdx(testMoveData, piece.square)];
-            // Make a move
-            if (move.idxPieceToCapture != -1) {
-                auto pieceIdx = m_getPieceDataIdx(testMoveData, piecesData[move.idxPieceToCapture].square);
-                testMoveData[pieceIdx].isTaken = true;
-            }
+    return moves;
+}
 
-            pieceToCheck->moveToSquare(move.square);
+void Chessboard::m_generateMoves(const QVector<PieceData> &piecesData, eColor teamToMove, bool isLegal,
+                                 engine::MoveList &moves) const
+{
+    moves.clear();
+    engine::Position pos;
+    if (!pos.setFEN(m_getPositionInFEN(piecesData, teamToMove)))
+        return;
 
-            // check if the king is NOT more under CHECK
-            if (m_isKingUnderCheck(piece.color, testMoveData) == NOCHECK)
-                validMoves.push_back(move);
+    if (isLegal)
+        engine::generateLegalMoves(pos, moves);
+    else // moves may leave the king under CHECK
+        engine::generateMoves(pos, moves);
+}
 
-            testMoveData = piecesData; // reset data after every move has been checked
-        }
-        moves = validMoves;
+const engine::MoveList &Chessboard::m_getLastPositionMoves(eColor teamToMove, bool isLegal) const
+{
+    const int key = teamToMove * 2 + (isLegal ? 1 : 0);
+    if (m_lastMovesKey != key) {
+        m_generateMoves(m_lastPiecesData, teamToMove, isLegal, m_lastMoves);
+        m_lastMovesKey = key;
     }
-
-    return moves;
+    return m_lastMoves;
 }
 
 MovePack Chessboard::m_getMovePackFromMove(const Move &move, const PieceData &piece, const QVector<PieceData> &pieceData)
@@ -1050,8 +889,8 @@ MovePack Chessboard::m_getMovePackFromMove(const Move &move, const PieceData &pi
     if (piece.type == PAWN &&
         (move.square.position.rank == 8 || move.square.position.rank == 1))
     {
-        ePieceType promotion = QUEEN; // #TODO: make a gui for choosing a piece for pawn promotion
-                                      // Saving piece promotion
+        ePieceType promotion = m_promotionType; // #TODO: make a gui for choosing a piece for pawn promotion
+                                                // Saving piece promotion
         mpack.results.push_back(MoveResult(piece.type,
                                            promotion,
                                            move.square, // Move is saved
@@ -1062,6 +901,30 @@ MovePack Chessboard::m_getMovePackFromMove(const Move &move, const PieceData &pi
     return mpack;
 }
 
+QString Chessboard::m_getMoveInCoordinates(const MovePack &mpack) const
+{
+    auto toCoordinates = [](const Square &square) {
+        return QString(QChar(square.position.file).toLower()) + QString::number(square.position.rank);
+    };
+
+    // the move of the piece itself is always the first result, see m_getMovePackFromMove
+    const MoveResult &pieceMove = mpack.results.first();
+    QString moveInCoordinates = toCoordinates(pieceMove.startSquare) + toCoordinates(pieceMove.endSquare);
+
+    for each (auto result in mpack.results) {
+        if (result.typeStart == result.typeEnd) continue;
+        switch (result.typeEnd) // PAWN promotion
+        {
+            case KNIGHT: moveInCoordinates += "n"; break;
+            case BISHOP: moveInCoordinates += "b"; break;
+            case ROOK:   moveInCoordinates += "r"; break;
+            default:     moveInCoordinates += "q"; break;
+        }
+    }
+
+    return moveInCoordinates;
+}
+
 int Chessboard::m_findPieceDataIndex(Piece* piece, const QVector<PieceData> &piecesData)
 {
     if (piece == nullptr) return -1;
@@ -1098,7 +961,12 @@ QString Chessboard::m_getRecordPGN(const Move &move, int movedPieceIdx, const QV
         moveInPGN += QChar(move.square.position.file).toLower() + QString(move.square.position.rank + '0');
         // PAWN promotion 
         if (move.square.position.rank == 1 || move.square.position.rank == 8) {
-            moveInPGN += "=Q"; // #TODO: choose promotion and save it to the Move class
+            switch (m_promotionType) { // #TODO: choose promotion and save it to the Move class
+                case KNIGHT: moveInPGN += "=N"; break;
+                case BISHOP: moveInPGN += "=B"; break;
+                case ROOK:   moveInPGN += "=R"; break;
+                default:     moveInPGN += "=Q"; break;
+            }
         }
         return moveInPGN; // Generation done
     }
@@ -1192,6 +1060,7 @@ QString Chessboard::m_getRecordPGN(const Move &move, int movedPieceIdx, const QV
 
 void Chessboard::m_updateLastPiecesData()
 {
+    m_lastMovesKey = -1; // the moves are generated anew for the new position
     auto lastMove = m_moveStack.last();
     for each (auto moveResult in lastMove.results)
     {
@@ -1238,7 +1107,8 @@ void Chessboard::m_doMovePack(QVector<MovePack>::iterator it)
 
 void Chessboard::m_undoMovePack(QVector<MovePack>::iterator it)
 {
-    for (auto i = 0; i < it->results.size(); i++) {
+    // in reverse order: the promotion is undone before the pawn goes back
+    for (auto i = it->results.size() - 1; i >= 0; i--) {
         auto moveResult = it->results.at(i);
         // search for piece including taken pieces and the same type to disambiguate
         Piece* piece = getPieceAt(moveResult.endSquare, moveResult.pieceColor, true, moveResult.typeEnd); 
@@ -1250,125 +1120,56 @@ void Chessboard::m_undoMovePack(QVector<MovePack>::iterator it)
     }
 }
 
-bool Chessboard::m_isSquareUnderAttack(Square square, eColor attackFrom, const QVector<PieceData> &piecesData) const 
+void Chessboard::m_declareResult(eCheckMateSate checkmateState)
 {
-    int    pieceIdx = -1;
-    Square initalSquare = square;
-    Square checkSquare;
-    bool   isUnderAttack;
+    if (m_isReplaying) // the position the replay ends in is declared by playMoves()
+        return;
 
-    // getPieceDataAt uses:
-    //      QVector<PieceData> piecesData
-    auto getPieceDataAt = [&](Square square) {
-        return m_getPieceDataIdx(piecesData, square);
-    };
+    if (checkmateState == CHECKMATE_STATE) {
+        emit gameOver(CHECKMATE);
+    } else if (isStalemate()) {
+        qDebug() << "STALEMATE";
+        emit gameOver(STALEMATE);
+    } else {
+        m_declareTablebaseResult();
+    }
+}
 
-    // checkSquareFor uses:
-    //      Square checkSquare as square for searching pieces which attacks the square
-    //      QVector<PieceData> piecesData
-    //      getPieceDataAt()
-    //      
-    //      returns true for breaking loop
-    auto checkSquareFor = [&](ePieceType type) {
-        pieceIdx = getPieceDataAt(checkSquare);
-        if (pieceIdx != -1) {
-            if (piecesData[pieceIdx].type == type && piecesData[pieceIdx].color == attackFrom) {
-                isUnderAttack = true;
-                return true;    // enemy piece; break a loop
-            } else return true; // mate piece or piece of other type; break a loop
-        } else {
-            return false; // no pieces, continue loop
-        }
-    };
+void Chessboard::m_declareTablebaseResult()
+{
+    if (m_isTablebaseResultDeclared)
+        return;
+
+    engine::Position pos;
+    if (!pos.setFEN(m_getLastPositionInFEN()) || !engine::Tablebases::canProbe(pos))
+        return;
+
+    bool isFound = false;
+    const engine::eWdl wdl = engine::Tablebases::probeWdl(pos, &isFound);
+    if (!isFound)
+        return;
 
-    // Checks pieces which can attack the `search square` by their moves
-    // move square -> piece -> attack => square under check
-    isUnderAttack = false; // reset result state before calculating moves
-
-    // PAWN
-    if (attackFrom == WHITE) checkSquare = initalSquare.moveDown();
-    if (attackFrom == BLACK) checkSquare = initalSquare.moveUp();
-
-    if ((pieceIdx = getPieceDataAt(checkSquare.moveLeft())) != -1 &&
-        piecesData[pieceIdx].type == PAWN && piecesData[pieceIdx].color == attackFrom)
-        isUnderAttack = true;
-    if ((pieceIdx = getPieceDataAt(checkSquare.moveRight())) != -1 &&
-        piecesData[pieceIdx].type == PAWN && piecesData[pieceIdx].color == attackFrom)
-        isUnderAttack = true;
-
-    // KNIGHT
-    checkSquare = initalSquare.moveLeft(2).moveUp();    checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveLeft(2).moveDown();  checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveRight(2).moveUp();   checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveRight(2).moveDown(); checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveUp(2).moveLeft();    checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveUp(2).moveRight();   checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveDown(2).moveLeft();  checkSquareFor(KNIGHT);
-    checkSquare = initalSquare.moveDown(2).moveRight(); checkSquareFor(KNIGHT);
-    checkSquare = initalSquare;
-    // BISHOP
-    while ((checkSquare = checkSquare.moveLeftUp()).isValid()    && checkSquareFor(BISHOP) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRightUp()).isValid()   && checkSquareFor(BISHOP) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRightDown()).isValid() && checkSquareFor(BISHOP) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveLeftDown()).isValid()  && checkSquareFor(BISHOP) == false); checkSquare = initalSquare;
-
-    // ROOK
-    while ((checkSquare = checkSquare.moveLeft()).isValid()  && checkSquareFor(ROOK) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveUp()).isValid()    && checkSquareFor(ROOK) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRight()).isValid() && checkSquareFor(ROOK) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveDown()).isValid()  && checkSquareFor(ROOK) == false); checkSquare = initalSquare;
-
-    // QUEEN
-    while ((checkSquare = checkSquare.moveLeft()).isValid()      && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveLeftUp()).isValid()    && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveUp()).isValid()        && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRightUp()).isValid()   && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRight()).isValid()     && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveRightDown()).isValid() && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveDown()).isValid()      && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-    while ((checkSquare = checkSquare.moveLeftDown()).isValid()  && checkSquareFor(QUEEN) == false); checkSquare = initalSquare;
-
-    // KING
-    checkSquare = initalSquare.moveLeft();      checkSquareFor(KING);
-    checkSquare = initalSquare.moveLeftUp();    checkSquareFor(KING);
-    checkSquare = initalSquare.moveUp();        checkSquareFor(KING);
-    checkSquare = initalSquare.moveRightUp();   checkSquareFor(KING);
-    checkSquare = initalSquare.moveRight();     checkSquareFor(KING);
-    checkSquare = initalSquare.moveRightDown(); checkSquareFor(KING);
-    checkSquare = initalSquare.moveDown();      checkSquareFor(KING);
-    checkSquare = initalSquare.moveLeftDown();  checkSquareFor(KING);
-
-    return isUnderAttack;
+    // cursed wins and blessed losses are drawn by the fifty moves rule
+    m_isTablebaseResultDeclared = true;
+    if (wdl == engine::WDL_WIN)
+        emit gameOver(TABLEBASE_WIN);
+    else if (wdl == engine::WDL_LOSS)
+        emit gameOver(TABLEBASE_LOSS);
+    else
+        emit gameOver(TABLEBASE_DRAW);
 }
 
 bool Chessboard::m_isKingUnderCheck(eColor kingColor, const QVector<PieceData> &piecesData) const
 {
-    Square kingSquare;
-    eColor oppoentColor;
-    bool   isKingUnderCheck;
-    int    kingIdx = -1;
-
-    // Declaration lambdas 
-    // Takes pointer to king PieceData according to piecesData
-    auto initKingFromData = [&]() {
-        for (auto i = 0; i < piecesData.size(); i++) {
-            if (piecesData[i].type == KING && piecesData[i].color == kingColor)
-                kingIdx = i;
-        }
-        if (kingIdx == -1)
-            throw std::runtime_error("ERROR: Chessboard::isKingCheckmated() - there is no king on the board.");
-        
-        kingSquare = piecesData[kingIdx].square;
-        if (piecesData[kingIdx].color == WHITE) oppoentColor = BLACK;
-        if (piecesData[kingIdx].color == BLACK) oppoentColor = WHITE;
-    };
-
-    // Checks piece which can CHECK the king by their moves
-    // move square -> piece -> check => king under check
-
-    initKingFromData();
-    isKingUnderCheck = m_isSquareUnderAttack(kingSquare, oppoentColor, piecesData);
-    return isKingUnderCheck;
+    eColor oppositeColor = (kingColor == WHITE) ? BLACK : WHITE;
+
+    // Position with the opposite team to move is valid only if the king isn't under CHECK,
+    // it is tried when the opposite king is under attack, e.g. for a scrolled UI board
+    engine::Position pos;
+    if (pos.setFEN(m_getPositionInFEN(piecesData, kingColor)))
+        return pos.inCheck();
+    // otherwise neither side can be to move, e.g. a king is missing: there is no CHECK to show
+    return false;
 }
 
 
@@ -1429,12 +1230,8 @@ void Chessboard::netPieceMoved(const QList<QVariant> &moveList)
     if (checkmateState == CHECKMATE_STATE) {
         qDebug() << "CHECKMATE";
         moveInPGN += "#";
-        emit gameOver(CHECKMATE);
-    }
-    if (isStalemate()) {
-        qDebug() << "STALEMATE";
-        emit gameOver(STALEMATE);
     }
+    m_declareResult(checkmateState);
 
     // #TODO: complete move actions between classes
     emit moveDone(moveInPGN);
@@ -1486,12 +1283,8 @@ void Chessboard::uiPieceMoved(Piece* piece, const Move &move)
     if (checkmateState == CHECKMATE_STATE) {
         qDebug() << "CHECKMATE";
         moveInPGN += "#";
-        emit gameOver(CHECKMATE);
-    }
-    if (isStalemate()) {
-        qDebug() << "STALEMATE";
-        emit gameOver(STALEMATE);
     }
+    m_declareResult(checkmateState);
 
     QList<QVariant> moveList;
     QVariant variantMove, variantPieceData;
@@ -24,10 +24,13 @@
 
 #include <QObject>
 #include <QVector>
+#include <QStringList>
 #include <QDataStream>
 #include <qmath.h>
 
 #include "chessevent.h"
+#include "notation.h"
+#include "engine/types.h"
 
 //==============================================================
 //                          Data types
@@ -36,23 +39,6 @@
 namespace notation
 {
 
-enum eColor {
-    WHITE,
-    BLACK,
-    EMPTY
-};
-
-enum eSquareNames {
-    A1, B1, C1, D1, E1, F1, G1, H1,
-    A2, B2, C2, D2, E2, F2, G2, H2,
-    A3, B3, C3, D3, E3, F3, G3, H3,
-    A4, B4, C4, D4, E4, F4, G4, H4,
-    A5, B5, C5, D5, E5, F5, G5, H5,
-    A6, B6, C6, D6, E6, F6, G6, H6,
-    A7, B7, C7, D7, E7, F7, G7, H7,
-    A8, B8, C8, D8, E8, F8, G8, H8
-};
-
 struct Position {
     Position() : file('A'), rank(1) {}
     Position(char _file, int _rank) : file(_file), rank(_rank) {}
@@ -223,15 +209,6 @@ Q_DECLARE_METATYPE(GameConfig)
 //                      Piece
 //==============================================================
 
-enum ePieceType {
-    PAWN,
-    KNIGHT,
-    BISHOP,
-    ROOK,
-    QUEEN,
-    KING
-};
-
 //    Piece contains all information about piece,
 //    Used in public namespace of Chessboard for connecting
 //    UI pieces and `Chessboard class` representation
@@ -411,6 +388,17 @@ public:
 
     // Gets board state as after i-th move
     QVector<PieceData> getBoardStateAfter(int moveIndex);
+    // getMovesInCoordinates:
+    //      Moves from the initial position up to the i-th move in coordinate notation (e2e4, e7e8q),
+    //      the way the engine takes the position to analyse
+    QStringList getMovesInCoordinates(int moveIndex) const;
+    // playMoves:
+    //      Makes the moves in coordinate notation from the very last position the way
+    //      the user makes them, a game opened from a file fills the move history so.
+    //      Stops at the first move the board can't make. moveStateScrolled and gameOver
+    //      come once, for the position after the last move.
+    //      Returns the number of moves made
+    int         playMoves(const QStringList &coordinateMoves);
 
     QPair<Square, Square> getLastMove() const;
 
@@ -436,7 +424,8 @@ signals:
     // void moveDoneFEN(const QString&); // Board position in FEN format after move
     void netMoveDone(const QList<QVariant> &); // signal for Network player
     // gameOver:
-    //      The reason is either STALEMATE or CHECKMATE
+    //      The reason is either STALEMATE or CHECKMATE, or the tablebase result
+    //      for the team to move as soon as the position is in the tablebases
     //      If something went wrong EMPTY_GAMEOVER state occurs
     void gameOver(eGameoverType reason);
 
@@ -446,14 +435,34 @@ private:
     int                 m_moveStackIterator;
 
     int m_nMovesWithoutCapture;
+    bool m_isTablebaseResultDeclared;
+    // m_promotionType: piece a pawn is promoted to by the move being made, a user always takes a queen
+    ePieceType m_promotionType;
+    // m_isReplaying: playMoves() is making the moves, moveStateScrolled and gameOver are emitted once at the end
+    bool m_isReplaying;
+    // moves of m_lastPiecesData, see m_getLastPositionMoves()
+    mutable engine::MoveList m_lastMoves;
+    mutable int              m_lastMovesKey; // teamToMove * 2 + isLegal, -1 until generated
 
     // m_getLastPositionInFEN:
     //      Calculates position of m_lastPiecesData in FEN format
     QString m_getLastPositionInFEN() const;
+    // m_getPositionInFEN:
+    //      Calculates position of arbitrary piecesData in FEN format with teamToMove to make a move.
+    //      It is the way the board state is passed to the engine move generator
+    QString m_getPositionInFEN(const QVector<PieceData> &piecesData, eColor teamToMove) const;
 
     // m_getPossibleMoves(const QVector<PieceData> &piecesData, int pieceIndex, bool checkmateValidation = true);
     //      Takes arbitrary board state instead of getPossibleMoves method
     QVector<Move>   m_getPossibleMoves(const QVector<PieceData> &piecesData, int pieceIndex, bool checkmateValidation = true) const;
+    // m_generateMoves:
+    //      All the moves of teamToMove in piecesData from the engine generator, legal ones or
+    //      those which may leave the king under CHECK. No moves if the engine rejects the position
+    void            m_generateMoves(const QVector<PieceData> &piecesData, eColor teamToMove, bool isLegal,
+                                    engine::MoveList &moves) const;
+    // m_getLastPositionMoves:
+    //      m_generateMoves() of m_lastPiecesData, generated once a position for all its pieces
+    const engine::MoveList &m_getLastPositionMoves(eColor teamToMove, bool isLegal) const;
 
     // m_getMovePackFromMove:
     //      Returns MovePack calculated from Move class
@@ -466,6 +475,9 @@ private:
     // m_getRecordPGN:
     //      Calculates move in PGN format from data in Move class and given piecesData
     QString m_getRecordPGN(const Move &move, int movedPieceIdx, const QVector<PieceData> &piecesData) const;
+    // m_getMoveInCoordinates:
+    //      Calculates move in coordinate notation from the MovePack of the move
+    QString m_getMoveInCoordinates(const MovePack &mpack) const;
 
     // m_updateLastPiecesData:
     //      Updates m_lastPiecesData according to the last move
@@ -489,9 +501,16 @@ private:
     //      Forces changes of MovePack to be undone
     void    m_undoMovePack(QVector<MovePack>::iterator);
 
-    //  m_isSquareUnderAttack:
-    //      returns either true or false according to square is either under attack or not.
-    bool    m_isSquareUnderAttack(Square square, eColor attackFrom, const QVector<PieceData> &piecesData) const;
+    //  m_declareResult:
+    //      Emits gameOver if the last position is a checkmate, a stalemate or a tablebase
+    //      result, not for the positions playMoves() goes through
+    void    m_declareResult(eCheckMateSate checkmateState);
+
+    //  m_declareTablebaseResult:
+    //      Emits gameOver with the tablebase result of the last position once a game,
+    //      the rest of a won or drawn ending isn't played out
+    void    m_declareTablebaseResult();
+
     //  m_isKingUnderCheck:
     //      returns either true or false according to king is either under CHECK or not.
     bool    m_isKingUnderCheck(eColor kingColor, const QVector<PieceData> &piecesData) const;
@@ -45,7 +45,11 @@ enum eGameoverType {
     EMPTY_GAMEOVER,
     RESIGN,
     CHECKMATE,
-    STALEMATE    
+    STALEMATE,
+    // decided by the endgame tablebases, for the side to move
+    TABLEBASE_WIN,
+    TABLEBASE_LOSS,
+    TABLEBASE_DRAW
 };
 
 enum eOfferType {
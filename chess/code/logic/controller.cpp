@@ -21,6 +21,7 @@
 *******************************************************************************/
 #include "controller.h"
 #include "utilities/chessutilities.h"
+#include "engine/movegen.h"
 
 // Phrases for translation:
 //  Translates into .ts file as translations for QObject
@@ -31,6 +32,11 @@ QObject::tr("Waiting for player...")
 QObject::tr("Connecting to server...")
 QObject::tr("Controller::networkEvent(): broken data has been recieved")
 QObject::tr("Connection lost")
+QObject::tr("Checkmate")
+QObject::tr("Stalemate")
+QObject::tr("Won by the tablebases")
+QObject::tr("Lost by the tablebases")
+QObject::tr("Drawn by the tablebases")
 #endif
 
 //==============================================================
@@ -46,12 +52,19 @@ Controller::Controller(BoardWidget * _widget)
 
     m_isConfigRecieved = false;
 
+    m_isEnginePlaying = false;
+    m_searchId = 0;
+    m_clock[WHITE] = m_clock[BLACK] = 0;
+
     connect(network, SIGNAL(eventRecieved(QByteArray)), this, SLOT(networkEvent(QByteArray)));
     connect(network, SIGNAL(networkConnected()), this, SLOT(connected()));
     connect(network, SIGNAL(networkDisconnected()), this, SLOT(disconnected()));
     connect(network, SIGNAL(networkError(const QString &)), this, SLOT(handleError(const QString &)));
 
     connect(this, SIGNAL(controllerError(const QString &)), widget, SLOT(enableWaiting(const QString&)));
+    connect(widget, SIGNAL(gameChosen(const QStringList &, int)), this, SLOT(showGame(const QStringList &, int)));
+    connect(&m_engine, SIGNAL(bestMove(int, const engine::SearchResult&)),
+            this, SLOT(engineMoved(int, const engine::SearchResult&)));
 }
 
 Controller::~Controller()
@@ -67,6 +80,8 @@ Controller::~Controller()
 void Controller::runServer(const GameConfig &config)
 {
     network->run(Network::SERVER);
+    m_stopEngine();
+    m_turnTimer.invalidate(); // the game starts when the player connects
 
     if (board) { // if board has already been created
         widget->setBoard(nullptr); // safely remove
@@ -81,6 +96,7 @@ void Controller::runServer(const GameConfig &config)
 
     connect(this->board, SIGNAL(netMoveDone(const QList<QVariant> &)),
             this, SLOT(pieceMoved(const QList<QVariant> &)));
+    connect(this->board, SIGNAL(gameOver(eGameoverType)), this, SLOT(gameOver(eGameoverType)));
 }
 
 void Controller::connectIP(const QHostAddress &address)
@@ -90,8 +106,60 @@ void Controller::connectIP(const QHostAddress &address)
     widget->enableWaiting(ChessUtilities::chessMark("Connecting to server..."));
 }
 
+int Controller::openGame(const QStringList &coordinateMoves)
+{
+    network->run(Network::EMPTY); // drop the connection, the game isn't played over the network
+    m_stopEngine();
+    m_turnTimer.invalidate();
+
+    if (board) { // if board has already been created
+        widget->setBoard(nullptr); // safely remove
+        board->disconnect(); // signal & slot
+        delete board;
+        board = nullptr;
+    }
+
+    // the game is shown from the white side, the moves come into the history as they are made
+    board = new Chessboard(GameConfig(WHITE));
+    widget->setBoard(board);
+    connect(this->board, SIGNAL(gameOver(eGameoverType)), this, SLOT(gameOver(eGameoverType)));
+    return board->playMoves(coordinateMoves);
+}
+
+void Controller::showGame(const QStringList &coordinateMoves, int ply)
+{
+    const int played = openGame(coordinateMoves);
+    if (ply > 0 && ply < played)
+        board->scrollToMove(ply - 1);
+}
+
+engine::SearchLimits Controller::searchLimits(const GameConfig &config, eColor sideToMove, qint64 timeLeft)
+{
+    engine::SearchLimits limits;
+    if (config.timeControl == GameConfig::UNLIMITED) {
+        limits.moveTime = ENGINE_MOVE_TIME;
+        return limits;
+    }
+    limits.time[sideToMove] = qMax<qint64>(1, timeLeft);
+    limits.increment[sideToMove] = qint64(config.increment) * 1000;
+    return limits;
+}
+
+void Controller::setEnginePlaying(bool isPlaying)
+{
+    m_isEnginePlaying = isPlaying;
+    if (isPlaying)
+        m_startEngineMove();
+    else
+        m_stopEngine();
+}
+
 void Controller::pieceMoved(const QList<QVariant> &moveList)
 {
+    // the user has moved by hand while the engine was thinking
+    m_stopEngine();
+    m_moveMade();
+
     QByteArray block;
     QDataStream sendStream(&block, QIODevice::WriteOnly);
     QVariant variantChessEvent, variantMove, variantPieceData;
@@ -137,6 +205,8 @@ void Controller::networkEvent(QByteArray data)
 
                 connect(this->board, SIGNAL(netMoveDone(const QList<QVariant> &)),
                         this, SLOT(pieceMoved(const QList<QVariant> &)));
+                connect(this->board, SIGNAL(gameOver(eGameoverType)), this, SLOT(gameOver(eGameoverType)));
+                m_newGame();
                 break;
             }
             case MOVE:
@@ -149,6 +219,8 @@ void Controller::networkEvent(QByteArray data)
                 moveList.push_back(variantPieceData);
 
                 board->netPieceMoved(moveList);
+                m_moveMade();
+                m_opponentMoved();
 
                 break;
             }
@@ -168,6 +240,8 @@ void Controller::disconnected()
 {
     auto cfg = board->config;
 
+    m_stopEngine();
+    m_turnTimer.invalidate();
     widget->setBoard(nullptr); // safely remove
     board->disconnect(); // signal & slot
     delete board;
@@ -180,6 +254,42 @@ void Controller::disconnected()
     widget->enableWaiting(ChessUtilities::chessMark("Connection lost"));
 }
 
+void Controller::gameOver(eGameoverType reason)
+{
+    m_stopEngine();
+    m_turnTimer.invalidate(); // the clocks stop
+    widget->stopAnalysis();
+
+    if (network->netType == Network::EMPTY) // a game opened for review is only shown
+        return;
+
+    // the tablebase result is for the team to move
+    const bool isUserToMove = board && board->getTeamToMove() == board->config.userColor;
+    switch (reason)
+    {
+        case CHECKMATE:
+            widget->enableWaiting(ChessUtilities::chessMark("Checkmate"));
+            break;
+        case STALEMATE:
+            widget->enableWaiting(ChessUtilities::chessMark("Stalemate"));
+            break;
+        case TABLEBASE_WIN:
+        case TABLEBASE_LOSS:
+            if ((reason == TABLEBASE_WIN) == isUserToMove)
+                widget->enableWaiting(ChessUtilities::chessMark("Won by the tablebases"));
+            else
+                widget->enableWaiting(ChessUtilities::chessMark("Lost by the tablebases"));
+            break;
+        case TABLEBASE_DRAW:
+            widget->enableWaiting(ChessUtilities::chessMark("Drawn by the tablebases"));
+            break;
+
+        default: // the move received can't be made on the board
+            emit controllerError(ChessUtilities::chessMark("Controller::networkEvent(): broken data has been recieved"));
+            break;
+    }
+}
+
 void Controller::connected()
 {
     if (network->netType == Network::SERVER) {
@@ -204,6 +314,7 @@ void Controller::connected()
         network->sendData(block);
 
         widget->disableWaiting();
+        m_newGame();
     }
     if (network->netType == Network::CLIENT) {
         widget->disableWaiting();
@@ -214,3 +325,88 @@ void Controller::handleError(const QString &str)
 {
     emit controllerError(str);
 }
+
+void Controller::engineMoved(int id, const engine::SearchResult &result)
+{
+    if (id != m_searchId) // a search stopped before
+        return;
+    m_searchId = 0;
+    // a ponder search ends early if the expected move ends the game, the opponent is still to move
+    if (!board || result.bestMove == engine::NO_MOVE || board->getTeamToMove() != board->config.userColor)
+        return;
+
+    // the user may be looking at an earlier position, the moves are made in the last one
+    board->scrollToMove(board->getNumberOfMoves() - 1);
+    board->playMoves(QStringList(engine::moveToString(result.bestMove))); // sent through pieceMoved()
+
+    if (result.ponderMove != engine::NO_MOVE)
+        m_startPondering(engine::moveToString(result.ponderMove));
+}
+
+void Controller::m_newGame()
+{
+    m_stopEngine();
+    m_clock[WHITE] = m_clock[BLACK] = qint64(board->config.timeLeft) * 1000;
+    m_turnTimer.start();
+    m_engine.newGame();
+    m_startEngineMove();
+}
+
+void Controller::m_moveMade()
+{
+    if (!board || !m_turnTimer.isValid())
+        return;
+    const eColor moved = board->getTeamToMove() == WHITE ? BLACK : WHITE;
+    m_clock[moved] += qint64(board->config.increment) * 1000 - m_turnTimer.restart();
+}
+
+void Controller::m_startEngineMove()
+{
+    if (!m_isEnginePlaying || !board || m_searchId != 0 || !m_turnTimer.isValid())
+        return;
+    const eColor color = board->config.userColor;
+    if (board->getTeamToMove() != color)
+        return;
+
+    const QStringList moves = board->getMovesInCoordinates(board->getNumberOfMoves() - 1);
+    const auto limits = searchLimits(board->config, color, m_clock[color] - m_turnTimer.elapsed());
+    m_searchId = m_engine.start(engine::Position::startFEN(), moves, limits);
+}
+
+void Controller::m_startPondering(const QString &ponderMove)
+{
+    if (!m_isEnginePlaying || !board || m_searchId != 0 || !m_turnTimer.isValid())
+        return;
+    const eColor color = board->config.userColor;
+    QStringList moves = board->getMovesInCoordinates(board->getNumberOfMoves() - 1);
+    moves.append(ponderMove);
+
+    // the clock of the engine doesn't run until the ponder hit, the limits apply from then on
+    auto limits = searchLimits(board->config, color, m_clock[color]);
+    limits.ponder = true;
+    m_searchId = m_engine.start(engine::Position::startFEN(), moves, limits);
+    m_ponderMove = ponderMove;
+}
+
+void Controller::m_opponentMoved()
+{
+    if (m_searchId != 0 && !m_ponderMove.isEmpty()) {
+        const QStringList moves = board->getMovesInCoordinates(board->getNumberOfMoves() - 1);
+        if (!moves.isEmpty() && moves.last() == m_ponderMove) {
+            m_ponderMove.clear();
+            m_engine.ponderHit(); // its best move comes to engineMoved() as that of a normal search
+            return;
+        }
+    }
+    m_stopEngine();
+    m_startEngineMove();
+}
+
+void Controller::m_stopEngine()
+{
+    m_ponderMove.clear();
+    if (m_searchId == 0)
+        return;
+    m_searchId = 0; // the best move of the stopped search is ignored
+    m_engine.stop();
+}
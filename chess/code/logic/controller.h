@@ -23,10 +23,12 @@
 #define CONTROLLER_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 #include "network\network.h"
 #include "logic\chessboard.h"
 #include "gui\boardwidget.h"
+#include "engine\engine.h"
 
 class Controller : public QObject {
     Q_OBJECT
@@ -42,12 +44,34 @@ public:
 
     void runServer(const GameConfig&);
     void connectIP(const QHostAddress&);
+    // openGame:
+    //      Replaces the game on the board, the network one too, with the moves in
+    //      coordinate notation played from the initial position for review.
+    //      Returns the number of moves the board has made
+    int  openGame(const QStringList &coordinateMoves);
+
+    // searchLimits:
+    //      Limits of an engine move for the side to move with `timeLeft` milliseconds on its
+    //      clock, GameConfig counts seconds and the engine milliseconds.
+    //      An UNLIMITED game has no clock, the engine thinks ENGINE_MOVE_TIME per move then
+    static engine::SearchLimits searchLimits(const GameConfig &config, eColor sideToMove, qint64 timeLeft);
 
 public slots:
+    // showGame:
+    //      Opens the game with openGame() and scrolls the board back to the
+    //      position after `ply` moves, the rest of the game stays in the history
+    void showGame(const QStringList &coordinateMoves, int ply);
+    // setEnginePlaying:
+    //      The engine makes the moves of the user in the network game on the game clock
+    //      and ponders on the move it expects in reply while the opponent thinks
+    void setEnginePlaying(bool isPlaying);
+
     // Common slots
     void pieceMoved(const QList<QVariant> &);
     void networkEvent(QByteArray data);
     void disconnected();
+    // gameOver: stops the engine, the clocks and the analysis, a network game is closed with the result
+    void gameOver(eGameoverType reason);
 
     // Server slots
     void connected();
@@ -55,12 +79,36 @@ public slots:
     // error handler
     void handleError(const QString &);
 
+private slots:
+    void engineMoved(int id, const engine::SearchResult &result);
+
 signals:
     void controllerError(const QString &); // #TODO: output error somewhere
 
 private:
+    enum { ENGINE_MOVE_TIME = 5000 }; // milliseconds per move without a clock
+
+    // m_newGame: resets the clocks from the board config and lets the engine move if it's its turn
+    void m_newGame();
+    // m_moveMade: the side that has moved is charged the time since the previous move
+    void m_moveMade();
+    // m_startEngineMove: starts the search if the engine plays and it's the user's turn
+    void m_startEngineMove();
+    // m_startPondering: searches the position after the expected opponent move on the opponent's time
+    void m_startPondering(const QString &ponderMove);
+    // m_opponentMoved: a ponder hit goes on as the search of the engine move, a miss starts it anew
+    void m_opponentMoved();
+    void m_stopEngine();
+
     // flag to receive GameConfig on connect
     bool m_isConfigRecieved;
+
+    engine::Engine m_engine;
+    bool           m_isEnginePlaying;
+    int            m_searchId; // 0 if the engine doesn't search for the game
+    QString        m_ponderMove; // the expected opponent move while pondering
+    qint64         m_clock[2]; // milliseconds left by eColor
+    QElapsedTimer  m_turnTimer; // since the last move, invalid while no network game is played
 };
 
 #endif//CONTROLLER_H
\ No newline at end of file
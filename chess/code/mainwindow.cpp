@@ -22,10 +22,20 @@
 #include "mainwindow.h"
 #include "gui\createdialog.h"
 #include "ui_mainwindow.h"
+#include "engine/tablebase.h"
+#include "engine/dtm.h"
+#include "engine/analysiscache.h"
+#include "engine/nnue.h"
+#include "engine/pgn.h"
+#include "engine/movegen.h"
 
 #include <QLineEdit>
 #include <QInputDialog>
+#include <QFileDialog>
 #include <QHostAddress>
+#include <QProgressDialog>
+
+#include <limits>
 
 //==============================================================
 //                        MainWindow
@@ -37,6 +47,14 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
+    // Syzygy and DTM tables next to the executable, before any engine or board probes them
+    engine::Tablebases::init(QApplication::instance()->applicationDirPath() + "/syzygy");
+    engine::Dtm::init(QApplication::instance()->applicationDirPath() + "/dtm");
+    // results of the earlier sessions, the analysis of a position studied before is shown at once
+    engine::AnalysisCache::open(QApplication::instance()->applicationDirPath() + "/analysis.cache");
+    // the network evaluation of the analysis and of the strongest bots, the classical one without the file
+    engine::Nnue::load(QApplication::instance()->applicationDirPath() + "/network.nnue");
+
     board_widget = new BoardWidget(this);
     controller = new Controller(board_widget);
     this->setCentralWidget(board_widget);
@@ -145,6 +163,112 @@ void MainWindow::on_connect_triggered()
 
 }
 
+void MainWindow::on_open_triggered()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Open game"), QString(),
+                                                          tr("PGN files (*.pgn);;All files (*)"));
+    if (fileName.isEmpty())
+        return;
+
+    engine::PgnFile file;
+    if (!file.open(fileName)) {
+        statusBar()->showMessage(tr("Can't open %1").arg(fileName));
+        return;
+    }
+
+    // the first games are listed, a larger database is browsed by the game number:
+    // the file isn't read further until a game past the list is asked for
+    const int maxListedGames = 1000;
+    QVector<qint64> offsets;
+    QStringList names;
+    QVector<engine::PgnToken> tokens;
+    engine::PgnGame game;
+    while (offsets.size() <= maxListedGames) {
+        const qint64 offset = file.offset();
+        if (!file.readTokens(tokens))
+            break;
+        offsets.append(offset);
+        engine::PgnFile::toGame(tokens, game);
+        names.append(QString("%1. %2 - %3, %4 %5 %6").arg(offsets.size())
+                     .arg(game.tag("White"), game.tag("Black"), game.tag("Event"), game.tag("Date"), game.result));
+    }
+    if (offsets.isEmpty()) {
+        statusBar()->showMessage(tr("There are no games in %1").arg(fileName));
+        return;
+    }
+
+    bool ok = true;
+    int index = 0;
+    if (offsets.size() > maxListedGames) {
+        index = QInputDialog::getInt(this, tr("Open game"), tr("Game number:"),
+                                     1, 1, std::numeric_limits<int>::max(), 1, &ok) - 1;
+        if (ok && index >= offsets.size()) {
+            const qint64 offset = m_findGameOffset(file, offsets.last(), index - offsets.size() + 1);
+            if (offset < 0)
+                return;
+            if (offset >= file.size()) {
+                statusBar()->showMessage(tr("There is no game %1 in %2").arg(index + 1).arg(fileName));
+                return;
+            }
+            offsets.append(offset);
+            index = offsets.size() - 1;
+        }
+    } else if (offsets.size() > 1) {
+        index = names.indexOf(QInputDialog::getItem(this, tr("Open game"), tr("Game:"), names, 0, false, &ok));
+    }
+    if (!ok || index < 0)
+        return;
+
+    file.seek(offsets.at(index));
+    file.readGame(game);
+    if (game.startFEN() != engine::Position::startFEN()) {
+        statusBar()->showMessage(tr("The board plays from the initial position only"));
+        return;
+    }
+
+    // SAN is resolved by the engine, the board takes the moves in coordinate notation
+    QStringList moves;
+    engine::Position pos;
+    pos.setFEN(engine::Position::startFEN());
+    for (const auto &san : game.moves) {
+        const engine::Move move = engine::moveFromSan(pos, san);
+        if (move == engine::NO_MOVE)
+            break;
+        moves.append(engine::moveToString(move));
+        pos.doMove(move);
+    }
+
+    const int played = controller->openGame(moves);
+    if (played < game.moves.size())
+        statusBar()->showMessage(tr("%1 of %2 moves of the game are shown").arg(played).arg(game.moves.size()));
+    else
+        statusBar()->showMessage(QString("%1 - %2 %3").arg(game.tag("White"), game.tag("Black"), game.result));
+}
+
+qint64 MainWindow::m_findGameOffset(const engine::PgnFile &file, qint64 offset, int count)
+{
+    // only the line starts are looked at for the tags opening a game, nothing is tokenized
+    QProgressDialog progress(tr("Looking for the game..."), tr("Cancel"), 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    offset = file.nextGameOffset(offset);
+    for (int i = 0; i < count && offset < file.size(); i++) {
+        offset = file.nextGameOffset(offset + 1);
+        if (i % 1000 == 0) {
+            progress.setValue(int(offset * 1000 / file.size()));
+            if (progress.wasCanceled())
+                return -1;
+        }
+    }
+    return offset;
+}
+
+void MainWindow::on_enginePlays_toggled(bool checked)
+{
+    controller->setEnginePlaying(checked);
+}
+
 void MainWindow::on_exit_triggered()
 {
     close();
@@ -24,12 +24,16 @@
 
 #include <QMainWindow>
 #include "gui\boardwidget.h"
-#include "gui\controller.h"
+#include "logic\controller.h"
 
 namespace Ui {
 class MainWindow;
 }
 
+namespace engine {
+class PgnFile;
+}
+
 
 //====================
 //    Main Window
@@ -55,11 +59,18 @@ protected:
 private slots:
    void on_create_triggered();
    void on_connect_triggered();
+   void on_open_triggered();
+   void on_enginePlays_toggled(bool);
    void on_exit_triggered();
 
 private:
     Ui::MainWindow *ui;
 
+    // m_findGameOffset:
+    //      Offset of the game the count games after the one at the offset, the size
+    //      of the file if there are fewer games, -1 if the user cancels the search
+    qint64 m_findGameOffset(const engine::PgnFile &file, qint64 offset, int count);
+
     // Translation objects
     QTranslator  *m_translator;
     QTranslator  *m_translatorQt;
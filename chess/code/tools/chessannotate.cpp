@@ -0,0 +1,98 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "engine/annotator.h"
+
+//==============================================================
+//                      chess-annotate
+//==============================================================
+
+//    Annotates the games of PGN files with the evaluation of the engine
+//
+//    Usage:
+//      chess-annotate [-t threads] [-n nodes] [-d depth] [-h hash MB] [-o file] <games.pgn> ...
+//          writes the games with a [%eval] comment after every move and the
+//          inaccuracies, mistakes and blunders marked to the file (annotated.pgn
+//          by default). All the hardware threads and 100000 nodes per position by default
+
+namespace
+{
+
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  chess-annotate [-t threads] [-n nodes = 100000] [-d depth] [-h hash MB = 16]\n"
+        << "                 [-o file = annotated.pgn] <games.pgn> ...\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    engine::Annotator::Options options;
+    options.threads = QThread::idealThreadCount();
+    bool hasDepth = false, hasNodes = false;
+    QString outputFile("annotated.pgn");
+    QStringList pgnFiles;
+    for (auto i = 0; i < args.size(); i++) {
+        const bool hasValue = i + 1 < args.size();
+        if (args.at(i) == "-t" && hasValue) {
+            options.threads = qMax(1, args.at(++i).toInt());
+        } else if (args.at(i) == "-n" && hasValue) {
+            options.nodes = qMax(Q_INT64_C(0), args.at(++i).toLongLong());
+            hasNodes = true;
+        } else if (args.at(i) == "-d" && hasValue) {
+            options.depth = qMax(0, args.at(++i).toInt());
+            hasDepth = true;
+        } else if (args.at(i) == "-h" && hasValue) {
+            options.hashMB = qMax(1, args.at(++i).toInt());
+        } else if (args.at(i) == "-o" && hasValue) {
+            outputFile = args.at(++i);
+        } else {
+            pgnFiles.append(args.at(i));
+        }
+    }
+    // a depth alone is the whole budget
+    if (hasDepth && !hasNodes)
+        options.nodes = 0;
+    if (pgnFiles.isEmpty() || (options.nodes == 0 && options.depth == 0)) {
+        printUsage(out);
+        return 1;
+    }
+
+    QString error;
+    if (!engine::Annotator::annotate(pgnFiles, outputFile, options, out, &error)) {
+        out << "Error: " << error << "\n";
+        return 1;
+    }
+    out << "Annotated games written to " << outputFile << "\n";
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "engine/benchmark.h"
+
+//==============================================================
+//                      chess-bench
+//==============================================================
+
+//    Command line benchmarks of the engine
+//
+//    Usage:
+//      chess-bench smp [depth] [max threads] [hash MB]
+//          time to depth with 1, 2, 4, ... threads up to max threads (32 by default)
+//      chess-bench ordering [depth] [hash MB]
+//          nodes to depth with and without the move ordering heuristics
+//      chess-bench pruning [depth] [hash MB]
+//          nodes and time to depth with each selective search technique on and off
+//      chess-bench pawns [depth] [hash MB]
+//          hit rate of the pawn structure cache and time to depth with and without it
+//      chess-bench nnue [network file]
+//          neural network evaluations per second, a random network without a file
+//      chess-bench ponder [opponent ms] [clock ms]
+//          reply latency with and without pondering on the opponent's time
+//      chess-bench stop [threads] [search ms]
+//          time from a stop request to the search result
+//      chess-bench bots [games] [threads] [seconds]
+//          many bot games at once on a thread pool: utilisation and move latency by level
+//      chess-bench book <polyglot file>
+//          time per probe of a memory mapped opening book
+//      chess-bench pgn <pgn file>
+//          MB/s and games/s of the memory mapped PGN tokenizer
+//      chess-bench import <pgn file> [max threads]
+//          games/s of the parallel PGN import with 1, 2, 4, ... threads
+//      chess-bench codec <pgn file>
+//          size and speed of the binary game format against PGN
+//      chess-bench db <database file> [pgn file]
+//          adds the PGN games to a game database, builds its position index and times searches
+
+namespace
+{
+
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  chess-bench smp [depth = 10] [max threads = 32] [hash MB = 256]\n"
+        << "  chess-bench ordering [depth = 7] [hash MB = 64]\n"
+        << "  chess-bench pruning [depth = 10] [hash MB = 64]\n"
+        << "  chess-bench pawns [depth = 10] [hash MB = 64]\n"
+        << "  chess-bench nnue [network file]\n"
+        << "  chess-bench ponder [opponent ms = 1000] [clock ms = 60000]\n"
+        << "  chess-bench stop [threads = 4] [search ms = 500]\n"
+        << "  chess-bench bots [games = 64] [threads = all but one] [seconds = 10]\n"
+        << "  chess-bench book <polyglot file>\n"
+        << "  chess-bench pgn <pgn file>\n"
+        << "  chess-bench import <pgn file> [max threads = hardware threads]\n"
+        << "  chess-bench codec <pgn file>\n"
+        << "  chess-bench db <database file> [pgn file]\n";
+}
+
+// argumentAt: integer argument or the default value if it is missing
+int argumentAt(const QStringList &args, int index, int defaultValue)
+{
+    bool ok = false;
+    int value = index < args.size() ? args.at(index).toInt(&ok) : 0;
+    return ok && value > 0 ? value : defaultValue;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    const QStringList args = app.arguments();
+
+    const QString command = args.size() > 1 ? args.at(1) : QString("smp");
+
+    if (command == "smp") {
+        int depth      = argumentAt(args, 2, 10);
+        int maxThreads = argumentAt(args, 3, 32);
+        int hashMB     = argumentAt(args, 4, 256);
+
+        QVector<int> threadCounts;
+        for (auto threads = 1; threads <= maxThreads; threads *= 2)
+            threadCounts.append(threads);
+
+        out << "Hardware threads: " << QThread::idealThreadCount() << "\n";
+        engine::Benchmark::smpSpeedup(out, depth, threadCounts, hashMB);
+        return 0;
+    }
+
+    if (command == "ordering") {
+        int depth  = argumentAt(args, 2, 7);
+        int hashMB = argumentAt(args, 3, 64);
+        engine::Benchmark::moveOrdering(out, depth, hashMB);
+        return 0;
+    }
+
+    if (command == "pruning") {
+        int depth  = argumentAt(args, 2, 10);
+        int hashMB = argumentAt(args, 3, 64);
+        engine::Benchmark::selectiveSearch(out, depth, hashMB);
+        return 0;
+    }
+
+    if (command == "pawns") {
+        int depth  = argumentAt(args, 2, 10);
+        int hashMB = argumentAt(args, 3, 64);
+        engine::Benchmark::pawnHash(out, depth, hashMB);
+        return 0;
+    }
+
+    if (command == "nnue") {
+        const QString networkFile = args.size() > 2 ? args.at(2) : QString();
+        return engine::Benchmark::nnue(out, networkFile) ? 0 : 1;
+    }
+
+    if (command == "ponder") {
+        int opponentMs = argumentAt(args, 2, 1000);
+        int clockMs    = argumentAt(args, 3, 60000);
+        engine::Benchmark::ponderLatency(out, opponentMs, clockMs);
+        return 0;
+    }
+
+    if (command == "stop") {
+        int threads  = argumentAt(args, 2, 4);
+        int searchMs = argumentAt(args, 3, 500);
+        engine::Benchmark::stopLatency(out, threads, searchMs);
+        return 0;
+    }
+
+    if (command == "bots") {
+        int games   = argumentAt(args, 2, 64);
+        int threads = argumentAt(args, 3, 0);
+        int seconds = argumentAt(args, 4, 10);
+        engine::Benchmark::bots(out, games, threads, seconds);
+        return 0;
+    }
+
+    if (command == "book" && args.size() > 2)
+        return engine::Benchmark::book(out, args.at(2)) ? 0 : 1;
+
+    if (command == "pgn" && args.size() > 2)
+        return engine::Benchmark::pgn(out, args.at(2)) ? 0 : 1;
+
+    if (command == "import" && args.size() > 2)
+        return engine::Benchmark::pgnImport(out, args.at(2), argumentAt(args, 3, QThread::idealThreadCount())) ? 0 : 1;
+
+    if (command == "codec" && args.size() > 2)
+        return engine::Benchmark::gameCodec(out, args.at(2)) ? 0 : 1;
+
+    if (command == "db" && args.size() > 2)
+        return engine::Benchmark::gameDatabase(out, args.at(2), args.size() > 3 ? args.at(3) : QString()) ? 0 : 1;
+
+    printUsage(out);
+    return 1;
+}
@@ -0,0 +1,168 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "engine/benchmark.h"
+#include "engine/match.h"
+#include "engine/nnue.h"
+#include "engine/tablebase.h"
+
+//==============================================================
+//                      chess-match
+//==============================================================
+
+//    Plays two configurations of the engine against each other until
+//    the sequential probability ratio test decides
+//
+//    Usage:
+//      chess-match [-c concurrency] [-g max games] [-tc seconds+increment] [-n nodes]
+//                  [-o openings] [-sprt elo0 elo1] [-tb syzygy dirs] [-e network]
+//                  [-first options] [-second options]
+//          options are comma separated switches of the engine, for example
+//          "name=nmp,nullMove=0,hash=32". All the hardware threads, 10+0.1 s
+//          and the bench positions as openings by default
+
+namespace
+{
+
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  chess-match [-c concurrency] [-g max games = 20000] [-tc seconds+increment = 10+0.1] [-n nodes]\n"
+        << "              [-o openings.epd] [-sprt elo0 elo1 = 0 5] [-tb syzygy dirs] [-e network]\n"
+        << "              [-first options] [-second options]\n"
+        << "  options: name=text,hash=MB,ordering=0|1,nnue=0|1,tablebases=0|1,\n"
+        << "           nullMove=0|1,lmr=0|1,futility=0|1,pawnHash=0|1\n";
+}
+
+// parsePlayer: the switches not given keep their defaults
+bool parsePlayer(const QString &text, engine::Match::Player *player)
+{
+    for (const QString &item : text.split(',', QString::SkipEmptyParts)) {
+        const int separator = item.indexOf('=');
+        if (separator < 0)
+            return false;
+        const QString key = item.left(separator).trimmed();
+        const QString value = item.mid(separator + 1).trimmed();
+        const bool on = value != "0" && value.compare("false", Qt::CaseInsensitive) != 0;
+        if (key == "name")
+            player->name = value;
+        else if (key == "hash")
+            player->hashMB = qMax(1, value.toInt());
+        else if (key == "ordering")
+            player->options.moveOrdering = on;
+        else if (key == "nnue")
+            player->options.useNnue = on;
+        else if (key == "tablebases")
+            player->options.useTablebases = on;
+        else if (key == "nullMove")
+            player->options.nullMove = on;
+        else if (key == "lmr")
+            player->options.lateMoveReductions = on;
+        else if (key == "futility")
+            player->options.futilityPruning = on;
+        else if (key == "pawnHash")
+            player->options.pawnHash = on;
+        else
+            return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    engine::Match::Options options;
+    options.concurrency = QThread::idealThreadCount();
+    engine::Match::Player first, second;
+    first.name = "first";
+    second.name = "second";
+    QString openingsFile, syzygyPaths, networkFile;
+    for (auto i = 0; i < args.size(); i++) {
+        const bool hasValue = i + 1 < args.size();
+        if (args.at(i) == "-c" && hasValue) {
+            options.concurrency = qMax(1, args.at(++i).toInt());
+        } else if (args.at(i) == "-g" && hasValue) {
+            options.maxGames = qMax(1, args.at(++i).toInt());
+        } else if (args.at(i) == "-tc" && hasValue) {
+            const QStringList tc = args.at(++i).split('+');
+            options.timeMs = qint64(tc.at(0).toDouble() * 1000);
+            options.incrementMs = tc.size() > 1 ? qint64(tc.at(1).toDouble() * 1000) : 0;
+        } else if (args.at(i) == "-n" && hasValue) {
+            options.nodes = qMax(Q_INT64_C(0), args.at(++i).toLongLong());
+        } else if (args.at(i) == "-o" && hasValue) {
+            openingsFile = args.at(++i);
+        } else if (args.at(i) == "-sprt" && i + 2 < args.size()) {
+            options.elo0 = args.at(++i).toDouble();
+            options.elo1 = args.at(++i).toDouble();
+        } else if (args.at(i) == "-tb" && hasValue) {
+            syzygyPaths = args.at(++i);
+        } else if (args.at(i) == "-e" && hasValue) {
+            networkFile = args.at(++i);
+        } else if (args.at(i) == "-first" && hasValue) {
+            if (!parsePlayer(args.at(++i), &first)) {
+                printUsage(out);
+                return 1;
+            }
+        } else if (args.at(i) == "-second" && hasValue) {
+            if (!parsePlayer(args.at(++i), &second)) {
+                printUsage(out);
+                return 1;
+            }
+        } else {
+            printUsage(out);
+            return 1;
+        }
+    }
+    if (options.timeMs <= 0 && options.nodes == 0) {
+        printUsage(out);
+        return 1;
+    }
+
+    if (openingsFile.isEmpty()) {
+        options.openings = engine::Benchmark::benchPositions();
+    } else {
+        QString error;
+        if (!engine::Match::readOpenings(openingsFile, &options.openings, &error)) {
+            out << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+    if (!syzygyPaths.isEmpty())
+        out << engine::Tablebases::init(syzygyPaths) << " Syzygy tables found\n";
+    if (!networkFile.isEmpty() && !engine::Nnue::load(networkFile)) {
+        out << "Error: can't load the network " << networkFile << "\n";
+        return 1;
+    }
+
+    engine::Match::run(first, second, options, out);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "engine/dtm.h"
+
+//==============================================================
+//                      chess-tbgen
+//==============================================================
+
+//    Generates distance to mate tables for the engine
+//
+//    Usage:
+//      chess-tbgen [-t threads] [-o directory] <material> ...
+//          writes <directory>/<material>.dtm for each material (KQvK, KBNvK, KPvK, ...),
+//          the tables a capture or a promotion leads to are generated first if missing.
+//          All the hardware threads and the current directory by default
+
+namespace
+{
+
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  chess-tbgen [-t threads] [-o directory] <material> ...\n"
+        << "  materials of up to " << int(engine::Dtm::DTM_PIECES) << " pieces like KQvK, KRvK, KBNvK, KPvK\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    int threads = QThread::idealThreadCount();
+    QString directory(".");
+    QStringList materials;
+    for (auto i = 0; i < args.size(); i++) {
+        if (args.at(i) == "-t" && i + 1 < args.size())
+            threads = qMax(1, args.at(++i).toInt());
+        else if (args.at(i) == "-o" && i + 1 < args.size())
+            directory = args.at(++i);
+        else
+            materials.append(args.at(i));
+    }
+    if (materials.isEmpty()) {
+        printUsage(out);
+        return 1;
+    }
+
+    out << "Threads: " << threads << "\n";
+    for (const auto &material : materials) {
+        QString error;
+        if (!engine::Dtm::generate(material, directory, threads, out, &error)) {
+            out << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
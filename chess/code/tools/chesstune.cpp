@@ -0,0 +1,95 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "engine/tuner.h"
+
+//==============================================================
+//                      chess-tune
+//==============================================================
+
+//    Tunes the classical evaluation on the games of PGN files
+//
+//    Usage:
+//      chess-tune [-t threads] [-i iterations] [-r rate] [-s skip plies] [-m max positions]
+//                 [-o file] <games.pgn> ...
+//          extracts the quiet positions after the opening of every finished game
+//          and writes the tuned values to the file (tuned.txt by default).
+//          All the hardware threads, 1000 iterations of 1 centipawn
+//          and 16 opening plies skipped by default
+
+namespace
+{
+
+void printUsage(QTextStream &out)
+{
+    out << "Usage:\n"
+        << "  chess-tune [-t threads] [-i iterations = 1000] [-r rate = 1.0] [-s skip plies = 16]\n"
+        << "             [-m max positions] [-o file = tuned.txt] <games.pgn> ...\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    engine::Tuner::Options options;
+    options.threads = QThread::idealThreadCount();
+    QString outputFile("tuned.txt");
+    QStringList pgnFiles;
+    for (auto i = 0; i < args.size(); i++) {
+        const bool hasValue = i + 1 < args.size();
+        if (args.at(i) == "-t" && hasValue)
+            options.threads = qMax(1, args.at(++i).toInt());
+        else if (args.at(i) == "-i" && hasValue)
+            options.iterations = qMax(0, args.at(++i).toInt());
+        else if (args.at(i) == "-r" && hasValue)
+            options.learningRate = args.at(++i).toDouble();
+        else if (args.at(i) == "-s" && hasValue)
+            options.skipPlies = qMax(0, args.at(++i).toInt());
+        else if (args.at(i) == "-m" && hasValue)
+            options.maxPositions = qMax(Q_INT64_C(0), args.at(++i).toLongLong());
+        else if (args.at(i) == "-o" && hasValue)
+            outputFile = args.at(++i);
+        else
+            pgnFiles.append(args.at(i));
+    }
+    if (pgnFiles.isEmpty()) {
+        printUsage(out);
+        return 1;
+    }
+
+    QString error;
+    if (!engine::Tuner::tune(pgnFiles, outputFile, options, out, &error)) {
+        out << "Error: " << error << "\n";
+        return 1;
+    }
+    out << "Tuned values written to " << outputFile << "\n";
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*******************************************************************************
+* Copyright (c) 2016-2017, Comrade Andrew A.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*******************************************************************************/
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QStringList>
+
+#include "engine/uci.h"
+
+//==============================================================
+//                      chess-uci
+//==============================================================
+
+//    Headless engine speaking the Universal Chess Interface over stdin/stdout,
+//    for tournament managers and engine matches. See engine::Uci for the commands.
+//
+//    Arguments are run as a single command before exiting, e.g.
+//      chess-uci bench [depth] [threads] [hash MB]
+//    prints the node count signature of the build, its time and nodes per second
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream in(stdin);
+    QTextStream out(stdout);
+
+    engine::Uci uci(in, out);
+    const QStringList args = app.arguments();
+    if (args.size() > 1) {
+        uci.execute(args.mid(1).join(' '));
+        return 0;
+    }
+    uci.loop();
+    return 0;
+}
@@ -0,0 +1,31 @@
+
+DEPENDPATH += .
+include(engine.pri)
+
+TEMPLATE = app
+TARGET   = chess-annotate
+QT       = core
+CONFIG  += console
+CONFIG  -= app_bundle
+
+win32:DEFINES += _CONSOLE WIN64
+unix:DEFINES  += UNIX
+
+INCLUDEPATH += ../chess/code
+
+SOURCES += ../chess/code/tools/chessannotate.cpp
+
+CONFIG(debug, debug|release) {
+    Configuration = debug
+} else {
+    Configuration = release
+}
+
+contains(QT_ARCH, i386) {
+    Platform = 32bit
+} else {
+    Platform = 64bit
+}
+
+DESTDIR     = ./$${Platform}/$${Configuration}
+OBJECTS_DIR = objs/chess-annotate/$${Platform}/$${Configuration}
@@ -10,6 +10,9 @@ message("You are running qmake on a generated .pro file. This may not work!")
 HEADERS += ../chess/code/mainwindow.h \
     ../chess/code/gui/boardwidget.h \
     ../chess/code/gui/boardinterface.h \
+    ../chess/code/gui/analysiswidget.h \
+    ../chess/code/gui/openingexplorer.h \
+    ../chess/code/gui/gameexplorer.h \
     ../chess/code/gui/createdialog.h \
     ../chess/code/logic/chessevent.h \
     ../chess/code/logic/chessboard.h \
@@ -23,6 +26,9 @@ SOURCES += ../chess/code/main.cpp \
     ../chess/code/logic/chessevent.cpp \
     ../chess/code/logic/controller.cpp \
     ../chess/code/gui/boardinterface.cpp \
+    ../chess/code/gui/analysiswidget.cpp \
+    ../chess/code/gui/openingexplorer.cpp \
+    ../chess/code/gui/gameexplorer.cpp \
     ../chess/code/gui/boardwidget.cpp \
     ../chess/code/gui/createdialog.cpp \
     ../chess/code/utilities/chessutilities.cpp
@@ -1,6 +1,7 @@
 
 DEPENDPATH += .
 include(chess.pri)
+include(engine.pri)
 
 TEMPLATE = app
 TARGET   = chess
@@ -0,0 +1,72 @@
+# ----------------------------------------------------
+# Engine sources shared by the GUI and the console tools.
+# ------------------------------------------------------
+
+HEADERS += ../chess/code/logic/notation.h \
+    ../chess/code/engine/bitboard.h \
+    ../chess/code/engine/types.h \
+    ../chess/code/engine/psqt.h \
+    ../chess/code/engine/position.h \
+    ../chess/code/engine/movegen.h \
+    ../chess/code/engine/movepicker.h \
+    ../chess/code/engine/see.h \
+    ../chess/code/engine/evaluation.h \
+    ../chess/code/engine/pawns.h \
+    ../chess/code/engine/nnue.h \
+    ../chess/code/engine/transposition.h \
+    ../chess/code/engine/timemanager.h \
+    ../chess/code/engine/search.h \
+    ../chess/code/engine/engine.h \
+    ../chess/code/engine/benchmark.h \
+    ../chess/code/engine/book.h \
+    ../chess/code/engine/tablebase.h \
+    ../chess/code/engine/dtm.h \
+    ../chess/code/engine/material.h \
+    ../chess/code/engine/parallel.h \
+    ../chess/code/engine/pgn.h \
+    ../chess/code/engine/tuner.h \
+    ../chess/code/engine/match.h \
+    ../chess/code/engine/bots.h \
+    ../chess/code/engine/analysiscache.h \
+    ../chess/code/engine/annotator.h \
+    ../chess/code/engine/gamelist.h \
+    ../chess/code/engine/pgnimport.h \
+    ../chess/code/engine/gamecodec.h \
+    ../chess/code/engine/gamedb.h
+SOURCES += ../chess/code/engine/bitboard.cpp \
+    ../chess/code/engine/psqt.cpp \
+    ../chess/code/engine/position.cpp \
+    ../chess/code/engine/movegen.cpp \
+    ../chess/code/engine/movepicker.cpp \
+    ../chess/code/engine/see.cpp \
+    ../chess/code/engine/evaluation.cpp \
+    ../chess/code/engine/pawns.cpp \
+    ../chess/code/engine/nnue.cpp \
+    ../chess/code/engine/transposition.cpp \
+    ../chess/code/engine/timemanager.cpp \
+    ../chess/code/engine/search.cpp \
+    ../chess/code/engine/engine.cpp \
+    ../chess/code/engine/benchmark.cpp \
+    ../chess/code/engine/book.cpp \
+    ../chess/code/engine/tablebase.cpp \
+    ../chess/code/engine/dtm.cpp \
+    ../chess/code/engine/pgn.cpp \
+    ../chess/code/engine/tuner.cpp \
+    ../chess/code/engine/match.cpp \
+    ../chess/code/engine/bots.cpp \
+    ../chess/code/engine/analysiscache.cpp \
+    ../chess/code/engine/annotator.cpp \
+    ../chess/code/engine/gamelist.cpp \
+    ../chess/code/engine/pgnimport.cpp \
+    ../chess/code/engine/gamecodec.cpp \
+    ../chess/code/engine/gamedb.cpp
+
+# SIMD kernels of the network evaluation: run qmake with CONFIG+=avx2 or CONFIG+=sse41,
+# the portable scalar code is used otherwise
+avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2
+} else: sse41 {
+    msvc: DEFINES += NNUE_SSE41
+    else: QMAKE_CXXFLAGS += -msse4.1
+}